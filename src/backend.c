@@ -0,0 +1,127 @@
+/*
+ * backend.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "gpiod.h"
+#include "backend.h"
+
+static GpioBackend *backends[] = { &wiringpi_backend, &mock_backend, &mmap_backend, &chardev_backend };
+
+/**
+ * \brief wiringPi pin number to BCM gpio number (board revision 2).
+ */
+const int wiringpi_to_bcm[NUM_PINS] = {
+  17, 18, 27, 22, 23, 24, 25, 4, 2, 3, 8, 7, 10, 9, 11, 14, 15
+};
+
+GpioBackend *gpio_backend = &wiringpi_backend; /**< the selected backend, wiringPi by default */
+const char *backend_device = NULL; /**< device or file of the backend, NULL for the default */
+int wiringpi_is_setup = 0; /**< wiringPi is set up by the backend or for the lcd */
+pthread_mutex_t wiringpi_setup_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * \brief Select the gpio backend by name.
+ *
+ * @param name "wiringpi", "mock", "mmap" or "chardev".
+ *
+ * @return 0 or -1 if the backend is unknown.
+ */
+int select_backend(const char *name) {
+  unsigned int i;
+
+  for (i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+    if (strcmp(backends[i]->name, name) == 0) {
+      gpio_backend = backends[i];
+      return 0;
+    }
+  }
+  return -1;
+}
+
+/**
+ * \brief set the device or file of the backend
+ *
+ * @param device
+ */
+void set_backend_device(const char *device) {
+  backend_device = device;
+}
+
+/**
+ * \brief Setup the selected backend.
+ *
+ * @return 0 or -1 on error.
+ */
+int setup_backend() {
+  return gpio_backend->setup(backend_device);
+}
+
+/**
+ * \brief get the name of the selected backend
+ */
+const char *get_backend_name() {
+  return gpio_backend->name;
+}
+
+/**
+ * \brief Setup wiringPi once.
+ *
+ * The dog128 library always needs wiringPi, also if another gpio backend
+ * is selected.
+ *
+ * @return 0 or -1 if wiringPi could not be set up.
+ */
+int require_wiringpi() {
+  pthread_mutex_lock(&wiringpi_setup_lock);
+  if (!wiringpi_is_setup) {
+    if (wiringPiSetup() == -1) {
+      printf("Unable to initialise wiringPi.\n");
+    } else {
+      wiringpi_is_setup = 1;
+    }
+  }
+  pthread_mutex_unlock(&wiringpi_setup_lock);
+
+  return wiringpi_is_setup ? 0 : -1;
+}
+
+/**
+ * \brief Read all pins with single reads.
+ *
+ * For backends without a bank register.
+ *
+ * @return Bit n is the level of pin n.
+ */
+unsigned int generic_read_bank(void) {
+  unsigned int mask = 0;
+  int pin;
+
+  for (pin = 0; pin < NUM_PINS; pin++) {
+    if (gpio_backend->digital_read(pin)) {
+      mask |= 1U << pin;
+    }
+  }
+  return mask;
+}
+
+/**
+ * \brief Write pins with single writes.
+ *
+ * For backends without a bank register.
+ *
+ * @param set_mask   Pins to set high.
+ * @param clear_mask Pins to set low.
+ */
+void generic_write_bank(unsigned int set_mask, unsigned int clear_mask) {
+  int pin;
+
+  for (pin = 0; pin < NUM_PINS; pin++) {
+    if (set_mask & (1U << pin)) {
+      gpio_backend->digital_write(pin, 1);
+    } else if (clear_mask & (1U << pin)) {
+      gpio_backend->digital_write(pin, 0);
+    }
+  }
+}
@@ -0,0 +1,156 @@
+/*
+ * backend.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef BACKEND_H_
+#define BACKEND_H_
+
+/**
+ * \brief Callback of a backend for an accepted edge.
+ *
+ * @param id           The id given on registration.
+ * @param level        The pin level after the edge.
+ * @param timestamp_ns Monotonic time of the edge.
+ */
+typedef void (*BackendEdgeCallback)(int id, int level, unsigned long long timestamp_ns);
+
+/**
+ * \brief Function table of a gpio backend.
+ *
+ * All pins are wiringPi pin numbers. Bank masks have bit n set for pin n.
+ * The register and chardev backends map them to BCM gpios with
+ * wiringpi_to_bcm. A backend with a bank register also gives raw access to
+ * it, raw masks have bit n set for the BCM gpio n.
+ */
+typedef struct GpioBackend {
+  const char *name;
+  int  (*setup)(const char *device);
+  void (*pin_mode)(int pin, int mode);
+  int  (*digital_read)(int pin);
+  void (*digital_write)(int pin, int value);
+  void (*pull_up_dn)(int pin, int pud);
+  int  (*isr)(int pin, int edge, int id, BackendEdgeCallback callback); //> again for an id replaces its isr
+  int  (*pin_to_gpio)(int pin);
+  unsigned int (*read_bank)(void);
+  void (*write_bank)(unsigned int set_mask, unsigned int clear_mask);
+  void (*set_debounce)(int pin, unsigned int period_us); //> optional, NULL if not supported
+  void (*pwm_write)(int pin, unsigned int duty);         //> optional, duty 0 to PWM_RANGE
+  void (*write_stats)(int client_socket_fd);             //> optional
+  unsigned int (*read_raw_bank)(void);                   //> optional, one read of the level register
+  void (*write_raw_bank)(unsigned int set_mask, unsigned int clear_mask); //> optional, one store per register
+} GpioBackend;
+
+extern GpioBackend wiringpi_backend;
+extern GpioBackend mock_backend;
+
+/**
+ * \brief mock client command.
+ *
+ * MOCK EDGE pin level changes a pin of the mock backend like an edge.
+ */
+#define CLIENT_MOCK "MOCK"
+#define MOCK_EDGE   "EDGE"
+
+extern GpioBackend mmap_backend;
+extern GpioBackend chardev_backend;
+extern GpioBackend *gpio_backend;
+extern const int wiringpi_to_bcm[NUM_PINS];
+
+int select_backend(const char *name);
+void set_backend_device(const char *device);
+int setup_backend();
+const char *get_backend_name();
+int require_wiringpi();
+unsigned int generic_read_bank(void);
+void generic_write_bank(unsigned int set_mask, unsigned int clear_mask);
+void mock_backend_set_level(int pin, int level);
+void do_mock_command(int client_socket_fd, char *buf);
+
+/*
+ * The calls which touch a pin are traced as backend spans, see trace.h.
+ */
+static inline void gpio_pin_mode(int pin, int mode) {
+  unsigned long long trace_ns = trace_begin();
+
+  gpio_backend->pin_mode(pin, mode);
+  trace_end(TRACE_BACKEND, trace_ns, pin);
+}
+
+static inline int gpio_digital_read(int pin) {
+  unsigned long long trace_ns = trace_begin();
+  int value = gpio_backend->digital_read(pin);
+
+  trace_end(TRACE_BACKEND, trace_ns, pin);
+  return value;
+}
+
+static inline void gpio_digital_write(int pin, int value) {
+  unsigned long long trace_ns = trace_begin();
+
+  gpio_backend->digital_write(pin, value);
+  trace_end(TRACE_BACKEND, trace_ns, pin);
+}
+
+static inline void gpio_pull_up_dn(int pin, int pud) {
+  gpio_backend->pull_up_dn(pin, pud);
+}
+
+static inline int gpio_isr(int pin, int edge, int id, BackendEdgeCallback callback) {
+  return gpio_backend->isr(pin, edge, id, callback);
+}
+
+static inline int gpio_pin_to_gpio(int pin) {
+  return gpio_backend->pin_to_gpio(pin);
+}
+
+static inline void gpio_set_debounce(int pin, unsigned int period_us) {
+  if (gpio_backend->set_debounce != NULL) {
+    gpio_backend->set_debounce(pin, period_us);
+  }
+}
+
+static inline int gpio_pwm_write(int pin, unsigned int duty) {
+  unsigned long long trace_ns;
+
+  if (gpio_backend->pwm_write == NULL) {
+    return -1;
+  }
+  trace_ns = trace_begin();
+  gpio_backend->pwm_write(pin, duty);
+  trace_end(TRACE_BACKEND, trace_ns, pin);
+  return 0;
+}
+
+static inline unsigned int gpio_read_bank(void) {
+  unsigned long long trace_ns = trace_begin();
+  unsigned int levels = gpio_backend->read_bank();
+
+  trace_end(TRACE_BACKEND, trace_ns, -1);
+  return levels;
+}
+
+static inline void gpio_write_bank(unsigned int set_mask, unsigned int clear_mask) {
+  unsigned long long trace_ns = trace_begin();
+
+  gpio_backend->write_bank(set_mask, clear_mask);
+  trace_end(TRACE_BACKEND, trace_ns, -1);
+}
+
+static inline unsigned int gpio_read_raw_bank(void) {
+  unsigned long long trace_ns = trace_begin();
+  unsigned int levels = gpio_backend->read_raw_bank();
+
+  trace_end(TRACE_BACKEND, trace_ns, -1);
+  return levels;
+}
+
+static inline void gpio_write_raw_bank(unsigned int set_mask, unsigned int clear_mask) {
+  unsigned long long trace_ns = trace_begin();
+
+  gpio_backend->write_raw_bank(set_mask, clear_mask);
+  trace_end(TRACE_BACKEND, trace_ns, -1);
+}
+
+#endif /* BACKEND_H_ */
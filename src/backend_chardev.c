@@ -0,0 +1,423 @@
+/*
+ * backend_chardev.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <stdint.h>
+#include <linux/gpio.h>
+#include "gpiod.h"
+#include "backend.h"
+
+/**
+ * \brief Default gpio chip of the chardev backend.
+ */
+#define GPIOCHIP_DEVICE "/dev/gpiochip0"
+
+/**
+ * \brief Size of the kernel event fifo of every line.
+ */
+#define CHARDEV_EVENT_BUFFER 64
+
+/**
+ * \brief Count of events read at once from a line.
+ */
+#define CHARDEV_READ_EVENTS 16
+
+/**
+ * \brief State of a requested line.
+ *
+ * Every pin has an own line request, so the config of a pin can be
+ * changed without touching the other pins.
+ */
+typedef struct ChardevLine {
+  int fd;                    //> Line request or -1 if not requested.
+  int output;                //> 1 if the line is an output.
+  int value;                 //> Last written level, the initial level of an output.
+  uint64_t bias;             //> GPIO_V2_LINE_FLAG_BIAS_* flag or 0.
+  uint64_t edge;             //> GPIO_V2_LINE_FLAG_EDGE_* flags or 0.
+  unsigned int debounce_us;  //> Kernel debounce period or 0.
+  int id;                    //> Isr id.
+  BackendEdgeCallback callback; //> Isr callback or NULL.
+  unsigned int line_seqno;   //> Sequence number of the last event.
+} ChardevLine;
+
+static ChardevLine chardev_lines[NUM_PINS];
+static int chardev_chip_fd  = -1;
+static int chardev_epoll_fd = -1;
+static int chardev_event_thread_running = 0;
+static unsigned long chardev_events = 0; /**< count of edges read from the kernel */
+static unsigned long chardev_lost   = 0; /**< count of edges lost by a full kernel fifo */
+static pthread_mutex_t chardev_lock = PTHREAD_MUTEX_INITIALIZER;
+
+int chardev_setup(const char *device) {
+  int pin;
+
+  if (device == NULL) {
+    device = GPIOCHIP_DEVICE;
+  }
+  if ((chardev_chip_fd = open(device, O_RDWR | O_CLOEXEC)) == -1) {
+    log_msg(LOG_MOD_GPIO, LOG_ERR, "%s: %m", device);
+    return -1;
+  }
+  if ((chardev_epoll_fd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+    log_msg(LOG_MOD_GPIO, LOG_ERR, "epoll_create1: %m");
+    return -1;
+  }
+  for (pin = 0; pin < NUM_PINS; pin++) {
+    chardev_lines[pin].fd          = -1;
+    chardev_lines[pin].output      = 0;
+    chardev_lines[pin].value       = 0;
+    chardev_lines[pin].bias        = 0;
+    chardev_lines[pin].edge        = 0;
+    chardev_lines[pin].debounce_us = 0;
+    chardev_lines[pin].callback    = NULL;
+    chardev_lines[pin].line_seqno  = 0;
+  }
+  return 0;
+}
+
+/**
+ * Request the line or change the config of the requested line.
+ * chardev_lock must be held.
+ *
+ * @param pin The pin.
+ *
+ * @return 0 or -1 on error.
+ */
+int chardev_configure_line(int pin) {
+  ChardevLine *line = &chardev_lines[pin];
+  struct gpio_v2_line_request request;
+  struct gpio_v2_line_config *config;
+  struct epoll_event event;
+
+  memset(&request, 0, sizeof(request));
+  config = &request.config;
+  if (line->output) {
+    // The line is driven with its written level at once, not with 0 first.
+    config->flags = GPIO_V2_LINE_FLAG_OUTPUT | line->bias;
+    config->attrs[0].mask = 1;
+    config->attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+    config->attrs[0].attr.values = line->value;
+    config->num_attrs = 1;
+  } else {
+    config->flags = GPIO_V2_LINE_FLAG_INPUT | line->bias | line->edge;
+    if (line->debounce_us > 0) {
+      config->attrs[0].mask = 1;
+      config->attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
+      config->attrs[0].attr.debounce_period_us = line->debounce_us;
+      config->num_attrs = 1;
+    }
+  }
+
+  if (line->fd != -1) {
+    if (ioctl(line->fd, GPIO_V2_LINE_SET_CONFIG_IOCTL, config) == -1) {
+      log_msg(LOG_MOD_GPIO, LOG_ERR, "pin %d: GPIO_V2_LINE_SET_CONFIG_IOCTL: %m", pin);
+      return -1;
+    }
+    return 0;
+  }
+
+  request.offsets[0]        = wiringpi_to_bcm[pin];
+  request.num_lines         = 1;
+  request.event_buffer_size = CHARDEV_EVENT_BUFFER;
+  strncpy(request.consumer, "gpiod", sizeof(request.consumer) - 1);
+  if (ioctl(chardev_chip_fd, GPIO_V2_GET_LINE_IOCTL, &request) == -1) {
+    log_msg(LOG_MOD_GPIO, LOG_ERR, "pin %d: GPIO_V2_GET_LINE_IOCTL: %m", pin);
+    return -1;
+  }
+  line->fd = request.fd;
+
+  event.events   = EPOLLIN;
+  event.data.u32 = pin;
+  if (epoll_ctl(chardev_epoll_fd, EPOLL_CTL_ADD, line->fd, &event) == -1) {
+    log_msg(LOG_MOD_ISR, LOG_ERR, "pin %d: epoll_ctl: %m", pin);
+  }
+  return 0;
+}
+
+void chardev_pin_mode(int pin, int mode) {
+  if (pin < 0 || pin >= NUM_PINS) {
+    return;
+  }
+  pthread_mutex_lock(&chardev_lock);
+  chardev_lines[pin].output = mode != INPUT;
+  chardev_configure_line(pin);
+  pthread_mutex_unlock(&chardev_lock);
+}
+
+/**
+ * Read a line gpiod has not requested.
+ *
+ * The line is requested without direction and bias flags, so its direction
+ * and bias are kept as they are, read and released at once. A line of
+ * another consumer can't be requested and is read as 0.
+ *
+ * @param pin The pin.
+ *
+ * @return The level.
+ */
+static int chardev_read_as_is(int pin) {
+  struct gpio_v2_line_request request;
+  struct gpio_v2_line_values values;
+
+  memset(&request, 0, sizeof(request));
+  request.offsets[0] = wiringpi_to_bcm[pin];
+  request.num_lines  = 1;
+  strncpy(request.consumer, "gpiod", sizeof(request.consumer) - 1);
+  if (ioctl(chardev_chip_fd, GPIO_V2_GET_LINE_IOCTL, &request) == -1) {
+    log_msg(LOG_MOD_GPIO, LOG_DEBUG, "pin %d: not requested and busy, read as 0: %m", pin);
+    return 0;
+  }
+  values.mask = 1;
+  values.bits = 0;
+  ioctl(request.fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values);
+  close(request.fd);
+  return values.bits & 1;
+}
+
+/**
+ * \brief Read a pin.
+ *
+ * A read never requests or reconfigures a line, only MODE, writes and the
+ * config do.
+ */
+int chardev_digital_read(int pin) {
+  struct gpio_v2_line_values values;
+  int fd, level;
+
+  if (pin < 0 || pin >= NUM_PINS) {
+    return 0;
+  }
+  pthread_mutex_lock(&chardev_lock);
+  fd = chardev_lines[pin].fd;
+  if (fd == -1) {
+    level = chardev_read_as_is(pin);
+    pthread_mutex_unlock(&chardev_lock);
+    return level;
+  }
+  pthread_mutex_unlock(&chardev_lock);
+
+  values.mask = 1;
+  values.bits = 0;
+  if (ioctl(fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) == -1) {
+    return 0;
+  }
+  return values.bits & 1;
+}
+
+/**
+ * \brief Read the levels of the requested lines.
+ *
+ * A line is never requested by a read of all pins, so the sampling doesn't
+ * claim lines of the lcd, the spi or other consumers. Not requested lines
+ * are read as 0.
+ *
+ * @return Bit n is the level of pin n.
+ */
+unsigned int chardev_read_bank(void) {
+  struct gpio_v2_line_values values;
+  unsigned int mask = 0;
+  int fds[NUM_PINS];
+  int pin;
+
+  pthread_mutex_lock(&chardev_lock);
+  for (pin = 0; pin < NUM_PINS; pin++) {
+    fds[pin] = chardev_lines[pin].fd;
+  }
+  pthread_mutex_unlock(&chardev_lock);
+
+  for (pin = 0; pin < NUM_PINS; pin++) {
+    values.mask = 1;
+    values.bits = 0;
+    if (fds[pin] != -1 && ioctl(fds[pin], GPIO_V2_LINE_GET_VALUES_IOCTL, &values) == 0 && (values.bits & 1)) {
+      mask |= 1U << pin;
+    }
+  }
+  return mask;
+}
+
+void chardev_digital_write(int pin, int value) {
+  struct gpio_v2_line_values values;
+  int fd;
+
+  if (pin < 0 || pin >= NUM_PINS) {
+    return;
+  }
+  pthread_mutex_lock(&chardev_lock);
+  chardev_lines[pin].value = value ? 1 : 0;
+  if (chardev_lines[pin].fd == -1) {
+    chardev_lines[pin].output = 1;
+    chardev_configure_line(pin);
+  }
+  fd = chardev_lines[pin].fd;
+  pthread_mutex_unlock(&chardev_lock);
+
+  values.mask = 1;
+  values.bits = value ? 1 : 0;
+  if (fd != -1) {
+    ioctl(fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values);
+  }
+}
+
+void chardev_pull_up_dn(int pin, int pud) {
+  if (pin < 0 || pin >= NUM_PINS) {
+    return;
+  }
+  pthread_mutex_lock(&chardev_lock);
+  switch (pud) {
+    case PUD_UP:
+      chardev_lines[pin].bias = GPIO_V2_LINE_FLAG_BIAS_PULL_UP;
+      break;
+    case PUD_DOWN:
+      chardev_lines[pin].bias = GPIO_V2_LINE_FLAG_BIAS_PULL_DOWN;
+      break;
+    default:
+      chardev_lines[pin].bias = GPIO_V2_LINE_FLAG_BIAS_DISABLED;
+      break;
+  }
+  if (chardev_lines[pin].fd != -1) {
+    chardev_configure_line(pin);
+  }
+  pthread_mutex_unlock(&chardev_lock);
+}
+
+void chardev_set_debounce(int pin, unsigned int period_us) {
+  if (pin < 0 || pin >= NUM_PINS) {
+    return;
+  }
+  pthread_mutex_lock(&chardev_lock);
+  chardev_lines[pin].debounce_us = period_us;
+  if (chardev_lines[pin].fd != -1) {
+    chardev_configure_line(pin);
+  }
+  pthread_mutex_unlock(&chardev_lock);
+}
+
+int chardev_pin_to_gpio(int pin) {
+  if (pin < 0 || pin >= NUM_PINS) {
+    return -1;
+  }
+  return wiringpi_to_bcm[pin];
+}
+
+/**
+ * \brief Event thread for all lines.
+ *
+ * All line requests are watched with one epoll fd. The kernel keeps the
+ * edges with timestamp in the fifo of the line, so no edge is lost while
+ * a callback runs. A gap in the line sequence numbers is counted as lost.
+ *
+ * @param arg unused
+ */
+void *chardev_event_thread(void *arg) {
+  struct epoll_event ready[NUM_PINS];
+  struct gpio_v2_line_event events[CHARDEV_READ_EVENTS];
+  BackendEdgeCallback callback;
+  ChardevLine *line;
+  int n, i, j, count, fd, id, pin;
+  ssize_t len;
+
+  trace_name_thread("chardev events");
+  while (1) {
+    n = epoll_wait(chardev_epoll_fd, ready, NUM_PINS, -1);
+    if (n == -1) {
+      if (errno != EINTR) {
+        log_msg(LOG_MOD_ISR, LOG_ERR, "epoll_wait: %m");
+      }
+      continue;
+    }
+    for (i = 0; i < n; i++) {
+      pin  = ready[i].data.u32;
+      line = &chardev_lines[pin];
+      pthread_mutex_lock(&chardev_lock);
+      fd       = line->fd;
+      id       = line->id;
+      callback = line->callback;
+      pthread_mutex_unlock(&chardev_lock);
+
+      len = read(fd, events, sizeof(events));
+      if (len <= 0) {
+        continue;
+      }
+      count = len / sizeof(struct gpio_v2_line_event);
+      for (j = 0; j < count; j++) {
+        pthread_mutex_lock(&chardev_lock);
+        chardev_events++;
+        if (line->line_seqno != 0 && events[j].line_seqno > line->line_seqno + 1) {
+          chardev_lost += events[j].line_seqno - line->line_seqno - 1;
+        }
+        line->line_seqno = events[j].line_seqno;
+        pthread_mutex_unlock(&chardev_lock);
+        if (callback != NULL) {
+          // The kernel timestamp is CLOCK_MONOTONIC like get_monotonic_ns().
+          callback(id, events[j].id == GPIO_V2_LINE_EVENT_RISING_EDGE, events[j].timestamp_ns);
+        }
+      }
+    }
+  }
+  return NULL;
+}
+
+int chardev_isr(int pin, int edge, int id, BackendEdgeCallback callback) {
+  pthread_t thread;
+  int result;
+
+  if (pin < 0 || pin >= NUM_PINS) {
+    return -1;
+  }
+  pthread_mutex_lock(&chardev_lock);
+  chardev_lines[pin].output   = 0;
+  chardev_lines[pin].id       = id;
+  chardev_lines[pin].callback = callback;
+  switch (edge) {
+    case INT_EDGE_RISING:
+      chardev_lines[pin].edge = GPIO_V2_LINE_FLAG_EDGE_RISING;
+      break;
+    case INT_EDGE_FALLING:
+      chardev_lines[pin].edge = GPIO_V2_LINE_FLAG_EDGE_FALLING;
+      break;
+    default:
+      chardev_lines[pin].edge = GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+      break;
+  }
+  result = chardev_configure_line(pin);
+  if (result == 0 && !chardev_event_thread_running) {
+    if ((errno = pthread_create(&thread, NULL, chardev_event_thread, NULL)) != 0) {
+      log_msg(LOG_MOD_GPIO, LOG_ERR, "pthread_create: %m");
+      result = -1;
+    } else {
+      pthread_detach(thread);
+      chardev_event_thread_running = 1;
+    }
+  }
+  pthread_mutex_unlock(&chardev_lock);
+
+  return result;
+}
+
+void chardev_write_stats(int client_socket_fd) {
+  char msg[BUFFER_SIZE];
+
+  pthread_mutex_lock(&chardev_lock);
+  snprintf(msg, BUFFER_SIZE, "chardev edges: %lu, lost: %lu", chardev_events, chardev_lost);
+  pthread_mutex_unlock(&chardev_lock);
+  write_msg_to_client(client_socket_fd, msg);
+}
+
+GpioBackend chardev_backend = {
+  .name          = "chardev",
+  .setup         = chardev_setup,
+  .pin_mode      = chardev_pin_mode,
+  .digital_read  = chardev_digital_read,
+  .digital_write = chardev_digital_write,
+  .pull_up_dn    = chardev_pull_up_dn,
+  .isr           = chardev_isr,
+  .pin_to_gpio   = chardev_pin_to_gpio,
+  .read_bank     = chardev_read_bank,
+  .write_bank    = generic_write_bank,
+  .set_debounce  = chardev_set_debounce,
+  .write_stats   = chardev_write_stats,
+};
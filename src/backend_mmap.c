@@ -0,0 +1,335 @@
+/*
+ * backend_mmap.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <sys/mman.h>
+#include <stdint.h>
+#include "gpiod.h"
+#include "backend.h"
+
+/**
+ * \brief Default device of the register backend.
+ */
+#define GPIOMEM_DEVICE "/dev/gpiomem"
+
+/**
+ * \brief Size of the mapped gpio register block.
+ */
+#define GPIO_BLOCK_SIZE 4096
+
+/**
+ * \brief Sample interval of the edge detection in microseconds.
+ */
+#define MMAP_POLL_INTERVAL_US 1000
+
+/* Register offsets of the BCM2835 gpio block in 32 bit words. */
+#define GPFSEL0   0
+#define GPSET0    7
+#define GPCLR0    10
+#define GPLEV0    13
+#define GPPUD     37
+#define GPPUDCLK0 38
+
+/* Function select values. */
+#define FSEL_INPUT  0
+#define FSEL_OUTPUT 1
+#define FSEL_ALT5   2
+
+typedef struct MmapIsr {
+  int pin;
+  int edge;
+  int id;
+  BackendEdgeCallback callback;
+} MmapIsr;
+
+static volatile uint32_t *gpio_registers = NULL;
+static int gpio_registers_fake = 0; /**< a plain file is mapped, emulate the level register */
+static MmapIsr mmap_isrs[MAX_INTERRUPTS];
+static int mmap_isr_count = 0;
+static int mmap_poll_running = 0;
+static pthread_mutex_t mmap_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Map the gpio registers.
+ *
+ * A regular file is mapped as fake registers for tests, it is grown to the
+ * register block size.
+ */
+int mmap_setup(const char *device) {
+  struct stat st;
+  void *map;
+  int fd;
+
+  if (device == NULL) {
+    device = GPIOMEM_DEVICE;
+  }
+  if ((fd = open(device, O_RDWR | O_SYNC)) == -1) {
+    log_msg(LOG_MOD_GPIO, LOG_ERR, "%s: %m", device);
+    return -1;
+  }
+  if (fstat(fd, &st) == -1) {
+    log_msg(LOG_MOD_GPIO, LOG_ERR, "%s: %m", device);
+    close(fd);
+    return -1;
+  }
+  if (S_ISREG(st.st_mode)) {
+    gpio_registers_fake = 1;
+    if (st.st_size < GPIO_BLOCK_SIZE && ftruncate(fd, GPIO_BLOCK_SIZE) == -1) {
+      log_msg(LOG_MOD_GPIO, LOG_ERR, "%s: %m", device);
+      close(fd);
+      return -1;
+    }
+  }
+  map = mmap(NULL, GPIO_BLOCK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    log_msg(LOG_MOD_GPIO, LOG_ERR, "mmap: %m");
+    return -1;
+  }
+  gpio_registers = (volatile uint32_t *) map;
+
+  return 0;
+}
+
+/**
+ * Get the bcm gpio of a pin or -1.
+ */
+static inline int mmap_bcm(int pin) {
+  if (pin < 0 || pin >= NUM_PINS) {
+    return -1;
+  }
+  return wiringpi_to_bcm[pin];
+}
+
+void mmap_pin_mode(int pin, int mode) {
+  int bcm = mmap_bcm(pin), shift, fsel;
+  uint32_t value;
+
+  if (bcm == -1) {
+    return;
+  }
+  shift = (bcm % 10) * 3;
+  // Only the hardware pwm pin (BCM 18) has pwm as alternate function 5.
+  fsel  = mode == OUTPUT ? FSEL_OUTPUT : (mode == PWM_OUTPUT && bcm == 18 ? FSEL_ALT5 : FSEL_INPUT);
+  pthread_mutex_lock(&mmap_lock);
+  value = gpio_registers[GPFSEL0 + bcm / 10];
+  gpio_registers[GPFSEL0 + bcm / 10] = (value & ~(7U << shift)) | ((uint32_t) fsel << shift);
+  pthread_mutex_unlock(&mmap_lock);
+}
+
+int mmap_digital_read(int pin) {
+  int bcm = mmap_bcm(pin);
+
+  if (bcm == -1) {
+    return 0;
+  }
+  return (gpio_registers[GPLEV0] >> bcm) & 1;
+}
+
+/**
+ * Write the set and clear register. With fake registers the level
+ * register is changed too, so a read returns the written value.
+ */
+static inline void mmap_write_bcm_mask(uint32_t set, uint32_t clear) {
+  if (set) {
+    gpio_registers[GPSET0] = set;
+  }
+  if (clear) {
+    gpio_registers[GPCLR0] = clear;
+  }
+  if (gpio_registers_fake) {
+    gpio_registers[GPLEV0] = (gpio_registers[GPLEV0] | set) & ~clear;
+  }
+}
+
+void mmap_digital_write(int pin, int value) {
+  int bcm = mmap_bcm(pin);
+
+  if (bcm == -1) {
+    return;
+  }
+  if (value) {
+    mmap_write_bcm_mask(1U << bcm, 0);
+  } else {
+    mmap_write_bcm_mask(0, 1U << bcm);
+  }
+}
+
+/**
+ * Wait some cycles for the pull up/down clock.
+ */
+static void mmap_pud_delay() {
+  struct timespec ts = { 0, 5000 };
+
+  nanosleep(&ts, NULL);
+}
+
+void mmap_pull_up_dn(int pin, int pud) {
+  int bcm = mmap_bcm(pin);
+
+  if (bcm == -1) {
+    return;
+  }
+  // The wiringPi PUD_* values are the values of the GPPUD register.
+  pthread_mutex_lock(&mmap_lock);
+  gpio_registers[GPPUD] = pud & 3;
+  mmap_pud_delay();
+  gpio_registers[GPPUDCLK0] = 1U << bcm;
+  mmap_pud_delay();
+  gpio_registers[GPPUD] = 0;
+  gpio_registers[GPPUDCLK0] = 0;
+  pthread_mutex_unlock(&mmap_lock);
+}
+
+int mmap_pin_to_gpio(int pin) {
+  return mmap_bcm(pin);
+}
+
+/**
+ * Read all pins with one read of the level register.
+ */
+unsigned int mmap_read_bank(void) {
+  uint32_t levels = gpio_registers[GPLEV0];
+  unsigned int mask = 0;
+  int pin;
+
+  for (pin = 0; pin < NUM_PINS; pin++) {
+    if (levels & (1U << wiringpi_to_bcm[pin])) {
+      mask |= 1U << pin;
+    }
+  }
+  return mask;
+}
+
+/**
+ * Write all pins with one write of the set and clear register.
+ */
+void mmap_write_bank(unsigned int set_mask, unsigned int clear_mask) {
+  uint32_t set = 0, clear = 0;
+  int pin;
+
+  for (pin = 0; pin < NUM_PINS; pin++) {
+    if (set_mask & (1U << pin)) {
+      set |= 1U << wiringpi_to_bcm[pin];
+    } else if (clear_mask & (1U << pin)) {
+      clear |= 1U << wiringpi_to_bcm[pin];
+    }
+  }
+  mmap_write_bcm_mask(set, clear);
+}
+
+/**
+ * Read the level register, bit n is BCM gpio n.
+ */
+unsigned int mmap_read_raw_bank(void) {
+  return gpio_registers[GPLEV0];
+}
+
+/**
+ * Write the masks of BCM gpios with one store to the set and the clear
+ * register.
+ */
+void mmap_write_raw_bank(unsigned int set_mask, unsigned int clear_mask) {
+  mmap_write_bcm_mask(set_mask, clear_mask);
+}
+
+/**
+ * \brief Edge detection thread.
+ *
+ * The registers have no interrupt for user space, so one thread samples
+ * the level register for all pins and calls the callbacks of changed pins.
+ *
+ * @param arg unused
+ */
+void *mmap_poll_thread(void *arg) {
+  struct timespec ts = { 0, MMAP_POLL_INTERVAL_US * 1000 };
+  MmapIsr isrs[MAX_INTERRUPTS];
+  uint32_t last, levels, changed;
+  unsigned long long now;
+  int i, count, bcm, level;
+
+  trace_name_thread("mmap poll");
+  last = gpio_registers[GPLEV0];
+  while (1) {
+    nanosleep(&ts, NULL);
+    levels  = gpio_registers[GPLEV0];
+    changed = levels ^ last;
+    last    = levels;
+    if (!changed) {
+      continue;
+    }
+    now = get_monotonic_ns();
+    pthread_mutex_lock(&mmap_lock);
+    count = mmap_isr_count;
+    memcpy(isrs, mmap_isrs, sizeof(MmapIsr) * count);
+    pthread_mutex_unlock(&mmap_lock);
+    for (i = 0; i < count; i++) {
+      bcm = wiringpi_to_bcm[isrs[i].pin];
+      if (!(changed & (1U << bcm))) {
+        continue;
+      }
+      level = (levels >> bcm) & 1;
+      if (isrs[i].edge == INT_EDGE_BOTH
+          || (isrs[i].edge == INT_EDGE_RISING && level)
+          || (isrs[i].edge == INT_EDGE_FALLING && !level)) {
+        isrs[i].callback(isrs[i].id, level, now);
+      }
+    }
+  }
+  return NULL;
+}
+
+int mmap_isr(int pin, int edge, int id, BackendEdgeCallback callback) {
+  pthread_t thread;
+  int i;
+
+  if (mmap_bcm(pin) == -1) {
+    return -1;
+  }
+  pthread_mutex_lock(&mmap_lock);
+  for (i = 0; i < mmap_isr_count; i++) {
+    if (mmap_isrs[i].id == id) {
+      break;
+    }
+  }
+  if (i == MAX_INTERRUPTS) {
+    pthread_mutex_unlock(&mmap_lock);
+    return -1;
+  }
+  if (i == mmap_isr_count) {
+    mmap_isr_count++;
+  }
+  mmap_isrs[i].pin      = pin;
+  mmap_isrs[i].edge     = edge;
+  mmap_isrs[i].id       = id;
+  mmap_isrs[i].callback = callback;
+  if (!mmap_poll_running) {
+    if ((errno = pthread_create(&thread, NULL, mmap_poll_thread, NULL)) != 0) {
+      log_msg(LOG_MOD_GPIO, LOG_ERR, "pthread_create: %m");
+      pthread_mutex_unlock(&mmap_lock);
+      return -1;
+    }
+    pthread_detach(thread);
+    mmap_poll_running = 1;
+  }
+  pthread_mutex_unlock(&mmap_lock);
+
+  return 0;
+}
+
+GpioBackend mmap_backend = {
+  .name          = "mmap",
+  .setup         = mmap_setup,
+  .pin_mode      = mmap_pin_mode,
+  .digital_read  = mmap_digital_read,
+  .digital_write = mmap_digital_write,
+  .pull_up_dn    = mmap_pull_up_dn,
+  .isr           = mmap_isr,
+  .pin_to_gpio   = mmap_pin_to_gpio,
+  .read_bank     = mmap_read_bank,
+  .write_bank    = mmap_write_bank,
+  .read_raw_bank  = mmap_read_raw_bank,
+  .write_raw_bank = mmap_write_raw_bank,
+};
@@ -0,0 +1,170 @@
+/*
+ * backend_mock.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "gpiod.h"
+#include "backend.h"
+
+/**
+ * \brief Number of pins of the mock.
+ */
+#define MOCK_PINS 32
+
+typedef struct MockIsr {
+  int pin;
+  int edge;
+  int id;
+  BackendEdgeCallback callback;
+} MockIsr;
+
+static int mock_levels[MOCK_PINS];
+static int mock_modes[MOCK_PINS];
+static MockIsr mock_isrs[MAX_INTERRUPTS];
+static int mock_isr_count = 0;
+static pthread_mutex_t mock_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Init the pins like the wiringPi mock, odd pins are high.
+ */
+int mock_setup(const char *device) {
+  int pin;
+
+  for (pin = 0; pin < MOCK_PINS; pin++) {
+    mock_levels[pin] = pin % 2;
+    mock_modes[pin]  = INPUT;
+  }
+  return 0;
+}
+
+void mock_pin_mode(int pin, int mode) {
+  if (pin >= 0 && pin < MOCK_PINS) {
+    mock_modes[pin] = mode;
+  }
+}
+
+int mock_digital_read(int pin) {
+  if (pin < 0 || pin >= MOCK_PINS) {
+    return 0;
+  }
+  return mock_levels[pin];
+}
+
+void mock_digital_write(int pin, int value) {
+  mock_backend_set_level(pin, value);
+}
+
+/**
+ * A pwm pin reads high from half the duty on.
+ */
+void mock_pwm_write(int pin, unsigned int duty) {
+  mock_pin_mode(pin, PWM_OUTPUT);
+  mock_backend_set_level(pin, duty >= PWM_RANGE / 2);
+}
+
+void mock_pull_up_dn(int pin, int pud) {
+}
+
+int mock_pin_to_gpio(int pin) {
+  return pin & 63;
+}
+
+int mock_isr(int pin, int edge, int id, BackendEdgeCallback callback) {
+  int i;
+
+  pthread_mutex_lock(&mock_lock);
+  for (i = 0; i < mock_isr_count; i++) {
+    if (mock_isrs[i].id == id) {
+      break;
+    }
+  }
+  if (i == MAX_INTERRUPTS) {
+    pthread_mutex_unlock(&mock_lock);
+    return -1;
+  }
+  if (i == mock_isr_count) {
+    mock_isr_count++;
+  }
+  mock_isrs[i].pin      = pin;
+  mock_isrs[i].edge     = edge;
+  mock_isrs[i].id       = id;
+  mock_isrs[i].callback = callback;
+  pthread_mutex_unlock(&mock_lock);
+
+  return 0;
+}
+
+/**
+ * \brief Change the level of a mock pin.
+ *
+ * Registered isr callbacks of the pin are called like on a real edge.
+ *
+ * @param pin   The pin.
+ * @param level The new level.
+ */
+void mock_backend_set_level(int pin, int level) {
+  MockIsr fire[MAX_INTERRUPTS];
+  unsigned long long now;
+  int i, count = 0, old;
+
+  if (pin < 0 || pin >= MOCK_PINS) {
+    return;
+  }
+  pthread_mutex_lock(&mock_lock);
+  old = mock_levels[pin];
+  mock_levels[pin] = level ? 1 : 0;
+  if (old != mock_levels[pin]) {
+    for (i = 0; i < mock_isr_count; i++) {
+      if (mock_isrs[i].pin == pin
+          && (mock_isrs[i].edge == INT_EDGE_BOTH
+              || (mock_isrs[i].edge == INT_EDGE_RISING && level)
+              || (mock_isrs[i].edge == INT_EDGE_FALLING && !level))) {
+        fire[count++] = mock_isrs[i];
+      }
+    }
+  }
+  pthread_mutex_unlock(&mock_lock);
+
+  now = get_monotonic_ns();
+  for (i = 0; i < count; i++) {
+    fire[i].callback(fire[i].id, level ? 1 : 0, now);
+  }
+}
+
+/**
+ * \brief Execute a mock command.
+ *
+ * MOCK EDGE pin level, used to replay recorded edges.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ * @param buf              The command arguments.
+ */
+void do_mock_command(int client_socket_fd, char *buf) {
+  int pin, level;
+
+  if (sscanf(buf, MOCK_EDGE " %d %d", &pin, &level) != 2) {
+    write_error_msg_to_client(client_socket_fd, "expected MOCK EDGE <#pin> <0|1>");
+  } else if (gpio_backend != &mock_backend) {
+    write_error_msg_to_client(client_socket_fd, "mock commands need the mock backend");
+  } else if (pin < 0 || pin >= MOCK_PINS || !is_valid_pin_value(level)) {
+    write_error_msg_to_client(client_socket_fd, "unknown port number or value");
+  } else {
+    mock_backend_set_level(pin, level);
+    write_msg_to_client(client_socket_fd, "operation performed");
+  }
+}
+
+GpioBackend mock_backend = {
+  .name          = "mock",
+  .setup         = mock_setup,
+  .pin_mode      = mock_pin_mode,
+  .digital_read  = mock_digital_read,
+  .digital_write = mock_digital_write,
+  .pull_up_dn    = mock_pull_up_dn,
+  .isr           = mock_isr,
+  .pin_to_gpio   = mock_pin_to_gpio,
+  .read_bank     = generic_read_bank,
+  .write_bank    = generic_write_bank,
+  .pwm_write     = mock_pwm_write,
+};
@@ -0,0 +1,193 @@
+/*
+ * backend_wiringpi.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <softPwm.h>
+#include "gpiod.h"
+#include "backend.h"
+
+/**
+ * \brief wiringPi pin of the hardware pwm (BCM 18).
+ */
+#define WIRINGPI_PWM_PIN 1
+
+/**
+ * \brief Range of the software pwm, 100 steps of 100us.
+ */
+#define WIRINGPI_SOFT_PWM_RANGE 100
+
+/**
+ * \brief Registered isr of a slot.
+ *
+ * wiringPi calls the isr without arguments, so every slot has an own
+ * trampoline function.
+ */
+typedef struct WiringPiIsr {
+  int pin;
+  int id;
+  int edge;                     //> INT_EDGE_* of the slot, filtered by the trampoline.
+  int registered;               //> 1 if wiringPi runs the isr thread of the slot.
+  BackendEdgeCallback callback;
+} WiringPiIsr;
+
+static WiringPiIsr wiringpi_isrs[MAX_INTERRUPTS];
+static int wiringpi_pwm_mode[NUM_PINS]; /**< 1 if the pin is a pwm output */
+
+int wiringpi_setup(const char *device) {
+  return require_wiringpi();
+}
+
+void wiringpi_pin_mode(int pin, int mode) {
+  if (pin >= 0 && pin < NUM_PINS && wiringpi_pwm_mode[pin]) {
+    if (pin != WIRINGPI_PWM_PIN) {
+      softPwmStop(pin);
+    }
+    wiringpi_pwm_mode[pin] = 0;
+  }
+  pinMode(pin, mode);
+}
+
+int wiringpi_digital_read(int pin) {
+  return digitalRead(pin);
+}
+
+void wiringpi_digital_write(int pin, int value) {
+  digitalWrite(pin, value);
+}
+
+void wiringpi_pull_up_dn(int pin, int pud) {
+  pullUpDnControl(pin, pud);
+}
+
+/**
+ * Write the duty of a pwm pin.
+ *
+ * The hardware pwm pin uses the pwm of the soc, every other pin gets a
+ * software pwm thread of wiringPi with a coarser range.
+ */
+void wiringpi_pwm_write(int pin, unsigned int duty) {
+  if (pin < 0 || pin >= NUM_PINS) {
+    return;
+  }
+  if (pin == WIRINGPI_PWM_PIN) {
+    if (!wiringpi_pwm_mode[pin]) {
+      pinMode(pin, PWM_OUTPUT);
+      wiringpi_pwm_mode[pin] = 1;
+    }
+    pwmWrite(pin, duty);
+    return;
+  }
+  if (!wiringpi_pwm_mode[pin]) {
+    if (softPwmCreate(pin, 0, WIRINGPI_SOFT_PWM_RANGE) != 0) {
+      return;
+    }
+    wiringpi_pwm_mode[pin] = 1;
+  }
+  softPwmWrite(pin, duty * WIRINGPI_SOFT_PWM_RANGE / PWM_RANGE);
+}
+
+int wiringpi_pin_to_gpio(int pin) {
+  return wpiPinToGpio(pin);
+}
+
+/**
+ * Call the callback of the slot with level and time of the edge.
+ *
+ * @param slot The isr slot.
+ */
+void wiringpi_isr(int slot) {
+  WiringPiIsr *isr = &wiringpi_isrs[slot];
+  int level = digitalRead(isr->pin);
+
+  if ((isr->edge == INT_EDGE_RISING && !level) || (isr->edge == INT_EDGE_FALLING && level)) {
+    return;
+  }
+  isr->callback(isr->id, level, get_monotonic_ns());
+}
+
+void wiringpi_isr0(void) {
+  wiringpi_isr(0);
+}
+
+void wiringpi_isr1(void) {
+  wiringpi_isr(1);
+}
+
+void wiringpi_isr2(void) {
+  wiringpi_isr(2);
+}
+
+void wiringpi_isr3(void) {
+  wiringpi_isr(3);
+}
+
+void wiringpi_isr4(void) {
+  wiringpi_isr(4);
+}
+
+void wiringpi_isr5(void) {
+  wiringpi_isr(5);
+}
+
+void wiringpi_isr6(void) {
+  wiringpi_isr(6);
+}
+
+void wiringpi_isr7(void) {
+  wiringpi_isr(7);
+}
+
+void wiringpi_isr8(void) {
+  wiringpi_isr(8);
+}
+
+void wiringpi_isr9(void) {
+  wiringpi_isr(9);
+}
+
+static void (*wiringpi_trampolines[MAX_INTERRUPTS])(void) = {
+  wiringpi_isr0, wiringpi_isr1, wiringpi_isr2, wiringpi_isr3, wiringpi_isr4,
+  wiringpi_isr5, wiringpi_isr6, wiringpi_isr7, wiringpi_isr8, wiringpi_isr9
+};
+
+/**
+ * Register the isr with wiringPi. The id is used as slot.
+ *
+ * Every wiringPiISR call starts an own isr thread and a thread can't be
+ * stopped, so a slot is registered once for both edges and the trampoline
+ * filters the edge. A registered slot only gets the new edge and callback,
+ * a slot is only reused for the same pin.
+ */
+int wiringpi_register_isr(int pin, int edge, int id, BackendEdgeCallback callback) {
+  if (id < 0 || id >= MAX_INTERRUPTS) {
+    return -1;
+  }
+  wiringpi_isrs[id].pin      = pin;
+  wiringpi_isrs[id].id       = id;
+  wiringpi_isrs[id].edge     = edge;
+  wiringpi_isrs[id].callback = callback;
+  if (wiringpi_isrs[id].registered) {
+    return 0;
+  }
+  if (wiringPiISR(pin, INT_EDGE_BOTH, wiringpi_trampolines[id]) != 0) {
+    return -1;
+  }
+  wiringpi_isrs[id].registered = 1;
+  return 0;
+}
+
+GpioBackend wiringpi_backend = {
+  .name          = "wiringpi",
+  .setup         = wiringpi_setup,
+  .pin_mode      = wiringpi_pin_mode,
+  .digital_read  = wiringpi_digital_read,
+  .digital_write = wiringpi_digital_write,
+  .pull_up_dn    = wiringpi_pull_up_dn,
+  .isr           = wiringpi_register_isr,
+  .pin_to_gpio   = wiringpi_pin_to_gpio,
+  .read_bank     = generic_read_bank,
+  .write_bank    = generic_write_bank,
+  .pwm_write     = wiringpi_pwm_write,
+};
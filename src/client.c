@@ -0,0 +1,821 @@
+/*
+ * client.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "gpiod.h"
+#include "client.h"
+
+Client clients[MAX_CLIENTS];
+pthread_mutex_t clients_lock = PTHREAD_MUTEX_INITIALIZER; /**< guard the client table */
+
+static int event_default_max        = EVENT_BATCH_MAX; /**< batch size of new clients */
+static int event_default_latency_ms = 0;               /**< batch latency of new clients */
+static int event_default_aggregate  = 0;               /**< aggregation of new clients */
+static unsigned long event_records  = 0; /**< count of written event records */
+static unsigned long event_writes   = 0; /**< count of event writes */
+static size_t output_high_water     = OUTPUT_HIGH_WATER; /**< queue limit of a client */
+static OutputPolicy output_policy   = OUTPUT_DROP;
+static unsigned long output_queued  = 0; /**< count of writes queued for a slow client */
+static unsigned long output_dropped = 0; /**< count of writes dropped by the policy */
+static unsigned long output_dropped_bytes = 0;
+static unsigned long output_disconnects   = 0;
+static size_t output_max_len        = 0; /**< longest output queue */
+static int wakeup_pipe[2] = { -1, -1 };  /**< wakes the socket thread for queued output */
+
+/**
+ * Start the event delivery of a new client with the defaults.
+ */
+static void init_event_batch(EventBatch *batch) {
+  batch->max        = event_default_max;
+  batch->latency_ms = event_default_latency_ms;
+  batch->aggregate  = event_default_aggregate;
+  batch->prefix_event = 0;
+  batch->count      = 0;
+}
+
+/**
+ * Free the client slot and close the socket. clients_lock must be held.
+ *
+ * @param client The client to free.
+ */
+void free_client(Client *client) {
+  close(client->fd);
+  free(client->out);
+  client->fd       = -1;
+  client->closing  = 0;
+  client->pending  = 0;
+  client->len      = 0;
+  client->out      = NULL;
+  client->out_len  = 0;
+  client->out_size = 0;
+  client->disconnected = 0;
+  client->packet   = 0;
+}
+
+/**
+ * \brief Init the client table.
+ */
+void init_clients() {
+  int i;
+
+  for (i = 0; i < MAX_CLIENTS; i++) {
+    clients[i].fd       = -1;
+    clients[i].closing  = 0;
+    clients[i].pending  = 0;
+    clients[i].len      = 0;
+    clients[i].out      = NULL;
+    clients[i].out_len  = 0;
+    clients[i].out_size = 0;
+    clients[i].disconnected = 0;
+    clients[i].packet   = 0;
+  }
+  if (pipe(wakeup_pipe) == -1) {
+    log_msg(LOG_MOD_CLIENT, LOG_ERR, "pipe: %m");
+    flush_log();
+    exit(EXIT_FAILURE);
+  }
+  fcntl(wakeup_pipe[0], F_SETFL, O_NONBLOCK);
+  fcntl(wakeup_pipe[1], F_SETFL, O_NONBLOCK);
+}
+
+/**
+ * \brief Add a new connected client.
+ *
+ * @param fd     The socket of the client.
+ * @param packet 1 for a SOCK_SEQPACKET client.
+ *
+ * @return 0 or -1 if the table is full.
+ */
+int add_client(int fd, int packet) {
+  int i;
+
+  pthread_mutex_lock(&clients_lock);
+  for (i = 0; i < MAX_CLIENTS; i++) {
+    if (clients[i].fd == -1) {
+      clients[i].fd      = fd;
+      clients[i].closing = 0;
+      clients[i].pending = 0;
+      clients[i].len     = 0;
+      clients[i].packet  = packet;
+      clients[i].tags_begin = 0;
+      init_event_batch(&clients[i].events);
+      pthread_mutex_unlock(&clients_lock);
+      return 0;
+    }
+  }
+  pthread_mutex_unlock(&clients_lock);
+
+  return -1;
+}
+
+/**
+ * \brief Find the client of the socket.
+ *
+ * @param fd The socket of the client.
+ *
+ * @return The client or NULL.
+ */
+Client *find_client(int fd) {
+  int i;
+
+  for (i = 0; i < MAX_CLIENTS; i++) {
+    if (clients[i].fd == fd) {
+      return &clients[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * \brief Check if the client is connected to the packet socket.
+ *
+ * @param fd The socket of the client.
+ *
+ * @return 1 for a SOCK_SEQPACKET client, otherwise 0.
+ */
+int is_packet_client(int fd) {
+  Client *client;
+  int packet = 0;
+
+  pthread_mutex_lock(&clients_lock);
+  client = find_client(fd);
+  if (client != NULL) {
+    packet = client->packet;
+  }
+  pthread_mutex_unlock(&clients_lock);
+
+  return packet;
+}
+
+/**
+ * \brief Close the client.
+ *
+ * The socket is closed after the last queued command of the client is
+ * executed and its output is written, so the client gets all answers.
+ *
+ * @param fd The socket of the client.
+ */
+void close_client(int fd) {
+  Client *client;
+
+  pthread_mutex_lock(&clients_lock);
+  client = find_client(fd);
+  if (client != NULL) {
+    if (client->pending == 0 && client->out_len == 0) {
+      free_client(client);
+    } else {
+      client->closing = 1;
+    }
+  }
+  pthread_mutex_unlock(&clients_lock);
+}
+
+/**
+ * \brief Mark a command of the client as queued.
+ *
+ * @param fd The socket of the client.
+ */
+void hold_client(int fd) {
+  Client *client;
+
+  pthread_mutex_lock(&clients_lock);
+  client = find_client(fd);
+  if (client != NULL) {
+    client->pending++;
+  }
+  pthread_mutex_unlock(&clients_lock);
+}
+
+/**
+ * \brief Mark a queued command of the client as done.
+ *
+ * @param fd The socket of the client.
+ */
+void release_client(int fd) {
+  Client *client;
+
+  pthread_mutex_lock(&clients_lock);
+  client = find_client(fd);
+  if (client != NULL) {
+    client->pending--;
+    if (client->closing && client->pending == 0 && client->out_len == 0) {
+      free_client(client);
+    }
+  }
+  pthread_mutex_unlock(&clients_lock);
+}
+
+/**
+ * \brief Fill poll entries with all clients to read from or to write to.
+ *
+ * A closing client is only polled to write its queued output.
+ *
+ * @param fds Array for the poll entries.
+ * @param max Size of fds.
+ *
+ * @return Count of filled entries.
+ */
+int get_client_pollfds(struct pollfd *fds, int max) {
+  int i, n = 0;
+
+  pthread_mutex_lock(&clients_lock);
+  for (i = 0; i < MAX_CLIENTS && n < max; i++) {
+    if (clients[i].fd != -1 && (!clients[i].closing || clients[i].out_len > 0)) {
+      fds[n].fd      = clients[i].fd;
+      fds[n].events  = (clients[i].closing ? 0 : POLLIN) | (clients[i].out_len > 0 ? POLLOUT : 0);
+      fds[n].revents = 0;
+      n++;
+    }
+  }
+  pthread_mutex_unlock(&clients_lock);
+
+  return n;
+}
+
+/**
+ * \brief The pipe to poll for queued output of other threads.
+ */
+int get_client_wakeup_fd() {
+  return wakeup_pipe[0];
+}
+
+/**
+ * \brief Empty the wakeup pipe.
+ */
+void clear_client_wakeup() {
+  char buf[64];
+
+  while (read(wakeup_pipe[0], buf, sizeof(buf)) > 0);
+}
+
+/**
+ * Disconnect a client that does not read its output. clients_lock must
+ * be held.
+ *
+ * The socket is shut down, the socket thread closes it like a client that
+ * closed the connection.
+ */
+static void disconnect_client(Client *client) {
+  client->disconnected = 1;
+  client->out_len      = 0;
+  shutdown(client->fd, SHUT_RDWR);
+  output_disconnects++;
+}
+
+/**
+ * Write to the socket of the client or queue the output if the socket
+ * does not take it. clients_lock must be held.
+ *
+ * A write is never split by the policy: the rest of a partly written
+ * write is always queued, a write above the high water mark is dropped
+ * or disconnects the client.
+ *
+ * A packet socket takes a write as a whole or not at all, a queued write
+ * keeps its length in a PacketHeader to be written as one packet again.
+ */
+static void queue_output(Client *client, const char *buf, size_t len) {
+  PacketHeader header = len;
+  size_t header_len = client->packet ? sizeof(header) : 0;
+  ssize_t n = 0;
+  size_t size;
+  char *out;
+
+  if (client->disconnected) {
+    return;
+  }
+  if (client->out_len == 0) {
+    n = write(client->fd, buf, len);
+    if (n == (ssize_t) len) {
+      return;
+    }
+    if (n == -1) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        // The client is gone, the socket thread closes it.
+        return;
+      }
+      n = 0;
+    }
+  }
+  if (n == 0 && client->out_len + len > output_high_water) {
+    if (output_policy == OUTPUT_DISCONNECT) {
+      disconnect_client(client);
+    } else {
+      output_dropped++;
+      output_dropped_bytes += len;
+    }
+    return;
+  }
+  buf += n;
+  len -= n;
+  if (client->out_len + header_len + len > client->out_size) {
+    size = client->out_size ? client->out_size : BUFFER_SIZE * 8;
+    while (size < client->out_len + header_len + len) {
+      size *= 2;
+    }
+    if ((out = realloc(client->out, size)) == NULL) {
+      output_dropped++;
+      output_dropped_bytes += len;
+      return;
+    }
+    client->out      = out;
+    client->out_size = size;
+  }
+  if (client->out_len == 0) {
+    // The socket thread polls the client for POLLOUT from now on.
+    write(wakeup_pipe[1], "w", 1);
+  }
+  memcpy(client->out + client->out_len, &header, header_len);
+  client->out_len += header_len;
+  memcpy(client->out + client->out_len, buf, len);
+  client->out_len += len;
+  output_queued++;
+  if (client->out_len > output_max_len) {
+    output_max_len = client->out_len;
+  }
+}
+
+/**
+ * \brief Write to a client.
+ *
+ * Never blocks, output the client does not read in time is queued and
+ * written by the socket thread.
+ *
+ * @param fd  The socket of the client.
+ * @param buf The data to write.
+ * @param len Length of the data.
+ */
+void write_client_output(int fd, const char *buf, size_t len) {
+  Client *client;
+
+  pthread_mutex_lock(&clients_lock);
+  client = find_client(fd);
+  if (client != NULL) {
+    queue_output(client, buf, len);
+  } else {
+    // Not in the client table, e.g. rejected with too many clients.
+    write(fd, buf, len);
+  }
+  pthread_mutex_unlock(&clients_lock);
+}
+
+/**
+ * Write the queued packets of a packet client. clients_lock must be held.
+ */
+static void flush_client_packets(Client *client) {
+  PacketHeader header;
+  size_t done = 0;
+  ssize_t n;
+
+  while (done < client->out_len) {
+    memcpy(&header, client->out + done, sizeof(header));
+    n = write(client->fd, client->out + done + sizeof(header), header);
+    if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    }
+    // A failed packet is gone like a failed write of a stream.
+    done += sizeof(header) + header;
+  }
+  client->out_len -= done;
+  memmove(client->out, client->out + done, client->out_len);
+}
+
+/**
+ * \brief Write the queued output of a writable client.
+ *
+ * A closing client is freed after its last output.
+ *
+ * @param fd The socket of the client.
+ */
+void flush_client_output(int fd) {
+  Client *client;
+  ssize_t n;
+
+  pthread_mutex_lock(&clients_lock);
+  client = find_client(fd);
+  if (client != NULL && client->out_len > 0) {
+    if (client->packet) {
+      flush_client_packets(client);
+    } else if ((n = write(fd, client->out, client->out_len)) > 0) {
+      client->out_len -= n;
+      memmove(client->out, client->out + n, client->out_len);
+    } else if (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
+      client->out_len = 0;
+    }
+    if (client->out_len == 0 && client->closing && client->pending == 0) {
+      free_client(client);
+    }
+  }
+  pthread_mutex_unlock(&clients_lock);
+}
+
+/**
+ * \brief Set the output queue limit and policy.
+ *
+ * @param high_water Queue limit in bytes or -1 to keep it.
+ * @param policy     OutputPolicy or -1 to keep it.
+ */
+void set_output_policy(int high_water, int policy) {
+  pthread_mutex_lock(&clients_lock);
+  if (high_water != -1) {
+    output_high_water = high_water;
+  }
+  if (policy != -1) {
+    output_policy = policy;
+  }
+  pthread_mutex_unlock(&clients_lock);
+}
+
+/**
+ * \brief Get the output policy of a name.
+ *
+ * @param name "drop" or "disconnect".
+ *
+ * @return The OutputPolicy or -1 for an unknown name.
+ */
+int parse_output_policy(const char *name) {
+  if (strcmp(name, "drop") == 0) {
+    return OUTPUT_DROP;
+  } else if (strcmp(name, "disconnect") == 0) {
+    return OUTPUT_DISCONNECT;
+  }
+  return -1;
+}
+
+/**
+ * \brief Write the output queue statistics.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ */
+void do_write_output_stats(int client_socket_fd) {
+  char msg[BUFFER_SIZE];
+  unsigned long queued, dropped, dropped_bytes, disconnects;
+  size_t max_len;
+
+  pthread_mutex_lock(&clients_lock);
+  queued        = output_queued;
+  dropped       = output_dropped;
+  dropped_bytes = output_dropped_bytes;
+  disconnects   = output_disconnects;
+  max_len       = output_max_len;
+  pthread_mutex_unlock(&clients_lock);
+
+  snprintf(msg, BUFFER_SIZE, "output: %lu queued, %lu dropped (%lu bytes), %lu disconnects, max queue %lu bytes",
+      queued, dropped, dropped_bytes, disconnects, (unsigned long) max_len);
+  write_msg_to_client(client_socket_fd, msg);
+}
+
+/**
+ * \brief Write to all connected clients.
+ *
+ * @param buf The data to write.
+ * @param len Length of the data.
+ */
+void broadcast_to_clients(const char *buf, size_t len) {
+  int i;
+
+  pthread_mutex_lock(&clients_lock);
+  for (i = 0; i < MAX_CLIENTS; i++) {
+    if (clients[i].fd != -1 && !clients[i].closing) {
+      queue_output(&clients[i], buf, len);
+    }
+  }
+  pthread_mutex_unlock(&clients_lock);
+}
+
+/**
+ * \brief Write event lines to a client with one write.
+ *
+ * Every line gets the event prefix of the client, "EVENT - " or "OK - ".
+ *
+ * @param fd    The socket of the client.
+ * @param lines The lines, every line ends with a newline.
+ * @param len   Length of the lines.
+ */
+void write_client_events(int fd, const char *lines, size_t len) {
+  Client *client;
+  const char *prefix, *line = lines, *newline;
+  char *out;
+  size_t out_len = 0, count = 0, i;
+
+  for (i = 0; i < len; i++) {
+    count += lines[i] == '\n';
+  }
+  if ((out = malloc(len + count * (strlen(SERVER_EVENT) + 3))) == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&clients_lock);
+  client = find_client(fd);
+  if (client != NULL && !client->closing) {
+    prefix = client->events.prefix_event ? SERVER_EVENT : SERVER_OK;
+    while (line < lines + len && (newline = memchr(line, '\n', lines + len - line)) != NULL) {
+      out_len += sprintf(out + out_len, "%s - ", prefix);
+      memcpy(out + out_len, line, newline - line + 1);
+      out_len += newline - line + 1;
+      line = newline + 1;
+    }
+    queue_output(client, out, out_len);
+  }
+  pthread_mutex_unlock(&clients_lock);
+  free(out);
+}
+
+/**
+ * \brief Split the tag from a command line.
+ *
+ * A tag is # and up to REPLY_TAG_SIZE - 2 letters, digits, _ or -,
+ * followed by a space or the end of the line.
+ *
+ * @param line The command line.
+ * @param tag  Buffer of REPLY_TAG_SIZE for the tag, empty if not tagged.
+ *
+ * @return The command without tag or NULL if the tag is invalid.
+ */
+char *split_request_tag(char *line, char *tag) {
+  size_t len;
+
+  tag[0] = '\0';
+  if (line[0] != '#') {
+    return line;
+  }
+  len = strspn(line + 1, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-") + 1;
+  if (len == 1 || len > REPLY_TAG_SIZE - 1 || (line[len] != ' ' && line[len] != '\0')) {
+    return NULL;
+  }
+  memcpy(tag, line, len);
+  tag[len] = '\0';
+  line += len;
+  while (*line == ' ') {
+    line++;
+  }
+  return line;
+}
+
+/**
+ * \brief Set the event delivery of new clients.
+ *
+ * A value of -1 keeps the current default.
+ *
+ * @param max        Records per write, 1 to EVENT_BATCH_MAX.
+ * @param latency_ms Longest wait of a record.
+ * @param aggregate  1 to merge repeated events.
+ */
+void set_event_defaults(int max, int latency_ms, int aggregate) {
+  pthread_mutex_lock(&clients_lock);
+  if (max != -1) {
+    event_default_max = max;
+  }
+  if (latency_ms != -1) {
+    event_default_latency_ms = latency_ms;
+  }
+  if (aggregate != -1) {
+    event_default_aggregate = aggregate;
+  }
+  pthread_mutex_unlock(&clients_lock);
+}
+
+/**
+ * Write the records of the batch with one write. clients_lock must be held.
+ */
+static void flush_event_batch(Client *client) {
+  EventBatch *batch = &client->events;
+  char buf[EVENT_BATCH_MAX * BUFFER_SIZE];
+  const char *prefix = batch->prefix_event ? SERVER_EVENT : SERVER_OK;
+  unsigned long long trace_ns = trace_begin();
+  size_t len = 0;
+  int r;
+
+  for (r = 0; r < batch->count; r++) {
+    if (batch->records[r].count > 1) {
+      len += snprintf(buf + len, sizeof(buf) - len, "%s - %s x%u since %llu\n", prefix,
+          batch->records[r].name, batch->records[r].count, batch->records[r].first_ns);
+    } else {
+      len += snprintf(buf + len, sizeof(buf) - len, "%s - %s\n", prefix, batch->records[r].name);
+    }
+  }
+  queue_output(client, buf, len);
+  event_records += batch->count;
+  event_writes++;
+  trace_end(TRACE_EVENT_FLUSH, trace_ns, batch->count);
+  batch->count = 0;
+}
+
+/**
+ * \brief Add an event to the batches of all clients.
+ *
+ * A full batch is written at once, the other batches are written by
+ * flush_client_events.
+ *
+ * @param name      The event name.
+ * @param queued_ns Monotonic time of the event.
+ */
+void queue_client_events(const char *name, unsigned long long queued_ns) {
+  EventBatch *batch;
+  EventRecord *record;
+  int i, r;
+
+  pthread_mutex_lock(&clients_lock);
+  for (i = 0; i < MAX_CLIENTS; i++) {
+    if (clients[i].fd == -1 || clients[i].closing) {
+      continue;
+    }
+    batch = &clients[i].events;
+    record = NULL;
+    if (batch->aggregate) {
+      for (r = 0; r < batch->count; r++) {
+        if (strncmp(batch->records[r].name, name, EVENT_NAME_SIZE - 1) == 0) {
+          record = &batch->records[r];
+          record->count++;
+          break;
+        }
+      }
+    }
+    if (record == NULL) {
+      record = &batch->records[batch->count++];
+      snprintf(record->name, EVENT_NAME_SIZE, "%s", name);
+      record->count    = 1;
+      record->first_ns = queued_ns;
+    }
+    if (batch->count >= batch->max) {
+      flush_event_batch(&clients[i]);
+    }
+  }
+  pthread_mutex_unlock(&clients_lock);
+}
+
+/**
+ * \brief Write the batches of all clients which waited long enough.
+ *
+ * @param now_ns The monotonic time.
+ *
+ * @return Monotonic time of the next due batch or 0 if no batch waits.
+ */
+unsigned long long flush_client_events(unsigned long long now_ns) {
+  unsigned long long due, next = 0;
+  int i;
+
+  pthread_mutex_lock(&clients_lock);
+  for (i = 0; i < MAX_CLIENTS; i++) {
+    if (clients[i].fd == -1 || clients[i].events.count == 0) {
+      continue;
+    }
+    due = clients[i].events.records[0].first_ns + clients[i].events.latency_ms * 1000000ULL;
+    if (due <= now_ns || clients[i].closing) {
+      flush_event_batch(&clients[i]);
+    } else if (next == 0 || due < next) {
+      next = due;
+    }
+  }
+  pthread_mutex_unlock(&clients_lock);
+
+  return next;
+}
+
+/**
+ * \brief Negotiate the event delivery of the client.
+ *
+ * EVENTS shows the delivery, EVENTS IMMEDIATE writes every event at once,
+ * EVENTS BATCH max latency_ms batches the events and EVENTS AGGREGATE ON|OFF
+ * merges repeated events of a source into one "name xN since t" record.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ * @param buf              The command arguments.
+ */
+void do_events(int client_socket_fd, char *buf) {
+  Client *client;
+  char mode[16], msg[BUFFER_SIZE];
+  int max, latency_ms, aggregate, prefix_event, n;
+  char *error = NULL;
+
+  pthread_mutex_lock(&clients_lock);
+  if ((client = find_client(client_socket_fd)) == NULL) {
+    pthread_mutex_unlock(&clients_lock);
+    return;
+  }
+  n = sscanf(buf, "%15s %d %d", mode, &max, &latency_ms);
+  if (n < 1) {
+    // Show the delivery.
+  } else if (strcmp(mode, "IMMEDIATE") == 0) {
+    client->events.max        = 1;
+    client->events.latency_ms = 0;
+    client->events.aggregate  = 0;
+  } else if (strcmp(mode, "BATCH") == 0) {
+    if (n != 3) {
+      error = "expected EVENTS BATCH <max> <latency_ms>";
+    } else if (max < 1 || max > EVENT_BATCH_MAX) {
+      error = "batch must be between 1 and 64";
+    } else if (latency_ms < 0 || latency_ms > EVENT_LATENCY_MAX_MS) {
+      error = "latency must be between 0 and 10000 ms";
+    } else {
+      client->events.max        = max;
+      client->events.latency_ms = latency_ms;
+    }
+  } else if (strcmp(mode, "AGGREGATE") == 0) {
+    n = sscanf(buf, "%*s %15s", mode);
+    if (n == 1 && (strcmp(mode, "ON") == 0 || strcmp(mode, "OFF") == 0)) {
+      client->events.aggregate = strcmp(mode, "ON") == 0;
+    } else {
+      error = "expected EVENTS AGGREGATE <ON|OFF>";
+    }
+  } else if (strcmp(mode, "PREFIX") == 0) {
+    n = sscanf(buf, "%*s %15s", mode);
+    if (n == 1 && (strcmp(mode, SERVER_EVENT) == 0 || strcmp(mode, SERVER_OK) == 0)) {
+      client->events.prefix_event = strcmp(mode, SERVER_EVENT) == 0;
+    } else {
+      error = "expected EVENTS PREFIX <EVENT|OK>";
+    }
+  } else {
+    error = "expected EVENTS [IMMEDIATE|BATCH|AGGREGATE|PREFIX]";
+  }
+  if (client->events.count >= client->events.max) {
+    flush_event_batch(client);
+  }
+  max        = client->events.max;
+  latency_ms = client->events.latency_ms;
+  aggregate  = client->events.aggregate;
+  prefix_event = client->events.prefix_event;
+  pthread_mutex_unlock(&clients_lock);
+
+  if (error != NULL) {
+    write_error_msg_to_client(client_socket_fd, error);
+    return;
+  }
+  snprintf(msg, BUFFER_SIZE, "events batch %d, latency %d ms, aggregate %s, prefix %s",
+      max, latency_ms, aggregate ? "on" : "off", prefix_event ? SERVER_EVENT : SERVER_OK);
+  write_msg_to_client(client_socket_fd, msg);
+}
+
+/**
+ * \brief Check if the client wants "#id BEGIN" before a multi line answer.
+ *
+ * @param fd The socket of the client.
+ */
+int client_tags_begin(int fd) {
+  Client *client;
+  int begin;
+
+  pthread_mutex_lock(&clients_lock);
+  client = find_client(fd);
+  begin  = client != NULL && client->tags_begin;
+  pthread_mutex_unlock(&clients_lock);
+  return begin;
+}
+
+/**
+ * \brief Negotiate the answers of tagged commands.
+ *
+ * TAGS shows the setting, TAGS BEGIN ON starts every tagged multi line
+ * answer with "#id BEGIN", so a client knows the answer ends with
+ * "#id END" without a list of the commands.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ * @param buf              The command arguments.
+ */
+void do_tags(int client_socket_fd, char *buf) {
+  Client *client;
+  char mode[16], value[16], msg[BUFFER_SIZE];
+  int begin, n;
+  char *error = NULL;
+
+  pthread_mutex_lock(&clients_lock);
+  if ((client = find_client(client_socket_fd)) == NULL) {
+    pthread_mutex_unlock(&clients_lock);
+    return;
+  }
+  n = sscanf(buf, "%15s %15s", mode, value);
+  if (n < 1) {
+    // Show the setting.
+  } else if (n == 2 && strcmp(mode, "BEGIN") == 0 && (strcmp(value, "ON") == 0 || strcmp(value, "OFF") == 0)) {
+    client->tags_begin = strcmp(value, "ON") == 0;
+  } else {
+    error = "expected TAGS [BEGIN ON|OFF]";
+  }
+  begin = client->tags_begin;
+  pthread_mutex_unlock(&clients_lock);
+
+  if (error != NULL) {
+    write_error_msg_to_client(client_socket_fd, error);
+    return;
+  }
+  snprintf(msg, BUFFER_SIZE, "tags begin %s", begin ? "on" : "off");
+  write_msg_to_client(client_socket_fd, msg);
+}
+
+/**
+ * \brief Write the event delivery statistics.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ */
+void do_write_event_stats(int client_socket_fd) {
+  char msg[BUFFER_SIZE];
+  unsigned long records, writes;
+
+  pthread_mutex_lock(&clients_lock);
+  records = event_records;
+  writes  = event_writes;
+  pthread_mutex_unlock(&clients_lock);
+
+  snprintf(msg, BUFFER_SIZE, "events: %lu records in %lu writes", records, writes);
+  write_msg_to_client(client_socket_fd, msg);
+}
@@ -0,0 +1,141 @@
+/*
+ * client.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef CLIENT_H_
+#define CLIENT_H_
+
+#include <poll.h>
+#include <stddef.h>
+
+/**
+ * \brief Maximal count of connected clients.
+ */
+#define MAX_CLIENTS 16
+
+/**
+ * \brief Size of the line buffer of a client.
+ *
+ * A command line longer than the buffer is rejected.
+ */
+#define CLIENT_BUFFER_SIZE 256
+
+/**
+ * \brief Pseudo file descriptor to write to all clients.
+ */
+#define CLIENT_BROADCAST -2
+
+/**
+ * \brief Maximal count of event records in a batch of a client.
+ */
+#define EVENT_BATCH_MAX 64
+
+/**
+ * \brief Longest latency of a batched event in milliseconds.
+ */
+#define EVENT_LATENCY_MAX_MS 10000
+
+/**
+ * \brief Maximal length of an event name in a record.
+ */
+#define EVENT_NAME_SIZE 64
+
+#define CLIENT_EVENTS "EVENTS"
+#define CLIENT_TAGS   "TAGS"
+
+/**
+ * \brief Default high water mark of the output queue of a client in bytes.
+ *
+ * Client sockets are non blocking. Output the client does not read in time
+ * is queued up to the high water mark, then the output policy applies.
+ */
+#define OUTPUT_HIGH_WATER     65536
+#define OUTPUT_HIGH_WATER_MIN 1024
+#define OUTPUT_HIGH_WATER_MAX 16777216
+
+typedef enum OutputPolicy {
+  OUTPUT_DROP = 0,   //> Drop writes above the high water mark, never a part of a write.
+  OUTPUT_DISCONNECT  //> Disconnect the client at the high water mark.
+} OutputPolicy;
+
+/**
+ * \brief Size of a request tag with the leading # and the terminating 0.
+ *
+ * A command line "#id command" is answered with "#id " before every
+ * answer line.
+ */
+#define REPLY_TAG_SIZE 18
+
+/**
+ * \brief Length header of a queued packet of a packet client.
+ */
+typedef unsigned int PacketHeader;
+
+/**
+ * \brief An event waiting in the batch of a client.
+ */
+typedef struct EventRecord {
+  char name[EVENT_NAME_SIZE];
+  unsigned int count;           //> Count of aggregated events.
+  unsigned long long first_ns;  //> Monotonic time of the first event.
+} EventRecord;
+
+/**
+ * \brief Event delivery of a client.
+ *
+ * The records are written with one write when the batch is full or the
+ * oldest record waited latency_ms.
+ */
+typedef struct EventBatch {
+  int max;                      //> Records per write, 1 writes every event at once.
+  int latency_ms;               //> Longest wait of a record.
+  int aggregate;                //> 1 to merge repeated events of the same source.
+  int prefix_event;             //> 1 writes "EVENT - name", otherwise "OK - name".
+  int count;                    //> Count of records.
+  EventRecord records[EVENT_BATCH_MAX];
+} EventBatch;
+
+typedef struct Client {
+  int fd;       //> Socket of the client or -1 if the slot is free.
+  int closing;  //> Client closed the connection, close after the last pending command.
+  int pending;  //> Count of queued or running commands of the client.
+  int len;      //> Used bytes in buf.
+  char buf[CLIENT_BUFFER_SIZE]; //> Incomplete command line.
+  EventBatch events;            //> Batched events of the client.
+  char *out;                    //> Output not yet taken by the socket.
+  size_t out_len;               //> Used bytes in out.
+  size_t out_size;              //> Size of out.
+  int disconnected;             //> 1 if disconnected by the output policy.
+  int packet;                   //> 1 for a SOCK_SEQPACKET client, out holds PacketHeader and packet.
+  int tags_begin;               //> 1 starts a tagged multi line answer with "#id BEGIN".
+} Client;
+
+void init_clients();
+int add_client(int fd, int packet);
+int is_packet_client(int fd);
+Client *find_client(int fd);
+void close_client(int fd);
+void hold_client(int fd);
+void release_client(int fd);
+int get_client_pollfds(struct pollfd *fds, int max);
+void broadcast_to_clients(const char *buf, size_t len);
+void write_client_events(int fd, const char *lines, size_t len);
+void write_client_output(int fd, const char *buf, size_t len);
+void flush_client_output(int fd);
+int get_client_wakeup_fd();
+void clear_client_wakeup();
+void set_output_policy(int high_water, int policy);
+int parse_output_policy(const char *name);
+void do_write_output_stats(int client_socket_fd);
+char *split_request_tag(char *line, char *tag);
+void set_event_defaults(int max, int latency_ms, int aggregate);
+void queue_client_events(const char *name, unsigned long long queued_ns);
+unsigned long long flush_client_events(unsigned long long now_ns);
+void do_events(int client_socket_fd, char *buf);
+int client_tags_begin(int fd);
+void do_tags(int client_socket_fd, char *buf);
+void do_write_event_stats(int client_socket_fd);
+
+#endif /* CLIENT_H_ */
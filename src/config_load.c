@@ -12,16 +12,549 @@
 #include "config_load.h"
 #include "interrupt.h"
 
-void load_params(int argc, char **argv) {
+char *config_file_name = NULL; /**< config file given with -i, read again on reload */
+
+/**
+ * \brief Select the gpio backend.
+ *
+ * @param backend Backend name with optional device "name[:device]".
+ *
+ * @return 0 or -1 if the backend is unknown.
+ */
+int configure_backend(char *backend) {
+  char *device = strchr(backend, ':');
+
+  if (device != NULL) {
+    *device++ = '\0';
+    set_backend_device(device);
+  }
+  return select_backend(backend);
+}
+
+/**
+ * Get the edge of a config string.
+ *
+ * @return INT_EDGE_FALLING, INT_EDGE_RISING, INT_EDGE_BOTH or -1.
+ */
+int parse_edge(const char *edge) {
+  if (strncmp(edge, "falling", strlen("falling")) == 0) {
+    return INT_EDGE_FALLING;
+  } else if (strncmp(edge, "rising", strlen("rising")) == 0) {
+    return INT_EDGE_RISING;
+  } else if (strncmp(edge, "both", strlen("both")) == 0) {
+    return INT_EDGE_BOTH;
+  }
+  return -1;
+}
+
+/**
+ * Read the reflex rules of the config file.
+ *
+ * A rule pin without interrupt gets an interrupt without name, so the
+ * edges of the pin reach the rules without an event to the clients.
+ *
+ * @param setting      The rules list.
+ * @param gpiod_config The struct to fill.
+ */
+void read_config_rules(config_setting_t *setting, GpiodConfig *gpiod_config) {
+  config_setting_t *rule_setting;
+  char const *rule_edge, *rule_action;
+  InterruptInfo *interrupt_info;
+  Rule *rule;
+  int count, r, i, action, edge;
+
+  count = config_setting_length(setting);
+  if (count > MAX_RULES) {
+    count = MAX_RULES;
+  }
+  for (r = 0; r < count; r++) {
+    rule_setting = config_setting_get_elem(setting, r);
+    rule = &gpiod_config->rules[gpiod_config->rules_count];
+    if (!(config_setting_lookup_int(rule_setting, "pin", &rule->pin)
+        && config_setting_lookup_string(rule_setting, "action", &rule_action)
+        && config_setting_lookup_int(rule_setting, "target", &rule->target))) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "rule %d: pin, action and target expected", r);
+      continue;
+    }
+    if ((action = parse_rule_action(rule_action)) == -1) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "rule %d: unknown action %s", r, rule_action);
+      continue;
+    }
+    if (!is_valid_pin_num(rule->pin) || !is_valid_pin_num(rule->target)) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "rule %d: unknown port number", r);
+      continue;
+    }
+    edge = INT_EDGE_BOTH;
+    if (config_setting_lookup_string(rule_setting, "edge", &rule_edge) && (edge = parse_edge(rule_edge)) == -1) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "rule %d: unknown edge %s", r, rule_edge);
+      continue;
+    }
+    if (!config_setting_lookup_int(rule_setting, "value", &rule->value)) {
+      rule->value = 1;
+    }
+    if (!config_setting_lookup_int(rule_setting, "duration", &rule->duration)) {
+      rule->duration = 0;
+    }
+    if (action == RULE_PULSE && rule->duration <= 0) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "rule %d: pulse needs a duration", r);
+      continue;
+    }
+    rule->action = action;
+    rule->edge   = edge;
+    rule->value  = rule->value != 0;
+    gpiod_config->rules_count++;
+
+    for (i = 0; i < gpiod_config->interrupts_count; i++) {
+      if (gpiod_config->interrupts[i].pin == rule->pin) {
+        break;
+      }
+    }
+    if (i < gpiod_config->interrupts_count) {
+      if (gpiod_config->interrupts[i].type != INT_EDGE_BOTH && gpiod_config->interrupts[i].type != edge) {
+        log_msg(LOG_MOD_DAEMON, LOG_WARNING, "rule %d: interrupt of pin %d doesn't report the rule edge", r, rule->pin);
+      }
+      continue;
+    }
+    if (gpiod_config->interrupts_count == MAX_INTERRUPTS) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "rule %d: no free interrupt for pin %d", r, rule->pin);
+      continue;
+    }
+    interrupt_info = &gpiod_config->interrupts[gpiod_config->interrupts_count++];
+    interrupt_info->pin        = rule->pin;
+    interrupt_info->wait       = 0;
+    interrupt_info->type       = INT_EDGE_BOTH;
+    interrupt_info->name       = NULL;
+    interrupt_info->occure     = 0;
+    interrupt_info->pud        = PUD_OFF;
+    interrupt_info->debounce   = 0;
+    interrupt_info->active     = 1;
+    interrupt_info->registered = 0;
+  }
+}
+
+/**
+ * Read the serial engines of the config file.
+ *
+ * @param setting      The serial list.
+ * @param gpiod_config The struct to fill.
+ */
+void read_config_serial(config_setting_t *setting, GpiodConfig *gpiod_config) {
+  config_setting_t *serial_setting;
+  char const *serial_name, *serial_order;
+  SerialEngine *engine;
+  int count, r;
+
+  count = config_setting_length(setting);
+  if (count > MAX_SERIAL_ENGINES) {
+    count = MAX_SERIAL_ENGINES;
+  }
+  for (r = 0; r < count; r++) {
+    serial_setting = config_setting_get_elem(setting, r);
+    engine = &gpiod_config->serial[gpiod_config->serial_count];
+    if (!(config_setting_lookup_string(serial_setting, "name", &serial_name)
+        && config_setting_lookup_int(serial_setting, "data", &engine->data)
+        && config_setting_lookup_int(serial_setting, "clock", &engine->clock))) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "serial %d: name, data and clock expected", r);
+      continue;
+    }
+    if (!config_setting_lookup_int(serial_setting, "latch", &engine->latch)) {
+      engine->latch = -1;
+    }
+    if (!is_valid_pin_num(engine->data) || !is_valid_pin_num(engine->clock)
+        || (engine->latch != -1 && !is_valid_pin_num(engine->latch))) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "serial %d: unknown port number", r);
+      continue;
+    }
+    engine->msb_first = 1;
+    if (config_setting_lookup_string(serial_setting, "order", &serial_order)) {
+      engine->msb_first = strcmp(serial_order, "lsb") != 0;
+    }
+    if (!config_setting_lookup_int(serial_setting, "clock_idle", &engine->clock_idle)) {
+      engine->clock_idle = 0;
+    }
+    if (!config_setting_lookup_int(serial_setting, "delay_us", &engine->delay_us)) {
+      engine->delay_us = 0;
+    }
+    if (engine->delay_us < 0 || engine->delay_us > MAX_SERIAL_DELAY_US) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "serial %d: delay_us must be 0 to %d", r, MAX_SERIAL_DELAY_US);
+      continue;
+    }
+    engine->clock_idle  = engine->clock_idle != 0;
+    engine->data_output = -1;
+    engine->name        = strndup(serial_name, strlen(serial_name));
+    gpiod_config->serial_count++;
+  }
+}
+
+/**
+ * Read the pin groups of the config file.
+ *
+ * @param setting      The groups group, every member is a pin list.
+ * @param gpiod_config The struct to fill.
+ */
+void read_config_groups(config_setting_t *setting, GpiodConfig *gpiod_config) {
+  config_setting_t *group_setting;
+  PinGroup *group;
+  int count, r, i, pin;
+
+  count = config_setting_length(setting);
+  for (r = 0; r < count && gpiod_config->groups_count < MAX_GROUPS; r++) {
+    group_setting = config_setting_get_elem(setting, r);
+    group = &gpiod_config->groups[gpiod_config->groups_count];
+    group->count = config_setting_length(group_setting);
+    if (group->count < 1 || group->count > NUM_PINS) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "group %s: 1 to %d pins expected", config_setting_name(group_setting), NUM_PINS);
+      continue;
+    }
+    for (i = 0; i < group->count; i++) {
+      pin = config_setting_get_int_elem(group_setting, i);
+      if (!is_valid_pin_num(pin)) {
+        break;
+      }
+      group->pins[i] = pin;
+    }
+    if (i < group->count) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "group %s: unknown port number", config_setting_name(group_setting));
+      continue;
+    }
+    snprintf(group->name, GROUP_NAME_SIZE, "%s", config_setting_name(group_setting));
+    gpiod_config->groups_count++;
+  }
+}
+
+/**
+ * Read the pin aliases of the config file.
+ *
+ * @param setting      The aliases group, every member is a pin.
+ * @param gpiod_config The struct to fill.
+ */
+void read_config_aliases(config_setting_t *setting, GpiodConfig *gpiod_config) {
+  config_setting_t *alias_setting;
+  PinAlias *alias;
+  int count, r;
+
+  count = config_setting_length(setting);
+  for (r = 0; r < count && gpiod_config->aliases_count < MAX_ALIASES; r++) {
+    alias_setting = config_setting_get_elem(setting, r);
+    alias = &gpiod_config->aliases[gpiod_config->aliases_count];
+    alias->pin = config_setting_get_int(alias_setting);
+    if (!is_valid_pin_num(alias->pin)) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "alias %s: unknown port number", config_setting_name(alias_setting));
+      continue;
+    }
+    snprintf(alias->name, GROUP_NAME_SIZE, "%s", config_setting_name(alias_setting));
+    gpiod_config->aliases_count++;
+  }
+}
+
+/**
+ * Read the lcd widgets of the config file.
+ *
+ * @param setting      The widgets list.
+ * @param gpiod_config The struct to fill.
+ */
+void read_config_widgets(config_setting_t *setting, GpiodConfig *gpiod_config) {
+  config_setting_t *widget_setting;
+  char const *widget_type, *widget_text;
+  Widget *widget;
+  char *error;
+  int count, r, type, max;
+
+  count = config_setting_length(setting);
+  for (r = 0; r < count && gpiod_config->widgets_count < MAX_WIDGETS; r++) {
+    widget_setting = config_setting_get_elem(setting, r);
+    widget = &gpiod_config->widgets[gpiod_config->widgets_count];
+    memset(widget, 0, sizeof(Widget));
+    if (!(config_setting_lookup_string(widget_setting, "type", &widget_type)
+        && config_setting_lookup_int(widget_setting, "pin", &widget->pin)
+        && config_setting_lookup_int(widget_setting, "x", &widget->x)
+        && config_setting_lookup_int(widget_setting, "y", &widget->y)
+        && config_setting_lookup_int(widget_setting, "width", &widget->width))) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "widget %d: type, pin, x, y and width expected", r);
+      continue;
+    }
+    if ((type = parse_widget_type(widget_type)) == -1) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "widget %d: unknown type %s", r, widget_type);
+      continue;
+    }
+    widget->type = type;
+    config_setting_lookup_int(widget_setting, "height", &widget->height);
+    if (config_setting_lookup_int(widget_setting, "max", &max)) {
+      widget->max = max > 0 ? max : 0;
+    }
+    if (config_setting_lookup_string(widget_setting, "high", &widget_text)) {
+      snprintf(widget->high, WIDGET_TEXT_SIZE, "%s", widget_text);
+    }
+    if (config_setting_lookup_string(widget_setting, "low", &widget_text)) {
+      snprintf(widget->low, WIDGET_TEXT_SIZE, "%s", widget_text);
+    }
+    if ((error = check_widget(widget)) != NULL) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "widget %d: %s", r, error);
+      continue;
+    }
+    gpiod_config->widgets_count++;
+  }
+}
+
+/**
+ * \brief Read the config file.
+ *
+ * Parse the config file into the given config struct without touching the
+ * running daemon. So the same parser is used on startup and on reload.
+ *
+ * @param file_name    The config file to read.
+ * @param gpiod_config The struct to fill.
+ *
+ * @return 0 on success or -1 if the file could not be parsed.
+ */
+int read_config_file(const char *file_name, GpiodConfig *gpiod_config) {
   config_t cfg;
   config_setting_t *setting, *interrupt_setting;
-  char const *config_socket, *inter_name, *inter_type_string, *inter_pud;
-  char *config_file_name;
-  int ch, inter_pin, inter_type, inter_wait, r, pud;
-  int lcd_di, lcd_led, lcd_spics, read_config = 0;
+  char const *config_socket, *config_backend, *lcd_init, *lcd_sprites, *state_name, *output_policy, *log_target, *log_level, *inter_name, *inter_type_string, *inter_pud;
+  int inter_pin, inter_type, inter_wait, inter_debounce, r, pud, count, level;
   InterruptInfo *interrupt_info;
 
-  while ((ch = getopt(argc, argv, "dhvs:a:l:c:i:")) != -1) {
+  gpiod_config->socket           = NULL;
+  gpiod_config->packet_socket    = NULL;
+  gpiod_config->snapshot         = NULL;
+  gpiod_config->backend          = NULL;
+  gpiod_config->backend_device   = NULL;
+  gpiod_config->lcd_di           = -1;
+  gpiod_config->lcd_led          = -1;
+  gpiod_config->lcd_spics        = -1;
+  gpiod_config->lcd_eager_init   = -1;
+  gpiod_config->lcd_sprites      = NULL;
+  gpiod_config->lcd_widget_interval = -1;
+  gpiod_config->state_name       = NULL;
+  gpiod_config->state_refresh    = -1;
+  gpiod_config->event_batch      = -1;
+  gpiod_config->event_latency    = -1;
+  gpiod_config->event_aggregate  = -1;
+  gpiod_config->output_high_water = -1;
+  gpiod_config->output_policy    = -1;
+  gpiod_config->log_target       = NULL;
+  for (r = 0; r < LOG_MOD_COUNT; r++) {
+    gpiod_config->log_levels[r]  = -1;
+  }
+  gpiod_config->interrupts_count = 0;
+  gpiod_config->rules_count      = 0;
+  gpiod_config->serial_count     = 0;
+  gpiod_config->groups_count     = 0;
+  gpiod_config->aliases_count    = 0;
+  gpiod_config->widgets_count    = 0;
+
+  config_init(&cfg);
+  /* Read the config file and about on error */
+  if (!config_read_file(&cfg, file_name)) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "%s:%d - %s", file_name, config_error_line(&cfg), config_error_text(&cfg));
+    config_destroy(&cfg);
+    return -1;
+  }
+
+  if (config_lookup_string(&cfg, "socket", &config_socket)) {
+    gpiod_config->socket = strndup(config_socket, strlen(config_socket));
+  }
+  if (config_lookup_string(&cfg, "packet_socket", &config_socket)) {
+    gpiod_config->packet_socket = strndup(config_socket, strlen(config_socket));
+  }
+  if (config_lookup_string(&cfg, "snapshot", &config_socket)) {
+    gpiod_config->snapshot = strndup(config_socket, strlen(config_socket));
+  }
+
+  if (config_lookup_string(&cfg, "backend", &config_backend)) {
+    gpiod_config->backend = strndup(config_backend, strlen(config_backend));
+  }
+  if (config_lookup_string(&cfg, "backend_device", &config_backend)) {
+    gpiod_config->backend_device = strndup(config_backend, strlen(config_backend));
+  }
+
+  setting = config_lookup(&cfg, "lcd");
+
+  if (setting != NULL) {
+    config_setting_lookup_int(setting, "di_pin", &gpiod_config->lcd_di);
+    config_setting_lookup_int(setting, "led_pin", &gpiod_config->lcd_led);
+    config_setting_lookup_int(setting, "spi_cs", &gpiod_config->lcd_spics);
+    if (config_setting_lookup_string(setting, "init", &lcd_init)) {
+      gpiod_config->lcd_eager_init = strcmp(lcd_init, "eager") == 0;
+    }
+    if (config_setting_lookup_string(setting, "sprites", &lcd_sprites)) {
+      gpiod_config->lcd_sprites = strndup(lcd_sprites, strlen(lcd_sprites));
+    }
+    config_setting_lookup_int(setting, "widget_interval", &gpiod_config->lcd_widget_interval);
+  }
+
+  setting = config_lookup(&cfg, "state");
+
+  if (setting != NULL) {
+    if (config_setting_lookup_string(setting, "name", &state_name)) {
+      gpiod_config->state_name = strndup(state_name, strlen(state_name));
+    }
+    config_setting_lookup_int(setting, "refresh", &gpiod_config->state_refresh);
+  }
+
+  setting = config_lookup(&cfg, "events");
+
+  if (setting != NULL) {
+    config_setting_lookup_int(setting, "batch", &gpiod_config->event_batch);
+    config_setting_lookup_int(setting, "latency", &gpiod_config->event_latency);
+    config_setting_lookup_bool(setting, "aggregate", &gpiod_config->event_aggregate);
+    if (gpiod_config->event_batch != -1 && (gpiod_config->event_batch < 1 || gpiod_config->event_batch > EVENT_BATCH_MAX)) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "events: batch must be between 1 and %d", EVENT_BATCH_MAX);
+      gpiod_config->event_batch = -1;
+    }
+    if (gpiod_config->event_latency != -1 && (gpiod_config->event_latency < 0 || gpiod_config->event_latency > EVENT_LATENCY_MAX_MS)) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "events: latency must be between 0 and %d ms", EVENT_LATENCY_MAX_MS);
+      gpiod_config->event_latency = -1;
+    }
+  }
+
+  setting = config_lookup(&cfg, "output");
+
+  if (setting != NULL) {
+    config_setting_lookup_int(setting, "high_water", &gpiod_config->output_high_water);
+    if (config_setting_lookup_string(setting, "policy", &output_policy)) {
+      if ((gpiod_config->output_policy = parse_output_policy(output_policy)) == -1) {
+        log_msg(LOG_MOD_DAEMON, LOG_ERR, "output: policy must be drop or disconnect");
+      }
+    }
+    if (gpiod_config->output_high_water != -1
+        && (gpiod_config->output_high_water < OUTPUT_HIGH_WATER_MIN || gpiod_config->output_high_water > OUTPUT_HIGH_WATER_MAX)) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "output: high_water must be between %d and %d bytes", OUTPUT_HIGH_WATER_MIN, OUTPUT_HIGH_WATER_MAX);
+      gpiod_config->output_high_water = -1;
+    }
+  }
+
+  setting = config_lookup(&cfg, "log");
+
+  if (setting != NULL) {
+    if (config_setting_lookup_string(setting, "target", &log_target)) {
+      gpiod_config->log_target = strndup(log_target, strlen(log_target));
+    }
+    // level is the default of all modules, a module name sets its own level.
+    level = -1;
+    if (config_setting_lookup_string(setting, "level", &log_level) && (level = parse_log_level(log_level)) == -1) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "log: unknown level %s", log_level);
+    }
+    for (r = 0; r < LOG_MOD_COUNT; r++) {
+      gpiod_config->log_levels[r] = level;
+      if (config_setting_lookup_string(setting, get_log_module_name(r), &log_level)
+          && (gpiod_config->log_levels[r] = parse_log_level(log_level)) == -1) {
+        log_msg(LOG_MOD_DAEMON, LOG_ERR, "log: unknown level %s of %s", log_level, get_log_module_name(r));
+        gpiod_config->log_levels[r] = level;
+      }
+    }
+  }
+
+  setting = config_lookup(&cfg, "interrupt");
+
+  if (setting != NULL)
+  {
+    if (config_setting_type(setting) == CONFIG_TYPE_LIST) {
+      count = config_setting_length(setting);
+      // Max interrupts are MAX_INTERRUPTS if more configured only the first are used!
+      if (count > MAX_INTERRUPTS) {
+        count = MAX_INTERRUPTS;
+      }
+      for (r=0; r < count; r++) {
+        interrupt_setting = config_setting_get_elem(setting, r);
+        if (!(config_setting_lookup_int(interrupt_setting, "pin", &inter_pin)
+            && config_setting_lookup_string(interrupt_setting, "type", &inter_type_string)
+            && config_setting_lookup_string(interrupt_setting, "name", &inter_name)
+            && config_setting_lookup_int(interrupt_setting, "wait", &inter_wait)
+            && config_setting_lookup_string(interrupt_setting, "pud", &inter_pud))) {
+          // TODO: Error message if configuration is not valid
+          continue;
+        }
+
+        if(strncmp(inter_pud, "none", strlen("none")) == 0) {
+          pud = PUD_OFF;
+        } else if (strncmp(inter_pud, "up", strlen("up")) == 0) {
+          pud = PUD_UP;
+        } else if (strncmp(inter_pud, "down", strlen("down")) == 0) {
+          pud = PUD_DOWN;
+        } else {
+          // TODO: Error message if configuration is not valid
+          continue;
+        }
+
+        if ((inter_type = parse_edge(inter_type_string)) == -1) {
+          // TODO: Error message if configuration is not valid
+          continue;
+        }
+        if (!config_setting_lookup_int(interrupt_setting, "debounce", &inter_debounce)) {
+          inter_debounce = 0;
+        }
+        interrupt_info = &gpiod_config->interrupts[gpiod_config->interrupts_count++];
+
+        interrupt_info->pin        = inter_pin;
+        interrupt_info->wait       = inter_wait;
+        interrupt_info->type       = inter_type;
+        interrupt_info->name       = strndup(inter_name, strlen(inter_name));
+        interrupt_info->occure     = 0;
+        interrupt_info->pud        = pud;
+        interrupt_info->debounce   = inter_debounce;
+        interrupt_info->active     = 1;
+        interrupt_info->registered = 0;
+      }
+    }
+  }
+
+  setting = config_lookup(&cfg, "rules");
+
+  if (setting != NULL && config_setting_type(setting) == CONFIG_TYPE_LIST) {
+    read_config_rules(setting, gpiod_config);
+  }
+
+  setting = config_lookup(&cfg, "serial");
+
+  if (setting != NULL && config_setting_type(setting) == CONFIG_TYPE_LIST) {
+    read_config_serial(setting, gpiod_config);
+  }
+
+  setting = config_lookup(&cfg, "groups");
+
+  if (setting != NULL && config_setting_type(setting) == CONFIG_TYPE_GROUP) {
+    read_config_groups(setting, gpiod_config);
+  }
+
+  setting = config_lookup(&cfg, "aliases");
+
+  if (setting != NULL && config_setting_type(setting) == CONFIG_TYPE_GROUP) {
+    read_config_aliases(setting, gpiod_config);
+  }
+
+  setting = config_lookup(&cfg, "widgets");
+
+  if (setting != NULL && config_setting_type(setting) == CONFIG_TYPE_LIST) {
+    read_config_widgets(setting, gpiod_config);
+  }
+
+  config_destroy(&cfg);
+
+  return 0;
+}
+
+/**
+ * Apply the log levels of the config file, -v logs everything.
+ */
+static void apply_log_levels(GpiodConfig *gpiod_config) {
+  int module;
+
+  for (module = 0; module < LOG_MOD_COUNT; module++) {
+    if (gpiod_config->log_levels[module] != -1) {
+      set_log_level(module, gpiod_config->log_levels[module]);
+    }
+  }
+  if (get_flag_verbose()) {
+    set_log_level(-1, LOG_DEBUG);
+  }
+}
+
+void load_params(int argc, char **argv) {
+  GpiodConfig gpiod_config;
+  int ch, r, read_config = 0;
+
+  while ((ch = getopt(argc, argv, "dhvs:p:a:l:c:b:m:r:k:t:i:")) != -1) {
     switch (ch) {
       case 'd':
         set_flag_dont_detach(1);
@@ -32,10 +565,14 @@ void load_params(int argc, char **argv) {
         break;
      case 'v':
        set_flag_verbose(1);
+       set_log_level(-1, LOG_DEBUG);
        break;
      case 's':
        set_socket_filename(optarg);
        break;
+     case 'p':
+       set_packet_socket_filename(optarg);
+       break;
      case 'a':
        if (is_valid_pin_num(atoi(optarg))) {
          set_lcd_di(atoi(optarg));
@@ -63,6 +600,25 @@ void load_params(int argc, char **argv) {
          exit(EXIT_FAILURE);
        }
        break;
+     case 'b':
+       if (configure_backend(optarg) == -1) {
+         printf("Unknown gpio backend %s!\n", optarg);
+         usage();
+         exit(EXIT_FAILURE);
+       }
+       break;
+     case 'm':
+       set_state_name(optarg);
+       break;
+     case 'r':
+       set_record_file(optarg);
+       break;
+     case 'k':
+       set_snapshot_file(optarg);
+       break;
+     case 't':
+       set_trace_file(optarg);
+       break;
      case 'i':
        read_config = 1;
        config_file_name = optarg;
@@ -74,99 +630,182 @@ void load_params(int argc, char **argv) {
   }
 
   if (read_config) {
-    config_init(&cfg);
-    /* Read the config file and about on error */
-    if (!config_read_file(&cfg, config_file_name)) {
-      printf("\n%s:%d - %s\n", config_file_name, config_error_line(&cfg), config_error_text(&cfg));
-      config_destroy(&cfg);
+    if (read_config_file(config_file_name, &gpiod_config) == -1) {
       exit(1);
     }
-
-    if (config_lookup_string(&cfg, "socket", &config_socket)) {
-      set_socket_filename(strndup(config_socket, strlen(config_socket)));
-      printf("Socket file configured from config file as: %s\n", get_socket_filename());
+    if (gpiod_config.log_target != NULL) {
+      set_log_target(gpiod_config.log_target);
     }
+    apply_log_levels(&gpiod_config);
 
-    setting = config_lookup(&cfg, "lcd");
+    if (gpiod_config.socket != NULL) {
+      set_socket_filename(gpiod_config.socket);
+      log_msg(LOG_MOD_DAEMON, LOG_INFO, "Socket file configured from config file as: %s", get_socket_filename());
+    }
+    if (gpiod_config.packet_socket != NULL) {
+      set_packet_socket_filename(gpiod_config.packet_socket);
+      log_msg(LOG_MOD_DAEMON, LOG_INFO, "Packet socket file configured from config file as: %s", get_packet_socket_filename());
+    }
+    if (gpiod_config.snapshot != NULL) {
+      set_snapshot_file(gpiod_config.snapshot);
+      log_msg(LOG_MOD_DAEMON, LOG_INFO, "Snapshot file configured from config file as: %s", get_snapshot_file());
+    }
 
-    if (setting != NULL) {
-      if (!config_setting_lookup_int(setting, "di_pin", &lcd_di)) {
-    	  set_lcd_di(lcd_di);
-    	  if (get_flag_verbose()) {
-    		  printf("Set DI Pin of the LCD Display to %i with config file\n", lcd_di);
-    	  }
-      }
-      if (!config_setting_lookup_int(setting, "led_pin", &lcd_led)) {
-    	  set_lcd_led(lcd_led);
-    	  if (get_flag_verbose()) {
-    		  printf("Set PWM LED Pin of the LCD Display to %i with config file\n", lcd_led);
-    	  }
-      }
-      if (!config_setting_lookup_int(setting, "spi_cs", &lcd_spics)) {
-    	  set_lcd_spics(lcd_spics);
-    	  if (get_flag_verbose()) {
-    		  printf("Set SPI CS Pin of the LCD Display to %i with config file\n", lcd_spics);
-    	  }
+    if (gpiod_config.backend_device != NULL) {
+      set_backend_device(gpiod_config.backend_device);
+    }
+    if (gpiod_config.backend != NULL) {
+      if (configure_backend(gpiod_config.backend) == -1) {
+        log_msg(LOG_MOD_DAEMON, LOG_ERR, "Unknown gpio backend %s in config file!", gpiod_config.backend);
+        exit(EXIT_FAILURE);
       }
+      log_msg(LOG_MOD_DAEMON, LOG_DEBUG, "Set gpio backend to %s with config file", get_backend_name());
+    }
+
+    if (gpiod_config.lcd_di != -1) {
+      set_lcd_di(gpiod_config.lcd_di);
+      log_msg(LOG_MOD_DAEMON, LOG_DEBUG, "Set DI Pin of the LCD Display to %i with config file", gpiod_config.lcd_di);
+    }
+    if (gpiod_config.lcd_led != -1) {
+      set_lcd_led(gpiod_config.lcd_led);
+      log_msg(LOG_MOD_DAEMON, LOG_DEBUG, "Set PWM LED Pin of the LCD Display to %i with config file", gpiod_config.lcd_led);
+    }
+    if (gpiod_config.lcd_spics != -1) {
+      set_lcd_spics(gpiod_config.lcd_spics);
+      log_msg(LOG_MOD_DAEMON, LOG_DEBUG, "Set SPI CS Pin of the LCD Display to %i with config file", gpiod_config.lcd_spics);
     }
 
-    setting = config_lookup(&cfg, "interrupt");
+    if (gpiod_config.lcd_eager_init != -1) {
+      set_lcd_eager_init(gpiod_config.lcd_eager_init);
+      log_msg(LOG_MOD_DAEMON, LOG_DEBUG, "Set LCD init to %s with config file", gpiod_config.lcd_eager_init ? "eager" : "lazy");
+    }
+    if (gpiod_config.lcd_sprites != NULL) {
+      set_sprite_dir(gpiod_config.lcd_sprites);
+      r = load_sprites();
+      log_msg(LOG_MOD_DAEMON, LOG_DEBUG, "Loaded %d sprites from %s with config file", r, gpiod_config.lcd_sprites);
+    }
+    set_widget_interval(gpiod_config.lcd_widget_interval);
+    set_widgets(gpiod_config.widgets, gpiod_config.widgets_count);
 
-    if (setting != NULL)
-    {
-      if (config_setting_type(setting) == CONFIG_TYPE_LIST) {
-        set_interrupts_count(config_setting_length(setting));
-        // Max interrupts are 10 if more configured only the first 10 are used!
-        if (get_interrupts_count() > 10) {
-          set_interrupts_count(10);
-        }
-        for (r=0; r < get_interrupts_count(); r++) {
-          interrupt_setting = config_setting_get_elem(setting, r);
-          if (!(config_setting_lookup_int(interrupt_setting, "pin", &inter_pin)
-              && config_setting_lookup_string(interrupt_setting, "type", &inter_type_string)
-              && config_setting_lookup_string(interrupt_setting, "name", &inter_name)
-              && config_setting_lookup_int(interrupt_setting, "wait", &inter_wait)
-              && config_setting_lookup_string(interrupt_setting, "pud", &inter_pud))) {
-            // TODO: Error message if configuration is not valid
-            continue;
-          }
-
-          if(strncmp(inter_pud, "none", strlen("none")) == 0) {
-            pud = PUD_OFF;
-          } else if (strncmp(inter_pud, "up", strlen("up")) == 0) {
-            pud = PUD_UP;
-          } else if (strncmp(inter_pud, "down", strlen("down")) == 0) {
-            pud = PUD_DOWN;
-          } else {
-            // TODO: Error message if configuration is not valid
-            continue;
-          }
-
-          if(strncmp(inter_type_string, "falling", strlen("falling")) == 0) {
-            inter_type = INT_EDGE_FALLING;
-          } else if (strncmp(inter_type_string, "rising", strlen("rising")) == 0) {
-            inter_type = INT_EDGE_RISING;
-          } else if (strncmp(inter_type_string, "both", strlen("both")) == 0) {
-            inter_type = INT_EDGE_BOTH;
-          } else {
-            // TODO: Error message if configuration is not valid
-            continue;
-          }
-          interrupt_info = malloc(sizeof(InterruptInfo));
-
-          if (r <= 10) {
-            interrupt_info->pin    = inter_pin;
-            interrupt_info->wait   = inter_wait;
-            interrupt_info->type   = inter_type;
-            interrupt_info->name   = strndup(inter_name, strlen(inter_name));
-            interrupt_info->occure = 0;
-            interrupt_info->pud    = pud;
-            set_interrupt_info(r, *interrupt_info);
-          }
-        }
-      }
+    if (gpiod_config.state_name != NULL) {
+      set_state_name(gpiod_config.state_name);
+    }
+    if (gpiod_config.state_refresh != -1) {
+      set_state_refresh(gpiod_config.state_refresh);
+      log_msg(LOG_MOD_DAEMON, LOG_DEBUG, "Set pin state refresh to %i ms with config file", gpiod_config.state_refresh);
     }
 
-    config_destroy(&cfg);
+    set_event_defaults(gpiod_config.event_batch, gpiod_config.event_latency, gpiod_config.event_aggregate);
+    set_output_policy(gpiod_config.output_high_water, gpiod_config.output_policy);
+
+    set_interrupts_count(gpiod_config.interrupts_count);
+    for (r = 0; r < gpiod_config.interrupts_count; r++) {
+      set_interrupt_info(r, gpiod_config.interrupts[r]);
+    }
+    set_rules(gpiod_config.rules, gpiod_config.rules_count);
+    set_serial_engines(gpiod_config.serial, gpiod_config.serial_count);
+    set_pin_groups(gpiod_config.groups, gpiod_config.groups_count, gpiod_config.aliases, gpiod_config.aliases_count);
+  }
+}
+
+/**
+ * \brief Reload the config file.
+ *
+ * Read the config file given with -i again and apply the difference to the
+ * running daemon. Connected clients stay connected, the result is written
+ * to the client socket.
+ *
+ * @param client_socket_fd The socket file descriptor to report to.
+ */
+void reload_config(int client_socket_fd) {
+  GpiodConfig gpiod_config;
+  char report[BUFFER_SIZE];
+  int di, led, spics;
+
+  if (config_file_name == NULL) {
+    write_error_msg_to_client(client_socket_fd, "reload: no config file given");
+    return;
+  }
+  if (read_config_file(config_file_name, &gpiod_config) == -1) {
+    write_error_msg_to_client(client_socket_fd, "reload: config file not valid, keep running config");
+    return;
+  }
+
+  apply_log_levels(&gpiod_config);
+
+  reload_rules(gpiod_config.rules, gpiod_config.rules_count, report, BUFFER_SIZE);
+  write_msg_to_client(client_socket_fd, report);
+
+  set_serial_engines(gpiod_config.serial, gpiod_config.serial_count);
+  snprintf(report, BUFFER_SIZE, "serial engines reloaded: %d engines", gpiod_config.serial_count);
+  write_msg_to_client(client_socket_fd, report);
+
+  set_pin_groups(gpiod_config.groups, gpiod_config.groups_count, gpiod_config.aliases, gpiod_config.aliases_count);
+  snprintf(report, BUFFER_SIZE, "groups reloaded: %d groups, %d aliases", gpiod_config.groups_count, gpiod_config.aliases_count);
+  write_msg_to_client(client_socket_fd, report);
+
+  set_event_defaults(gpiod_config.event_batch, gpiod_config.event_latency, gpiod_config.event_aggregate);
+  set_output_policy(gpiod_config.output_high_water, gpiod_config.output_policy);
+
+  if (reload_interrupts(gpiod_config.interrupts, gpiod_config.interrupts_count, report, BUFFER_SIZE) == -1) {
+    write_error_msg_to_client(client_socket_fd, report);
+  } else {
+    write_msg_to_client(client_socket_fd, report);
+  }
+
+  di    = gpiod_config.lcd_di    != -1 ? gpiod_config.lcd_di    : get_lcd_di();
+  led   = gpiod_config.lcd_led   != -1 ? gpiod_config.lcd_led   : get_lcd_led();
+  spics = gpiod_config.lcd_spics != -1 ? gpiod_config.lcd_spics : get_lcd_spics();
+  if (reconfigure_lcd(di, led, spics)) {
+    write_msg_to_client(client_socket_fd, "lcd reloaded: pins changed, display is initialized on next command");
+  }
+  if (gpiod_config.lcd_sprites != NULL) {
+    set_sprite_dir(gpiod_config.lcd_sprites);
+    snprintf(report, BUFFER_SIZE, "sprites reloaded: %d sprites", load_sprites());
+    write_msg_to_client(client_socket_fd, report);
   }
+  set_widget_interval(gpiod_config.lcd_widget_interval);
+  set_widgets(gpiod_config.widgets, gpiod_config.widgets_count);
+  snprintf(report, BUFFER_SIZE, "widgets reloaded: %d widgets", gpiod_config.widgets_count);
+  write_msg_to_client(client_socket_fd, report);
+
+  if (gpiod_config.socket != NULL) {
+    if (strcmp(gpiod_config.socket, get_socket_filename()) != 0) {
+      write_error_msg_to_client(client_socket_fd, "reload: changed socket needs a restart");
+    }
+    free(gpiod_config.socket);
+  }
+  if (gpiod_config.packet_socket != NULL) {
+    if (get_packet_socket_filename() == NULL || strcmp(gpiod_config.packet_socket, get_packet_socket_filename()) != 0) {
+      write_error_msg_to_client(client_socket_fd, "reload: changed packet socket needs a restart");
+    }
+    free(gpiod_config.packet_socket);
+  }
+  if (gpiod_config.snapshot != NULL) {
+    if (get_snapshot_file() == NULL || strcmp(gpiod_config.snapshot, get_snapshot_file()) != 0) {
+      write_error_msg_to_client(client_socket_fd, "reload: changed snapshot needs a restart");
+    }
+    free(gpiod_config.snapshot);
+  }
+  if (gpiod_config.backend != NULL) {
+    if (strncmp(gpiod_config.backend, get_backend_name(), strlen(get_backend_name())) != 0) {
+      write_error_msg_to_client(client_socket_fd, "reload: changed backend needs a restart");
+    }
+    free(gpiod_config.backend);
+  }
+  free(gpiod_config.backend_device);
+  if (gpiod_config.state_name != NULL) {
+    if (strcmp(gpiod_config.state_name, get_state_name() != NULL ? get_state_name() : "none") != 0) {
+      write_error_msg_to_client(client_socket_fd, "reload: changed state needs a restart");
+    }
+    free(gpiod_config.state_name);
+  }
+  if (gpiod_config.log_target != NULL) {
+    if (strcmp(gpiod_config.log_target, get_log_target()) != 0) {
+      write_error_msg_to_client(client_socket_fd, "reload: changed log target needs a restart");
+    }
+    free(gpiod_config.log_target);
+  }
+
+  log_msg(LOG_MOD_DAEMON, LOG_NOTICE, "Reloaded config file %s: %s", config_file_name, report);
 }
@@ -8,6 +8,56 @@
 #ifndef CONFIG_H_
 #define CONFIG_H_
 
+#include <stddef.h>
+#include "interrupt.h"
+#include "rules.h"
+#include "shift.h"
+#include "groups.h"
+#include "widget.h"
+#include "log.h"
+
+/**
+ * \brief Parsed content of the config file.
+ *
+ * Values not found in the config file are -1 or NULL.
+ */
+typedef struct GpiodConfig {
+  char *socket;          //> Socket file name.
+  char *packet_socket;   //> SOCK_SEQPACKET socket file name.
+  char *snapshot;        //> Snapshot file name.
+  char *backend;         //> Gpio backend name, optional with ":device".
+  char *backend_device;  //> Device or file of the gpio backend.
+  int lcd_di;            //> DI pin of the lcd display.
+  int lcd_led;           //> PWM pin of the lcd backlight.
+  int lcd_spics;         //> SPI chipselect of the lcd display.
+  int lcd_eager_init;    //> 1 to initialize the display on startup.
+  char *lcd_sprites;     //> Directory of the sprites loaded on startup.
+  int lcd_widget_interval; //> Shortest time between two widget updates in milliseconds.
+  char *state_name;      //> Shared memory name of the pin state or "none".
+  int state_refresh;     //> Sample interval of the pin state in milliseconds.
+  int event_batch;       //> Event records per write of new clients.
+  int event_latency;     //> Longest wait of a batched event in milliseconds.
+  int event_aggregate;   //> 1 to merge repeated events of new clients.
+  int output_high_water; //> Output queue limit of a client in bytes.
+  int output_policy;     //> OutputPolicy at the output queue limit.
+  char *log_target;      //> syslog, stdout or a log file.
+  int log_levels[LOG_MOD_COUNT]; //> Level of each LogModule.
+  int interrupts_count;  //> Count of valid entries in interrupts.
+  InterruptInfo interrupts[MAX_INTERRUPTS];
+  int rules_count;       //> Count of valid entries in rules.
+  Rule rules[MAX_RULES];
+  int serial_count;      //> Count of valid entries in serial.
+  SerialEngine serial[MAX_SERIAL_ENGINES];
+  int groups_count;      //> Count of valid entries in groups.
+  PinGroup groups[MAX_GROUPS];
+  int aliases_count;     //> Count of valid entries in aliases.
+  PinAlias aliases[MAX_ALIASES];
+  int widgets_count;     //> Count of valid entries in widgets.
+  Widget widgets[MAX_WIDGETS];
+} GpiodConfig;
+
 void load_params(int argc, char **argv);
+int read_config_file(const char *file_name, GpiodConfig *gpiod_config);
+void reload_config(int client_socket_fd);
 
 #endif /* CONFIG_H_ */
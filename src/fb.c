@@ -0,0 +1,701 @@
+/*
+ * fb.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "gpiod.h"
+#include "fb.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define FB_KERNEL "sse2"
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FB_KERNEL "neon"
+#else
+#define FB_KERNEL "scalar"
+#endif
+
+/**
+ * \brief A 64 bit word of a page row, the rows are accessed as bytes too.
+ */
+typedef uint64_t __attribute__((may_alias)) FbWord;
+
+#define FB_BYTES 0x0101010101010101ULL
+
+static Framebuffer framebuffer = {
+  .back_x1 = { FB_WIDTH, FB_WIDTH, FB_WIDTH, FB_WIDTH, FB_WIDTH, FB_WIDTH, FB_WIDTH, FB_WIDTH },
+  .back_x2 = { -1, -1, -1, -1, -1, -1, -1, -1 },
+  .dirty_x1 = { FB_WIDTH, FB_WIDTH, FB_WIDTH, FB_WIDTH, FB_WIDTH, FB_WIDTH, FB_WIDTH, FB_WIDTH },
+  .dirty_x2 = { -1, -1, -1, -1, -1, -1, -1, -1 },
+  .mirror_x1 = { FB_WIDTH, FB_WIDTH, FB_WIDTH, FB_WIDTH, FB_WIDTH, FB_WIDTH, FB_WIDTH, FB_WIDTH },
+  .mirror_x2 = { -1, -1, -1, -1, -1, -1, -1, -1 }
+};
+
+/**
+ * \brief Name of the vector kernel of the span operations.
+ */
+const char *fb_kernel_name() {
+  return FB_KERNEL;
+}
+
+/**
+ * Combine a byte of a page row with a mask.
+ */
+static inline void span_byte(uint8_t *dest, uint8_t mask, FbMode mode) {
+  switch (mode) {
+    case FB_SET:
+      *dest |= mask;
+      break;
+    case FB_CLEAR:
+      *dest &= ~mask;
+      break;
+    case FB_XOR:
+      *dest ^= mask;
+      break;
+  }
+}
+
+/**
+ * Combine a word of a page row with a mask.
+ */
+static inline void span_word(FbWord *dest, uint64_t mask, FbMode mode) {
+  switch (mode) {
+    case FB_SET:
+      *dest |= mask;
+      break;
+    case FB_CLEAR:
+      *dest &= ~mask;
+      break;
+    case FB_XOR:
+      *dest ^= mask;
+      break;
+  }
+}
+
+/**
+ * \brief Combine the columns x1 to x2 of a page row with a row mask.
+ *
+ * The same mask applies to every column, so a span of a filled rectangle
+ * is a run of masked 16 byte vector or 64 bit word operations with single
+ * bytes only at the unaligned ends.
+ *
+ * @param row  The page row.
+ * @param x1   First column.
+ * @param x2   Last column.
+ * @param mask Rows of the page to change.
+ * @param mode How the mask is combined.
+ */
+void fb_span(uint8_t *row, int x1, int x2, uint8_t mask, FbMode mode) {
+  uint64_t word = mask * FB_BYTES;
+
+  for (; x1 <= x2 && (x1 & 7) != 0; x1++) {
+    span_byte(&row[x1], mask, mode);
+  }
+#if defined(__SSE2__)
+  if (x1 + 15 <= x2) {
+    __m128i vmask = _mm_set1_epi8((char) mask), v;
+
+    for (; x1 + 15 <= x2; x1 += 16) {
+      v = _mm_loadu_si128((__m128i *) &row[x1]);
+      switch (mode) {
+        case FB_SET:
+          v = _mm_or_si128(v, vmask);
+          break;
+        case FB_CLEAR:
+          v = _mm_andnot_si128(vmask, v);
+          break;
+        case FB_XOR:
+          v = _mm_xor_si128(v, vmask);
+          break;
+      }
+      _mm_storeu_si128((__m128i *) &row[x1], v);
+    }
+  }
+#elif defined(__ARM_NEON)
+  if (x1 + 15 <= x2) {
+    uint8x16_t vmask = vdupq_n_u8(mask), v;
+
+    for (; x1 + 15 <= x2; x1 += 16) {
+      v = vld1q_u8(&row[x1]);
+      switch (mode) {
+        case FB_SET:
+          v = vorrq_u8(v, vmask);
+          break;
+        case FB_CLEAR:
+          v = vbicq_u8(v, vmask);
+          break;
+        case FB_XOR:
+          v = veorq_u8(v, vmask);
+          break;
+      }
+      vst1q_u8(&row[x1], v);
+    }
+  }
+#endif
+  for (; x1 + 7 <= x2; x1 += 8) {
+    span_word((FbWord *) &row[x1], word, mode);
+  }
+  for (; x1 <= x2; x1++) {
+    span_byte(&row[x1], mask, mode);
+  }
+}
+
+/**
+ * \brief The framebuffer, only used by the lcd worker.
+ */
+Framebuffer *get_framebuffer() {
+  return &framebuffer;
+}
+
+/**
+ * \brief Mark columns of a page of the back buffer as changed.
+ *
+ * @param page The page.
+ * @param x1   First column.
+ * @param x2   Last column.
+ */
+void fb_mark_dirty(int page, int x1, int x2) {
+  if (x1 < framebuffer.back_x1[page]) {
+    framebuffer.back_x1[page] = x1;
+  }
+  if (x2 > framebuffer.back_x2[page]) {
+    framebuffer.back_x2[page] = x2;
+  }
+}
+
+/**
+ * Mark columns of a page of the shown frame as changed, for the push and
+ * for the mirror.
+ */
+static void fb_mark_shown(int page, int x1, int x2) {
+  if (x1 < framebuffer.dirty_x1[page]) {
+    framebuffer.dirty_x1[page] = x1;
+  }
+  if (x2 > framebuffer.dirty_x2[page]) {
+    framebuffer.dirty_x2[page] = x2;
+  }
+  if (x1 < framebuffer.mirror_x1[page]) {
+    framebuffer.mirror_x1[page] = x1;
+  }
+  if (x2 > framebuffer.mirror_x2[page]) {
+    framebuffer.mirror_x2[page] = x2;
+  }
+}
+
+/**
+ * Mark a page as pushed.
+ */
+static void fb_mark_clean(int page) {
+  framebuffer.dirty_x1[page] = FB_WIDTH;
+  framebuffer.dirty_x2[page] = -1;
+}
+
+/**
+ * \brief Clear the back buffer.
+ */
+void fb_clear() {
+  int page;
+
+  for (page = 0; page < FB_PAGES; page++) {
+    fb_span(framebuffer.pages[page], 0, FB_WIDTH - 1, 0xff, FB_CLEAR);
+    fb_mark_dirty(page, 0, FB_WIDTH - 1);
+  }
+}
+
+/**
+ * \brief Invert the back buffer.
+ */
+void fb_invert() {
+  int page;
+
+  for (page = 0; page < FB_PAGES; page++) {
+    fb_span(framebuffer.pages[page], 0, FB_WIDTH - 1, 0xff, FB_XOR);
+    fb_mark_dirty(page, 0, FB_WIDTH - 1);
+  }
+}
+
+/**
+ * \brief Push all pixels again, the dog128 library buffer was cleared.
+ */
+void fb_reset_pushed() {
+  int page;
+
+  memset(framebuffer.pushed, 0, sizeof(framebuffer.pushed));
+  for (page = 0; page < FB_PAGES; page++) {
+    framebuffer.dirty_x1[page] = 0;
+    framebuffer.dirty_x2[page] = FB_WIDTH - 1;
+  }
+}
+
+/**
+ * \brief Follow an invert of the dog128 library buffer.
+ */
+void fb_invert_pushed() {
+  int page;
+
+  for (page = 0; page < FB_PAGES; page++) {
+    fb_span(framebuffer.pushed[page], 0, FB_WIDTH - 1, 0xff, FB_XOR);
+    framebuffer.dirty_x1[page] = 0;
+    framebuffer.dirty_x2[page] = FB_WIDTH - 1;
+  }
+}
+
+/**
+ * \brief Show the back buffer.
+ *
+ * The columns changed since the last SHOW are copied into the shown frame.
+ */
+void fb_show() {
+  int page, x1, x2;
+
+  for (page = 0; page < FB_PAGES; page++) {
+    x1 = framebuffer.back_x1[page];
+    x2 = framebuffer.back_x2[page];
+    if (x1 > x2) {
+      continue;
+    }
+    memcpy(&framebuffer.shown[page][x1], &framebuffer.pages[page][x1], x2 - x1 + 1);
+    fb_mark_shown(page, x1, x2);
+    framebuffer.back_x1[page] = FB_WIDTH;
+    framebuffer.back_x2[page] = -1;
+  }
+}
+
+/**
+ * \brief Show a rectangle of the back buffer.
+ *
+ * Used for the widgets between two SHOWs, the rest of the back buffer
+ * stays unshown.
+ *
+ * @param x1 Left column.
+ * @param y1 Top row.
+ * @param x2 Right column.
+ * @param y2 Bottom row.
+ */
+void fb_show_area(int x1, int y1, int x2, int y2) {
+  int page, x;
+  uint8_t mask;
+
+  x1 = x1 < 0 ? 0 : x1;
+  y1 = y1 < 0 ? 0 : y1;
+  x2 = x2 >= FB_WIDTH ? FB_WIDTH - 1 : x2;
+  y2 = y2 >= FB_HEIGHT ? FB_HEIGHT - 1 : y2;
+  if (x1 > x2 || y1 > y2) {
+    return;
+  }
+  for (page = y1 / 8; page <= y2 / 8; page++) {
+    mask = 0xff;
+    if (page == y1 / 8) {
+      mask &= 0xff << (y1 & 7);
+    }
+    if (page == y2 / 8) {
+      mask &= 0xff >> (7 - (y2 & 7));
+    }
+    for (x = x1; x <= x2; x++) {
+      framebuffer.shown[page][x] = (framebuffer.shown[page][x] & ~mask) | (framebuffer.pages[page][x] & mask);
+    }
+    fb_mark_shown(page, x1, x2);
+  }
+}
+
+/**
+ * \brief Set the pixels of a snapshot, they are pushed with the next show.
+ *
+ * @param pages The pixels.
+ */
+void fb_restore(const uint8_t pages[FB_PAGES][FB_WIDTH]) {
+  int page;
+
+  memcpy(framebuffer.pages, pages, sizeof(framebuffer.pages));
+  memcpy(framebuffer.shown, pages, sizeof(framebuffer.shown));
+  for (page = 0; page < FB_PAGES; page++) {
+    fb_mark_shown(page, 0, FB_WIDTH - 1);
+  }
+}
+
+/**
+ * \brief Push the changed pixels of the shown frame into the buffer of the
+ * dog128 library.
+ *
+ * Only the changed columns are compared, 8 columns at once. A run of
+ * changed columns whose page byte is all set or all clear, as left by fills,
+ * clear and invert, is drawn with one rect, the other changed pixels are
+ * drawn with dot.
+ *
+ * @param pen_color The pen color of the client commands, restored after
+ *                  the push.
+ *
+ * @return Count of pushed pixels.
+ */
+unsigned long fb_push(int pen_color) {
+  unsigned long pushed = 0;
+  uint8_t value, changed, bit;
+  int page, x, end, color = pen_color;
+
+  for (page = 0; page < FB_PAGES; page++) {
+    for (x = framebuffer.dirty_x1[page]; x <= framebuffer.dirty_x2[page]; x++) {
+      if ((x & 7) == 0 && x + 7 <= framebuffer.dirty_x2[page]
+          && *(FbWord *) &framebuffer.shown[page][x] == *(FbWord *) &framebuffer.pushed[page][x]) {
+        x += 7;
+        continue;
+      }
+      value   = framebuffer.shown[page][x];
+      changed = value ^ framebuffer.pushed[page][x];
+      if (changed != 0 && (value == 0x00 || value == 0xff)) {
+        for (end = x; end < framebuffer.dirty_x2[page]
+             && framebuffer.shown[page][end + 1] == value
+             && framebuffer.pushed[page][end + 1] != value; end++) {
+        }
+        if (end > x) {
+          if ((value & 1) != color) {
+            color = value & 1;
+            setPenColor(color);
+          }
+          rect(x, page * 8, end, page * 8 + 7, 1);
+          for (; x <= end; x++) {
+            pushed += __builtin_popcount(value ^ framebuffer.pushed[page][x]);
+            framebuffer.pushed[page][x] = value;
+          }
+          x = end;
+          continue;
+        }
+      }
+      for (bit = 0; changed != 0; bit++, changed >>= 1) {
+        if (!(changed & 1)) {
+          continue;
+        }
+        if (((framebuffer.shown[page][x] >> bit) & 1) != color) {
+          color = (framebuffer.shown[page][x] >> bit) & 1;
+          setPenColor(color);
+        }
+        dot(x, page * 8 + bit);
+        pushed++;
+      }
+      framebuffer.pushed[page][x] = framebuffer.shown[page][x];
+    }
+    fb_mark_clean(page);
+  }
+  if (color != pen_color) {
+    setPenColor(pen_color);
+  }
+  return pushed;
+}
+
+/**
+ * \brief Draw a page packed bitmap into the framebuffer.
+ *
+ * Every byte of the bitmap is shifted into one or two framebuffer pages,
+ * the bitmap is clipped at the right and the bottom of the display.
+ *
+ * @param x      Left column.
+ * @param y      Top row.
+ * @param width  Width of the bitmap, width bytes per page.
+ * @param height Height of the bitmap.
+ * @param data   The bitmap.
+ * @param mode   How the pixels are combined.
+ */
+void fb_blit(int x, int y, int width, int height, const uint8_t *data, FbMode mode) {
+  int pages = (height + 7) / 8, page, dest, shift = y & 7, columns, c;
+  unsigned int bits;
+
+  columns = x + width > FB_WIDTH ? FB_WIDTH - x : width;
+  for (page = 0; page < pages; page++) {
+    dest = (y >> 3) + page;
+    if (dest >= FB_PAGES) {
+      break;
+    }
+    for (c = 0; c < columns; c++) {
+      bits = data[page * width + c];
+      // Rows below the bitmap in the last page are not part of the bitmap.
+      if (page == pages - 1 && (height & 7) != 0) {
+        bits &= (1U << (height & 7)) - 1;
+      }
+      bits <<= shift;
+      span_byte(&framebuffer.pages[dest][x + c], bits & 0xff, mode);
+      if (shift != 0 && dest + 1 < FB_PAGES) {
+        span_byte(&framebuffer.pages[dest + 1][x + c], bits >> 8, mode);
+      }
+    }
+    fb_mark_dirty(dest, x, x + columns - 1);
+    if (shift != 0 && dest + 1 < FB_PAGES) {
+      fb_mark_dirty(dest + 1, x, x + columns - 1);
+    }
+  }
+}
+
+/**
+ * \brief Fill a rectangle of the framebuffer.
+ *
+ * Every page of the rectangle is one span, the rectangle is clipped at the
+ * display.
+ *
+ * @param x1    Left column.
+ * @param y1    Top row.
+ * @param x2    Right column.
+ * @param y2    Bottom row.
+ * @param color 1 to set, 0 to clear the pixels.
+ */
+void fb_fill(int x1, int y1, int x2, int y2, int color) {
+  int page;
+  uint8_t mask;
+
+  x1 = x1 < 0 ? 0 : x1;
+  y1 = y1 < 0 ? 0 : y1;
+  x2 = x2 >= FB_WIDTH ? FB_WIDTH - 1 : x2;
+  y2 = y2 >= FB_HEIGHT ? FB_HEIGHT - 1 : y2;
+  if (x1 > x2 || y1 > y2) {
+    return;
+  }
+  for (page = y1 / 8; page <= y2 / 8; page++) {
+    mask = 0xff;
+    if (page == y1 / 8) {
+      mask &= 0xff << (y1 & 7);
+    }
+    if (page == y2 / 8) {
+      mask &= 0xff >> (7 - (y2 & 7));
+    }
+    fb_span(framebuffer.pages[page], x1, x2, mask, color ? FB_SET : FB_CLEAR);
+    fb_mark_dirty(page, x1, x2);
+  }
+}
+
+/**
+ * \brief Draw the border of a rectangle into the framebuffer.
+ *
+ * @param x1    Left column.
+ * @param y1    Top row.
+ * @param x2    Right column.
+ * @param y2    Bottom row.
+ * @param color 1 to set, 0 to clear the pixels.
+ */
+void fb_frame(int x1, int y1, int x2, int y2, int color) {
+  fb_fill(x1, y1, x2, y1, color);
+  fb_fill(x1, y2, x2, y2, color);
+  fb_fill(x1, y1, x1, y2, color);
+  fb_fill(x2, y1, x2, y2, color);
+}
+
+/**
+ * \brief Draw a rectangle of two corners into the framebuffer.
+ *
+ * @param x1    Column of the first corner.
+ * @param y1    Row of the first corner.
+ * @param x2    Column of the second corner.
+ * @param y2    Row of the second corner.
+ * @param fill  1 to fill the rectangle, 0 for the border.
+ * @param color 1 to set, 0 to clear the pixels.
+ */
+void fb_rect(int x1, int y1, int x2, int y2, int fill, int color) {
+  int t;
+
+  if (x1 > x2) {
+    t = x1; x1 = x2; x2 = t;
+  }
+  if (y1 > y2) {
+    t = y1; y1 = y2; y2 = t;
+  }
+  if (fill) {
+    fb_fill(x1, y1, x2, y2, color);
+  } else {
+    fb_frame(x1, y1, x2, y2, color);
+  }
+}
+
+/**
+ * \brief Set or clear a pixel of the framebuffer.
+ *
+ * @param x     Column.
+ * @param y     Row.
+ * @param color 1 to set, 0 to clear the pixel.
+ */
+void fb_pixel(int x, int y, int color) {
+  if (x < 0 || x >= FB_WIDTH || y < 0 || y >= FB_HEIGHT) {
+    return;
+  }
+  span_byte(&framebuffer.pages[y >> 3][x], 1 << (y & 7), color ? FB_SET : FB_CLEAR);
+  fb_mark_dirty(y >> 3, x, x);
+}
+
+/**
+ * \brief Draw a line into the framebuffer.
+ *
+ * Horizontal and vertical lines are fills, other lines are drawn pixel by
+ * pixel with Bresenham.
+ *
+ * @param x1    Column of the start.
+ * @param y1    Row of the start.
+ * @param x2    Column of the end.
+ * @param y2    Row of the end.
+ * @param color 1 to set, 0 to clear the pixels.
+ */
+void fb_line(int x1, int y1, int x2, int y2, int color) {
+  int dx = abs(x2 - x1), dy = -abs(y2 - y1), sx = x1 < x2 ? 1 : -1, sy = y1 < y2 ? 1 : -1, err = dx + dy, e2;
+
+  if (x1 == x2 || y1 == y2) {
+    fb_rect(x1, y1, x2, y2, 1, color);
+    return;
+  }
+  for (;;) {
+    fb_pixel(x1, y1, color);
+    if (x1 == x2 && y1 == y2) {
+      break;
+    }
+    e2 = 2 * err;
+    if (e2 >= dy) {
+      err += dy;
+      x1  += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      y1  += sy;
+    }
+  }
+}
+
+/**
+ * Integer square root.
+ */
+static long long fb_isqrt(long long value) {
+  long long root = 0, bit = 1LL << 62;
+
+  while (bit > value) {
+    bit >>= 2;
+  }
+  for (; bit != 0; bit >>= 2) {
+    if (value >= root + bit) {
+      value -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+  }
+  return root;
+}
+
+/**
+ * Half width of an ellipse in row dy from the center, -1 outside.
+ *
+ * The edge is taken half a pixel outside the radius like the midpoint
+ * algorithm, so the top and bottom rows of a circle are not single pixels.
+ */
+static int fb_ellipse_width(long long rx, long long ry, int dy) {
+  long long w = 2 * rx + 1, h = 2 * ry + 1;
+
+  if (dy > ry) {
+    return -1;
+  }
+  return (int) fb_isqrt(w * w * (h * h - 4LL * dy * dy) / (4 * h * h));
+}
+
+/**
+ * \brief Draw an ellipse into the framebuffer.
+ *
+ * Every row of the ellipse is a span: a filled row from the left to the
+ * right edge, an outline row from the edge to the edge of the next row,
+ * so the outline has no gaps.
+ *
+ * @param x     Column of the center.
+ * @param y     Row of the center.
+ * @param rx    Horizontal radius.
+ * @param ry    Vertical radius.
+ * @param fill  1 to fill the ellipse, 0 for the outline.
+ * @param color 1 to set, 0 to clear the pixels.
+ */
+void fb_ellipse(int x, int y, int rx, int ry, int fill, int color) {
+  int dy, width, inner;
+
+  if (rx < 0 || ry < 0) {
+    return;
+  }
+  for (dy = 0; dy <= ry; dy++) {
+    width = fb_ellipse_width(rx, ry, dy);
+    if (fill) {
+      fb_fill(x - width, y - dy, x + width, y - dy, color);
+      if (dy > 0) {
+        fb_fill(x - width, y + dy, x + width, y + dy, color);
+      }
+      continue;
+    }
+    inner = fb_ellipse_width(rx, ry, dy + 1) + 1;
+    inner = inner < width ? inner : width;
+    if (inner == 0) {
+      fb_fill(x - width, y - dy, x + width, y - dy, color);
+      fb_fill(x - width, y + dy, x + width, y + dy, color);
+    } else {
+      fb_fill(x - width, y - dy, x - inner, y - dy, color);
+      fb_fill(x + inner, y - dy, x + width, y - dy, color);
+      fb_fill(x - width, y + dy, x - inner, y + dy, color);
+      fb_fill(x + inner, y + dy, x + width, y + dy, color);
+    }
+  }
+}
+
+/**
+ * 5x7 font of the characters 0x20 to 0x7e, page packed, bit 0 is the top row.
+ */
+static const uint8_t fb_font[][5] = {
+  { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5f, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 },
+  { 0x14, 0x7f, 0x14, 0x7f, 0x14 }, { 0x24, 0x2a, 0x7f, 0x2a, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 },
+  { 0x36, 0x49, 0x56, 0x20, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 }, { 0x00, 0x1c, 0x22, 0x41, 0x00 },
+  { 0x00, 0x41, 0x22, 0x1c, 0x00 }, { 0x14, 0x08, 0x3e, 0x08, 0x14 }, { 0x08, 0x08, 0x3e, 0x08, 0x08 },
+  { 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 },
+  { 0x20, 0x10, 0x08, 0x04, 0x02 }, { 0x3e, 0x51, 0x49, 0x45, 0x3e }, { 0x00, 0x42, 0x7f, 0x40, 0x00 },
+  { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4b, 0x31 }, { 0x18, 0x14, 0x12, 0x7f, 0x10 },
+  { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3c, 0x4a, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 },
+  { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1e }, { 0x00, 0x36, 0x36, 0x00, 0x00 },
+  { 0x00, 0x56, 0x36, 0x00, 0x00 }, { 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 },
+  { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 }, { 0x32, 0x49, 0x79, 0x41, 0x3e },
+  { 0x7e, 0x11, 0x11, 0x11, 0x7e }, { 0x7f, 0x49, 0x49, 0x49, 0x36 }, { 0x3e, 0x41, 0x41, 0x41, 0x22 },
+  { 0x7f, 0x41, 0x41, 0x22, 0x1c }, { 0x7f, 0x49, 0x49, 0x49, 0x41 }, { 0x7f, 0x09, 0x09, 0x09, 0x01 },
+  { 0x3e, 0x41, 0x49, 0x49, 0x7a }, { 0x7f, 0x08, 0x08, 0x08, 0x7f }, { 0x00, 0x41, 0x7f, 0x41, 0x00 },
+  { 0x20, 0x40, 0x41, 0x3f, 0x01 }, { 0x7f, 0x08, 0x14, 0x22, 0x41 }, { 0x7f, 0x40, 0x40, 0x40, 0x40 },
+  { 0x7f, 0x02, 0x0c, 0x02, 0x7f }, { 0x7f, 0x04, 0x08, 0x10, 0x7f }, { 0x3e, 0x41, 0x41, 0x41, 0x3e },
+  { 0x7f, 0x09, 0x09, 0x09, 0x06 }, { 0x3e, 0x41, 0x51, 0x21, 0x5e }, { 0x7f, 0x09, 0x19, 0x29, 0x46 },
+  { 0x46, 0x49, 0x49, 0x49, 0x31 }, { 0x01, 0x01, 0x7f, 0x01, 0x01 }, { 0x3f, 0x40, 0x40, 0x40, 0x3f },
+  { 0x1f, 0x20, 0x40, 0x20, 0x1f }, { 0x3f, 0x40, 0x38, 0x40, 0x3f }, { 0x63, 0x14, 0x08, 0x14, 0x63 },
+  { 0x07, 0x08, 0x70, 0x08, 0x07 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7f, 0x41, 0x41, 0x00 },
+  { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7f, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 },
+  { 0x40, 0x40, 0x40, 0x40, 0x40 }, { 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 },
+  { 0x7f, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 }, { 0x38, 0x44, 0x44, 0x48, 0x7f },
+  { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x08, 0x7e, 0x09, 0x01, 0x02 }, { 0x0c, 0x52, 0x52, 0x52, 0x3e },
+  { 0x7f, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7d, 0x40, 0x00 }, { 0x20, 0x40, 0x44, 0x3d, 0x00 },
+  { 0x7f, 0x10, 0x28, 0x44, 0x00 }, { 0x00, 0x41, 0x7f, 0x40, 0x00 }, { 0x7c, 0x04, 0x18, 0x04, 0x78 },
+  { 0x7c, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 }, { 0x7c, 0x14, 0x14, 0x14, 0x08 },
+  { 0x08, 0x14, 0x14, 0x18, 0x7c }, { 0x7c, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 },
+  { 0x04, 0x3f, 0x44, 0x40, 0x20 }, { 0x3c, 0x40, 0x40, 0x20, 0x7c }, { 0x1c, 0x20, 0x40, 0x20, 0x1c },
+  { 0x3c, 0x40, 0x30, 0x40, 0x3c }, { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0c, 0x50, 0x50, 0x50, 0x3c },
+  { 0x44, 0x64, 0x54, 0x4c, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 }, { 0x00, 0x00, 0x7f, 0x00, 0x00 },
+  { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x10, 0x08, 0x08, 0x10, 0x08 }
+};
+
+/**
+ * \brief Write text with the built in 5x7 font into the framebuffer.
+ *
+ * The text is clipped at column x_max, unknown characters are written as
+ * '?'.
+ *
+ * @param x     Left column.
+ * @param y     Top row.
+ * @param x_max Last column of the text.
+ * @param text  The text.
+ *
+ * @return Column after the text.
+ */
+int fb_text(int x, int y, int x_max, const char *text) {
+  int ch, width;
+
+  if (x_max >= FB_WIDTH) {
+    x_max = FB_WIDTH - 1;
+  }
+  for (; *text != '\0' && x <= x_max; text++, x += FB_CHAR_WIDTH) {
+    ch = (unsigned char) *text;
+    if (ch < 0x20 || ch > 0x7e) {
+      ch = '?';
+    }
+    width = x_max - x + 1 < 5 ? x_max - x + 1 : 5;
+    fb_blit(x, y, width, 7, fb_font[ch - 0x20], FB_SET);
+  }
+  return x;
+}
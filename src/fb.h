@@ -0,0 +1,76 @@
+/*
+ * fb.h
+ *
+ *  Created on: 19.10.2026
+ *
+ * Framebuffer of the dog128 display. gpiod draws all graphics itself, only
+ * the text of the fonts of the dog128 library is drawn by the library.
+ *
+ * The pixels are page packed like the display ram of the ST7565: a page
+ * is 8 rows, bit n of byte x of page p is the pixel (x, 8 * p + n).
+ *
+ * The clients draw into a back buffer, a SHOW copies its changed columns
+ * into the shown frame. Widgets between two SHOWs copy only their own
+ * rectangles, so a half drawn frame of a client is never shown. Changed
+ * columns of the shown frame are pushed into the buffer of the dog128
+ * library before show, only changed pixels are pushed.
+ */
+
+#ifndef FB_H_
+#define FB_H_
+
+#include <stdint.h>
+
+#define FB_WIDTH  128
+#define FB_HEIGHT 64
+#define FB_PAGES  (FB_HEIGHT / 8)
+
+/**
+ * \brief Size of a character of the built in font, including the space column.
+ */
+#define FB_CHAR_WIDTH  6
+#define FB_CHAR_HEIGHT 8
+
+typedef enum FbMode {
+  FB_SET = 0, //> Set the pixels.
+  FB_CLEAR,   //> Clear the pixels.
+  FB_XOR      //> Invert the pixels.
+} FbMode;
+
+/**
+ * \brief The page rows are aligned for the word and vector kernels.
+ */
+typedef struct Framebuffer {
+  uint8_t pages[FB_PAGES][FB_WIDTH] __attribute__((aligned(16)));  //> The back buffer the clients draw into.
+  uint8_t shown[FB_PAGES][FB_WIDTH] __attribute__((aligned(16)));  //> The shown frame.
+  uint8_t pushed[FB_PAGES][FB_WIDTH] __attribute__((aligned(16))); //> The pixels in the buffer of the dog128 library.
+  int back_x1[FB_PAGES];              //> First column of a page of the back buffer changed since the last SHOW.
+  int back_x2[FB_PAGES];              //> Last column of a page of the back buffer changed since the last SHOW.
+  int dirty_x1[FB_PAGES];             //> First column of a page of the shown frame not pushed.
+  int dirty_x2[FB_PAGES];             //> Last column of a page of the shown frame not pushed, < dirty_x1 if clean.
+  int mirror_x1[FB_PAGES];            //> First column of a page changed since the last mirror frame.
+  int mirror_x2[FB_PAGES];            //> Last column of a page changed since the last mirror frame.
+} Framebuffer;
+
+Framebuffer *get_framebuffer();
+void fb_mark_dirty(int page, int x1, int x2);
+void fb_clear();
+void fb_invert();
+void fb_reset_pushed();
+void fb_invert_pushed();
+void fb_show();
+void fb_show_area(int x1, int y1, int x2, int y2);
+void fb_restore(const uint8_t pages[FB_PAGES][FB_WIDTH]);
+const char *fb_kernel_name();
+void fb_span(uint8_t *row, int x1, int x2, uint8_t mask, FbMode mode);
+void fb_blit(int x, int y, int width, int height, const uint8_t *data, FbMode mode);
+void fb_fill(int x1, int y1, int x2, int y2, int color);
+void fb_frame(int x1, int y1, int x2, int y2, int color);
+void fb_rect(int x1, int y1, int x2, int y2, int fill, int color);
+void fb_pixel(int x, int y, int color);
+void fb_line(int x1, int y1, int x2, int y2, int color);
+void fb_ellipse(int x, int y, int rx, int ry, int fill, int color);
+int fb_text(int x, int y, int x_max, const char *text);
+unsigned long fb_push(int pen_color);
+
+#endif /* FB_H_ */
@@ -0,0 +1,245 @@
+/*
+ * fb_bench.c
+ *
+ *  Created on: 19.10.2026
+ *
+ * Benchmark of the framebuffer kernels against per pixel drawing.
+ *
+ * Every operation is timed with the span kernels of fb.c, with a per pixel
+ * loop on a page packed buffer and with the routine of the dog128 library.
+ * The kernels are checked against the per pixel loop first, the exit code
+ * is 1 on a difference. Build and run with `make bench-fb`.
+ */
+
+#include "gpiod.h"
+#include "fb.h"
+
+#define BENCH_RUNS 2000
+
+static uint8_t reference[FB_PAGES][FB_WIDTH];
+
+/**
+ * Set or clear one pixel like the per pixel routines of the library.
+ */
+static void reference_pixel(int x, int y, int color) {
+  if (color) {
+    reference[y / 8][x] |= 1 << (y % 8);
+  } else {
+    reference[y / 8][x] &= ~(1 << (y % 8));
+  }
+}
+
+static void reference_fill(int x1, int y1, int x2, int y2, int color) {
+  int x, y;
+
+  for (y = y1; y <= y2; y++) {
+    for (x = x1; x <= x2; x++) {
+      reference_pixel(x, y, color);
+    }
+  }
+}
+
+/**
+ * Fill an ellipse pixel by pixel, a pixel is inside if it is within half a
+ * pixel outside the radius like in fb_ellipse.
+ */
+static void reference_ellipse(int cx, int cy, int rx, int ry, int color) {
+  long long w = 2 * rx + 1, h = 2 * ry + 1, dx, dy;
+  int x, y;
+
+  for (y = 0; y < FB_HEIGHT; y++) {
+    for (x = 0; x < FB_WIDTH; x++) {
+      dx = x - cx;
+      dy = y - cy;
+      if (4 * h * h * dx * dx <= w * w * (h * h - 4 * dy * dy)) {
+        reference_pixel(x, y, color);
+      }
+    }
+  }
+}
+
+static void reference_invert() {
+  int x, y;
+
+  for (y = 0; y < FB_HEIGHT; y++) {
+    for (x = 0; x < FB_WIDTH; x++) {
+      reference_pixel(x, y, !((reference[y / 8][x] >> (y % 8)) & 1));
+    }
+  }
+}
+
+static void fb_invert_pages() {
+  Framebuffer *fb = get_framebuffer();
+  int page;
+
+  for (page = 0; page < FB_PAGES; page++) {
+    fb_span(fb->pages[page], 0, FB_WIDTH - 1, 0xff, FB_XOR);
+  }
+}
+
+/**
+ * Compare the framebuffer with the per pixel reference.
+ */
+static int check(const char *name) {
+  if (memcmp(get_framebuffer()->pages, reference, sizeof(reference)) != 0) {
+    printf("%s: framebuffer differs from per pixel reference\n", name);
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * Check random fills, filled ellipses and inversions.
+ */
+static int check_kernels() {
+  int i, x1, y1, x2, y2, color, failed = 0;
+
+  srand(42);
+  fb_clear();
+  memset(reference, 0, sizeof(reference));
+  for (i = 0; i < 10000 && !failed; i++) {
+    x1    = rand() % FB_WIDTH;
+    y1    = rand() % FB_HEIGHT;
+    x2    = x1 + rand() % (FB_WIDTH - x1);
+    y2    = y1 + rand() % (FB_HEIGHT - y1);
+    color = rand() & 1;
+    fb_fill(x1, y1, x2, y2, color);
+    reference_fill(x1, y1, x2, y2, color);
+    failed = check("fill");
+    if (i % 10 == 0 && !failed) {
+      x1    = rand() % FB_WIDTH;
+      y1    = rand() % FB_HEIGHT;
+      x2    = rand() % 40;
+      y2    = rand() % 40;
+      color = rand() & 1;
+      fb_ellipse(x1, y1, x2, y2, 1, color);
+      reference_ellipse(x1, y1, x2, y2, color);
+      failed = check("ellipse");
+    }
+    if (i % 100 == 0 && !failed) {
+      fb_invert_pages();
+      reference_invert();
+      failed = check("invert");
+    }
+  }
+  return failed;
+}
+
+/**
+ * Print the time of one run in nanoseconds.
+ */
+static void report(const char *name, const char *kind, unsigned long long start) {
+  printf("%-18s %-10s %8llu ns\n", name, kind, (get_monotonic_ns() - start) / BENCH_RUNS);
+}
+
+/**
+ * Time the kernel, the per pixel loop and the library for a fill.
+ */
+static void bench_fill(const char *name, int x1, int y1, int x2, int y2) {
+  unsigned long long start;
+  int i;
+
+  start = get_monotonic_ns();
+  for (i = 0; i < BENCH_RUNS; i++) {
+    fb_fill(x1, y1, x2, y2, i & 1);
+  }
+  report(name, "fb", start);
+  start = get_monotonic_ns();
+  for (i = 0; i < BENCH_RUNS; i++) {
+    reference_fill(x1, y1, x2, y2, i & 1);
+  }
+  report(name, "per pixel", start);
+  start = get_monotonic_ns();
+  for (i = 0; i < BENCH_RUNS; i++) {
+    setPenColor(i & 1);
+    rect(x1, y1, x2, y2, 1);
+  }
+  report(name, "dog128", start);
+}
+
+/**
+ * Time the kernel, the per pixel loop and the library for a filled ellipse.
+ */
+static void bench_ellipse(const char *name, int x, int y, int rx, int ry) {
+  unsigned long long start;
+  int i;
+
+  start = get_monotonic_ns();
+  for (i = 0; i < BENCH_RUNS; i++) {
+    fb_ellipse(x, y, rx, ry, 1, i & 1);
+  }
+  report(name, "fb", start);
+  start = get_monotonic_ns();
+  for (i = 0; i < BENCH_RUNS; i++) {
+    reference_ellipse(x, y, rx, ry, i & 1);
+  }
+  report(name, "per pixel", start);
+  start = get_monotonic_ns();
+  for (i = 0; i < BENCH_RUNS; i++) {
+    setPenColor(i & 1);
+    ellipse(x, y, rx, ry, 1);
+  }
+  report(name, "dog128", start);
+}
+
+static void bench_clear_invert() {
+  unsigned long long start;
+  int i;
+
+  start = get_monotonic_ns();
+  for (i = 0; i < BENCH_RUNS; i++) {
+    fb_clear();
+  }
+  report("clear", "fb", start);
+  start = get_monotonic_ns();
+  for (i = 0; i < BENCH_RUNS; i++) {
+    reference_fill(0, 0, FB_WIDTH - 1, FB_HEIGHT - 1, 0);
+  }
+  report("clear", "per pixel", start);
+  start = get_monotonic_ns();
+  for (i = 0; i < BENCH_RUNS; i++) {
+    clear();
+  }
+  report("clear", "dog128", start);
+
+  start = get_monotonic_ns();
+  for (i = 0; i < BENCH_RUNS; i++) {
+    fb_invert();
+  }
+  report("invert", "fb", start);
+  start = get_monotonic_ns();
+  for (i = 0; i < BENCH_RUNS; i++) {
+    reference_invert();
+  }
+  report("invert", "per pixel", start);
+  start = get_monotonic_ns();
+  for (i = 0; i < BENCH_RUNS; i++) {
+    invert();
+  }
+  report("invert", "dog128", start);
+}
+
+/**
+ * \brief Monotonic time, gpiod.c is not linked into the benchmark.
+ */
+unsigned long long get_monotonic_ns() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+  if (check_kernels()) {
+    return 1;
+  }
+  init(DI, LED, SPICS);
+  printf("framebuffer kernel: %s, %d runs\n", fb_kernel_name(), BENCH_RUNS);
+  bench_fill("fill 128x64", 0, 0, FB_WIDTH - 1, FB_HEIGHT - 1);
+  bench_fill("fill 61x21 at 3,5", 3, 5, 63, 25);
+  bench_fill("fill 8x8", 40, 16, 47, 23);
+  bench_ellipse("ellipse 30x20", 64, 32, 30, 20);
+  bench_ellipse("circle 8", 20, 20, 8, 8);
+  bench_clear_invert();
+  return 0;
+}
@@ -4,6 +4,7 @@
  */ 
 
 #include "gpiod.h"
+#include "gpiod_state.h"
 
 /** 
  * \brief Pid file for deamon mode.
@@ -12,7 +13,7 @@
  */
 #define PID_FILE "/var/run/gpiod.pid"
 
-static char *pinNames [] = {
+static char *pinNames [NUM_PINS] = {
     "GPIO 0",
     "GPIO 1",
     "GPIO 2",
@@ -30,17 +31,13 @@ static char *pinNames [] = {
     "SCLK  ",
     "TxD   ",
     "RxD   ",
-    "GPIO 8",
-    "GPIO 9",
-    "GPIO10",
-    "GPIO11",
 };
 
 
 char *socket_filename;    /**< Socket file name */
+char *packet_socket_filename = NULL; /**< SOCK_SEQPACKET socket file name or NULL */
 int flag_verbose     = 0; /**< variable to set verbose output */
 int flag_dont_detach = 0; /**< variable to not run as daemon */
-int client_socket_fd = 0;
 
 /**
  * \brief Set verbose flag
@@ -90,10 +87,27 @@ char* get_socket_filename() {
 }
 
 /**
- * \brief get client socket file descriptor.
+ * \brief set the file name of the packet socket
+ *
+ * @param name The file name or NULL for no packet socket.
  */
-int get_client_socket_fd() {
-	return client_socket_fd;
+void set_packet_socket_filename(char* name) {
+	packet_socket_filename = name;
+}
+
+char* get_packet_socket_filename() {
+	return packet_socket_filename;
+}
+
+/**
+ * \brief get monotonic time
+ *
+ * @return monotonic clock in nanoseconds.
+ */
+unsigned long long get_monotonic_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
 }
 
 /**
@@ -102,13 +116,19 @@ int get_client_socket_fd() {
  * Print the usage to stdout.
  */
 void usage() {
-  printf("Usage: gpiod [ -d ] [ -v ] [ -s socketfile ] [ -a diport ] [ -l ledport ] [ -c spics ] [ -i configfile ] [ -h ]\n");
+  printf("Usage: gpiod [ -d ] [ -v ] [ -s socketfile ] [ -p packetfile ] [ -a diport ] [ -l ledport ] [ -c spics ] [ -b backend ] [ -m statename ] [ -r tracefile ] [ -k snapfile ] [ -t jsonfile ] [ -i configfile ] [ -h ]\n");
   printf("    -d            don't daemonize\n");
   printf("    -v            verbose\n");
   printf("    -s sockefile  use the given file for for socket\n");
+  printf("    -p packetfile also listen on a SOCK_SEQPACKET socket, one command or batch per packet\n");
   printf("    -a diport     set di pin of the lcd display (default: %d)\n", DI);
   printf("    -l ledport    set backlight pwm port of the lcd display (default: %d)\n", LED);
   printf("    -c spics      set the spi chipselect fo the lcd display (default: %d)\n", SPICS);
+  printf("    -b backend    gpio backend wiringpi, mock, mmap[:device] or chardev[:device] (default: wiringpi)\n");
+  printf("    -m statename  shared memory name of the pin state or none (default: %s)\n", GPIOD_STATE_NAME);
+  printf("    -r tracefile  record the commands and edges to the trace file\n");
+  printf("    -k snapfile   keep the pins, pwm and lcd in a snapshot file across restarts\n");
+  printf("    -t jsonfile   timeline of TRACE DUMP and SIGUSR1 (default: %s)\n", TRACE_FILE);
   printf("    -i configfile use the given config file to configure gpiod\n");
   printf("    -h            show help (this message)\n");
 }
@@ -120,34 +140,54 @@ void do_write_info(int client_socket_fd) {
     write_msg_to_client(client_socket_fd, "WRITE pin value => Write value output pin.");
     write_msg_to_client(client_socket_fd, "READALL => Read all pins.");
     write_msg_to_client(client_socket_fd, "MODE pin mode => Set mode of pin. possible modes: (IN|OUT).");
+    write_msg_to_client(client_socket_fd, "PULSE pin level width_us => Write a pulse of level.");
+    write_msg_to_client(client_socket_fd, "WRITEAT pin value ns => Write at monotonic time.");
+    write_msg_to_client(client_socket_fd, "WRITEAFTER pin value us => Write after delay.");
+    write_msg_to_client(client_socket_fd, "WAIT pin 0|1|EDGE timeout_ms => Wait for a level or an edge.");
+    write_msg_to_client(client_socket_fd, "WAITANY mask [timeout_ms] => Wait for an edge of the pins of the mask.");
+    write_msg_to_client(client_socket_fd, "PWM pin [duty] => Set or read pwm duty 0 to 1024.");
+    write_msg_to_client(client_socket_fd, "FADE pin from to duration_ms [linear|gamma] => Fade pwm duty.");
+    write_msg_to_client(client_socket_fd, "BUSWRITE group value => Write value to pin group.");
+    write_msg_to_client(client_socket_fd, "BUSREAD group => Read value of pin group.");
+    write_msg_to_client(client_socket_fd, "SHIFTOUT data clk latch MSB|LSB byte... => Shift bytes out.");
+    write_msg_to_client(client_socket_fd, "SHIFTIN data clk load MSB|LSB count => Shift bytes in.");
+    write_msg_to_client(client_socket_fd, "SERIALOUT name byte... => Shift out with serial engine.");
+    write_msg_to_client(client_socket_fd, "SERIALIN name count => Shift in with serial engine.");
+    write_msg_to_client(client_socket_fd, "EVENTS [IMMEDIATE|BATCH max ms|AGGREGATE ON|OFF|PREFIX EVENT|OK] => Set event delivery.");
+    write_msg_to_client(client_socket_fd, "#id command => Answer every line of command with #id.");
+    write_msg_to_client(client_socket_fd, "TAGS [BEGIN ON|OFF] => Start tagged multi line answers with #id BEGIN.");
+    write_msg_to_client(client_socket_fd, "STATS => Show daemon statistics.");
+    write_msg_to_client(client_socket_fd, "TRACE [ON|OFF|DUMP] => Trace spans, dump as Chrome trace JSON.");
+    write_msg_to_client(client_socket_fd, "LOG [module|ALL level] => Show or set the log level of the modules.");
 }
+
 /**
- * \brief strrpos implementation.
- * 
- * Self impelemtation of strrpos
- * 
- * @param string The string to search into.
- * @param niddle The char where will be searched.
- * 
- * @return char position or -1
- */
-int strrpos(char *string, char niddle) {
-    char *pos_info;
-    
-    pos_info = strrchr(string, niddle);
-    if (pos_info == NULL) {
-        return -1;
-    } else {
-        return pos_info - string;
+ * \brief Write the daemon statistics.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ */
+void do_write_stats(int client_socket_fd) {
+    do_write_scheduler_stats(client_socket_fd);
+    do_write_event_stats(client_socket_fd);
+    do_write_output_stats(client_socket_fd);
+    do_write_rules_stats(client_socket_fd);
+    do_write_pwm_stats(client_socket_fd);
+    do_write_wait_stats(client_socket_fd);
+    if (gpio_backend->write_stats != NULL) {
+      gpio_backend->write_stats(client_socket_fd);
     }
+    do_write_lcd_stats(client_socket_fd);
+    do_write_trace_stats(client_socket_fd);
+    do_write_log_stats(client_socket_fd);
+    do_write_snapshot_stats(client_socket_fd);
 }
-
 /**
  * Delete the pid file for cleanup.
  */
 void delete_pid_file() {
   if (unlink(PID_FILE) == -1) {
-    perror(PID_FILE);
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "%s: %m", PID_FILE);
+    flush_log();
     exit (EXIT_FAILURE);
   }
 }
@@ -157,7 +197,13 @@ void delete_pid_file() {
  */
 void delete_socket_file() {
   if (unlink(socket_filename) == -1) {
-    perror(socket_filename);
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "%s: %m", socket_filename);
+    flush_log();
+    exit (EXIT_FAILURE);
+  }
+  if (packet_socket_filename != NULL && unlink(packet_socket_filename) == -1) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "%s: %m", packet_socket_filename);
+    flush_log();
     exit (EXIT_FAILURE);
   }
 }
@@ -170,9 +216,42 @@ void cleanup_and_exit() {
     delete_pid_file();
   }
   delete_socket_file();
+  cleanup_state();
+  cleanup_record();
+  flush_log();
   exit(EXIT_SUCCESS);
 }
 
+#ifndef NO_SIG_HANDLER
+/**
+ * \brief Thread to reload the config file on SIGHUP, switch the trace on SIGUSR1
+ * and exit on SIGTERM and SIGINT.
+ *
+ * SIGHUP, SIGUSR1, SIGTERM and SIGINT are blocked in all threads and only
+ * accepted here with sigwait. So the reload, the trace dump and the last
+ * snapshot write run outside of a signal handler and neither the client read
+ * nor the isr threads are interrupted.
+ *
+ * @param arg The signal set with SIGHUP, SIGUSR1, SIGTERM and SIGINT.
+ */
+void *reload_signal_thread(void *arg) {
+  sigset_t *set = (sigset_t *) arg;
+  int sig;
+
+  while (sigwait(set, &sig) == 0) {
+    if (sig == SIGHUP) {
+      reload_config(CLIENT_BROADCAST);
+    } else if (sig == SIGUSR1) {
+      trace_toggle();
+    } else if (sig == SIGTERM || sig == SIGINT) {
+      save_snapshot();
+      cleanup_and_exit();
+    }
+  }
+  return NULL;
+}
+#endif
+
 /**
  * Write pid file if started as daemon.
  */
@@ -186,6 +265,169 @@ void write_pid_file() {
   fclose(pid_file);
 }
 
+/**
+ * \brief Tag of the command answered by the current thread.
+ */
+typedef struct ReplyTag {
+  const char *tag;   //> The tag with # or NULL if the command has no tag.
+  int written;       //> Count of answers written with the tag.
+  int deferred;      //> 1 if the answer is written later.
+  int packet_fd;     //> Packet client of the answer or -1.
+  char *packet;      //> The answer to a packet client, written as one packet.
+  size_t packet_len;
+  size_t packet_size;
+} ReplyTag;
+
+static __thread ReplyTag reply_tag = { NULL, 0, 0, -1, NULL, 0, 0 };
+
+/**
+ * \brief Set the tag of the answers written by the current thread.
+ *
+ * @param tag The tag with # or NULL or an empty string for no tag.
+ */
+void set_reply_tag(const char *tag) {
+  reply_tag.tag      = (tag != NULL && tag[0] != '\0') ? tag : NULL;
+  reply_tag.written  = 0;
+  reply_tag.deferred = 0;
+  reply_tag.packet_fd  = -1;
+  reply_tag.packet_len = 0;
+}
+
+/**
+ * \brief Start the answer of a command.
+ *
+ * The answer to a packet client is collected until end_reply and written
+ * as one packet. A tagged multi line answer starts with "#id BEGIN" if the
+ * client asked for it with TAGS BEGIN ON.
+ *
+ * @param fd         The client socket.
+ * @param tag        The tag with # or NULL or an empty string for no tag.
+ * @param multi_line 1 if the command has a multi line answer.
+ */
+void begin_reply(int fd, const char *tag, int multi_line) {
+  set_reply_tag(tag);
+  if (is_packet_client(fd)) {
+    reply_tag.packet_fd = fd;
+  }
+  if (reply_tag.tag != NULL && multi_line && client_tags_begin(fd)) {
+    write_to_client(fd, "BEGIN\n", 6);
+  }
+}
+
+/**
+ * \brief Keep the tag of the current command for a later answer.
+ *
+ * @param tag Buffer of REPLY_TAG_SIZE, empty if the command has no tag.
+ */
+void defer_reply(char *tag) {
+  snprintf(tag, REPLY_TAG_SIZE, "%s", reply_tag.tag != NULL ? reply_tag.tag : "");
+  reply_tag.deferred = 1;
+}
+
+/**
+ * \brief Finish the answer of a tagged command.
+ *
+ * A multi line answer ends with "#id END", a command without an answer
+ * gets "#id OK - operation performed", so every tagged command is
+ * answered. Untagged commands are answered as before.
+ *
+ * @param fd         The client socket.
+ * @param multi_line 1 if the command has a multi line answer.
+ */
+void end_reply(int fd, int multi_line) {
+  if (reply_tag.tag != NULL) {
+    if (multi_line) {
+      write_to_client(fd, "END\n", 4);
+    } else if (reply_tag.written == 0 && !reply_tag.deferred) {
+      write_msg_to_client(fd, "operation performed");
+    }
+  }
+  if (reply_tag.packet_len > 0) {
+    write_client_output(reply_tag.packet_fd, reply_tag.packet, reply_tag.packet_len);
+  }
+  set_reply_tag(NULL);
+}
+
+/**
+ * Write an answer, the answer to a packet client is collected.
+ */
+static void write_reply(int fd, const char *buf, size_t len) {
+  size_t size;
+  char *packet;
+
+  if (fd != reply_tag.packet_fd) {
+    write_client_output(fd, buf, len);
+    return;
+  }
+  if (reply_tag.packet_len + len > reply_tag.packet_size) {
+    size = reply_tag.packet_size ? reply_tag.packet_size : BUFFER_SIZE * 8;
+    while (size < reply_tag.packet_len + len) {
+      size *= 2;
+    }
+    if ((packet = realloc(reply_tag.packet, size)) == NULL) {
+      return;
+    }
+    reply_tag.packet      = packet;
+    reply_tag.packet_size = size;
+  }
+  memcpy(reply_tag.packet + reply_tag.packet_len, buf, len);
+  reply_tag.packet_len += len;
+}
+
+/**
+ * Write data with the reply tag before every line.
+ */
+static void write_tagged(int fd, const char *buf, size_t len) {
+  char stack_buf[4 * BUFFER_SIZE], *out = stack_buf;
+  size_t tag_len = strlen(reply_tag.tag), out_len = 0, lines = 0, i;
+  const char *line = buf, *newline;
+
+  for (i = 0; i < len; i++) {
+    lines += buf[i] == '\n';
+  }
+  if (len > 0 && buf[len - 1] != '\n') {
+    lines++;
+  }
+  if (len + lines * (tag_len + 1) > sizeof(stack_buf) && (out = malloc(len + lines * (tag_len + 1))) == NULL) {
+    return;
+  }
+  while (line < buf + len) {
+    newline = memchr(line, '\n', buf + len - line);
+    newline = newline != NULL ? newline + 1 : buf + len;
+    memcpy(out + out_len, reply_tag.tag, tag_len);
+    out[out_len + tag_len] = ' ';
+    out_len += tag_len + 1;
+    memcpy(out + out_len, line, newline - line);
+    out_len += newline - line;
+    line = newline;
+  }
+  write_reply(fd, out, out_len);
+  reply_tag.written++;
+  if (out != stack_buf) {
+    free(out);
+  }
+}
+
+/**
+ * \brief Write to a socket client.
+ *
+ * All answers and events are written here. Answers of a tagged command
+ * get the tag before every line.
+ *
+ * @param fd  Socket file descriptor or CLIENT_BROADCAST for all clients.
+ * @param buf Data to write.
+ * @param len Length of the data.
+ */
+void write_to_client(int fd, const char *buf, size_t len) {
+  if (fd == CLIENT_BROADCAST) {
+    broadcast_to_clients(buf, len);
+  } else if (reply_tag.tag != NULL) {
+    write_tagged(fd, buf, len);
+  } else {
+    write_reply(fd, buf, len);
+  }
+}
+
 /**
  * Write error message to socket client.
  * 
@@ -197,7 +439,7 @@ void write_error_msg_to_client(int fd, char *msg) {
   size_t len;
   snprintf(buf, BUFFER_SIZE, "%s - %s\n", SERVER_ERROR, msg);
   len = strlen(buf);
-  write(fd, buf, len);
+  write_to_client(fd, buf, len);
 }
 
 /**
@@ -211,7 +453,7 @@ void write_int_value_to_client(int fd, int value) {
   size_t len;
   snprintf(buf, BUFFER_SIZE, "%s - %d\n", SERVER_OK, value);
   len = strlen(buf);
-  write(fd, buf, len);
+  write_to_client(fd, buf, len);
 }
 
 /**
@@ -225,7 +467,7 @@ void write_msg_to_client(int fd, char *msg) {
   size_t len;
   snprintf(buf, BUFFER_SIZE, "%s - %s\n", SERVER_OK, msg);
   len = strlen(buf);
-  write(fd, buf, len);
+  write_to_client(fd, buf, len);
 }
 
 /**
@@ -234,20 +476,22 @@ void write_msg_to_client(int fd, char *msg) {
  * @param fd File descriptor of the socket.
  */
 void write_all_data_to_client(int fd) {
-  int pin;
+  // One bank read, the chardev backend doesn't request lines to read them.
+  unsigned int levels = gpio_read_bank();
+  int pin, value;
   char msg[BUFFER_SIZE];
   size_t len;
 
-  if (flag_verbose) {
-    printf("EXECUTING %s\n", CLIENT_READALL);
-  }  
+  log_msg(LOG_MOD_GPIO, LOG_DEBUG, "EXECUTING %s", CLIENT_READALL);
   snprintf(msg, BUFFER_SIZE, "%s\n", SERVER_OK);
   len = strlen(msg);
-  write(fd, msg, len);
+  write_to_client(fd, msg, len);
   for (pin = 0 ; pin < NUM_PINS ; ++pin) {
-    snprintf(msg, BUFFER_SIZE, "%d %3d %s %d\n", pin, wpiPinToGpio(pin), pinNames[pin], digitalRead(pin));
+    value = (levels >> pin) & 1;
+    state_set_level(pin, value);
+    snprintf(msg, BUFFER_SIZE, "%d %3d %s %d\n", pin, gpio_pin_to_gpio(pin), pinNames[pin], value);
     len = strlen(msg);
-    write(fd, msg, len);
+    write_to_client(fd, msg, len);
   }
 }
 
@@ -259,7 +503,7 @@ void write_all_data_to_client(int fd) {
  * @return 0 or 1
  */
 int is_valid_pin_num(int pin_num) {
-  return (pin_num >= 0) && (pin_num < 16);
+  return (pin_num >= 0) && (pin_num < NUM_PINS);
 }
 
 /**
@@ -293,22 +537,20 @@ int is_valid_pin_mode(char *mode_str) {
  * @param buf              Input Command.
  */
 void do_read_from_pin(int client_socket_fd, char *buf) {
+  char args[BUFFER_SIZE];
   int pin_num;
-  int n = sscanf(buf, "%d", &pin_num);
+  int n = sscanf(expand_pin_alias(buf, args, BUFFER_SIZE), "%d", &pin_num);
   if (n != 1) {
     write_error_msg_to_client(client_socket_fd, "parameter of type integer expected");
   } else if (!is_valid_pin_num(pin_num)) {
     write_error_msg_to_client(client_socket_fd, "unknown port number");
   } else {
     int value;
-    if (flag_verbose) {
-      printf("EXECUTING %s PIN %d\n", CLIENT_READ, pin_num);
-    }
+    log_msg(LOG_MOD_GPIO, LOG_DEBUG, "EXECUTING %s PIN %d", CLIENT_READ, pin_num);
 
-    value = digitalRead(pin_num);
-    if (flag_verbose) {
-      printf("VALUE = %d\n", value);
-    }
+    value = gpio_digital_read(pin_num);
+    state_set_level(pin_num, value);
+    log_msg(LOG_MOD_GPIO, LOG_DEBUG, "VALUE = %d", value);
     write_int_value_to_client(client_socket_fd, value);
   }
 }
@@ -322,8 +564,9 @@ void do_read_from_pin(int client_socket_fd, char *buf) {
  * @param buf              The command.
  */
 void do_write_to_pin(int client_socket_fd, char *buf) {
+  char args[BUFFER_SIZE];
   int pin_num, value;
-  int n = sscanf(buf, "%d %d", &pin_num, &value);
+  int n = sscanf(expand_pin_alias(buf, args, BUFFER_SIZE), "%d %d", &pin_num, &value);
   if (n != 2) {
     write_error_msg_to_client(client_socket_fd, "expected WRITE <#pin> <0|1>");
   } else if (!is_valid_pin_num(pin_num)) {
@@ -331,10 +574,9 @@ void do_write_to_pin(int client_socket_fd, char *buf) {
   } else if (!is_valid_pin_value(value)) {
     write_error_msg_to_client(client_socket_fd, "value must be 0 or 1");
   } else {
-    if (flag_verbose) {
-      printf("EXECUTING %s PIN %d VALUE = %d\n", CLIENT_WRITE, pin_num, value);
-    }
-    digitalWrite(pin_num, value);
+    log_msg(LOG_MOD_GPIO, LOG_DEBUG, "EXECUTING %s PIN %d VALUE = %d", CLIENT_WRITE, pin_num, value);
+    gpio_digital_write(pin_num, value);
+    state_set_level(pin_num, value);
     write_msg_to_client(client_socket_fd, "operation performed");
   }
 }
@@ -348,9 +590,9 @@ void do_write_to_pin(int client_socket_fd, char *buf) {
  * @param buf              The command.
  */
 void do_set_pin_mode(int client_socket_fd, char *buf) {
-  char mode_str[BUFFER_SIZE];
+  char mode_str[BUFFER_SIZE], args[BUFFER_SIZE];
   int pin_num;
-  int n = sscanf(buf, "%d %s", &pin_num, mode_str);
+  int n = sscanf(expand_pin_alias(buf, args, BUFFER_SIZE), "%d %s", &pin_num, mode_str);
   if (n != 2) {
     write_error_msg_to_client(client_socket_fd, "expected MODE <#pin> <IN|OUT>");
   } else if (!is_valid_pin_num(pin_num)) {
@@ -359,14 +601,30 @@ void do_set_pin_mode(int client_socket_fd, char *buf) {
     write_error_msg_to_client(client_socket_fd, "mode must be IN or OUT");
   } else {
     int mode = strcmp(mode_str, "IN")==0?0:1;
-    if (flag_verbose) {
-      printf("EXECUTING %s PIN %d DIR = %s (%d)\n", CLIENT_MODE, pin_num, mode_str, mode);
-    }
-    pinMode(pin_num, mode);
+    log_msg(LOG_MOD_GPIO, LOG_DEBUG, "EXECUTING %s PIN %d DIR = %s (%d)", CLIENT_MODE, pin_num, mode_str, mode);
+    gpio_pin_mode(pin_num, mode);
+    state_set_mode(pin_num, mode);
     write_msg_to_client(client_socket_fd, "operation performed");
   }
 }
 
+/**
+ * Get the arguments of a command.
+ *
+ * @param command The command line.
+ * @param len     Length of the command name.
+ *
+ * @return The arguments, an empty string if there are none.
+ */
+char *command_arguments(char *command, size_t len) {
+  char *args = command + len;
+
+  if (*args == ' ') {
+    args++;
+  }
+  return args;
+}
+
 /**
  * Read command and select the right subroutine.
  * 
@@ -374,16 +632,55 @@ void do_set_pin_mode(int client_socket_fd, char *buf) {
  * @param client_socket_fd The socket file descriptor.
  */
 void read_command(char *command, int client_socket_fd) {
+    state_count_command();
     if (strncmp(command, CLIENT_READALL, 7) == 0) {
       write_all_data_to_client(client_socket_fd);
     } else if (strncmp(command, CLIENT_READ, strlen(CLIENT_READ)) == 0) {
-      do_read_from_pin(client_socket_fd, command + strlen(CLIENT_READ) + 1);
+      do_read_from_pin(client_socket_fd, command_arguments(command, strlen(CLIENT_READ)));
+    } else if (strncmp(command, CLIENT_WRITEAT, strlen(CLIENT_WRITEAT)) == 0) {
+      do_write_at(client_socket_fd, command_arguments(command, strlen(CLIENT_WRITEAT)));
+    } else if (strncmp(command, CLIENT_WRITEAFTER, strlen(CLIENT_WRITEAFTER)) == 0) {
+      do_write_after(client_socket_fd, command_arguments(command, strlen(CLIENT_WRITEAFTER)));
     } else if (strncmp(command, CLIENT_WRITE, strlen(CLIENT_WRITE)) == 0) {
-      do_write_to_pin(client_socket_fd, command + strlen(CLIENT_WRITE) + 1);
+      do_write_to_pin(client_socket_fd, command_arguments(command, strlen(CLIENT_WRITE)));
+    } else if (strncmp(command, CLIENT_BUSWRITE, strlen(CLIENT_BUSWRITE)) == 0) {
+      do_bus_write(client_socket_fd, command_arguments(command, strlen(CLIENT_BUSWRITE)));
+    } else if (strncmp(command, CLIENT_BUSREAD, strlen(CLIENT_BUSREAD)) == 0) {
+      do_bus_read(client_socket_fd, command_arguments(command, strlen(CLIENT_BUSREAD)));
+    } else if (strncmp(command, CLIENT_SHIFTOUT, strlen(CLIENT_SHIFTOUT)) == 0) {
+      do_shift_out(client_socket_fd, command_arguments(command, strlen(CLIENT_SHIFTOUT)));
+    } else if (strncmp(command, CLIENT_SHIFTIN, strlen(CLIENT_SHIFTIN)) == 0) {
+      do_shift_in(client_socket_fd, command_arguments(command, strlen(CLIENT_SHIFTIN)));
+    } else if (strncmp(command, CLIENT_SERIALOUT, strlen(CLIENT_SERIALOUT)) == 0) {
+      do_serial_out(client_socket_fd, command_arguments(command, strlen(CLIENT_SERIALOUT)));
+    } else if (strncmp(command, CLIENT_SERIALIN, strlen(CLIENT_SERIALIN)) == 0) {
+      do_serial_in(client_socket_fd, command_arguments(command, strlen(CLIENT_SERIALIN)));
+    } else if (strncmp(command, CLIENT_PWM, strlen(CLIENT_PWM)) == 0) {
+      do_pwm(client_socket_fd, command_arguments(command, strlen(CLIENT_PWM)));
+    } else if (strncmp(command, CLIENT_FADE, strlen(CLIENT_FADE)) == 0) {
+      do_fade(client_socket_fd, command_arguments(command, strlen(CLIENT_FADE)));
+    } else if (strncmp(command, CLIENT_PULSE, strlen(CLIENT_PULSE)) == 0) {
+      do_pulse(client_socket_fd, command_arguments(command, strlen(CLIENT_PULSE)));
     } else if (strncmp(command, CLIENT_MODE, 4) == 0) {
-      do_set_pin_mode(client_socket_fd, command + strlen(CLIENT_MODE) + 1);
+      do_set_pin_mode(client_socket_fd, command_arguments(command, strlen(CLIENT_MODE)));
     } else if (strncmp(command, CLIENT_LCD, strlen(CLIENT_LCD)) == 0) {
-      do_lcd_commands(client_socket_fd, command + strlen(CLIENT_LCD) + 1);
+      do_lcd_commands(client_socket_fd, command_arguments(command, strlen(CLIENT_LCD)));
+    } else if (strncmp(command, CLIENT_WAITANY, strlen(CLIENT_WAITANY)) == 0) {
+      do_wait_any(client_socket_fd, command_arguments(command, strlen(CLIENT_WAITANY)));
+    } else if (strncmp(command, CLIENT_WAIT, strlen(CLIENT_WAIT)) == 0) {
+      do_wait(client_socket_fd, command_arguments(command, strlen(CLIENT_WAIT)));
+    } else if (strncmp(command, CLIENT_MOCK, strlen(CLIENT_MOCK)) == 0) {
+      do_mock_command(client_socket_fd, command_arguments(command, strlen(CLIENT_MOCK)));
+    } else if (strncmp(command, CLIENT_EVENTS, strlen(CLIENT_EVENTS)) == 0) {
+      do_events(client_socket_fd, command_arguments(command, strlen(CLIENT_EVENTS)));
+    } else if (strncmp(command, CLIENT_TAGS, strlen(CLIENT_TAGS)) == 0) {
+      do_tags(client_socket_fd, command_arguments(command, strlen(CLIENT_TAGS)));
+    } else if (strncmp(command, CLIENT_TRACE, strlen(CLIENT_TRACE)) == 0) {
+      do_trace(client_socket_fd, command_arguments(command, strlen(CLIENT_TRACE)));
+    } else if (strncmp(command, CLIENT_LOG, strlen(CLIENT_LOG)) == 0) {
+      do_log(client_socket_fd, command_arguments(command, strlen(CLIENT_LOG)));
+    } else if (strncmp(command, CLIENT_STATS, strlen(CLIENT_STATS)) == 0) {
+      do_write_stats(client_socket_fd);
     } else if (strncmp(command, CLIENT_INFO, strlen(CLIENT_INFO)) == 0) {
     	do_write_info(client_socket_fd);
     	do_write_lcd_info(client_socket_fd);
@@ -393,92 +690,249 @@ void read_command(char *command, int client_socket_fd) {
 }
 
 /**
- * Read client input function for endless loop.
- * 
- * @param socketfd Read client input.
- * @return Allways 1
+ * Accept a new client connection.
+ *
+ * @param socketfd The listening socket.
+ * @param packet   1 for the SOCK_SEQPACKET socket.
  */
-int read_client(int socketfd) {
+void accept_client(int socketfd, int packet) {
   struct sockaddr_un address;
   socklen_t address_len = sizeof(address);
-  int n, parted = 0, len;
-  char new_line = '\n';
-  char *command, *rest = NULL, *part = NULL, *step, buf[BUFFER_SIZE];
-  
-  step = malloc(BUFFER_SIZE*2);
-  bzero(buf, BUFFER_SIZE);
+  unsigned long long trace_ns = trace_begin();
+  int fd;
 
-  if ((client_socket_fd = accept(socketfd, (struct sockaddr *) &address, &address_len)) < 0) {
-    perror("accept");
+  if ((fd = accept(socketfd, (struct sockaddr *) &address, &address_len)) < 0) {
+    log_msg(LOG_MOD_CLIENT, LOG_ERR, "accept: %m");
+    return;
   }
-  
+  // A client that does not read must never block a writer.
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+  if (add_client(fd, packet) == -1) {
+    write_error_msg_to_client(fd, "too many clients");
+    close(fd);
+    return;
+  }
+  state_count_client();
+  record_connect(fd);
+  log_msg(LOG_MOD_CLIENT, LOG_DEBUG, "client connected: %d", fd);
+  trace_end(TRACE_ACCEPT, trace_ns, fd);
+}
 
-  while ( (n = read(client_socket_fd, buf, BUFFER_SIZE-1)) > 0 ) {
-    if (n == -1) {
-      perror("read");
+/**
+ * Schedule every line of a packet, a packet is a command or a batch of
+ * command lines.
+ *
+ * A packet is read as a whole, so no input is kept between two reads.
+ *
+ * @param client The packet client.
+ *
+ * @return 0 if the client closed the connection, otherwise 1.
+ */
+static int read_packet_client(Client *client) {
+  unsigned long long trace_ns = trace_begin();
+  char *line, *newline;
+  int fd = client->fd;
+  ssize_t n;
+
+  // MSG_TRUNC returns the length of the packet, also of a longer packet.
+  n = recv(fd, client->buf, CLIENT_BUFFER_SIZE - 1, MSG_TRUNC);
+  trace_end(TRACE_READ, trace_ns, fd);
+  if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+    return 1;
+  }
+  if (n == -1) {
+    log_msg(LOG_MOD_CLIENT, LOG_ERR, "recv: %m");
+  }
+  if (n <= 0) {
+    return 0;
+  }
+  if (n > CLIENT_BUFFER_SIZE - 1) {
+    write_error_msg_to_client(fd, "command too long");
+    return 1;
+  }
+  client->buf[n] = '\0';
+  log_msg(LOG_MOD_CLIENT, LOG_DEBUG, "client send packet: %s", client->buf);
+
+  for (line = client->buf; line != NULL; line = newline) {
+    if ((newline = strchr(line, '\n')) != NULL) {
+      *newline++ = '\0';
     }
-    if (flag_verbose) {
-        printf("client send: %s\n", buf);
+    line[strcspn(line, "\r")] = '\0';
+    if (*line != '\0') {
+      schedule_command(fd, line);
     }
-    
-    len = strlen(buf);
-    
-    if (parted) {
-        part = strndup(rest, strlen(rest));
-    } else {
-        if (part != NULL) {
-            free(part);
-        }
-        part = NULL;
+  }
+  return 1;
+}
+
+/**
+ * Read client input and schedule every complete command line.
+ *
+ * An incomplete line stays in the client buffer until the rest is read.
+ * 
+ * @param fd The client socket.
+ *
+ * @return 0 if the client closed the connection, otherwise 1.
+ */
+int read_client(int fd) {
+  Client *client = find_client(fd);
+  unsigned long long trace_ns = trace_begin();
+  char *line, *newline;
+  int n;
+
+  if (client == NULL) {
+    return 0;
+  }
+  if (client->packet) {
+    return read_packet_client(client);
+  }
+  n = read(fd, client->buf + client->len, CLIENT_BUFFER_SIZE - 1 - client->len);
+  trace_end(TRACE_READ, trace_ns, fd);
+  if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+    return 1;
+  }
+  if (n == -1) {
+    log_msg(LOG_MOD_CLIENT, LOG_ERR, "read: %m");
+  }
+  if (n <= 0) {
+    // A last command without newline is executed before the close.
+    if (client->len > 0) {
+      client->buf[client->len] = '\0';
+      client->len = 0;
+      schedule_command(fd, client->buf);
     }
-    
-    if (strrpos(buf, new_line) < len - 1) {
-        parted = 1;
-    } else {
-        parted = 0;
+    return 0;
+  }
+  client->len += n;
+  client->buf[client->len] = '\0';
+  log_msg(LOG_MOD_CLIENT, LOG_DEBUG, "client send: %s", client->buf);
+
+  line = client->buf;
+  while ((newline = strchr(line, '\n')) != NULL) {
+    *newline = '\0';
+    if (newline > line && newline[-1] == '\r') {
+      newline[-1] = '\0';
+    }
+    if (*line != '\0') {
+      log_msg(LOG_MOD_CLIENT, LOG_DEBUG, "client command to process: %s", line);
+      schedule_command(fd, line);
     }
-    
-    command = strtok(buf, "\n");
+    line = newline + 1;
+  }
+  client->len -= line - client->buf;
+  memmove(client->buf, line, client->len);
+  if (client->len == CLIENT_BUFFER_SIZE - 1) {
+    write_error_msg_to_client(fd, "command too long");
+    client->len = 0;
+  }
 
-    if (command == NULL) {
-        perror("can't read command");
-    } else {
-        if (rest != NULL) {
-            free(rest);
-        }
-        if (part != NULL) {
-            bzero(step, BUFFER_SIZE * 2);
-            strncpy(step, part, strlen(part));
-            strncat(step, command, strlen(command));
-            rest = strndup(step, strlen(step));
-        } else {
-            rest = strndup(command, strlen(command));
-        }
+  return 1;
+}
+
+/**
+ * Wait for new clients and client input.
+ *
+ * @param socketfd The listening socket.
+ * @param packetfd The listening SOCK_SEQPACKET socket or -1.
+ */
+void serve_clients(int socketfd, int packetfd) {
+  struct pollfd fds[MAX_CLIENTS + 3];
+  int n, i;
+
+  trace_name_thread("clients");
+
+  while (1) {
+    fds[0].fd      = socketfd;
+    fds[0].events  = POLLIN;
+    fds[0].revents = 0;
+    // Other threads wake the poll when they queued output of a client.
+    fds[1].fd      = get_client_wakeup_fd();
+    fds[1].events  = POLLIN;
+    fds[1].revents = 0;
+    // poll ignores a negative fd.
+    fds[2].fd      = packetfd;
+    fds[2].events  = POLLIN;
+    fds[2].revents = 0;
+    n = get_client_pollfds(fds + 3, MAX_CLIENTS) + 3;
+
+    if (poll(fds, n, -1) == -1) {
+      if (errno != EINTR) {
+        log_msg(LOG_MOD_CLIENT, LOG_ERR, "poll: %m");
+      }
+      continue;
     }
-    
-    if (flag_verbose) {
-        printf("client command to process: %s\n", command);
+    if (fds[1].revents & POLLIN) {
+      clear_client_wakeup();
     }
-    
-    while(command != NULL) {
-        command = strtok(NULL, "\n");
-        if (command != NULL) {
-            read_command(rest, client_socket_fd);
-            if (rest != NULL) {
-                free(rest);
-            }
-            rest = NULL;
-            rest = strndup(command, strlen(command));
+    for (i = 3; i < n; i++) {
+      if (fds[i].revents & (POLLOUT | POLLHUP | POLLERR) && fds[i].events & POLLOUT) {
+        flush_client_output(fds[i].fd);
+      }
+      if ((fds[i].events & POLLIN) && (fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+        if (!read_client(fds[i].fd)) {
+          record_close(fds[i].fd);
+          // A client that only shut down its writing side still gets the answers of its waits.
+          if (fds[i].revents & (POLLHUP | POLLERR)) {
+            cancel_client_waits(fds[i].fd);
+          }
+          cancel_lcd_watch(fds[i].fd);
+          close_client(fds[i].fd);
         }
+      }
     }
-    if (parted == 0) {
-        read_command(rest, client_socket_fd);
+    if (fds[0].revents & POLLIN) {
+      accept_client(socketfd, 0);
+    }
+    if (fds[2].revents & POLLIN) {
+      accept_client(packetfd, 1);
     }
-    bzero(buf, BUFFER_SIZE);
   }
-  close(client_socket_fd);
+}
 
-  return 1;
+/**
+ * Create a listening socket, the daemon exits on error.
+ *
+ * @param filename The socket file.
+ * @param type     SOCK_STREAM or SOCK_SEQPACKET.
+ *
+ * @return The listening socket.
+ */
+static int listen_socket(char *filename, int type) {
+  struct sockaddr_un address;
+  socklen_t address_len;
+  int fd;
+
+  if ((fd = socket(AF_UNIX,type,0)) < 0) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "creating socket: %m");
+    flush_log();
+    exit (EXIT_FAILURE);
+  }
+
+  bzero((char *) &address, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, filename, strlen(filename));
+  address_len = strlen(address.sun_path) + sizeof(address.sun_family) + 1;
+
+  log_msg(LOG_MOD_DAEMON, LOG_DEBUG, "Binding to socket file: %s", filename);
+  if (bind(fd, (struct sockaddr *)&address, address_len) < 0) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "binding socket: %m");
+    flush_log();
+    exit (EXIT_FAILURE);
+  }
+
+  if (chmod(filename, S_IRWXU | S_IRWXG | S_IRWXO) == -1) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "socket_file: %m");
+    flush_log();
+    exit (EXIT_FAILURE);
+  }
+
+  if (listen(fd, 10) == -1) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "listening socket: %m");
+    flush_log();
+    exit (EXIT_FAILURE);
+  }
+
+  return fd;
 }
 
 /**
@@ -490,11 +944,11 @@ int read_client(int socketfd) {
  */
 int main(int argc, char **argv) {
   pid_t pid;
-  int socketfd;
-  struct sockaddr_un address;
-  socklen_t address_len;
+  int socketfd, packetfd = -1;
 #ifndef NO_SIG_HANDLER
   struct sigaction sig_act, sig_oact;
+  static sigset_t reload_set;
+  pthread_t reload_thread;
 #endif
   
   load_params(argc, argv);
@@ -515,61 +969,71 @@ int main(int argc, char **argv) {
     write_pid_file();
   } 
 
+  // A write to a closed client fails with EPIPE instead of killing the daemon.
+  signal(SIGPIPE, SIG_IGN);
+
 #ifndef NO_SIG_HANDLER
   sig_act.sa_handler = cleanup_and_exit;
   sigemptyset (&sig_act.sa_mask);
-  if (sigaction(SIGTERM, &sig_act, &sig_oact) == -1) {
-    perror("sigaction");
-    exit (EXIT_FAILURE);
-  }
   if (sigaction(SIGSEGV, &sig_act, &sig_oact) == -1) {
     perror("sigaction");
     exit (EXIT_FAILURE);
   }
-  if (sigaction(SIGINT, &sig_act, &sig_oact) == -1) {
-    perror("sigaction");
+  // Block the signals before any thread is created, they are handled by the reload thread.
+  sigemptyset(&reload_set);
+  sigaddset(&reload_set, SIGHUP);
+  sigaddset(&reload_set, SIGUSR1);
+  sigaddset(&reload_set, SIGTERM);
+  sigaddset(&reload_set, SIGINT);
+  if (pthread_sigmask(SIG_BLOCK, &reload_set, NULL) != 0) {
+    perror("pthread_sigmask");
     exit (EXIT_FAILURE);
   }
-#endif
-
-  if ((socketfd = socket(AF_UNIX,SOCK_STREAM,0)) < 0) {
-    perror("creating socket");
+  if (pthread_create(&reload_thread, NULL, reload_signal_thread, &reload_set) != 0) {
+    perror("pthread_create");
     exit (EXIT_FAILURE);
   }
+  pthread_detach(reload_thread);
+#endif
+  // After the signal mask, the log thread inherits it.
+  start_log(!flag_dont_detach);
 
-  bzero((char *) &address, sizeof(address));
-  address.sun_family = AF_UNIX;
-  strncpy(address.sun_path, socket_filename, strlen(socket_filename));
-  address_len = strlen(address.sun_path) + sizeof(address.sun_family) + 1;
-
-  if (flag_verbose) {
-    printf("Binding to socket file: %s\n", socket_filename);
-  }
-  if (bind(socketfd, (struct sockaddr *)&address, address_len) < 0) {
-    perror("binding socket");
+  if (setup_backend() == -1) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "Unable to initialise GPIO mode with backend %s.", get_backend_name());
+    flush_log();
     exit (EXIT_FAILURE);
   }
-
-  if (chmod(socket_filename, S_IRWXU | S_IRWXG | S_IRWXO) == -1) {
-    perror("socket_file");
+  if (init_state() == -1) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "Unable to create the shared memory state %s.", get_state_name());
+    flush_log();
     exit (EXIT_FAILURE);
   }
-
-  if (listen(socketfd, 10) == -1) {
-    perror("listening socket");
+  if (init_record() == -1) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "Unable to create the trace file.");
+    flush_log();
     exit (EXIT_FAILURE);
   }
+  // The outputs are restored before a client can connect.
+  apply_snapshot();
 
-  if (wiringPiSetup() == -1) {
-    printf ("Unable to initialise GPIO mode.\n");
-    exit (EXIT_FAILURE);
+  socketfd = listen_socket(socket_filename, SOCK_STREAM);
+  if (packet_socket_filename != NULL) {
+    packetfd = listen_socket(packet_socket_filename, SOCK_SEQPACKET);
   }
   
+  init_clients();
+  start_scheduler();
+  start_timers();
+  start_snapshot();
+  apply_rules();
   registerInterrupts();
+  start_widgets();
 
-  while(read_client(socketfd)) {
-    // Loop to accept client connection
+  if (get_lcd_eager_init()) {
+    start_lcd_init();
   }
 
+  serve_clients(socketfd, packetfd);
+
   return 0;
 }
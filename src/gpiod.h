@@ -12,12 +12,35 @@
 #include <fcntl.h>
 #include <string.h>
 #include <sys/time.h>
+#include <time.h>
+#include <pthread.h>
+#include <poll.h>
+#include <errno.h>
 #include <libconfig.h>
 
 #include "wiringPi.h"
+#include "trace.h"
+#include "log.h"
+#include "backend.h"
 #include "lcd.h"
 #include "config_load.h"
 #include "interrupt.h"
+#include "client.h"
+#include "scheduler.h"
+#include "state.h"
+#include "timer.h"
+#include "rules.h"
+#include "timed.h"
+#include "shift.h"
+#include "groups.h"
+#include "pwm.h"
+#include "record.h"
+#include "wait.h"
+#include "fb.h"
+#include "sprite.h"
+#include "widget.h"
+#include "mirror.h"
+#include "snapshot.h"
 
 /**
  * \brief The Buffer size for socket input reading
@@ -54,10 +77,27 @@
  */
 #define CLIENT_MODE    "MODE"
 
+/**
+ * \brief timed client commands.
+ *
+ * Write a pulse, write at a monotonic time or after a delay.
+ */
+#define CLIENT_PULSE      "PULSE"
+#define CLIENT_WRITEAT    "WRITEAT"
+#define CLIENT_WRITEAFTER "WRITEAFTER"
+
 #define CLIENT_INFO    "INFO"
 
+/**
+ * \brief stats client command.
+ *
+ * Show daemon statistics.
+ */
+#define CLIENT_STATS   "STATS"
+
 #define SERVER_OK    "OK"
 #define SERVER_ERROR "ERROR"
+#define SERVER_EVENT "EVENT"
 
 void write_all_data_to_client(int fd);
 void do_read_from_pin(int client_socket_fd, char *buf);
@@ -65,7 +105,13 @@ void do_write_to_pin(int client_socket_fd, char *buf);
 void do_set_pin_mode(int client_socket_fd, char *buf);
 int is_valid_pin_num(int pin_num);
 int is_valid_pin_value(int value);
+void set_reply_tag(const char *tag);
+void begin_reply(int fd, const char *tag, int multi_line);
+void defer_reply(char *tag);
+void end_reply(int fd, int multi_line);
+void write_to_client(int fd, const char *buf, size_t len);
 void write_msg_to_client(int fd, char *msg);
+void read_command(char *command, int client_socket_fd);
 void write_int_value_to_client(int fd, int value);
 void write_error_msg_to_client(int fd, char *msg);
 void usage();
@@ -73,7 +119,9 @@ void set_flag_verbose(int flag);
 void set_flag_dont_detach(int flag);
 void set_socket_filename(char* name);
 char* get_socket_filename();
+void set_packet_socket_filename(char* name);
+char* get_packet_socket_filename();
 int get_flag_verbose();
-int get_client_socket_fd();
+unsigned long long get_monotonic_ns();
 
 #endif /* GPIOD_H_ */
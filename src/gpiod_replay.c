@@ -0,0 +1,562 @@
+/*
+ * gpiod_replay.c
+ *
+ *  Created on: 19.10.2026
+ *
+ * Replay a trace recorded with gpiod -r against a running gpiod.
+ *
+ * Every recorded client gets an own connection and sends its commands at
+ * the recorded times, divided by the speed. Recorded edges are replayed
+ * with MOCK EDGE, so the daemon should run with the mock backend. Every
+ * command is sent with a #n tag, its latency is the time to the first
+ * answer line with the tag.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "record.h"
+
+#define REPLAY_SOCKET       "/var/lib/gpiod/socket"
+#define REPLAY_CLIENTS      256
+#define REPLAY_PENDING      256
+#define REPLAY_EVENTS       64
+#define REPLAY_VERBS        32
+#define REPLAY_LINE_SIZE    4096
+#define REPLAY_DRAIN_MS     1000
+
+/**
+ * \brief A sent command waiting for the answer.
+ */
+typedef struct Pending {
+  unsigned long long sent_ns;
+  unsigned long tag;            //> Tag number of the command.
+  int verb;
+  int active;                   //> 1 while the answer is missing.
+} Pending;
+
+typedef struct ReplayClient {
+  long long id;                 //> Recorded client id or -1.
+  int fd;                       //> Connection or -1.
+  int len;                      //> Used bytes in buf.
+  char buf[REPLAY_LINE_SIZE];   //> Incomplete answer line.
+  Pending pending[REPLAY_PENDING]; //> Indexed by tag modulo REPLAY_PENDING.
+  unsigned long next_tag;
+  int count;                    //> Count of pending commands.
+} ReplayClient;
+
+/**
+ * \brief Latencies of all commands of a verb.
+ */
+typedef struct Verb {
+  char name[16];
+  unsigned long long *latency_ns;
+  int count;
+  int size;
+} Verb;
+
+static char *socket_name = REPLAY_SOCKET;
+static ReplayClient replay_clients[REPLAY_CLIENTS];
+static ReplayClient control;    /**< connection for the edges */
+static char *event_names[REPLAY_EVENTS];
+static int event_count = 0;
+static Verb verbs[REPLAY_VERBS];
+static int verb_count = 0;
+static unsigned long commands = 0, answered = 0, lost = 0, edges = 0, edge_errors = 0, skipped = 0;
+static unsigned long events_recorded = 0, events_received = 0;
+
+static unsigned long long monotonic_ns() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void usage() {
+  printf("Usage: gpiod_replay [ -s socketfile ] [ -x speed ] [ -h ] tracefile\n");
+  printf("    -s socketfile socket of the daemon (default: %s)\n", REPLAY_SOCKET);
+  printf("    -x speed      replay speed, 1 is the recorded timing, 0 as fast as possible (default: 1)\n");
+  printf("    -h            show help (this message)\n");
+}
+
+static int connect_daemon() {
+  struct sockaddr_un address;
+  int fd;
+
+  if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) {
+    perror("socket");
+    exit(EXIT_FAILURE);
+  }
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  snprintf(address.sun_path, sizeof(address.sun_path), "%s", socket_name);
+  if (connect(fd, (struct sockaddr *) &address, sizeof(address)) == -1) {
+    perror(socket_name);
+    exit(EXIT_FAILURE);
+  }
+  return fd;
+}
+
+/**
+ * Skip the #id tag of a command or an answer line.
+ */
+static const char *skip_tag(const char *line) {
+  if (line[0] == '#') {
+    line += strcspn(line, " ");
+    line += strspn(line, " ");
+  }
+  return line;
+}
+
+static int find_verb(const char *command) {
+  size_t len;
+  int v;
+
+  command = skip_tag(command);
+  len = strcspn(command, " ");
+  if (len >= sizeof(verbs[0].name)) {
+    len = sizeof(verbs[0].name) - 1;
+  }
+  for (v = 0; v < verb_count; v++) {
+    if (strlen(verbs[v].name) == len && strncmp(verbs[v].name, command, len) == 0) {
+      return v;
+    }
+  }
+  if (verb_count == REPLAY_VERBS) {
+    return REPLAY_VERBS - 1;
+  }
+  snprintf(verbs[verb_count].name, len + 1, "%s", command);
+  return verb_count++;
+}
+
+static void add_latency(int v, unsigned long long latency_ns) {
+  Verb *verb = &verbs[v];
+
+  if (verb->count == verb->size) {
+    verb->size       = verb->size ? verb->size * 2 : 64;
+    verb->latency_ns = realloc(verb->latency_ns, verb->size * sizeof(unsigned long long));
+  }
+  verb->latency_ns[verb->count++] = latency_ns;
+}
+
+/**
+ * Check if the answer line is an interrupt event of the trace.
+ */
+static int is_event_line(const char *line) {
+  size_t len;
+  int e;
+
+  if (strncmp(line, "OK - ", 5) == 0) {
+    line += 5;
+  } else if (strncmp(line, "EVENT - ", 8) == 0) {
+    line += 8;
+  } else {
+    return 0;
+  }
+  for (e = 0; e < event_count; e++) {
+    len = strlen(event_names[e]);
+    if (strncmp(line, event_names[e], len) == 0 && (line[len] == '\0' || strncmp(line + len, " x", 2) == 0)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Take an answer line. The first answer line with the tag of a command
+ * ends the latency of the command, further lines of the tag (READALL,
+ * END) are skipped. Untagged lines are events.
+ */
+static void answer_line(ReplayClient *client, const char *line, unsigned long long now) {
+  Pending *pending;
+  unsigned long tag;
+  char *end;
+
+  if (client == &control) {
+    if (strncmp(skip_tag(line), "ERROR", 5) == 0) {
+      edge_errors++;
+    }
+    return;
+  }
+  if (line[0] != '#') {
+    if (is_event_line(line)) {
+      events_received++;
+    }
+    return;
+  }
+  tag = strtoul(line + 1, &end, 10);
+  if (end == line + 1 || *end != ' ') {
+    return;
+  }
+  pending = &client->pending[tag % REPLAY_PENDING];
+  if (!pending->active || pending->tag != tag) {
+    // Further lines of an answer.
+    return;
+  }
+  add_latency(pending->verb, now - pending->sent_ns);
+  pending->active = 0;
+  client->count--;
+  answered++;
+}
+
+/**
+ * Count the unanswered commands of a closed connection as lost.
+ */
+static void drop_pending(ReplayClient *client) {
+  int i;
+
+  lost += client->count;
+  client->count = 0;
+  for (i = 0; i < REPLAY_PENDING; i++) {
+    client->pending[i].active = 0;
+  }
+}
+
+/**
+ * Read the answers of a connection.
+ *
+ * @return 0 if the daemon closed the connection.
+ */
+static int read_answers(ReplayClient *client, unsigned long long now) {
+  char *line, *newline;
+  int n;
+
+  n = read(client->fd, client->buf + client->len, REPLAY_LINE_SIZE - 1 - client->len);
+  if (n <= 0) {
+    return 0;
+  }
+  client->len += n;
+  client->buf[client->len] = '\0';
+  line = client->buf;
+  while ((newline = strchr(line, '\n')) != NULL) {
+    *newline = '\0';
+    answer_line(client, line, now);
+    line = newline + 1;
+  }
+  client->len -= line - client->buf;
+  memmove(client->buf, line, client->len);
+  if (client->len == REPLAY_LINE_SIZE - 1) {
+    client->len = 0;
+  }
+  return 1;
+}
+
+/**
+ * Read answers until the monotonic time.
+ */
+static void pump(unsigned long long until_ns) {
+  struct pollfd fds[REPLAY_CLIENTS + 1];
+  ReplayClient *owners[REPLAY_CLIENTS + 1];
+  struct timespec ts;
+  unsigned long long now;
+  int i, n;
+
+  while ((now = monotonic_ns()) < until_ns || until_ns == 0) {
+    n = 0;
+    for (i = 0; i < REPLAY_CLIENTS; i++) {
+      if (replay_clients[i].fd != -1) {
+        owners[n] = &replay_clients[i];
+        fds[n].fd = replay_clients[i].fd;
+        fds[n].events = POLLIN;
+        n++;
+      }
+    }
+    owners[n] = &control;
+    fds[n].fd = control.fd;
+    fds[n].events = POLLIN;
+    n++;
+    ts.tv_sec  = until_ns ? (until_ns - now) / 1000000000ULL : 0;
+    ts.tv_nsec = until_ns ? (until_ns - now) % 1000000000ULL : 0;
+    if (ppoll(fds, n, &ts, NULL) <= 0) {
+      if (until_ns == 0) {
+        return;
+      }
+      continue;
+    }
+    now = monotonic_ns();
+    for (i = 0; i < n; i++) {
+      if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) && !read_answers(owners[i], now)) {
+        drop_pending(owners[i]);
+        close(owners[i]->fd);
+        owners[i]->fd = -1;
+        if (owners[i] == &control) {
+          fprintf(stderr, "daemon closed the connection\n");
+          exit(EXIT_FAILURE);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Close the connection of a recorded client after its answers.
+ *
+ * The recorded client closed after its answers, so they are waited for up
+ * to the drain time. The slot is free for the next recorded client.
+ */
+static void close_client(ReplayClient *client) {
+  unsigned long long end = monotonic_ns() + REPLAY_DRAIN_MS * 1000000ULL;
+
+  client->id = -1;
+  if (client->fd == -1) {
+    return;
+  }
+  while (client->count > 0 && client->fd != -1 && monotonic_ns() < end) {
+    pump(monotonic_ns() + 10000000ULL);
+  }
+  if (client->fd != -1) {
+    close(client->fd);
+  }
+  drop_pending(client);
+  client->fd = -1;
+}
+
+/**
+ * Find the connection of a recorded client id.
+ *
+ * @param create 1 to take a free slot for an unknown id.
+ *
+ * @return The client or NULL if unknown or all slots are taken.
+ */
+static ReplayClient *find_client(uint32_t id, int create) {
+  ReplayClient *free_client = NULL;
+  int i;
+
+  for (i = 0; i < REPLAY_CLIENTS; i++) {
+    if (replay_clients[i].id == id) {
+      return &replay_clients[i];
+    }
+    if (free_client == NULL && replay_clients[i].id == -1 && replay_clients[i].fd == -1) {
+      free_client = &replay_clients[i];
+    }
+  }
+  if (create && free_client != NULL) {
+    free_client->id = id;
+  }
+  return create ? free_client : NULL;
+}
+
+static unsigned long long pending_commands() {
+  unsigned long long count = 0;
+  int i;
+
+  for (i = 0; i < REPLAY_CLIENTS; i++) {
+    count += replay_clients[i].count;
+  }
+  return count;
+}
+
+/**
+ * Send a command line of a recorded client.
+ */
+static void send_command(ReplayClient *client, const char *command, size_t len) {
+  char line[REPLAY_LINE_SIZE], recorded[REPLAY_LINE_SIZE];
+  Pending *pending;
+  int n;
+
+  if (client->fd == -1) {
+    client->fd = connect_daemon();
+  }
+  if (len > REPLAY_LINE_SIZE - 32) {
+    len = REPLAY_LINE_SIZE - 32;
+  }
+  // The recorded tag is replaced by the tag of the replay.
+  memcpy(recorded, command, len);
+  recorded[len] = '\0';
+  pending = &client->pending[client->next_tag % REPLAY_PENDING];
+  if (pending->active) {
+    // Too many unanswered commands, the oldest is lost.
+    client->count--;
+    lost++;
+  }
+  n = snprintf(line, sizeof(line), "#%lu %s\n", client->next_tag, skip_tag(recorded));
+  pending->tag     = client->next_tag++;
+  pending->verb    = find_verb(recorded);
+  pending->active  = 1;
+  pending->sent_ns = monotonic_ns();
+  client->count++;
+  commands++;
+  if (write(client->fd, line, n) != n) {
+    perror("write");
+  }
+}
+
+static int compare_latency(const void *a, const void *b) {
+  unsigned long long x = *(const unsigned long long *) a, y = *(const unsigned long long *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+static void print_report(unsigned long long duration_ns) {
+  unsigned long long sum;
+  Verb *verb;
+  int v, i;
+
+  printf("replayed in %llu ms: commands %lu, answered %lu, lost %lu, edges %lu (%lu failed), events %lu recorded, %lu received\n",
+      duration_ns / 1000000, commands, answered, lost, edges, edge_errors, events_recorded, events_received);
+  if (skipped > 0) {
+    printf("skipped %lu records of clients beyond %d connections\n", skipped, REPLAY_CLIENTS);
+  }
+  printf("%-12s %8s %10s %10s %10s %10s %10s\n", "command", "count", "min us", "avg us", "p50 us", "p99 us", "max us");
+  for (v = 0; v < verb_count; v++) {
+    verb = &verbs[v];
+    if (verb->count == 0) {
+      continue;
+    }
+    qsort(verb->latency_ns, verb->count, sizeof(unsigned long long), compare_latency);
+    for (sum = 0, i = 0; i < verb->count; i++) {
+      sum += verb->latency_ns[i];
+    }
+    printf("%-12s %8d %10llu %10llu %10llu %10llu %10llu\n", verb->name, verb->count,
+        verb->latency_ns[0] / 1000, sum / verb->count / 1000, verb->latency_ns[verb->count / 2] / 1000,
+        verb->latency_ns[(verb->count * 99) / 100] / 1000, verb->latency_ns[verb->count - 1] / 1000);
+  }
+}
+
+/**
+ * Read the whole trace file.
+ */
+static char *read_trace(const char *file_name, size_t *size) {
+  FILE *file;
+  char *data;
+  long len;
+
+  if ((file = fopen(file_name, "r")) == NULL) {
+    perror(file_name);
+    exit(EXIT_FAILURE);
+  }
+  fseek(file, 0, SEEK_END);
+  len = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  data = malloc(len > 0 ? len : 1);
+  if (fread(data, 1, len, file) != (size_t) len) {
+    perror(file_name);
+    exit(EXIT_FAILURE);
+  }
+  fclose(file);
+  *size = len;
+  return data;
+}
+
+int main(int argc, char **argv) {
+  RecordHeader *header;
+  RecordEntry entry;
+  ReplayClient *client;
+  char *trace, *data, command[64];
+  size_t size, offset;
+  double speed = 1.0;
+  unsigned long long start, end;
+  int ch, i;
+
+  while ((ch = getopt(argc, argv, "hs:x:")) != -1) {
+    switch (ch) {
+      case 's':
+        socket_name = optarg;
+        break;
+      case 'x':
+        speed = atof(optarg);
+        break;
+      case 'h':
+        usage();
+        exit(EXIT_SUCCESS);
+      default:
+        usage();
+        exit(EXIT_FAILURE);
+    }
+  }
+  if (optind != argc - 1 || speed < 0) {
+    usage();
+    exit(EXIT_FAILURE);
+  }
+  signal(SIGPIPE, SIG_IGN);
+
+  trace  = read_trace(argv[optind], &size);
+  header = (RecordHeader *) trace;
+  if (size < sizeof(RecordHeader) || header->magic != RECORD_MAGIC || header->version != RECORD_VERSION) {
+    fprintf(stderr, "%s: not a gpiod trace\n", argv[optind]);
+    exit(EXIT_FAILURE);
+  }
+  // Known event names to tell events from answers.
+  for (offset = sizeof(RecordHeader); offset + sizeof(RecordEntry) <= size; offset += sizeof(RecordEntry) + entry.len) {
+    memcpy(&entry, trace + offset, sizeof(RecordEntry));
+    if (entry.type != RECORD_EVENT || offset + sizeof(RecordEntry) + entry.len > size) {
+      continue;
+    }
+    events_recorded++;
+    for (i = 0; i < event_count; i++) {
+      if (strlen(event_names[i]) == entry.len && strncmp(event_names[i], trace + offset + sizeof(RecordEntry), entry.len) == 0) {
+        break;
+      }
+    }
+    if (i == event_count && event_count < REPLAY_EVENTS) {
+      event_names[event_count++] = strndup(trace + offset + sizeof(RecordEntry), entry.len);
+    }
+  }
+
+  for (i = 0; i < REPLAY_CLIENTS; i++) {
+    replay_clients[i].id    = -1;
+    replay_clients[i].fd    = -1;
+    replay_clients[i].count = 0;
+  }
+  control.fd = connect_daemon();
+
+  start = monotonic_ns();
+  for (offset = sizeof(RecordHeader); offset + sizeof(RecordEntry) <= size; offset += sizeof(RecordEntry) + entry.len) {
+    memcpy(&entry, trace + offset, sizeof(RecordEntry));
+    data = trace + offset + sizeof(RecordEntry);
+    if (offset + sizeof(RecordEntry) + entry.len > size) {
+      break;
+    }
+    if (speed > 0) {
+      pump(start + (unsigned long long) (entry.time_ns / speed));
+    } else {
+      pump(0);
+    }
+    switch (entry.type) {
+      case RECORD_CONNECT:
+        if ((client = find_client(entry.client, 1)) == NULL) {
+          skipped++;
+        } else if (client->fd == -1) {
+          client->fd = connect_daemon();
+        }
+        break;
+      case RECORD_CLOSE:
+        if ((client = find_client(entry.client, 0)) != NULL) {
+          close_client(client);
+        }
+        break;
+      case RECORD_COMMAND:
+        if ((client = find_client(entry.client, 1)) == NULL) {
+          skipped++;
+        } else {
+          send_command(client, data, entry.len);
+        }
+        break;
+      case RECORD_EDGE:
+        if (entry.len == 2) {
+          snprintf(command, sizeof(command), "MOCK EDGE %d %d\n", data[0], data[1]);
+          if (write(control.fd, command, strlen(command)) > 0) {
+            edges++;
+          }
+        }
+        break;
+    }
+  }
+  // Wait for the last answers.
+  end = monotonic_ns();
+  while (pending_commands() > 0 && monotonic_ns() < end + REPLAY_DRAIN_MS * 1000000ULL) {
+    pump(monotonic_ns() + 10000000ULL);
+  }
+  pump(monotonic_ns() + 10000000ULL);
+  lost += pending_commands();
+  print_report(monotonic_ns() - start);
+
+  return 0;
+}
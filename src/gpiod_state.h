@@ -0,0 +1,164 @@
+/*
+ * gpiod_state.h
+ *
+ *  Created on: 19.10.2026
+ *
+ * Read only view of the gpiod pin state in shared memory.
+ *
+ * gpiod publishes the pin levels, modes, event counters and some daemon
+ * counters in a shared memory segment. A reader maps the segment once and
+ * reads the state without a socket round trip:
+ *
+ *   GpiodState *state = gpiod_state_open(GPIOD_STATE_NAME);
+ *   int level = gpiod_state_read_level(state, 4);
+ *
+ * The writer protects every update with a sequence lock. A reader retries
+ * until it got a consistent copy, it never blocks the daemon.
+ */
+
+#ifndef GPIOD_STATE_H_
+#define GPIOD_STATE_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/**
+ * \brief Default name of the shared memory segment.
+ */
+#define GPIOD_STATE_NAME "/gpiod-state"
+
+#define GPIOD_STATE_MAGIC   0x67706964
+#define GPIOD_STATE_VERSION 1
+
+/**
+ * \brief Count of pins in the state.
+ */
+#define GPIOD_STATE_PINS 32
+
+typedef struct GpiodStatePin {
+  uint32_t event_seq;      //> Count of edges of the pin.
+  uint32_t reserved;
+  uint64_t last_event_ns;  //> Monotonic time of the last edge.
+} GpiodStatePin;
+
+typedef struct GpiodState {
+  uint32_t magic;          //> GPIOD_STATE_MAGIC
+  uint32_t version;        //> GPIOD_STATE_VERSION
+  uint32_t seq;            //> Sequence lock, odd while the daemon writes.
+  uint32_t pin_count;      //> Count of valid pins.
+  uint32_t levels;         //> Bit n is the level of pin n.
+  uint32_t outputs;        //> Bit n is set if pin n is an output.
+  uint64_t updated_ns;     //> Monotonic time of the last update.
+  uint64_t event_seq;      //> Count of all edges.
+  uint64_t commands;       //> Count of executed commands.
+  uint64_t events;         //> Count of events written to the clients.
+  uint64_t clients;        //> Count of accepted client connections.
+  GpiodStatePin pins[GPIOD_STATE_PINS];
+} GpiodState;
+
+/**
+ * \brief Map the state segment read only.
+ *
+ * @param name Name of the segment, GPIOD_STATE_NAME by default.
+ *
+ * @return The state or NULL.
+ */
+static inline GpiodState *gpiod_state_open(const char *name) {
+  GpiodState *state;
+  int fd = shm_open(name, O_RDONLY, 0);
+
+  if (fd == -1) {
+    return NULL;
+  }
+  state = (GpiodState *) mmap(NULL, sizeof(GpiodState), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (state == MAP_FAILED) {
+    return NULL;
+  }
+  if (state->magic != GPIOD_STATE_MAGIC || state->version != GPIOD_STATE_VERSION) {
+    munmap(state, sizeof(GpiodState));
+    return NULL;
+  }
+  return state;
+}
+
+/**
+ * \brief Unmap the state segment.
+ */
+static inline void gpiod_state_close(GpiodState *state) {
+  munmap(state, sizeof(GpiodState));
+}
+
+/**
+ * \brief Begin a read, wait while the daemon writes.
+ */
+static inline uint32_t gpiod_state_read_begin(const GpiodState *state) {
+  uint32_t seq;
+
+  while ((seq = __atomic_load_n(&state->seq, __ATOMIC_ACQUIRE)) & 1) {
+    // writer active
+  }
+  return seq;
+}
+
+/**
+ * \brief End a read.
+ *
+ * @return 1 if the read must be repeated.
+ */
+static inline int gpiod_state_read_retry(const GpiodState *state, uint32_t seq) {
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return __atomic_load_n(&state->seq, __ATOMIC_RELAXED) != seq;
+}
+
+/**
+ * \brief Read the level of a pin.
+ *
+ * @return 0, 1 or -1 for an invalid pin.
+ */
+static inline int gpiod_state_read_level(const GpiodState *state, int pin) {
+  uint32_t seq, levels;
+
+  if (pin < 0 || pin >= GPIOD_STATE_PINS) {
+    return -1;
+  }
+  do {
+    seq    = gpiod_state_read_begin(state);
+    levels = state->levels;
+  } while (gpiod_state_read_retry(state, seq));
+
+  return (levels >> pin) & 1;
+}
+
+/**
+ * \brief Read the levels of all pins.
+ *
+ * @return Bit n is the level of pin n.
+ */
+static inline uint32_t gpiod_state_read_levels(const GpiodState *state) {
+  uint32_t seq, levels;
+
+  do {
+    seq    = gpiod_state_read_begin(state);
+    levels = state->levels;
+  } while (gpiod_state_read_retry(state, seq));
+
+  return levels;
+}
+
+/**
+ * \brief Copy the whole state consistent.
+ */
+static inline void gpiod_state_snapshot(const GpiodState *state, GpiodState *copy) {
+  uint32_t seq;
+
+  do {
+    seq = gpiod_state_read_begin(state);
+    memcpy(copy, (const void *) state, sizeof(GpiodState));
+  } while (gpiod_state_read_retry(state, seq));
+}
+
+#endif /* GPIOD_STATE_H_ */
@@ -0,0 +1,516 @@
+/*
+ * gpiodclient.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "gpiodclient.h"
+
+/**
+ * \brief A sent command waiting for its answer.
+ */
+typedef struct GpiodPending {
+  unsigned int id;               //> Number of the #id tag.
+  int multi_line;                //> 1 after "#id BEGIN", the answer ends with "#id END".
+  GpiodAnswerCallback callback;
+  void *arg;
+} GpiodPending;
+
+struct GpiodClient {
+  char socket_name[108];
+  int fd;                        //> Connected socket or -1.
+  unsigned int next_id;
+  GpiodPending *pending;         //> Commands in the order they were sent.
+  int pending_count;
+  int pending_size;
+  char *out;                     //> Commands not yet written.
+  size_t out_len;
+  size_t out_size;
+  char in[GPIOD_CLIENT_BUFFER_SIZE];
+  size_t in_len;
+  GpiodEventCallback event_callback;
+  void *event_arg;
+  int processing;                //> 1 while gpiod_client_process dispatches lines.
+  unsigned int connection;       //> Counts the lost connections.
+};
+
+/**
+ * \brief Answer of a blocking command.
+ */
+typedef struct GpiodResult {
+  char *answer;
+  size_t size;
+  size_t len;
+  int error;
+  int done;
+} GpiodResult;
+
+/**
+ * \brief Create a client, the connection is made with the first command.
+ *
+ * @param socket_name The socket of the daemon or NULL for the default.
+ *
+ * @return The client or NULL if out of memory.
+ */
+GpiodClient *gpiod_client_new(const char *socket_name) {
+  GpiodClient *client = calloc(1, sizeof(GpiodClient));
+
+  if (client == NULL) {
+    return NULL;
+  }
+  snprintf(client->socket_name, sizeof(client->socket_name), "%s",
+      socket_name != NULL ? socket_name : GPIOD_CLIENT_SOCKET);
+  client->fd      = -1;
+  client->next_id = 1;
+  return client;
+}
+
+/**
+ * \brief Close the connection and free the client.
+ *
+ * The callbacks of pending commands are not called.
+ */
+void gpiod_client_free(GpiodClient *client) {
+  if (client->fd != -1) {
+    close(client->fd);
+  }
+  free(client->pending);
+  free(client->out);
+  free(client);
+}
+
+/**
+ * Close the connection and fail all pending commands.
+ */
+static void gpiod_client_disconnect(GpiodClient *client) {
+  GpiodPending *pending = client->pending;
+  GpiodAnswer answer = { "connection lost", 15, -1, 1 };
+  int i, count = client->pending_count;
+
+  close(client->fd);
+  client->fd      = -1;
+  client->out_len = 0;
+  client->in_len  = 0;
+  client->connection++;
+  // The callbacks may send new commands on a new connection.
+  client->pending       = NULL;
+  client->pending_count = 0;
+  client->pending_size  = 0;
+  for (i = 0; i < count; i++) {
+    if (pending[i].callback != NULL) {
+      pending[i].callback(client, &answer, pending[i].arg);
+    }
+  }
+  free(pending);
+}
+
+/**
+ * Append data to the output buffer.
+ *
+ * @return 0 or -1 if out of memory.
+ */
+static int gpiod_client_append(GpiodClient *client, const char *data, size_t len) {
+  char *out;
+
+  if (client->out_len + len > client->out_size) {
+    if ((out = realloc(client->out, (client->out_len + len) * 2)) == NULL) {
+      return -1;
+    }
+    client->out      = out;
+    client->out_size = (client->out_len + len) * 2;
+  }
+  memcpy(client->out + client->out_len, data, len);
+  client->out_len += len;
+  return 0;
+}
+
+/**
+ * Write as much of the output buffer as the socket takes.
+ *
+ * @return 0 or -1 if the connection was lost.
+ */
+static int gpiod_client_flush(GpiodClient *client) {
+  ssize_t n;
+
+  while (client->out_len > 0) {
+    n = send(client->fd, client->out, client->out_len, MSG_NOSIGNAL);
+    if (n == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return 0;
+      }
+      gpiod_client_disconnect(client);
+      return -1;
+    }
+    client->out_len -= n;
+    memmove(client->out, client->out + n, client->out_len);
+  }
+  return 0;
+}
+
+/**
+ * \brief Connect to the daemon if not connected.
+ *
+ * The socket is non blocking. The client asks for "EVENT -" event lines,
+ * so events are never taken for answers, and for "#id BEGIN" before a
+ * multi line answer.
+ *
+ * @return 0 or -1 if the daemon is not reachable.
+ */
+int gpiod_client_connect(GpiodClient *client) {
+  struct sockaddr_un address;
+  static const char events[] = "EVENTS PREFIX EVENT\nTAGS BEGIN ON\n";
+
+  if (client->fd != -1) {
+    return 0;
+  }
+  if ((client->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == -1) {
+    return -1;
+  }
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  snprintf(address.sun_path, sizeof(address.sun_path), "%s", client->socket_name);
+  if (connect(client->fd, (struct sockaddr *) &address, sizeof(address)) == -1) {
+    close(client->fd);
+    client->fd = -1;
+    return -1;
+  }
+  if (gpiod_client_append(client, events, sizeof(events) - 1) == -1) {
+    gpiod_client_disconnect(client);
+    return -1;
+  }
+  return gpiod_client_flush(client);
+}
+
+void gpiod_client_set_event_callback(GpiodClient *client, GpiodEventCallback callback, void *arg) {
+  client->event_callback = callback;
+  client->event_arg      = arg;
+}
+
+/**
+ * \brief The socket to poll for POLLIN, -1 if not connected.
+ */
+int gpiod_client_fd(GpiodClient *client) {
+  return client->fd;
+}
+
+/**
+ * \brief Check if commands wait for POLLOUT.
+ */
+int gpiod_client_want_write(GpiodClient *client) {
+  return client->out_len > 0;
+}
+
+/**
+ * \brief Count of commands waiting for the answer.
+ */
+int gpiod_client_pending(GpiodClient *client) {
+  return client->pending_count;
+}
+
+/**
+ * \brief Send a command.
+ *
+ * The command is written at once if the socket takes it, otherwise with
+ * the next gpiod_client_process.
+ *
+ * @param client   The client.
+ * @param command  The command without newline.
+ * @param callback Called for the answer or NULL.
+ * @param arg      Argument of the callback.
+ *
+ * @return The id of the command or -1 if the daemon is not reachable.
+ */
+int gpiod_client_send(GpiodClient *client, const char *command, GpiodAnswerCallback callback, void *arg) {
+  char tag[16];
+  GpiodPending *pending;
+  struct pollfd fds;
+  int len;
+
+  if (client->fd != -1 && client->pending_count == 0 && !client->processing) {
+    // Notice a connection closed by the daemon before the command is lost.
+    fds.fd     = client->fd;
+    fds.events = POLLIN;
+    if (poll(&fds, 1, 0) > 0) {
+      gpiod_client_process(client);
+    }
+  }
+  if (strchr(command, '\n') != NULL || gpiod_client_connect(client) == -1) {
+    return -1;
+  }
+  if (client->pending_count == client->pending_size) {
+    pending = realloc(client->pending, (client->pending_size ? client->pending_size * 2 : 16) * sizeof(GpiodPending));
+    if (pending == NULL) {
+      return -1;
+    }
+    client->pending      = pending;
+    client->pending_size = client->pending_size ? client->pending_size * 2 : 16;
+  }
+  len = snprintf(tag, sizeof(tag), "#%u ", client->next_id);
+  if (gpiod_client_append(client, tag, len) == -1
+      || gpiod_client_append(client, command, strlen(command)) == -1
+      || gpiod_client_append(client, "\n", 1) == -1) {
+    return -1;
+  }
+  pending = &client->pending[client->pending_count++];
+  pending->id         = client->next_id;
+  pending->multi_line = 0;
+  pending->callback   = callback;
+  pending->arg        = arg;
+  // The id 0 is never used, the tag must be valid after a wrap around.
+  if (++client->next_id == 0) {
+    client->next_id = 1;
+  }
+  if (gpiod_client_flush(client) == -1) {
+    return -1;
+  }
+  return pending->id;
+}
+
+/**
+ * Give an event line "EVENT - name [xN since T]" to the event callback.
+ */
+static void dispatch_event(GpiodClient *client, char *line) {
+  GpiodEvent event;
+  char *aggregated;
+
+  if (client->event_callback == NULL) {
+    return;
+  }
+  event.name     = line;
+  event.count    = 1;
+  event.since_ns = 0;
+  aggregated = strstr(line, " x");
+  if (aggregated != NULL && sscanf(aggregated, " x%u since %llu", &event.count, &event.since_ns) == 2) {
+    *aggregated = '\0';
+  }
+  client->event_callback(client, &event, client->event_arg);
+}
+
+/**
+ * Give an answer line to the callback of its command.
+ */
+static void dispatch_line(GpiodClient *client, char *line, size_t len) {
+  GpiodPending pending;
+  GpiodAnswer answer;
+  unsigned long id;
+  char *end;
+  int i;
+
+  if (line[0] != '#') {
+    // Untagged lines are events or the answer of EVENTS PREFIX.
+    if (strncmp(line, "EVENT - ", 8) == 0) {
+      dispatch_event(client, line + 8);
+    }
+    return;
+  }
+  id = strtoul(line + 1, &end, 10);
+  if (*end != ' ') {
+    return;
+  }
+  for (i = 0; i < client->pending_count && client->pending[i].id != id; i++);
+  if (i == client->pending_count) {
+    return;
+  }
+  if (!client->pending[i].multi_line && strcmp(end + 1, "BEGIN") == 0) {
+    client->pending[i].multi_line = 1;
+    return;
+  }
+  pending      = client->pending[i];
+  answer.line  = end + 1;
+  answer.len   = len - (answer.line - line);
+  answer.error = strncmp(answer.line, "ERROR", 5) == 0;
+  answer.done  = !pending.multi_line;
+  if (pending.multi_line && strcmp(answer.line, "END") == 0) {
+    answer.line += 3;
+    answer.len   = 0;
+    answer.done  = 1;
+  }
+  if (answer.done) {
+    client->pending_count--;
+    memmove(&client->pending[i], &client->pending[i + 1], (client->pending_count - i) * sizeof(GpiodPending));
+  }
+  if (pending.callback != NULL) {
+    pending.callback(client, &answer, pending.arg);
+  }
+}
+
+/**
+ * Read the socket and dispatch all received answers.
+ *
+ * The callbacks may send commands, a lost connection ends the dispatch
+ * because the read buffer is cleared.
+ */
+static int gpiod_client_read_answers(GpiodClient *client) {
+  unsigned int connection = client->connection;
+  char *line, *newline;
+  ssize_t n;
+
+  while (1) {
+    n = read(client->fd, client->in + client->in_len, GPIOD_CLIENT_BUFFER_SIZE - 1 - client->in_len);
+    if (n == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return 0;
+    }
+    if (n <= 0) {
+      gpiod_client_disconnect(client);
+      return -1;
+    }
+    client->in_len += n;
+    client->in[client->in_len] = '\0';
+
+    line = client->in;
+    while ((newline = memchr(line, '\n', client->in + client->in_len - line)) != NULL) {
+      *newline = '\0';
+      dispatch_line(client, line, newline - line);
+      if (client->connection != connection) {
+        return -1;
+      }
+      line = newline + 1;
+    }
+    client->in_len -= line - client->in;
+    memmove(client->in, line, client->in_len);
+    if (client->in_len == GPIOD_CLIENT_BUFFER_SIZE - 1) {
+      // A line longer than the buffer is dropped.
+      client->in_len = 0;
+    }
+  }
+}
+
+/**
+ * \brief Write pending commands and dispatch all received answers.
+ *
+ * Call it if the socket is readable or writable, it never blocks. Called
+ * from a callback it only writes, the answers are dispatched by the
+ * outer call.
+ *
+ * @return 0 or -1 if the connection was lost, the pending commands
+ *         are answered with error -1 then.
+ */
+int gpiod_client_process(GpiodClient *client) {
+  int result;
+
+  if (client->fd == -1) {
+    return -1;
+  }
+  if (gpiod_client_flush(client) == -1) {
+    return -1;
+  }
+  if (client->processing) {
+    return 0;
+  }
+  client->processing = 1;
+  result = gpiod_client_read_answers(client);
+  client->processing = 0;
+  return result;
+}
+
+/**
+ * \brief Wait for the socket and process it.
+ *
+ * @param client     The client.
+ * @param timeout_ms Longest wait or -1 to wait without timeout.
+ *
+ * @return 0 or -1 if not connected or the connection was lost.
+ */
+int gpiod_client_wait(GpiodClient *client, int timeout_ms) {
+  struct pollfd fds;
+
+  if (client->fd == -1) {
+    return -1;
+  }
+  fds.fd     = client->fd;
+  fds.events = POLLIN | (gpiod_client_want_write(client) ? POLLOUT : 0);
+  if (poll(&fds, 1, timeout_ms) == -1 && errno != EINTR) {
+    return -1;
+  }
+  return gpiod_client_process(client);
+}
+
+/**
+ * Collect the lines of an answer for gpiod_client_command.
+ */
+static void collect_answer(GpiodClient *client, const GpiodAnswer *answer, void *arg) {
+  GpiodResult *result = (GpiodResult *) arg;
+
+  if (answer->len > 0 && result->len + 1 < result->size) {
+    result->len += snprintf(result->answer + result->len, result->size - result->len,
+        "%s%.*s", result->len > 0 ? "\n" : "", (int) answer->len, answer->line);
+    if (result->len >= result->size) {
+      result->len = result->size - 1;
+    }
+  }
+  if (result->error == 0) {
+    result->error = answer->error;
+  }
+  result->done = answer->done;
+}
+
+/**
+ * \brief Send a command and wait for the answer.
+ *
+ * Events received meanwhile are given to the event callback.
+ *
+ * @param client  The client.
+ * @param command The command without newline.
+ * @param answer  Buffer for the answer lines, may be NULL.
+ * @param size    Size of the buffer.
+ *
+ * @return 0 for an OK answer, 1 for an ERROR answer or -1 if the daemon
+ *         is not reachable.
+ */
+int gpiod_client_command(GpiodClient *client, const char *command, char *answer, size_t size) {
+  GpiodResult result = { answer, answer != NULL ? size : 0, 0, 0, 0 };
+
+  if (result.size > 0) {
+    answer[0] = '\0';
+  }
+  if (gpiod_client_send(client, command, collect_answer, &result) == -1) {
+    return -1;
+  }
+  while (!result.done) {
+    gpiod_client_wait(client, -1);
+  }
+  return result.error;
+}
+
+/**
+ * \brief Read a pin.
+ *
+ * @return The level or -1 on error.
+ */
+int gpiod_client_read(GpiodClient *client, int pin) {
+  char command[32], answer[64];
+  int level;
+
+  snprintf(command, sizeof(command), "READ %d", pin);
+  if (gpiod_client_command(client, command, answer, sizeof(answer)) != 0
+      || sscanf(answer, "OK - %d", &level) != 1) {
+    return -1;
+  }
+  return level;
+}
+
+/**
+ * \brief Write a pin.
+ *
+ * @return 0 or -1 on error.
+ */
+int gpiod_client_write(GpiodClient *client, int pin, int value) {
+  char command[32];
+
+  snprintf(command, sizeof(command), "WRITE %d %d", pin, value);
+  return gpiod_client_command(client, command, NULL, 0) == 0 ? 0 : -1;
+}
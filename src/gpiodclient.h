@@ -0,0 +1,96 @@
+/*
+ * gpiodclient.h
+ *
+ *  Created on: 19.10.2026
+ *
+ * Client library of the gpiod socket protocol.
+ *
+ * A GpiodClient keeps one connection to the daemon and connects again
+ * after the daemon closed it. Every command is sent with a #id tag, so many
+ * commands can be pending and their answers are matched even if they
+ * complete out of order. The answers are parsed in the read buffer and
+ * given to the callbacks without a copy.
+ *
+ * Non blocking, e.g. with poll or epoll:
+ *
+ *   GpiodClient *client = gpiod_client_new(NULL);
+ *   gpiod_client_send(client, "READ 4", on_answer, NULL);
+ *   // wait for POLLIN on gpiod_client_fd(client), and for POLLOUT
+ *   // while gpiod_client_want_write(client)
+ *   gpiod_client_process(client);
+ *
+ * Blocking:
+ *
+ *   char answer[64];
+ *   gpiod_client_command(client, "READ 4", answer, sizeof(answer));
+ *
+ * A client must only be used by one thread. The callbacks may send new
+ * commands, but must not call the blocking functions. A
+ * gpiod_client_process called from a callback only writes.
+ */
+
+#ifndef GPIODCLIENT_H_
+#define GPIODCLIENT_H_
+
+#include <stddef.h>
+
+/**
+ * \brief Default socket of the daemon.
+ */
+#define GPIOD_CLIENT_SOCKET "/var/lib/gpiod/socket"
+
+/**
+ * \brief Size of the read buffer, the longest answer line.
+ */
+#define GPIOD_CLIENT_BUFFER_SIZE 4096
+
+typedef struct GpiodClient GpiodClient;
+
+/**
+ * \brief A line of an answer.
+ *
+ * The line points into the read buffer and is only valid in the callback.
+ */
+typedef struct GpiodAnswer {
+  const char *line;  //> Answer line without tag and newline, e.g. "OK - 1".
+  size_t len;        //> Length of the line.
+  int error;         //> 1 for an ERROR answer, -1 if the connection was lost.
+  int done;          //> 1 for the last line of the answer.
+} GpiodAnswer;
+
+/**
+ * \brief An interrupt event.
+ *
+ * The name points into the read buffer and is only valid in the callback.
+ */
+typedef struct GpiodEvent {
+  const char *name;            //> Interrupt name.
+  unsigned int count;          //> Count of aggregated events, 1 if not aggregated.
+  unsigned long long since_ns; //> Monotonic time of the first aggregated event or 0.
+} GpiodEvent;
+
+/**
+ * \brief Called for every line of an answer.
+ *
+ * A single line answer is one call with done set. A multi line answer,
+ * started by the daemon with "#id BEGIN", is one call per line and a last
+ * call with an empty line and done set.
+ */
+typedef void (*GpiodAnswerCallback)(GpiodClient *client, const GpiodAnswer *answer, void *arg);
+typedef void (*GpiodEventCallback)(GpiodClient *client, const GpiodEvent *event, void *arg);
+
+GpiodClient *gpiod_client_new(const char *socket_name);
+void gpiod_client_free(GpiodClient *client);
+int gpiod_client_connect(GpiodClient *client);
+void gpiod_client_set_event_callback(GpiodClient *client, GpiodEventCallback callback, void *arg);
+int gpiod_client_fd(GpiodClient *client);
+int gpiod_client_want_write(GpiodClient *client);
+int gpiod_client_pending(GpiodClient *client);
+int gpiod_client_send(GpiodClient *client, const char *command, GpiodAnswerCallback callback, void *arg);
+int gpiod_client_process(GpiodClient *client);
+int gpiod_client_wait(GpiodClient *client, int timeout_ms);
+int gpiod_client_command(GpiodClient *client, const char *command, char *answer, size_t size);
+int gpiod_client_read(GpiodClient *client, int pin);
+int gpiod_client_write(GpiodClient *client, int pin, int value);
+
+#endif /* GPIODCLIENT_H_ */
@@ -0,0 +1,111 @@
+/*
+ * gpiodctl.c
+ *
+ *  Created on: 19.10.2026
+ *
+ * Send commands to gpiod with libgpiodclient.
+ *
+ * The commands of the arguments or, without arguments, the lines of stdin
+ * are sent at once without waiting for the answers. Every answer line is
+ * printed when it arrives, so answers of slow commands may come after
+ * answers of later commands.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "gpiodclient.h"
+
+static int errors = 0;
+static int answers = 0;
+
+static void usage() {
+  printf("Usage: gpiodctl [ -s socketfile ] [ -e ] [ -h ] [ command ... ]\n");
+  printf("    -s socketfile socket of the daemon (default: %s)\n", GPIOD_CLIENT_SOCKET);
+  printf("    -e            print events until interrupted\n");
+  printf("    -h            show help (this message)\n");
+  printf("Without command the commands are read from stdin, one per line.\n");
+}
+
+static void print_answer(GpiodClient *client, const GpiodAnswer *answer, void *arg) {
+  if (answer->len > 0) {
+    printf("%.*s\n", (int) answer->len, answer->line);
+  }
+  if (answer->error) {
+    errors++;
+  }
+  if (answer->done) {
+    answers++;
+  }
+}
+
+static void print_event(GpiodClient *client, const GpiodEvent *event, void *arg) {
+  if (event->count > 1) {
+    printf("EVENT - %s x%u since %llu\n", event->name, event->count, event->since_ns);
+  } else {
+    printf("EVENT - %s\n", event->name);
+  }
+  fflush(stdout);
+}
+
+static void send_command(GpiodClient *client, const char *command, int *sent) {
+  if (gpiod_client_send(client, command, print_answer, NULL) == -1) {
+    fprintf(stderr, "gpiodctl: can not send %s\n", command);
+    exit(EXIT_FAILURE);
+  }
+  (*sent)++;
+}
+
+int main(int argc, char **argv) {
+  GpiodClient *client;
+  char *socket_name = NULL, line[GPIOD_CLIENT_BUFFER_SIZE];
+  int ch, i, events = 0, sent = 0;
+
+  while ((ch = getopt(argc, argv, "hes:")) != -1) {
+    switch (ch) {
+      case 's':
+        socket_name = optarg;
+        break;
+      case 'e':
+        events = 1;
+        break;
+      case 'h':
+        usage();
+        exit(EXIT_SUCCESS);
+      default:
+        usage();
+        exit(EXIT_FAILURE);
+    }
+  }
+  if ((client = gpiod_client_new(socket_name)) == NULL || gpiod_client_connect(client) == -1) {
+    perror(socket_name != NULL ? socket_name : GPIOD_CLIENT_SOCKET);
+    exit(EXIT_FAILURE);
+  }
+  if (events) {
+    gpiod_client_set_event_callback(client, print_event, NULL);
+  }
+
+  if (optind < argc) {
+    for (i = optind; i < argc; i++) {
+      send_command(client, argv[i], &sent);
+    }
+  } else if (!events) {
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+      line[strcspn(line, "\r\n")] = '\0';
+      if (line[0] != '\0') {
+        send_command(client, line, &sent);
+      }
+    }
+  }
+
+  while (answers < sent || events) {
+    if (gpiod_client_wait(client, -1) == -1) {
+      break;
+    }
+    fflush(stdout);
+  }
+  gpiod_client_free(client);
+
+  return errors > 0 || answers < sent ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,309 @@
+/*
+ * groups.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "gpiod.h"
+#include "groups.h"
+
+/**
+ * \brief A pin group with precomputed bank masks.
+ *
+ * A bus value is written with one bank write. If the backend has a raw bank
+ * the masks are in BCM gpios and the value is written with one store to the
+ * set and one to the clear register. Pins that are ascending in the bank
+ * need only a shift, other pins are looked up byte by byte.
+ */
+typedef struct BusPort {
+  PinGroup group;
+  unsigned int mask;              //> Bank mask of all pins in wiringPi pins.
+  int raw;                        //> 1 if the port uses the raw bank of the backend.
+  unsigned int bank_mask;         //> Mask of all pins in the bank that is read and written.
+  int shift;                      //> Shift of a group of ascending bank bits or -1.
+  int output;                     //> Current direction of the pins, -1 if unknown.
+  unsigned int write_lut[4][256]; //> Bank mask of every byte of the value.
+  unsigned int read_lut[4][256];  //> Value bits of every byte of the bank.
+  unsigned int state_lut[4][256]; //> wiringPi bank mask of every byte of the value.
+} BusPort;
+
+static BusPort bus_ports[MAX_GROUPS];
+static int bus_ports_count = 0;
+static PinAlias pin_aliases[MAX_ALIASES];
+static int pin_aliases_count = 0;
+static pthread_mutex_t groups_lock = PTHREAD_MUTEX_INITIALIZER; /**< guard the tables against a reload */
+
+/**
+ * Bit of a pin in the bank of the port.
+ */
+static int bus_port_bit(BusPort *port, int pin) {
+  return port->raw ? gpio_pin_to_gpio(pin) : pin;
+}
+
+/**
+ * Precompute the masks of a port.
+ */
+static void compile_bus_port(BusPort *port, PinGroup *group, int output) {
+  int i, j, byte, value, bit, first;
+
+  port->group     = *group;
+  port->raw       = gpio_backend->read_raw_bank != NULL && gpio_backend->write_raw_bank != NULL;
+  port->mask      = 0;
+  port->bank_mask = 0;
+  port->output    = output;
+  first = bus_port_bit(port, group->pins[0]);
+  port->shift = first;
+  for (i = 0; i < group->count; i++) {
+    port->mask |= 1U << group->pins[i];
+    port->bank_mask |= 1U << bus_port_bit(port, group->pins[i]);
+    if (bus_port_bit(port, group->pins[i]) != first + i) {
+      port->shift = -1;
+    }
+  }
+  memset(port->write_lut, 0, sizeof(port->write_lut));
+  memset(port->read_lut, 0, sizeof(port->read_lut));
+  memset(port->state_lut, 0, sizeof(port->state_lut));
+  for (byte = 0; byte < 4; byte++) {
+    for (value = 0; value < 256; value++) {
+      for (bit = 0; bit < 8; bit++) {
+        if (!(value & (1 << bit))) {
+          continue;
+        }
+        i = byte * 8 + bit;
+        if (i < group->count) {
+          port->write_lut[byte][value] |= 1U << bus_port_bit(port, group->pins[i]);
+          port->state_lut[byte][value] |= 1U << group->pins[i];
+        }
+        // Find the bit of bank bit i in the value.
+        for (j = 0; j < group->count; j++) {
+          if (bus_port_bit(port, group->pins[j]) == i) {
+            port->read_lut[byte][value] |= 1U << j;
+          }
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Direction of a port before a reload, -1 if the port didn't exist with the
+ * same pins. groups_lock must be held.
+ */
+static int bus_port_old_output(PinGroup *group) {
+  int i;
+
+  for (i = 0; i < bus_ports_count; i++) {
+    if (strcmp(bus_ports[i].group.name, group->name) == 0
+        && bus_ports[i].group.count == group->count
+        && memcmp(bus_ports[i].group.pins, group->pins, sizeof(group->pins[0]) * group->count) == 0) {
+      return bus_ports[i].output;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Look up the bits of a value byte by byte.
+ */
+static unsigned int bus_port_lookup(unsigned int lut[4][256], unsigned int value) {
+  return lut[0][value & 0xff] | lut[1][(value >> 8) & 0xff]
+      | lut[2][(value >> 16) & 0xff] | lut[3][(value >> 24) & 0xff];
+}
+
+/**
+ * \brief Set the pin groups and aliases of the config file.
+ *
+ * The pins are already checked.
+ *
+ * @param groups        The groups.
+ * @param count         Count of groups.
+ * @param aliases       The aliases.
+ * @param aliases_count Count of aliases.
+ */
+void set_pin_groups(PinGroup *groups, int count, PinAlias *aliases, int aliases_count) {
+  static int outputs[MAX_GROUPS];
+  int i;
+
+  pthread_mutex_lock(&groups_lock);
+  // Keep the direction of unchanged ports, BUSREAD doesn't switch it.
+  for (i = 0; i < count; i++) {
+    outputs[i] = bus_port_old_output(&groups[i]);
+  }
+  for (i = 0; i < count; i++) {
+    compile_bus_port(&bus_ports[i], &groups[i], outputs[i]);
+  }
+  bus_ports_count = count;
+  memcpy(pin_aliases, aliases, sizeof(PinAlias) * aliases_count);
+  pin_aliases_count = aliases_count;
+  pthread_mutex_unlock(&groups_lock);
+}
+
+/**
+ * \brief Find the pin of an alias.
+ *
+ * @param name The alias, not terminated.
+ * @param len  Length of the alias.
+ *
+ * @return The pin or -1.
+ */
+int find_pin_alias(const char *name, size_t len) {
+  int i, pin = -1;
+
+  pthread_mutex_lock(&groups_lock);
+  for (i = 0; i < pin_aliases_count; i++) {
+    if (strlen(pin_aliases[i].name) == len && strncmp(pin_aliases[i].name, name, len) == 0) {
+      pin = pin_aliases[i].pin;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&groups_lock);
+
+  return pin;
+}
+
+/**
+ * \brief Replace a pin alias at the start of the arguments.
+ *
+ * @param buf      The command arguments.
+ * @param args     Buffer for the arguments with the pin number.
+ * @param args_len Size of args.
+ *
+ * @return args if an alias was replaced, otherwise buf.
+ */
+char *expand_pin_alias(char *buf, char *args, size_t args_len) {
+  size_t len = strcspn(buf, " ");
+  int pin;
+
+  if (len == 0 || (*buf >= '0' && *buf <= '9') || *buf == '-') {
+    return buf;
+  }
+  if ((pin = find_pin_alias(buf, len)) == -1) {
+    return buf;
+  }
+  snprintf(args, args_len, "%d%s", pin, buf + len);
+  return args;
+}
+
+/**
+ * Find a port. groups_lock must be held.
+ */
+static BusPort *find_bus_port(const char *name, size_t len) {
+  int i;
+
+  for (i = 0; i < bus_ports_count; i++) {
+    if (strlen(bus_ports[i].group.name) == len && strncmp(bus_ports[i].group.name, name, len) == 0) {
+      return &bus_ports[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Set the direction of the port pins. groups_lock must be held.
+ */
+static void bus_port_direction(BusPort *port, int output) {
+  int i;
+
+  if (port->output == output) {
+    return;
+  }
+  for (i = 0; i < port->group.count; i++) {
+    gpio_pin_mode(port->group.pins[i], output ? OUTPUT : INPUT);
+    state_set_mode(port->group.pins[i], output);
+  }
+  port->output = output;
+}
+
+/**
+ * \brief Write a value to a pin group.
+ *
+ * BUSWRITE name value, all pins are written with one bank write.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ * @param buf              The command arguments.
+ */
+void do_bus_write(int client_socket_fd, char *buf) {
+  BusPort *port;
+  unsigned long value;
+  unsigned int set;
+  size_t len = strcspn(buf, " ");
+  char *end = NULL;
+
+  value = buf[len] != '\0' ? strtoul(buf + len + 1, &end, 0) : 0;
+  if (len == 0 || buf[len] == '\0' || end == buf + len + 1 || *end != '\0') {
+    write_error_msg_to_client(client_socket_fd, "expected BUSWRITE <group> <value>");
+    return;
+  }
+  pthread_mutex_lock(&groups_lock);
+  if ((port = find_bus_port(buf, len)) == NULL) {
+    pthread_mutex_unlock(&groups_lock);
+    write_error_msg_to_client(client_socket_fd, "unknown group");
+    return;
+  }
+  if (port->group.count < 32 && value >> port->group.count) {
+    pthread_mutex_unlock(&groups_lock);
+    write_error_msg_to_client(client_socket_fd, "value too large for group");
+    return;
+  }
+  if (port->shift != -1) {
+    set = (value << port->shift) & port->bank_mask;
+  } else {
+    set = bus_port_lookup(port->write_lut, value);
+  }
+  bus_port_direction(port, 1);
+  if (port->raw) {
+    gpio_write_raw_bank(set, port->bank_mask & ~set);
+    set = bus_port_lookup(port->state_lut, value);
+  } else {
+    gpio_write_bank(set, port->mask & ~set);
+  }
+  state_set_bank(set, port->mask & ~set);
+  pthread_mutex_unlock(&groups_lock);
+
+  log_msg(LOG_MOD_GPIO, LOG_DEBUG, "EXECUTING %s %.*s VALUE = %lu", CLIENT_BUSWRITE, (int) len, buf, value);
+  write_msg_to_client(client_socket_fd, "operation performed");
+}
+
+/**
+ * \brief Read the value of a pin group.
+ *
+ * BUSREAD name, all pins are read with one bank read. The direction of the
+ * pins isn't changed, an output group reads back its levels. A group that
+ * wasn't written yet is switched to input once.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ * @param buf              The command arguments.
+ */
+void do_bus_read(int client_socket_fd, char *buf) {
+  BusPort *port;
+  unsigned int bank, value, set;
+  size_t len = strcspn(buf, " ");
+  char msg[BUFFER_SIZE];
+
+  pthread_mutex_lock(&groups_lock);
+  if (len == 0 || (port = find_bus_port(buf, len)) == NULL) {
+    pthread_mutex_unlock(&groups_lock);
+    write_error_msg_to_client(client_socket_fd, len == 0 ? "expected BUSREAD <group>" : "unknown group");
+    return;
+  }
+  if (port->output == -1) {
+    bus_port_direction(port, 0);
+  }
+  bank = port->raw ? gpio_read_raw_bank() : gpio_read_bank();
+  if (port->shift != -1) {
+    value = (bank & port->bank_mask) >> port->shift;
+  } else {
+    value = bus_port_lookup(port->read_lut, bank);
+  }
+  if (port->raw) {
+    set = bus_port_lookup(port->state_lut, value);
+    pthread_mutex_unlock(&groups_lock);
+    state_set_bank(set, port->mask & ~set);
+  } else {
+    pthread_mutex_unlock(&groups_lock);
+    state_set_levels(bank);
+  }
+
+  snprintf(msg, BUFFER_SIZE, "%u", value);
+  write_msg_to_client(client_socket_fd, msg);
+}
@@ -0,0 +1,51 @@
+/*
+ * groups.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef GROUPS_H_
+#define GROUPS_H_
+
+/**
+ * \brief Maximal count of pin groups.
+ */
+#define MAX_GROUPS 8
+
+/**
+ * \brief Maximal count of pin aliases.
+ */
+#define MAX_ALIASES 32
+
+/**
+ * \brief Maximal length of a group or alias name.
+ */
+#define GROUP_NAME_SIZE 32
+
+#define CLIENT_BUSWRITE "BUSWRITE"
+#define CLIENT_BUSREAD  "BUSREAD"
+
+/**
+ * \brief A named group of pins, the first pin is bit 0 of the bus value.
+ */
+typedef struct PinGroup {
+  char name[GROUP_NAME_SIZE];
+  int count;                    //> Count of pins.
+  int pins[NUM_PINS];
+} PinGroup;
+
+/**
+ * \brief A name of a pin.
+ */
+typedef struct PinAlias {
+  char name[GROUP_NAME_SIZE];
+  int pin;
+} PinAlias;
+
+void set_pin_groups(PinGroup *groups, int count, PinAlias *aliases, int aliases_count);
+int find_pin_alias(const char *name, size_t len);
+char *expand_pin_alias(char *buf, char *args, size_t args_len);
+void do_bus_write(int client_socket_fd, char *buf);
+void do_bus_read(int client_socket_fd, char *buf);
+
+#endif /* GROUPS_H_ */
@@ -5,12 +5,16 @@
  *      Author: michele
  */
 
+#include <pthread.h>
 #include "interrupt.h"
 
 int interrupts_count = 0;
-InterruptInfo interrupt_infos[10];
+InterruptInfo interrupt_infos[MAX_INTERRUPTS];
+pthread_mutex_t interrupts_lock = PTHREAD_MUTEX_INITIALIZER; /**< guard the slot table against a reload */
 
 void set_interrupt_info(int pos, InterruptInfo info) {
+	info.active = 1;
+	info.registered = 0;
 	interrupt_infos[pos] = info;
 }
 void set_interrupts_count(int count) {
@@ -21,96 +25,189 @@ int get_interrupts_count() {
 	return interrupts_count;
 }
 
-void interrupt(int id) {
+/**
+ * \brief Edge callback of the backend.
+ *
+ * @param id           The interrupt slot.
+ * @param level        The pin level after the edge.
+ * @param timestamp_ns Monotonic time of the edge.
+ */
+void interrupt(int id, int level, unsigned long long timestamp_ns) {
   unsigned long time;
-  struct timeval tv;
   char msg[50];
-  gettimeofday(&tv, NULL);
-  time = (unsigned long) (unsigned long long)(tv.tv_sec) * 1000 + (unsigned long long)(tv.tv_usec) / 1000;
-  if (interrupt_infos[id].occure + interrupt_infos[id].wait <= time) {
+  int fire = 0, active, pin;
+  time = (unsigned long) (timestamp_ns / 1000000);
+  pthread_mutex_lock(&interrupts_lock);
+  pin    = interrupt_infos[id].pin;
+  active = interrupt_infos[id].active;
+  // A slot retired by a reload keeps its isr thread, ignore it.
+  // A slot without name only feeds the rules.
+  if (active && interrupt_infos[id].name != NULL && (interrupt_infos[id].occure == 0 || interrupt_infos[id].occure + interrupt_infos[id].wait <= time)) {
     interrupt_infos[id].occure = time;
-    sprintf(msg, "%s", interrupt_infos[id].name);
-    write_msg_to_client(get_client_socket_fd(), msg);
+    snprintf(msg, sizeof(msg), "%s", interrupt_infos[id].name);
+    fire = 1;
+  }
+  pthread_mutex_unlock(&interrupts_lock);
+  // Only queued, the log never delays the edge.
+  log_msg(LOG_MOD_ISR, LOG_DEBUG, "edge pin %d level %d at %llu ns", pin, level, timestamp_ns);
+  // Rules react to every edge, the wait time only limits the events.
+  if (active) {
+    run_rules(pin, level, timestamp_ns);
+  }
+  // Every edge is published, also edges inside the wait time.
+  state_edge(pin, level, timestamp_ns);
+  record_edge(pin, level, timestamp_ns);
+  wait_notify_edge(pin, level, timestamp_ns);
+  widget_notify_edge(pin, level, timestamp_ns);
+  if (fire) {
+    log_msg(LOG_MOD_ISR, LOG_DEBUG, "event %s of pin %d", msg, pin);
+    record_event(msg);
+    schedule_event(msg);
   }
 }
 
-void interrupt0(void) {
-  interrupt(0);
-}
-
-void interrupt1(void) {
-  interrupt(1);
-}
-
-void interrupt2(void) {
-  interrupt(2);
-}
-
-void interrupt3(void) {
-  interrupt(3);
-}
-
-void interrupt4(void) {
-  interrupt(4);
-}
-
-void interrupt5(void) {
-  interrupt(5);
-}
-
-void interrupt6(void) {
-  interrupt(6);
-}
-
-void interrupt7(void) {
-  interrupt(7);
-}
-
-void interrupt8(void) {
-  interrupt(8);
-}
+/**
+ * Setup the pin of the slot and register the slot with the backend.
+ *
+ * @param r The interrupt slot.
+ */
+void register_interrupt_slot(int r) {
+	InterruptInfo info = interrupt_infos[r];
 
-void interrupt9(void) {
-  interrupt(9);
+	gpio_pin_mode(info.pin, INPUT);
+	state_set_mode(info.pin, 0);
+	gpio_pull_up_dn(info.pin, info.pud);
+	if (info.debounce > 0) {
+		gpio_set_debounce(info.pin, info.debounce);
+	}
+	gpio_isr(info.pin, info.type, r, interrupt);
+	interrupt_infos[r].registered = 1;
 }
 
 void registerInterrupts() {
 	int r;
 	// Setup pin and interrupts callback from the configuration.
 	for (r=0; r < interrupts_count; r++) {
-	  pinMode(interrupt_infos[r].pin, INPUT);
-	  pullUpDnControl(interrupt_infos[r].pin, interrupt_infos[r].pud);
-	  switch (r) {
-		case (0):
-		  wiringPiISR(interrupt_infos[r].pin, interrupt_infos[r].type, &interrupt0);
-		  break;
-		case (1):
-		  wiringPiISR(interrupt_infos[r].pin, interrupt_infos[r].type, &interrupt1);
-		  break;
-		case (2):
-		  wiringPiISR(interrupt_infos[r].pin, interrupt_infos[r].type, &interrupt2);
-		  break;
-		case (3):
-		  wiringPiISR(interrupt_infos[r].pin, interrupt_infos[r].type, &interrupt3);
-		  break;
-		case (4):
-		  wiringPiISR(interrupt_infos[r].pin, interrupt_infos[r].type, &interrupt4);
-		  break;
-		case (5):
-		  wiringPiISR(interrupt_infos[r].pin, interrupt_infos[r].type, &interrupt5);
-		  break;
-		case (6):
-		  wiringPiISR(interrupt_infos[r].pin, interrupt_infos[r].type, &interrupt6);
-		  break;
-		case (7):
-		  wiringPiISR(interrupt_infos[r].pin, interrupt_infos[r].type, &interrupt7);
-		  break;
-		case (8):
-		  wiringPiISR(interrupt_infos[r].pin, interrupt_infos[r].type, &interrupt8);
-		  break;
-		case (9):
-		  wiringPiISR(interrupt_infos[r].pin, interrupt_infos[r].type, &interrupt9);
-		  break;
-	  }
+		if (interrupt_infos[r].active) {
+			register_interrupt_slot(r);
+		}
+	}
+}
+
+/**
+ * Compare two interrupt names, a rule only slot has no name.
+ */
+static int same_name(const char *a, const char *b) {
+	return (a == NULL || b == NULL) ? a == b : strcmp(a, b) == 0;
 }
+
+/**
+ * \brief Apply a reloaded interrupt configuration.
+ *
+ * Compare the new interrupt list with the running slots. Only the name and
+ * wait of an unchanged pin is updated, pins with changed edge or pull
+ * resistor are registered again and new pins get a free slot. The new slot
+ * table is swapped in at once, so the isr callbacks never see a half
+ * applied configuration.
+ *
+ * A backend can't unregister an isr. A removed pin keeps its slot, the slot
+ * is only deactivated and can only be reused by the same pin again.
+ *
+ * @param infos       The new interrupt list, the names are owned by the table afterwards.
+ * @param count       Count of entries in infos.
+ * @param report      Buffer for the human readable result.
+ * @param report_len  Size of the report buffer.
+ *
+ * @return 0 on success or -1 if not all interrupts could be applied.
+ */
+int reload_interrupts(InterruptInfo *infos, int count, char *report, size_t report_len) {
+	InterruptInfo table[MAX_INTERRUPTS];
+	char *old_names[MAX_INTERRUPTS * 2];
+	int reregister[MAX_INTERRUPTS] = { 0 };
+	int matched[MAX_INTERRUPTS] = { 0 };
+	int added = 0, changed = 0, removed = 0, unchanged = 0, failed = 0;
+	int slots, old_name_count = 0, r, i;
+
+	pthread_mutex_lock(&interrupts_lock);
+	memcpy(table, interrupt_infos, sizeof(table));
+	slots = interrupts_count;
+	pthread_mutex_unlock(&interrupts_lock);
+
+	for (r = 0; r < slots; r++) {
+		if (!table[r].active) {
+			continue;
+		}
+		for (i = 0; i < count; i++) {
+			if (!matched[i] && infos[i].pin == table[r].pin) {
+				break;
+			}
+		}
+		if (i == count) {
+			table[r].active = 0;
+			old_names[old_name_count++] = table[r].name;
+			table[r].name = NULL;
+			removed++;
+			continue;
+		}
+		matched[i] = 1;
+		if (infos[i].type != table[r].type || infos[i].pud != table[r].pud
+				|| infos[i].debounce != table[r].debounce) {
+			table[r].type = infos[i].type;
+			table[r].pud = infos[i].pud;
+			table[r].debounce = infos[i].debounce;
+			reregister[r] = 1;
+			changed++;
+		} else if (infos[i].wait != table[r].wait || !same_name(infos[i].name, table[r].name)) {
+			changed++;
+		} else {
+			unchanged++;
+		}
+		table[r].wait = infos[i].wait;
+		old_names[old_name_count++] = table[r].name;
+		table[r].name = infos[i].name;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (matched[i]) {
+			continue;
+		}
+		for (r = 0; r < MAX_INTERRUPTS; r++) {
+			if (!table[r].active && (!table[r].registered || table[r].pin == infos[i].pin)) {
+				break;
+			}
+		}
+		if (r == MAX_INTERRUPTS) {
+			free(infos[i].name);
+			failed++;
+			continue;
+		}
+		infos[i].registered = table[r].registered;
+		infos[i].active = 1;
+		infos[i].occure = 0;
+		table[r] = infos[i];
+		reregister[r] = 1;
+		added++;
+		if (r >= slots) {
+			slots = r + 1;
+		}
+	}
+
+	pthread_mutex_lock(&interrupts_lock);
+	memcpy(interrupt_infos, table, sizeof(table));
+	interrupts_count = slots;
+	pthread_mutex_unlock(&interrupts_lock);
+
+	for (r = 0; r < slots; r++) {
+		if (reregister[r]) {
+			register_interrupt_slot(r);
+		}
+	}
+	for (i = 0; i < old_name_count; i++) {
+		free(old_names[i]);
+	}
+
+	snprintf(report, report_len, "interrupts reloaded: %d added, %d changed, %d removed, %d unchanged, %d failed",
+			added, changed, removed, unchanged, failed);
+
+	return failed ? -1 : 0;
 }
@@ -10,20 +10,32 @@
 
 #include <stdlib.h>
 #include "wiringPi.h"
-#include "gpiod.h"
+
+/**
+ * \brief Maximal count of interrupts.
+ *
+ * One callback slot exists for every interrupt, more configured interrupts are ignored.
+ */
+#define MAX_INTERRUPTS 10
 
 typedef struct InterruptInfo {
   int pin; //> Gpio pin where the interrupt is occur.
   int type; //> Interrupt type INT_EDGE_FALLING, INT_EDGE_RISING, INT_EDGE_BOTH
   char *name; //> Interrupt name to write on socket.
   int wait;  //> Wait until next interrupt will be used.
-  unsigned long occure; //> Last occur of interrupt in unix timestamp.
+  unsigned long occure; //> Last occur of interrupt in monotonic milliseconds.
   int pud; //> Pull resistior mode.
+  int debounce; //> Debounce period in microseconds for backends with kernel debounce, 0 for none.
+  int active; //> 1 if the slot is used by the running configuration.
+  int registered; //> 1 if the isr is registered for the slot pin.
 } InterruptInfo;
 
+#include "gpiod.h"
+
 void registerInterrupts();
 void set_interrupt_info(int pos, InterruptInfo info);
 void set_interrupts_count(int count);
 int get_interrupts_count();
+int reload_interrupts(InterruptInfo *infos, int count, char *report, size_t report_len);
 
 #endif /* INTERRUPT_H_ */
@@ -8,6 +8,18 @@ int lcd_is_init      = 0; /**< variable if lcd display is initialized */
 int lcd_di           = DI; /**< variable with gpio pi of di lcd signal */
 int lcd_led          = LED; /**< variable with gpio pwm pin for lcd backlight */
 int lcd_spics        = SPICS; /**< variable with spi cs */
+int lcd_eager_init   = 0; /**< initialize the display on startup in a background thread */
+int lcd_initializing = 0; /**< background init is running, lcd commands wait */
+int lcd_pen_color    = 1; /**< pen color of the client commands */
+unsigned long long lcd_init_time_us = 0; /**< duration of the last display init */
+unsigned long lcd_queued_commands   = 0; /**< count of lcd commands waiting for the init */
+LcdLibraryOp lcd_library_ops[LCD_LIBRARY_OPS]; /**< library drawings waiting for the SHOW */
+int lcd_library_ops_count = 0;
+pthread_mutex_t lcd_init_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t lcd_init_done  = PTHREAD_COND_INITIALIZER;
+int lcd_new_di, lcd_new_led, lcd_new_spics; /**< pins of a reload, applied by the lcd worker */
+int lcd_pins_pending = 0; /**< 1 if the lcd worker has to apply the new pins */
+pthread_mutex_t lcd_pins_lock = PTHREAD_MUTEX_INITIALIZER;
 
 /**
  * \brief set lcd di
@@ -62,17 +74,338 @@ void set_lcd_spics(int spics) {
 int get_lcd_spics() {
 	return lcd_spics;
 }
+/**
+ * \brief set eager lcd init
+ *
+ * @param eager 1 to initialize the display on startup.
+ */
+void set_lcd_eager_init(int eager) {
+	lcd_eager_init = eager;
+}
+
+/**
+ * \brief get eager lcd init
+ *
+ * @return int
+ */
+int get_lcd_eager_init() {
+	return lcd_eager_init;
+}
+
+/**
+ * Init the display and fonts and measure the time.
+ */
+void lcd_init_display() {
+  unsigned long long start = get_monotonic_ns();
+
+  require_wiringpi();
+  init(lcd_di, lcd_led, lcd_spics);
+  initFonts();
+  // The init starts with an empty library buffer.
+  fb_reset_pushed();
+  lcd_init_time_us = (get_monotonic_ns() - start) / 1000;
+}
+
 /**
  * Init the lcd display only once.
  */
 void init_lcd() {
   if (!lcd_is_init) {
-    init(lcd_di, lcd_led, lcd_spics);
-    initFonts();
+    lcd_init_display();
     lcd_is_init = 1;
   }
 }
 
+/**
+ * \brief Background thread for eager lcd init.
+ *
+ * @param arg unused
+ */
+void *lcd_init_thread(void *arg) {
+  lcd_init_display();
+  log_msg(LOG_MOD_LCD, LOG_INFO, "LCD initialized in %llu us", lcd_init_time_us);
+  pthread_mutex_lock(&lcd_init_lock);
+  lcd_is_init      = 1;
+  lcd_initializing = 0;
+  pthread_cond_broadcast(&lcd_init_done);
+  pthread_mutex_unlock(&lcd_init_lock);
+
+  return NULL;
+}
+
+/**
+ * \brief Start the eager lcd init.
+ *
+ * Start the display init in a background thread. lcd commands stay in the
+ * lcd queue until the init is finished.
+ */
+void start_lcd_init() {
+  pthread_t thread;
+
+  pthread_mutex_lock(&lcd_init_lock);
+  if (lcd_initializing) {
+    pthread_mutex_unlock(&lcd_init_lock);
+    return;
+  }
+  lcd_is_init      = 0;
+  lcd_initializing = 1;
+  pthread_mutex_unlock(&lcd_init_lock);
+
+  if (pthread_create(&thread, NULL, lcd_init_thread, NULL) != 0) {
+    log_msg(LOG_MOD_LCD, LOG_ERR, "pthread_create: %m");
+    pthread_mutex_lock(&lcd_init_lock);
+    lcd_initializing = 0;
+    pthread_cond_broadcast(&lcd_init_done);
+    pthread_mutex_unlock(&lcd_init_lock);
+    return;
+  }
+  pthread_detach(thread);
+}
+
+/**
+ * Wait until a running background init is finished.
+ *
+ * Called by the lcd worker, so the following lcd commands wait in the lcd
+ * queue and all other commands are not delayed.
+ */
+void lcd_wait_for_init() {
+  pthread_mutex_lock(&lcd_init_lock);
+  if (lcd_initializing) {
+    lcd_queued_commands++;
+    while (lcd_initializing) {
+      pthread_cond_wait(&lcd_init_done, &lcd_init_lock);
+    }
+  }
+  pthread_mutex_unlock(&lcd_init_lock);
+}
+
+/**
+ * Wait for a running background init and init the display if needed.
+ *
+ * Only for the drawing paths of the lcd worker, the commands without
+ * display access never wait for the init.
+ */
+static void lcd_ready() {
+  lcd_wait_for_init();
+  init_lcd();
+}
+
+/**
+ * Apply the pins of a reload, job of the lcd worker.
+ *
+ * An already initialized display is initialized again with the next lcd
+ * command, or at once with eager init.
+ */
+static void lcd_apply_pins() {
+  pthread_mutex_lock(&lcd_pins_lock);
+  if (!lcd_pins_pending) {
+    pthread_mutex_unlock(&lcd_pins_lock);
+    return;
+  }
+  lcd_di           = lcd_new_di;
+  lcd_led          = lcd_new_led;
+  lcd_spics        = lcd_new_spics;
+  lcd_pins_pending = 0;
+  pthread_mutex_unlock(&lcd_pins_lock);
+  if (lcd_eager_init) {
+    start_lcd_init();
+  } else {
+    lcd_is_init = 0;
+  }
+}
+
+/**
+ * \brief Change the lcd pins of the running daemon.
+ *
+ * The pins are swapped by the lcd worker between two lcd commands, so a
+ * drawing never sees half changed pins.
+ *
+ * @param di    The di pin.
+ * @param led   The backlight pwm pin.
+ * @param spics The spi chip select id.
+ *
+ * @return 1 if the pins are changed, otherwise 0.
+ */
+int reconfigure_lcd(int di, int led, int spics) {
+  int schedule;
+
+  pthread_mutex_lock(&lcd_pins_lock);
+  if (lcd_pins_pending ? di == lcd_new_di && led == lcd_new_led && spics == lcd_new_spics
+      : di == lcd_di && led == lcd_led && spics == lcd_spics) {
+    pthread_mutex_unlock(&lcd_pins_lock);
+    return 0;
+  }
+  lcd_new_di       = di;
+  lcd_new_led      = led;
+  lcd_new_spics    = spics;
+  schedule         = !lcd_pins_pending;
+  lcd_pins_pending = 1;
+  pthread_mutex_unlock(&lcd_pins_lock);
+  if (schedule) {
+    schedule_lcd_call(lcd_apply_pins);
+  }
+
+  return 1;
+}
+
+/**
+ * Queue a drawing of the library for the next SHOW.
+ *
+ * A CLEAR drops the drawings before it.
+ *
+ * @return 0 or -1 if too many drawings are queued.
+ */
+static int lcd_queue_library_op(LcdLibraryOpType type, int font, int x, int y, char *text) {
+  LcdLibraryOp *op;
+  int i;
+
+  if (type == LCD_OP_CLEAR) {
+    for (i = 0; i < lcd_library_ops_count; i++) {
+      free(lcd_library_ops[i].text);
+    }
+    lcd_library_ops_count = 0;
+  }
+  if (lcd_library_ops_count == LCD_LIBRARY_OPS) {
+    return -1;
+  }
+  op = &lcd_library_ops[lcd_library_ops_count++];
+  op->type  = type;
+  op->font  = font;
+  op->x     = x;
+  op->y     = y;
+  op->color = lcd_pen_color;
+  op->text  = text;
+  return 0;
+}
+
+/**
+ * Apply the queued drawings to the buffer of the library.
+ */
+static void lcd_apply_library_ops() {
+  LcdLibraryOp *op;
+  int i, color = lcd_pen_color;
+
+  for (i = 0; i < lcd_library_ops_count; i++) {
+    op = &lcd_library_ops[i];
+    switch (op->type) {
+      case LCD_OP_CLEAR:
+        clear();
+        fb_reset_pushed();
+        break;
+      case LCD_OP_INVERT:
+        invert();
+        fb_invert_pushed();
+        break;
+      case LCD_OP_TEXT:
+        if (op->color != color) {
+          color = op->color;
+          setPenColor(color);
+        }
+        selectFont(op->font);
+        writeText(op->text, op->x, op->y);
+        free(op->text);
+        break;
+    }
+  }
+  lcd_library_ops_count = 0;
+  if (color != lcd_pen_color) {
+    setPenColor(lcd_pen_color);
+  }
+}
+
+/**
+ * Show the frame of the client: the library drawings, the widgets and the
+ * back buffer.
+ */
+static void lcd_show_frame() {
+  unsigned long long trace_ns;
+  int drawn;
+
+  trace_ns = trace_begin();
+  lcd_apply_library_ops();
+  drawn = render_widgets(0);
+  fb_show();
+  fb_push(lcd_pen_color);
+  trace_end(TRACE_LCD_RENDER, trace_ns, drawn);
+  trace_ns = trace_begin();
+  show();
+  trace_end(TRACE_SPI_FLUSH, trace_ns, 0);
+  mirror_show();
+}
+
+/**
+ * \brief Draw the changed widgets and show the display.
+ *
+ * Internal job of the lcd worker, queued by the widget update timer. Only
+ * the rectangles of the widgets are shown, the drawing of a client waits
+ * for its SHOW.
+ */
+void lcd_flush_widgets() {
+  unsigned long long trace_ns;
+  int drawn;
+
+  lcd_ready();
+  trace_ns = trace_begin();
+  if ((drawn = render_widgets(1)) > 0) {
+    fb_push(lcd_pen_color);
+    trace_end(TRACE_LCD_RENDER, trace_ns, drawn);
+    trace_ns = trace_begin();
+    show();
+    trace_end(TRACE_SPI_FLUSH, trace_ns, 0);
+    mirror_show();
+  }
+}
+
+/**
+ * \brief Show the display of a snapshot.
+ *
+ * Internal job of the lcd worker, queued by start_snapshot. The framebuffer
+ * is already restored.
+ *
+ * @param contrast_value  The contrast or -1 if not set.
+ * @param backlight_level The backlight level or -1 if not set.
+ */
+void lcd_restore(int contrast_value, int backlight_level) {
+  lcd_ready();
+  if (contrast_value != -1) {
+    contrast(contrast_value);
+  }
+  if (backlight_level != -1) {
+    pwm_set_level(PWM_TARGET_LCD, backlight_level);
+  }
+  fb_push(lcd_pen_color);
+  show();
+  mirror_show();
+}
+
+/**
+ * \brief Fade the backlight.
+ *
+ * LCD FADE from to duration_ms [linear|gamma], the levels are in percent.
+ *
+ * @param client_socket_fd The unix socket file descriptor.
+ * @param buf              The lcd command.
+ */
+void do_lcd_fade(int client_socket_fd, char *buf) {
+  char command[BUFFER_SIZE], curve_name[16];
+  int from, to;
+  unsigned long duration_ms;
+  FadeCurve curve;
+  int n = sscanf(buf, "%s %d %d %lu %15s", command, &from, &to, &duration_ms, curve_name);
+
+  if (n < 4) {
+    write_error_msg_to_client(client_socket_fd, "unexpected parameters for fade backlight");
+  } else if (from < 0 || from > PWM_LCD_RANGE || to < 0 || to > PWM_LCD_RANGE) {
+    write_error_msg_to_client(client_socket_fd, "parameters for fade backlight must be between 0 and 100");
+  } else if (duration_ms > PWM_FADE_MAX_MS) {
+    write_error_msg_to_client(client_socket_fd, "time too long");
+  } else if (parse_fade_curve(n == 5 ? curve_name : NULL, &curve) == -1) {
+    write_error_msg_to_client(client_socket_fd, "curve must be linear or gamma");
+  } else {
+    pwm_start_fade(PWM_TARGET_LCD, from, to, duration_ms, curve);
+  }
+}
+
 /**
  * \brief work on lcd commands.
  * 
@@ -84,60 +417,68 @@ void init_lcd() {
 void do_lcd_commands(int client_socket_fd, char *buf) {
   char command[BUFFER_SIZE], *text;
   int x1, x2, y1, y2, r1, r2, fill, fontId;
-  int n = sscanf(buf, "%s", command);
+  int n;
+  n = sscanf(buf, "%s", command);
   if (n != 1) {
     write_error_msg_to_client(client_socket_fd, "parameter of type string expected");
   } else if (strncmp(command, LCD_LINE, strlen(LCD_LINE)) == 0) {
-    init_lcd();
+    lcd_ready();
     int n = sscanf(buf, "%s %d %d %d %d", command, &x1, &y1, &x2, &y2);
     if (n != 5) {
       write_error_msg_to_client(client_socket_fd, "unexpected parameters for draw line");
     } else {
-      line(x1, y1, x2, y2);
+      fb_line(x1, y1, x2, y2, lcd_pen_color);
     }
   } else if (strncmp(command, LCD_SHOW, strlen(LCD_SHOW)) == 0) {
-    init_lcd();
-    show();
+    lcd_ready();
+    lcd_show_frame();
   } else if (strncmp(command, LCD_CLEAR, strlen(LCD_CLEAR)) == 0) {
-    init_lcd();
-    clear();
+    lcd_ready();
+    lcd_queue_library_op(LCD_OP_CLEAR, 0, 0, 0, NULL);
+    fb_clear();
+    invalidate_widgets();
   } else if (strncmp(command, LCD_INVERT, strlen(LCD_INVERT)) == 0) {
-    init_lcd();
-    invert();
+    lcd_ready();
+    if (lcd_queue_library_op(LCD_OP_INVERT, 0, 0, 0, NULL) == -1) {
+      write_error_msg_to_client(client_socket_fd, "too many texts and inverts before SHOW");
+    } else {
+      fb_invert();
+      invalidate_widgets();
+    }
   } else if (strncmp(command, LCD_RECT, strlen(LCD_RECT)) == 0) {
-    init_lcd();
+    lcd_ready();
     int n = sscanf(buf, "%s %d %d %d %d %d", command, &x1, &y1, &x2, &y2, &fill);
     if (n != 6) {
       write_error_msg_to_client(client_socket_fd, "unexpected parameters for draw rect");
     } else {
-      rect(x1, y1, x2, y2, fill);
+      fb_rect(x1, y1, x2, y2, fill, lcd_pen_color);
     }
   } else if (strncmp(command, LCD_CIRCLE, strlen(LCD_CIRCLE)) == 0) {
-    init_lcd();
+    lcd_ready();
     int n = sscanf(buf, "%s %d %d %d %d", command, &x1, &y1, &r1, &fill);
     if (n != 5) {
       write_error_msg_to_client(client_socket_fd, "unexpected parameters for draw circle");
     } else {
-      circle(x1, y1, r1, fill);
+      fb_ellipse(x1, y1, r1, r1, fill, lcd_pen_color);
     }
   } else if (strncmp(command, LCD_ELLIPSE, strlen(LCD_ELLIPSE)) == 0) {
-    init_lcd();
+    lcd_ready();
     int n = sscanf(buf, "%s %d %d %d %d %d", command, &x1, &y1, &r1, &r2, &fill);
     if (n != 6) {
       write_error_msg_to_client(client_socket_fd, "unexpected parameters for draw ellipse");
     } else {
-      ellipse(x1, y1, r1, r2, fill);
+      fb_ellipse(x1, y1, r1, r2, fill, lcd_pen_color);
     }
   } else if (strncmp(command, LCD_DOT, strlen(LCD_DOT)) == 0) {
-    init_lcd();
+    lcd_ready();
     int n = sscanf(buf, "%s %d %d", command, &x1, &y1);
     if (n != 3) {
       write_error_msg_to_client(client_socket_fd, "unexpected parameters for draw dot");
     } else {
-      dot(x1, y1);
+      fb_pixel(x1, y1, lcd_pen_color);
     }
   } else if (strncmp(command, LCD_COLOR, strlen(LCD_COLOR)) == 0) {
-    init_lcd();
+    lcd_ready();
     int n = sscanf(buf, "%s %d", command, &x1);
     if (n != 2) {
       write_error_msg_to_client(client_socket_fd, "unexpected parameters for set pen color");
@@ -145,19 +486,23 @@ void do_lcd_commands(int client_socket_fd, char *buf) {
       write_error_msg_to_client(client_socket_fd, "parameters for set pen color can be only 0 or 1");
     } else {
       setPenColor(x1);
+      lcd_pen_color = x1;
     }
   } else if (strncmp(command, LCD_BACKLIGHT, strlen(LCD_BACKLIGHT)) == 0) {
-    init_lcd();
+    lcd_ready();
     int n = sscanf(buf, "%s %d", command, &x1);
     if (n != 2) {
       write_error_msg_to_client(client_socket_fd, "unexpected parameters for set backlight");
     } else if (x1 < 0 || x1 > 100) {
       write_error_msg_to_client(client_socket_fd, "parameters for set backlight can be only 0 or 100");
     } else {
-      backlight(x1);
+      pwm_set_level(PWM_TARGET_LCD, x1);
     }
+  } else if (strncmp(command, LCD_FADE, strlen(LCD_FADE)) == 0) {
+    lcd_ready();
+    do_lcd_fade(client_socket_fd, buf);
   } else if (strncmp(command, LCD_CONTRAST, strlen(LCD_CONTRAST)) == 0) {
-    init_lcd();
+    lcd_ready();
     int n = sscanf(buf, "%s %d", command, &x1);
     if (n != 2) {
       write_error_msg_to_client(client_socket_fd, "unexpected parameters for set contrast");
@@ -165,9 +510,10 @@ void do_lcd_commands(int client_socket_fd, char *buf) {
       write_error_msg_to_client(client_socket_fd, "parameters for set contrast can be only 0 or 1024");
     } else {
       contrast(x1);
+      snapshot_set_contrast(x1);
     }
   } else if (strncmp(command, LCD_DSPNORMAL, strlen(LCD_DSPNORMAL)) == 0) {
-    init_lcd();
+    lcd_ready();
     int n = sscanf(buf, "%s %d", command, &x1);
     if (n != 2) {
       write_error_msg_to_client(client_socket_fd, "unexpected parameters for set display normal");
@@ -177,17 +523,28 @@ void do_lcd_commands(int client_socket_fd, char *buf) {
       displaynormal(x1);
     }
   } else if (strncmp(command, LCD_TEXT, strlen(LCD_TEXT)) == 0) {
-    init_lcd();
+    lcd_ready();
     text = malloc(strlen(buf) + 1);
     int n = sscanf(buf, "%s %d %d %d %[^\t\n]", command, &fontId, &x1, &y1, text);
     if (n != 5) {
       write_error_msg_to_client(client_socket_fd, "unexpected parameters to write text");
+      free(text);
     } else if (fontId < 0 || fontId > 33) {
       write_error_msg_to_client(client_socket_fd, "fontId to write Text must be between 0 and 33");
-    } else {
-      selectFont(fontId);
-      writeText(text, x1, y1);
+      free(text);
+    } else if (lcd_queue_library_op(LCD_OP_TEXT, fontId, x1, y1, text) == -1) {
+      write_error_msg_to_client(client_socket_fd, "too many texts and inverts before SHOW");
+      free(text);
     }
+  } else if (strncmp(command, LCD_SPRITE, strlen(LCD_SPRITE)) == 0) {
+    lcd_ready();
+    do_lcd_sprite(client_socket_fd, buf);
+  } else if (strncmp(command, LCD_WIDGET, strlen(LCD_WIDGET)) == 0) {
+    do_lcd_widget(client_socket_fd, buf);
+  } else if (strncmp(command, LCD_WATCH, strlen(LCD_WATCH)) == 0) {
+    do_lcd_watch(client_socket_fd, buf);
+  } else if (strncmp(command, LCD_DUMP, strlen(LCD_DUMP)) == 0) {
+    do_lcd_dump(client_socket_fd);
   } else if (strncmp(command, LCD_INFO, strlen(LCD_INFO)) == 0) {
 	  do_write_lcd_info(client_socket_fd);
   } else if (strncmp(command, LCD_FONT_INFO, strlen(LCD_FONT_INFO)) == 0) {
@@ -202,6 +559,7 @@ void do_write_lcd_info(int client_socket_fd) {
     write_msg_to_client(client_socket_fd, "LCD CLEAR => clear screen buffer.");
     write_msg_to_client(client_socket_fd, "LCD SHOW => wirte screen buffer to lcd.");
     write_msg_to_client(client_socket_fd, "LCD BACKLIGHT value => change backlight between 0 and 100%.");
+    write_msg_to_client(client_socket_fd, "LCD FADE from to duration_ms [linear|gamma] => fade backlight.");
     write_msg_to_client(client_socket_fd, "LCD CONTRAST value => change contrast between 5 and 25.");
     write_msg_to_client(client_socket_fd, "LCD DSPNORMAL value => change display 0 => normal, 1 => reverse.");
     write_msg_to_client(client_socket_fd, "LCD INVERT => invert display.");
@@ -212,10 +570,43 @@ void do_write_lcd_info(int client_socket_fd) {
     write_msg_to_client(client_socket_fd, "LCD CIRCLE x1 y1 r1 fill => write circle to screen buffer.");
     write_msg_to_client(client_socket_fd, "LCD ELLIPSE x1 y1 r1 r2 fill => write ellipse to screen buffer.");
     write_msg_to_client(client_socket_fd, "LCD TEXT fontId x1 y1 \"TEXT\" => write text to screen buffer.");
+    write_msg_to_client(client_socket_fd, "LCD SPRITE DEFINE id w h hex => store a page packed sprite.");
+    write_msg_to_client(client_socket_fd, "LCD SPRITE DRAW id x y [set|clear|xor] => draw a sprite to screen buffer.");
+    write_msg_to_client(client_socket_fd, "LCD SPRITE FREE id => delete a sprite.");
+    write_msg_to_client(client_socket_fd, "LCD WIDGET PIN id pin x y w h => box filled while the pin is high.");
+    write_msg_to_client(client_socket_fd, "LCD WIDGET COUNTER id pin x y w => count of edges of the pin.");
+    write_msg_to_client(client_socket_fd, "LCD WIDGET BAR id pin x y w h max => bar of the count of edges.");
+    write_msg_to_client(client_socket_fd, "LCD WIDGET TEXT id pin x y w high low => text of the pin level.");
+    write_msg_to_client(client_socket_fd, "LCD WIDGET RESET|FREE id => restart the count or delete a widget.");
+    write_msg_to_client(client_socket_fd, "LCD WATCH [ON|OFF] => stream the shown screen as page deltas.");
+    write_msg_to_client(client_socket_fd, "LCD DUMP => get the shown screen as plain pbm.");
     write_msg_to_client(client_socket_fd, "LCD FONTINFO => get a list of all fonts.");
     write_msg_to_client(client_socket_fd, "LCD INFO => get this info.");
 }
 
+/**
+ * \brief Write the lcd statistics.
+ *
+ * @param client_socket_fd The unix socket file descriptor.
+ */
+void do_write_lcd_stats(int client_socket_fd) {
+  char msg[BUFFER_SIZE];
+
+  if (lcd_initializing) {
+    snprintf(msg, BUFFER_SIZE, "lcd init: %s, running", lcd_eager_init ? "eager" : "lazy");
+  } else if (lcd_is_init) {
+    snprintf(msg, BUFFER_SIZE, "lcd init: %s, done in %llu us", lcd_eager_init ? "eager" : "lazy", lcd_init_time_us);
+  } else {
+    snprintf(msg, BUFFER_SIZE, "lcd init: %s, not initialized", lcd_eager_init ? "eager" : "lazy");
+  }
+  write_msg_to_client(client_socket_fd, msg);
+  snprintf(msg, BUFFER_SIZE, "lcd commands waiting for init: %lu", lcd_queued_commands);
+  write_msg_to_client(client_socket_fd, msg);
+  do_write_sprite_stats(client_socket_fd);
+  do_write_widget_stats(client_socket_fd);
+  do_write_mirror_stats(client_socket_fd);
+}
+
 void do_write_lcd_font_info(int client_socket_fd) {
     write_msg_to_client(client_socket_fd, "LCD FONT SIZE 4x6 ID 0");
     write_msg_to_client(client_socket_fd, "LCD FONT SIZE 5x12 ID 2");
@@ -34,6 +34,7 @@
 #define LCD_CIRCLE     "CIRCLE"
 #define LCD_ELLIPSE    "ELLIPSE"
 #define LCD_BACKLIGHT  "BACKLIGHT"
+#define LCD_FADE       "FADE"
 #define LCD_CONTRAST   "CONTRAST"
 #define LCD_DSPNORMAL  "DSPNORMAL"
 #define LCD_INVERT     "INVERT"
@@ -41,6 +42,32 @@
 #define LCD_DOT        "DOT"
 #define LCD_COLOR      "COLOR"
 
+/**
+ * \brief Maximal count of library drawings between two SHOWs.
+ */
+#define LCD_LIBRARY_OPS 64
+
+typedef enum LcdLibraryOpType {
+  LCD_OP_CLEAR = 0, //> clear the library buffer
+  LCD_OP_INVERT,    //> invert the library buffer
+  LCD_OP_TEXT       //> write a text with a font of the library
+} LcdLibraryOpType;
+
+/**
+ * \brief A drawing into the buffer of the dog128 library.
+ *
+ * The library buffer is shown by the widget updates too, so the drawings
+ * wait for the SHOW of the client like the back buffer of gpiod.
+ */
+typedef struct LcdLibraryOp {
+  LcdLibraryOpType type;
+  int font;                     //> Font of the text.
+  int x;                        //> Column of the text.
+  int y;                        //> Row of the text.
+  int color;                    //> Pen color of the text.
+  char *text;                   //> The text, freed after the SHOW.
+} LcdLibraryOp;
+
 void do_lcd_commands(int client_socket_fd, char *buf);
 void set_lcd_di(int di);
 int get_lcd_di();
@@ -48,6 +75,14 @@ void set_lcd_led(int led);
 int get_lcd_led();
 void set_lcd_spics(int spics);
 int get_lcd_spics();
+int reconfigure_lcd(int di, int led, int spics);
+void set_lcd_eager_init(int eager);
+int get_lcd_eager_init();
+void start_lcd_init();
+void do_write_lcd_stats(int client_socket_fd);
+void lcd_flush_widgets();
+void lcd_restore(int contrast_value, int backlight_level);
+void do_lcd_fade(int client_socket_fd, char *buf);
 void do_write_lcd_info(int client_socket_fd);
 void do_write_lcd_font_info(int client_socket_fd);
 
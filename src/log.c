@@ -0,0 +1,538 @@
+/*
+ * log.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <strings.h>
+#include "gpiod.h"
+#include "log.h"
+
+int log_levels[LOG_MOD_COUNT] = { LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT,
+    LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT };
+
+static const char *log_module_names[LOG_MOD_COUNT] = { "daemon", "client", "gpio", "isr", "lcd", "timer" };
+static const char *log_level_names[LOG_DEBUG + 1] = { "emerg", "alert", "crit", "error", "warning", "notice", "info", "debug" };
+
+static LogRecord log_ring[LOG_RING_SIZE];
+static unsigned long log_head = 0;        /**< count of claimed records */
+static unsigned long log_tail = 0;        /**< count of written records */
+static unsigned long log_dropped = 0;     /**< records lost in a full ring */
+static unsigned long log_reported = 0;    /**< dropped records already reported */
+static const char *log_target = NULL;     /**< syslog, stdout, a file or NULL for the default */
+static FILE *log_file = NULL;             /**< output or NULL for syslog */
+static int log_started = 0;               /**< 1 while the log thread runs */
+static pthread_mutex_t log_write_lock = PTHREAD_MUTEX_INITIALIZER; /**< serialize the output */
+
+/**
+ * \brief Parse a level name.
+ *
+ * @param name error, warning, notice, info or debug, any case.
+ *
+ * @return The syslog priority or -1.
+ */
+int parse_log_level(const char *name) {
+  int level;
+
+  for (level = LOG_ERR; level <= LOG_DEBUG; level++) {
+    if (strcasecmp(name, log_level_names[level]) == 0) {
+      return level;
+    }
+  }
+  return -1;
+}
+
+/**
+ * \brief Parse a module name.
+ *
+ * @param name The module name, any case.
+ *
+ * @return The LogModule or -1.
+ */
+int parse_log_module(const char *name) {
+  int module;
+
+  for (module = 0; module < LOG_MOD_COUNT; module++) {
+    if (strcasecmp(name, log_module_names[module]) == 0) {
+      return module;
+    }
+  }
+  return -1;
+}
+
+const char *get_log_module_name(int module) {
+  return log_module_names[module];
+}
+
+/**
+ * \brief Set the level of a module.
+ *
+ * @param module The LogModule or -1 for all modules.
+ * @param level  The syslog priority.
+ */
+void set_log_level(int module, int level) {
+  int m;
+
+  for (m = 0; m < LOG_MOD_COUNT; m++) {
+    if (module == -1 || module == m) {
+      __atomic_store_n(&log_levels[m], level, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+/**
+ * \brief Set the output of the log, used by start_log.
+ *
+ * @param target syslog, stdout or a file name.
+ */
+void set_log_target(const char *target) {
+  log_target = target;
+}
+
+const char *get_log_target() {
+  return log_target != NULL ? log_target : LOG_TARGET_STDOUT;
+}
+
+/**
+ * Parse a conversion of the format.
+ *
+ * @param format    Position after the %.
+ * @param stars     1 for a * width, 2 for a * precision.
+ * @param precision Literal precision or -1.
+ * @param length    The length modifier, 'H' for hh and 'q' for ll.
+ *
+ * @return The conversion character, the position after it in end.
+ */
+static char parse_conversion(const char *format, const char **end, int *stars, int *precision, char *length) {
+  *stars     = 0;
+  *precision = -1;
+  *length    = 0;
+
+  format += strspn(format, "-+ #0'");
+  if (*format == '*') {
+    *stars |= 1;
+    format++;
+  } else {
+    format += strspn(format, "0123456789");
+  }
+  if (*format == '.') {
+    format++;
+    if (*format == '*') {
+      *stars |= 2;
+      format++;
+    } else {
+      *precision = atoi(format);
+      format += strspn(format, "0123456789");
+    }
+  }
+  if (strchr("hlLzjt", *format) != NULL && *format != '\0') {
+    *length = *format++;
+    if ((*length == 'h' || *length == 'l') && *format == *length) {
+      *length = *length == 'h' ? 'H' : 'q';
+      format++;
+    }
+  }
+  *end = *format != '\0' ? format + 1 : format;
+  return *format;
+}
+
+/**
+ * Copy the arguments into the record.
+ *
+ * Only the conversions are parsed, the message is formatted by the log
+ * thread. Strings are copied, they may be gone when the record is written.
+ */
+static void capture_args(LogRecord *record, const char *format, va_list ap, int error) {
+  const char *s;
+  size_t text_len = 0, len;
+  int stars, precision, count, i;
+  char conversion, length;
+  LogArg *arg;
+
+  record->nargs     = 0;
+  record->truncated = 0;
+  while ((format = strchr(format, '%')) != NULL) {
+    if (format[1] == '%') {
+      format += 2;
+      continue;
+    }
+    conversion = parse_conversion(format + 1, &format, &stars, &precision, &length);
+    count      = (stars & 1) + (stars >> 1);
+    if (record->nargs + count + 1 > LOG_MAX_ARGS) {
+      record->truncated = 1;
+      return;
+    }
+    for (i = 0; i < count; i++) {
+      record->args[record->nargs++].i = va_arg(ap, int);
+    }
+    if (stars & 2) {
+      precision = (int) record->args[record->nargs - 1].i;
+    }
+    arg = &record->args[record->nargs];
+    switch (conversion) {
+    case 'd': case 'i':
+      arg->i = length == 'q' ? va_arg(ap, long long) : length == 'l' ? va_arg(ap, long)
+          : length == 'z' ? (long long) va_arg(ap, ssize_t) : length == 'j' ? (long long) va_arg(ap, intmax_t)
+          : length == 't' ? (long long) va_arg(ap, ptrdiff_t) : va_arg(ap, int);
+      break;
+    case 'u': case 'x': case 'X': case 'o':
+      arg->u = length == 'q' ? va_arg(ap, unsigned long long) : length == 'l' ? va_arg(ap, unsigned long)
+          : length == 'z' ? (unsigned long long) va_arg(ap, size_t) : length == 'j' ? (unsigned long long) va_arg(ap, uintmax_t)
+          : length == 't' ? (unsigned long long) va_arg(ap, ptrdiff_t) : va_arg(ap, unsigned int);
+      break;
+    case 'c':
+      arg->i = va_arg(ap, int);
+      break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+      arg->d = length == 'L' ? (double) va_arg(ap, long double) : va_arg(ap, double);
+      break;
+    case 'p':
+      arg->p = va_arg(ap, void *);
+      break;
+    case 's':
+      if ((s = va_arg(ap, const char *)) == NULL) {
+        s = "(null)";
+      }
+      len = strnlen(s, precision >= 0 ? (size_t) precision : LOG_TEXT_SIZE);
+      if (text_len + len + 1 > LOG_TEXT_SIZE) {
+        len = text_len < LOG_TEXT_SIZE ? LOG_TEXT_SIZE - text_len - 1 : 0;
+      }
+      if (text_len >= LOG_TEXT_SIZE) {
+        record->truncated = 1;
+        return;
+      }
+      memcpy(record->text + text_len, s, len);
+      record->text[text_len + len] = '\0';
+      arg->text = text_len;
+      text_len += len + 1;
+      break;
+    case 'm':
+      // %m takes no argument, the errno of the call is stored.
+      arg->i = error;
+      break;
+    default:
+      record->truncated = 1;
+      return;
+    }
+    record->nargs++;
+  }
+}
+
+/**
+ * Format a record like printf with the stored arguments.
+ */
+static void format_record(LogRecord *record, char *out, size_t size) {
+  const char *format = record->format, *start, *end;
+  char spec[32], conversion, length;
+  int stars, precision, count, n = 0, a = 0, width_arg[2];
+  size_t len = 0;
+  LogArg *arg;
+
+  out[0] = '\0';
+  while (*format != '\0' && len < size - 1) {
+    if ((end = strchr(format, '%')) == NULL) {
+      end = format + strlen(format);
+    }
+    n = snprintf(out + len, size - len, "%.*s", (int) (end - format), format);
+    len += n > 0 ? n : 0;
+    if (*end == '\0' || len >= size - 1) {
+      break;
+    }
+    if (end[1] == '%') {
+      len += snprintf(out + len, size - len, "%%");
+      format = end + 2;
+      continue;
+    }
+    start      = end;
+    conversion = parse_conversion(start + 1, &format, &stars, &precision, &length);
+    count      = (stars & 1) + (stars >> 1);
+    if (a + count + 1 > record->nargs) {
+      snprintf(out + len, size - len, "...");
+      return;
+    }
+    snprintf(spec, sizeof(spec), "%.*s", (int) (format - start), start);
+    for (n = 0; n < count; n++) {
+      width_arg[n] = (int) record->args[a++].i;
+    }
+    arg = &record->args[a++];
+#define LOG_FORMAT(value) (count == 2 ? snprintf(out + len, size - len, spec, width_arg[0], width_arg[1], value) \
+    : count == 1 ? snprintf(out + len, size - len, spec, width_arg[0], value) : snprintf(out + len, size - len, spec, value))
+    switch (conversion) {
+    case 'd': case 'i':
+      n = length == 'q' ? LOG_FORMAT(arg->i) : length == 'l' ? LOG_FORMAT((long) arg->i)
+          : length == 'z' ? LOG_FORMAT((ssize_t) arg->i) : length == 'j' ? LOG_FORMAT((intmax_t) arg->i)
+          : length == 't' ? LOG_FORMAT((ptrdiff_t) arg->i) : LOG_FORMAT((int) arg->i);
+      break;
+    case 'u': case 'x': case 'X': case 'o':
+      n = length == 'q' ? LOG_FORMAT(arg->u) : length == 'l' ? LOG_FORMAT((unsigned long) arg->u)
+          : length == 'z' ? LOG_FORMAT((size_t) arg->u) : length == 'j' ? LOG_FORMAT((uintmax_t) arg->u)
+          : length == 't' ? LOG_FORMAT((ptrdiff_t) arg->u) : LOG_FORMAT((unsigned int) arg->u);
+      break;
+    case 'c':
+      n = LOG_FORMAT((int) arg->i);
+      break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+      n = length == 'L' ? LOG_FORMAT((long double) arg->d) : LOG_FORMAT(arg->d);
+      break;
+    case 'p':
+      n = LOG_FORMAT(arg->p);
+      break;
+    case 's':
+      n = LOG_FORMAT(record->text + arg->text);
+      break;
+    case 'm':
+      n = snprintf(out + len, size - len, "%s", strerror((int) arg->i));
+      break;
+    default:
+      n = 0;
+      break;
+    }
+#undef LOG_FORMAT
+    len += n > 0 ? n : 0;
+  }
+  if (record->truncated && len < size - 4) {
+    snprintf(out + len, size - len, " ...");
+  }
+}
+
+/**
+ * Write a formatted message. log_write_lock must be held.
+ */
+static void write_log_line(int module, int level, unsigned long long time_ns, const char *text) {
+  char stamp[32];
+  time_t seconds = time_ns / 1000000000ULL;
+  int len = strlen(text);
+  struct tm tm;
+
+  // Client input is logged with its newline.
+  while (len > 0 && text[len - 1] == '\n') {
+    len--;
+  }
+
+  if (log_started && log_file == NULL) {
+    syslog(level, "%s: %.*s", log_module_names[module], len, text);
+    return;
+  }
+  localtime_r(&seconds, &tm);
+  strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+  fprintf(log_file != NULL ? log_file : stdout, "%s.%06llu %s %s: %.*s\n", stamp, (time_ns % 1000000000ULL) / 1000,
+      log_level_names[level], log_module_names[module], len, text);
+}
+
+/**
+ * Realtime of a message.
+ */
+static unsigned long long get_log_time_ns() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * \brief Log a message of a module.
+ *
+ * The message is only queued, a full ring drops it. Before the log thread
+ * is started the message is written at once. The format must be a string
+ * constant, it is kept until the log thread formats the message.
+ *
+ * @param module The LogModule.
+ * @param level  The syslog priority.
+ * @param format printf format, %m is the current errno.
+ */
+void log_msg(LogModule module, int level, const char *format, ...) {
+  char text[BUFFER_SIZE * 2];
+  unsigned long head, seq;
+  LogRecord *record;
+  int error = errno;
+  va_list ap;
+
+  if (!log_enabled(module, level)) {
+    return;
+  }
+  va_start(ap, format);
+  if (!__atomic_load_n(&log_started, __ATOMIC_ACQUIRE)) {
+    errno = error;
+    vsnprintf(text, sizeof(text), format, ap);
+    va_end(ap);
+    pthread_mutex_lock(&log_write_lock);
+    write_log_line(module, level, get_log_time_ns(), text);
+    fflush(log_file != NULL ? log_file : stdout);
+    pthread_mutex_unlock(&log_write_lock);
+    return;
+  }
+
+  head = __atomic_load_n(&log_head, __ATOMIC_RELAXED);
+  do {
+    if (head - __atomic_load_n(&log_tail, __ATOMIC_ACQUIRE) >= LOG_RING_SIZE) {
+      __atomic_fetch_add(&log_dropped, 1, __ATOMIC_RELAXED);
+      va_end(ap);
+      return;
+    }
+  } while (!__atomic_compare_exchange_n(&log_head, &head, head + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+  seq    = head + 1;
+  record = &log_ring[head & (LOG_RING_SIZE - 1)];
+  record->time_ns = get_log_time_ns();
+  record->format  = format;
+  record->module  = module;
+  record->level   = level;
+  capture_args(record, format, ap, error);
+  va_end(ap);
+  __atomic_store_n(&record->seq, seq, __ATOMIC_RELEASE);
+}
+
+/**
+ * Write the published records. log_write_lock must be held.
+ *
+ * @return Count of written records.
+ */
+static int drain_log() {
+  char text[BUFFER_SIZE * 4];
+  unsigned long tail = log_tail, dropped;
+  LogRecord *record;
+  int count = 0;
+
+  while (1) {
+    record = &log_ring[tail & (LOG_RING_SIZE - 1)];
+    if (__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) != tail + 1) {
+      break;
+    }
+    format_record(record, text, sizeof(text));
+    write_log_line(record->module, record->level, record->time_ns, text);
+    tail++;
+    // The slot is free for the writers from now on.
+    __atomic_store_n(&log_tail, tail, __ATOMIC_RELEASE);
+    count++;
+  }
+  dropped = __atomic_load_n(&log_dropped, __ATOMIC_RELAXED);
+  if (dropped != log_reported) {
+    snprintf(text, sizeof(text), "%lu messages dropped, the log ring was full", dropped - log_reported);
+    write_log_line(LOG_MOD_DAEMON, LOG_WARNING, get_log_time_ns(), text);
+    log_reported = dropped;
+  }
+  if (count > 0 && log_file != NULL) {
+    fflush(log_file);
+  }
+  return count;
+}
+
+/**
+ * \brief Thread to format and write the log.
+ *
+ * @param arg unused
+ */
+void *log_thread(void *arg) {
+  struct timespec ts = { 0, LOG_FLUSH_MS * 1000000L };
+
+  trace_name_thread("log");
+  while (1) {
+    pthread_mutex_lock(&log_write_lock);
+    drain_log();
+    pthread_mutex_unlock(&log_write_lock);
+    nanosleep(&ts, NULL);
+  }
+  return NULL;
+}
+
+/**
+ * \brief Open the log output and start the log thread.
+ *
+ * Without a target a daemon logs to syslog, a daemon started with -d to
+ * stdout.
+ *
+ * @param detached 1 if the daemon runs in the background.
+ */
+void start_log(int detached) {
+  pthread_t thread;
+
+  if (log_target == NULL) {
+    log_target = detached ? LOG_TARGET_SYSLOG : LOG_TARGET_STDOUT;
+  }
+  if (strcmp(log_target, LOG_TARGET_STDOUT) == 0) {
+    log_file = stdout;
+  } else if (strcmp(log_target, LOG_TARGET_SYSLOG) != 0 && (log_file = fopen(log_target, "a")) == NULL) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "%s: %m, logging to syslog", log_target);
+    log_target = LOG_TARGET_SYSLOG;
+  }
+  if (log_file == NULL) {
+    openlog("gpiod", LOG_PID, LOG_DAEMON);
+  }
+  if (pthread_create(&thread, NULL, log_thread, NULL) != 0) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "pthread_create: %m");
+    exit (EXIT_FAILURE);
+  }
+  pthread_detach(thread);
+  __atomic_store_n(&log_started, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * \brief Write the queued records at once, e.g. before an exit.
+ *
+ * Safe in a signal handler, nothing is written if the log thread writes.
+ */
+void flush_log() {
+  if (pthread_mutex_trylock(&log_write_lock) == 0) {
+    drain_log();
+    fflush(log_file != NULL ? log_file : stdout);
+    pthread_mutex_unlock(&log_write_lock);
+  }
+}
+
+/**
+ * Write the target and the levels of the log.
+ */
+static void write_log_status(int client_socket_fd) {
+  char msg[BUFFER_SIZE];
+  int module, len;
+
+  len = snprintf(msg, BUFFER_SIZE, "log %s", get_log_target());
+  for (module = 0; module < LOG_MOD_COUNT && len < BUFFER_SIZE; module++) {
+    len += snprintf(msg + len, BUFFER_SIZE - len, ", %s %s", log_module_names[module],
+        log_level_names[__atomic_load_n(&log_levels[module], __ATOMIC_RELAXED)]);
+  }
+  write_msg_to_client(client_socket_fd, msg);
+}
+
+/**
+ * \brief Show or set the log levels.
+ *
+ * LOG shows the levels, LOG module|ALL level sets the level of a module or
+ * of all modules.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ * @param buf              The command arguments.
+ */
+void do_log(int client_socket_fd, char *buf) {
+  char module_name[16], level_name[16];
+  int module = -1, level;
+  int n = sscanf(buf, "%15s %15s", module_name, level_name);
+
+  if (n <= 0) {
+    write_log_status(client_socket_fd);
+  } else if (n != 2) {
+    write_error_msg_to_client(client_socket_fd, "expected LOG [module|ALL level]");
+  } else if (strcasecmp(module_name, "ALL") != 0 && (module = parse_log_module(module_name)) == -1) {
+    write_error_msg_to_client(client_socket_fd, "unknown log module");
+  } else if ((level = parse_log_level(level_name)) == -1) {
+    write_error_msg_to_client(client_socket_fd, "level must be error, warning, notice, info or debug");
+  } else {
+    set_log_level(module, level);
+    write_log_status(client_socket_fd);
+  }
+}
+
+/**
+ * \brief Write the log statistics.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ */
+void do_write_log_stats(int client_socket_fd) {
+  char msg[BUFFER_SIZE];
+
+  snprintf(msg, BUFFER_SIZE, "log: %lu messages, %lu dropped, ring %d",
+      __atomic_load_n(&log_head, __ATOMIC_RELAXED), __atomic_load_n(&log_dropped, __ATOMIC_RELAXED), LOG_RING_SIZE);
+  write_msg_to_client(client_socket_fd, msg);
+}
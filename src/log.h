@@ -0,0 +1,102 @@
+/*
+ * log.h
+ *
+ *  Created on: 19.10.2026
+ *
+ * Asynchronous logging with a level per module.
+ *
+ * log_msg only copies the format and the arguments into a fixed size record
+ * of a lock free ring, the log thread formats the records and writes them to
+ * syslog, stdout or a file. So logging never waits for the output, also not
+ * in the isr threads. The levels are the syslog priorities.
+ */
+
+#ifndef LOG_H_
+#define LOG_H_
+
+#include <syslog.h>
+
+/**
+ * \brief Count of records in the ring, a power of two.
+ *
+ * Records logged into a full ring are dropped and counted.
+ */
+#define LOG_RING_SIZE 1024
+
+/**
+ * \brief Arguments and bytes of string arguments of a record.
+ *
+ * Longer strings are cut, further arguments are written as "...".
+ */
+#define LOG_MAX_ARGS  6
+#define LOG_TEXT_SIZE 80
+
+/**
+ * \brief Interval of the log thread to look for new records in milliseconds.
+ */
+#define LOG_FLUSH_MS 20
+
+#define LOG_LEVEL_DEFAULT LOG_INFO
+#define LOG_TARGET_SYSLOG "syslog"
+#define LOG_TARGET_STDOUT "stdout"
+
+#define CLIENT_LOG "LOG"
+
+typedef enum LogModule {
+  LOG_MOD_DAEMON = 0, //> Startup, config, reload and signals.
+  LOG_MOD_CLIENT,     //> Connections and client input.
+  LOG_MOD_GPIO,       //> Pin commands and the backends.
+  LOG_MOD_ISR,        //> Edges and interrupt events.
+  LOG_MOD_LCD,        //> Display, sprites and widgets.
+  LOG_MOD_TIMER,      //> Timer wheel, timed writes and fades.
+  LOG_MOD_COUNT
+} LogModule;
+
+/**
+ * \brief Argument of a record, the type is given by the conversion of the format.
+ */
+typedef union LogArg {
+  long long i;
+  unsigned long long u;
+  double d;
+  const void *p;
+  int text;                     //> Offset of a string argument in the text of the record.
+} LogArg;
+
+/**
+ * \brief A log message before formatting.
+ */
+typedef struct LogRecord {
+  unsigned long seq;            //> Position + 1 in the ring, written last.
+  unsigned long long time_ns;   //> Realtime of the message.
+  const char *format;           //> The format, a string constant.
+  unsigned char module;         //> LogModule
+  unsigned char level;          //> syslog priority
+  unsigned char nargs;          //> Count of stored arguments.
+  unsigned char truncated;      //> 1 if not all arguments were stored.
+  LogArg args[LOG_MAX_ARGS];
+  char text[LOG_TEXT_SIZE];     //> The string arguments, each terminated with 0.
+} LogRecord;
+
+extern int log_levels[LOG_MOD_COUNT];
+
+/**
+ * \brief Check if a message of the module and level is logged.
+ */
+static inline int log_enabled(LogModule module, int level) {
+  return level <= __atomic_load_n(&log_levels[module], __ATOMIC_RELAXED);
+}
+
+void log_msg(LogModule module, int level, const char *format, ...) __attribute__((format(printf, 3, 4)));
+int parse_log_level(const char *name);
+int parse_log_module(const char *name);
+const char *get_log_module_name(int module);
+void set_log_level(int module, int level);
+void set_log_target(const char *target);
+const char *get_log_target();
+void start_log(int detached);
+void flush_log();
+void do_log(int client_socket_fd, char *buf);
+void do_write_log_stats(int client_socket_fd);
+
+#endif /* LOG_H_ */
@@ -0,0 +1,224 @@
+/*
+ * mirror.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "gpiod.h"
+#include "fb.h"
+#include "mirror.h"
+
+/**
+ * \brief Size of the text of one mirror frame.
+ *
+ * A page delta is at most FB_WIDTH runs of 4 hex digits.
+ */
+#define MIRROR_FRAME_SIZE (FB_PAGES * (FB_WIDTH * 4 + 48) + 48)
+
+static uint8_t mirror[FB_PAGES][FB_WIDTH];   /**< the framebuffer at the last SHOW */
+static int watchers[MAX_CLIENTS];            /**< sockets of the watching clients */
+static int watchers_count = 0;
+static unsigned long mirror_seq = 0;         /**< sequence of the last frame */
+static unsigned long mirror_frames = 0;      /**< count of streamed frames */
+static unsigned long mirror_bytes = 0;       /**< bytes of the streamed frames per watcher */
+static pthread_mutex_t mirror_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Write the run length encoded delta of a page as a line.
+ *
+ * The delta is the XOR of the new and the mirrored columns, leading and
+ * trailing unchanged columns are not written. A run is two hex digits
+ * count and two hex digits byte.
+ *
+ * @return Length of the line or 0 if the page is unchanged.
+ */
+static size_t encode_page_delta(char *out, unsigned long seq, int page, const uint8_t *new, const uint8_t *old, int x1, int x2) {
+  uint8_t delta[FB_WIDTH];
+  size_t len;
+  int x, run;
+
+  for (x = x1; x <= x2; x++) {
+    delta[x] = new[x] ^ old[x];
+  }
+  while (x1 <= x2 && delta[x1] == 0) {
+    x1++;
+  }
+  while (x2 >= x1 && delta[x2] == 0) {
+    x2--;
+  }
+  if (x1 > x2) {
+    return 0;
+  }
+  len = sprintf(out, "LCD DELTA %lu %d %d ", seq, page, x1);
+  for (x = x1; x <= x2; x += run) {
+    for (run = 1; x + run <= x2 && run < MIRROR_RUN_MAX && delta[x + run] == delta[x]; run++);
+    len += sprintf(out + len, "%02x%02x", run, delta[x]);
+  }
+  out[len++] = '\n';
+  return len;
+}
+
+/**
+ * \brief Stream the changes of the framebuffer to the watching clients.
+ *
+ * Called by the lcd worker after a SHOW. Only the columns changed since
+ * the last frame are compared, so an unchanged screen costs nothing. A
+ * frame is the changed page deltas followed by "LCD SHOW seq".
+ */
+void mirror_show() {
+  static char frame[MIRROR_FRAME_SIZE];
+  Framebuffer *fb = get_framebuffer();
+  int page, x1, x2, i, changed = 0;
+  size_t len = 0;
+
+  pthread_mutex_lock(&mirror_lock);
+  for (page = 0; page < FB_PAGES; page++) {
+    x1 = fb->mirror_x1[page];
+    x2 = fb->mirror_x2[page];
+    if (x1 > x2) {
+      continue;
+    }
+    if (watchers_count > 0) {
+      len += encode_page_delta(frame + len, mirror_seq + 1, page, fb->shown[page], mirror[page], x1, x2);
+    }
+    memcpy(&mirror[page][x1], &fb->shown[page][x1], x2 - x1 + 1);
+    fb->mirror_x1[page] = FB_WIDTH;
+    fb->mirror_x2[page] = -1;
+    changed = 1;
+  }
+  if (changed) {
+    snapshot_lcd_shown((const uint8_t (*)[FB_WIDTH]) mirror);
+  }
+  if (len > 0) {
+    mirror_seq++;
+    len += sprintf(frame + len, "LCD SHOW %lu\n", mirror_seq);
+    for (i = 0; i < watchers_count; i++) {
+      write_client_events(watchers[i], frame, len);
+    }
+    mirror_frames++;
+    mirror_bytes += len;
+  }
+  pthread_mutex_unlock(&mirror_lock);
+}
+
+/**
+ * Write the mirrored frame as key frame. mirror_lock must be held.
+ *
+ * A key frame starts with "LCD KEY seq", the watcher clears its copy and
+ * applies the deltas of the key frame to the empty screen.
+ */
+static void write_key_frame(int client_socket_fd) {
+  static const uint8_t empty[FB_WIDTH];
+  static char frame[MIRROR_FRAME_SIZE];
+  size_t len;
+  int page;
+
+  len = sprintf(frame, "LCD KEY %lu\n", mirror_seq);
+  for (page = 0; page < FB_PAGES; page++) {
+    len += encode_page_delta(frame + len, mirror_seq, page, mirror[page], empty, 0, FB_WIDTH - 1);
+  }
+  len += sprintf(frame + len, "LCD SHOW %lu\n", mirror_seq);
+  write_client_events(client_socket_fd, frame, len);
+}
+
+/**
+ * Remove a watcher. mirror_lock must be held.
+ *
+ * @return 1 if the client was watching.
+ */
+static int remove_watcher(int client_socket_fd) {
+  int i;
+
+  for (i = 0; i < watchers_count; i++) {
+    if (watchers[i] == client_socket_fd) {
+      watchers[i] = watchers[--watchers_count];
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * \brief Stop the stream of a closed client.
+ *
+ * @param client_socket_fd The socket of the client.
+ */
+void cancel_lcd_watch(int client_socket_fd) {
+  pthread_mutex_lock(&mirror_lock);
+  remove_watcher(client_socket_fd);
+  pthread_mutex_unlock(&mirror_lock);
+}
+
+/**
+ * \brief Start or stop the stream of the display to the client.
+ *
+ * LCD WATCH [ON|OFF], a new watcher gets a key frame of the shown screen
+ * at once and then the delta of every SHOW.
+ *
+ * @param client_socket_fd The unix socket file descriptor.
+ * @param buf              The lcd command.
+ */
+void do_lcd_watch(int client_socket_fd, char *buf) {
+  char mode[8] = "ON";
+
+  sscanf(buf, "%*s %7s", mode);
+  if (strcmp(mode, "ON") != 0 && strcmp(mode, "OFF") != 0) {
+    write_error_msg_to_client(client_socket_fd, "expected LCD WATCH [ON|OFF]");
+    return;
+  }
+  pthread_mutex_lock(&mirror_lock);
+  remove_watcher(client_socket_fd);
+  if (strcmp(mode, "ON") == 0) {
+    watchers[watchers_count++] = client_socket_fd;
+    write_key_frame(client_socket_fd);
+  }
+  pthread_mutex_unlock(&mirror_lock);
+}
+
+/**
+ * \brief Write the shown screen as plain pbm.
+ *
+ * Every line of the answer is a line of the pbm file: "P1", "128 64" and a
+ * line of 0 and 1 for every row. The pbm is written with one write, the
+ * static buffer is only used by the info worker.
+ *
+ * @param client_socket_fd The unix socket file descriptor.
+ */
+void do_lcd_dump(int client_socket_fd) {
+  static char pbm[(FB_HEIGHT + 2) * (FB_WIDTH + 8)];
+  size_t len;
+  int x, y;
+
+  len = sprintf(pbm, "%s - P1\n%s - %d %d\n", SERVER_OK, SERVER_OK, FB_WIDTH, FB_HEIGHT);
+  pthread_mutex_lock(&mirror_lock);
+  for (y = 0; y < FB_HEIGHT; y++) {
+    len += sprintf(pbm + len, "%s - ", SERVER_OK);
+    for (x = 0; x < FB_WIDTH; x++) {
+      pbm[len++] = (mirror[y / 8][x] >> (y % 8)) & 1 ? '1' : '0';
+    }
+    pbm[len++] = '\n';
+  }
+  pthread_mutex_unlock(&mirror_lock);
+
+  write_to_client(client_socket_fd, pbm, len);
+}
+
+/**
+ * \brief Write the mirror statistics.
+ *
+ * @param client_socket_fd The unix socket file descriptor.
+ */
+void do_write_mirror_stats(int client_socket_fd) {
+  char msg[BUFFER_SIZE];
+  unsigned long frames, bytes;
+  int count;
+
+  pthread_mutex_lock(&mirror_lock);
+  count  = watchers_count;
+  frames = mirror_frames;
+  bytes  = mirror_bytes;
+  pthread_mutex_unlock(&mirror_lock);
+
+  snprintf(msg, BUFFER_SIZE, "lcd mirror: %d watchers, %lu frames, %lu bytes per watcher", count, frames, bytes);
+  write_msg_to_client(client_socket_fd, msg);
+}
@@ -0,0 +1,24 @@
+/*
+ * mirror.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef MIRROR_H_
+#define MIRROR_H_
+
+#define LCD_WATCH "WATCH"
+#define LCD_DUMP  "DUMP"
+
+/**
+ * \brief Longest run of a byte in a delta, a run is written as count and byte.
+ */
+#define MIRROR_RUN_MAX 255
+
+void mirror_show();
+void cancel_lcd_watch(int client_socket_fd);
+void do_lcd_watch(int client_socket_fd, char *buf);
+void do_lcd_dump(int client_socket_fd);
+void do_write_mirror_stats(int client_socket_fd);
+
+#endif /* MIRROR_H_ */
@@ -0,0 +1,296 @@
+/*
+ * pwm.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <math.h>
+#include "gpiod.h"
+#include "pwm.h"
+
+/**
+ * \brief A running fade of a pwm pin or the lcd backlight.
+ *
+ * Every target has one fade, a new fade or level replaces it.
+ */
+typedef struct Fade {
+  Timer timer;
+  int target;                     //> Pin or PWM_TARGET_LCD.
+  int from;
+  int to;
+  FadeCurve curve;
+  unsigned long long start_ns;    //> Monotonic start of the fade.
+  unsigned long long duration_ns;
+  int active;                     //> 1 while the fade runs.
+} Fade;
+
+static Fade fades[NUM_PINS + 1];
+static int pwm_levels[NUM_PINS + 1]; /**< last written level of every target */
+static unsigned long fade_steps = 0; /**< count of written fade steps */
+static unsigned long fades_done = 0; /**< count of finished fades */
+static pthread_mutex_t pwm_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static inline int pwm_range(int target) {
+  return target == PWM_TARGET_LCD ? PWM_LCD_RANGE : PWM_RANGE;
+}
+
+/**
+ * Write the level of a target. pwm_lock must be held.
+ */
+static void pwm_output(int target, int level) {
+  if (target == PWM_TARGET_LCD) {
+    backlight(level);
+  } else {
+    gpio_pwm_write(target, level);
+  }
+  pwm_levels[target] = level;
+  snapshot_set_pwm(target, level);
+}
+
+/**
+ * Check if the target can be written.
+ */
+static int pwm_supported(int target) {
+  return target == PWM_TARGET_LCD || gpio_backend->pwm_write != NULL;
+}
+
+/**
+ * Stop the fade of a target. pwm_lock must be held.
+ */
+static void pwm_stop_fade(Fade *fade) {
+  if (fade->active) {
+    fade->active = 0;
+    timer_cancel(&fade->timer);
+  }
+}
+
+/**
+ * Get the level of a fade at a time.
+ *
+ * A gamma fade interpolates the perceived brightness, the level is the
+ * brightness raised to PWM_GAMMA.
+ */
+static int fade_level(Fade *fade, unsigned long long now_ns) {
+  double range = pwm_range(fade->target);
+  double f, from, to;
+
+  if (now_ns >= fade->start_ns + fade->duration_ns) {
+    return fade->to;
+  }
+  f = (double) (now_ns - fade->start_ns) / fade->duration_ns;
+  if (fade->curve == FADE_LINEAR) {
+    return fade->from + (int) lround((fade->to - fade->from) * f);
+  }
+  from = pow(fade->from / range, 1.0 / PWM_GAMMA);
+  to   = pow(fade->to / range, 1.0 / PWM_GAMMA);
+  return (int) lround(range * pow(from + (to - from) * f, PWM_GAMMA));
+}
+
+/**
+ * \brief Timer callback of a fade step.
+ *
+ * The level is computed from the time, so a late step doesn't stretch the
+ * fade. Unchanged levels are not written.
+ *
+ * @param arg The fade.
+ */
+void fade_step(void *arg) {
+  Fade *fade = (Fade *) arg;
+  unsigned long long now = get_monotonic_ns();
+  unsigned long long end, next;
+  int level;
+
+  pthread_mutex_lock(&pwm_lock);
+  if (!fade->active) {
+    // The fade was replaced after the timer expired.
+    pthread_mutex_unlock(&pwm_lock);
+    return;
+  }
+  level = fade_level(fade, now);
+  if (level != pwm_levels[fade->target]) {
+    pwm_output(fade->target, level);
+    fade_steps++;
+  }
+  end = fade->start_ns + fade->duration_ns;
+  if (now >= end) {
+    fade->active = 0;
+    fades_done++;
+  } else {
+    next = fade->start_ns + ((now - fade->start_ns) / (PWM_FADE_STEP_MS * 1000000ULL) + 1) * PWM_FADE_STEP_MS * 1000000ULL;
+    timer_add(&fade->timer, next < end ? next : end);
+  }
+  pthread_mutex_unlock(&pwm_lock);
+}
+
+/**
+ * \brief Set the level of a target and stop its fade.
+ *
+ * @param target The pin or PWM_TARGET_LCD.
+ * @param level  0 to PWM_RANGE, 0 to PWM_LCD_RANGE for the lcd.
+ *
+ * @return 0 or -1 if the backend has no pwm.
+ */
+int pwm_set_level(int target, int level) {
+  if (!pwm_supported(target)) {
+    return -1;
+  }
+  pthread_mutex_lock(&pwm_lock);
+  pwm_stop_fade(&fades[target]);
+  pwm_output(target, level);
+  pthread_mutex_unlock(&pwm_lock);
+
+  return 0;
+}
+
+/**
+ * \brief Start a fade of a target.
+ *
+ * The levels are checked by the caller. A running fade of the target is
+ * replaced.
+ *
+ * @param target      The pin or PWM_TARGET_LCD.
+ * @param from        Level at the start.
+ * @param to          Level at the end.
+ * @param duration_ms Duration of the fade, 0 sets the end level at once.
+ * @param curve       Curve of the fade.
+ *
+ * @return 0 or -1 if the backend has no pwm.
+ */
+int pwm_start_fade(int target, int from, int to, unsigned long duration_ms, FadeCurve curve) {
+  Fade *fade = &fades[target];
+
+  if (!pwm_supported(target)) {
+    return -1;
+  }
+  pthread_mutex_lock(&pwm_lock);
+  pwm_stop_fade(fade);
+  if (fade->timer.callback == NULL) {
+    timer_init(&fade->timer, fade_step, fade);
+  }
+  fade->target      = target;
+  fade->from        = from;
+  fade->to          = to;
+  fade->curve       = curve;
+  fade->start_ns    = get_monotonic_ns();
+  fade->duration_ns = duration_ms * 1000000ULL;
+  if (duration_ms == 0 || from == to) {
+    pwm_output(target, to);
+    fades_done++;
+  } else {
+    pwm_output(target, from);
+    fade->active = 1;
+    timer_add(&fade->timer, fade->start_ns + PWM_FADE_STEP_MS * 1000000ULL);
+  }
+  pthread_mutex_unlock(&pwm_lock);
+
+  return 0;
+}
+
+/**
+ * \brief Parse the curve of a fade.
+ *
+ * @param name  "linear", "gamma" or NULL for linear.
+ * @param curve The parsed curve.
+ *
+ * @return 0 or -1 if the curve is unknown.
+ */
+int parse_fade_curve(const char *name, FadeCurve *curve) {
+  if (name == NULL || strcasecmp(name, "linear") == 0) {
+    *curve = FADE_LINEAR;
+  } else if (strcasecmp(name, "gamma") == 0) {
+    *curve = FADE_GAMMA;
+  } else {
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * \brief Set or read the duty of a pwm pin.
+ *
+ * PWM pin duty sets the duty and stops a fade, PWM pin reads the current
+ * duty, also while the pin fades.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ * @param buf              The command arguments.
+ */
+void do_pwm(int client_socket_fd, char *buf) {
+  int pin_num, duty;
+  char args[BUFFER_SIZE], msg[BUFFER_SIZE];
+  int n = sscanf(expand_pin_alias(buf, args, BUFFER_SIZE), "%d %d", &pin_num, &duty);
+
+  if (n < 1) {
+    write_error_msg_to_client(client_socket_fd, "expected PWM <#pin> [duty]");
+  } else if (!is_valid_pin_num(pin_num)) {
+    write_error_msg_to_client(client_socket_fd, "unknown port number");
+  } else if (n == 1) {
+    pthread_mutex_lock(&pwm_lock);
+    duty = pwm_levels[pin_num];
+    pthread_mutex_unlock(&pwm_lock);
+    snprintf(msg, BUFFER_SIZE, "%d", duty);
+    write_msg_to_client(client_socket_fd, msg);
+  } else if (duty < 0 || duty > PWM_RANGE) {
+    write_error_msg_to_client(client_socket_fd, "duty must be between 0 and 1024");
+  } else if (pwm_set_level(pin_num, duty) == -1) {
+    write_error_msg_to_client(client_socket_fd, "pwm not supported by the backend");
+  } else {
+    log_msg(LOG_MOD_GPIO, LOG_DEBUG, "EXECUTING %s PIN %d DUTY = %d", CLIENT_PWM, pin_num, duty);
+    write_msg_to_client(client_socket_fd, "operation performed");
+  }
+}
+
+/**
+ * \brief Fade the duty of a pwm pin.
+ *
+ * FADE pin from to duration_ms [linear|gamma], the steps are written by
+ * the timer thread and the command returns at once.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ * @param buf              The command arguments.
+ */
+void do_fade(int client_socket_fd, char *buf) {
+  int pin_num, from, to;
+  unsigned long duration_ms;
+  FadeCurve curve;
+  char args[BUFFER_SIZE], curve_name[16];
+  int n = sscanf(expand_pin_alias(buf, args, BUFFER_SIZE), "%d %d %d %lu %15s", &pin_num, &from, &to, &duration_ms, curve_name);
+
+  if (n < 4) {
+    write_error_msg_to_client(client_socket_fd, "expected FADE <#pin> <from> <to> <duration_ms> [linear|gamma]");
+  } else if (!is_valid_pin_num(pin_num)) {
+    write_error_msg_to_client(client_socket_fd, "unknown port number");
+  } else if (from < 0 || from > PWM_RANGE || to < 0 || to > PWM_RANGE) {
+    write_error_msg_to_client(client_socket_fd, "duty must be between 0 and 1024");
+  } else if (duration_ms > PWM_FADE_MAX_MS) {
+    write_error_msg_to_client(client_socket_fd, "time too long");
+  } else if (parse_fade_curve(n == 5 ? curve_name : NULL, &curve) == -1) {
+    write_error_msg_to_client(client_socket_fd, "curve must be linear or gamma");
+  } else if (pwm_start_fade(pin_num, from, to, duration_ms, curve) == -1) {
+    write_error_msg_to_client(client_socket_fd, "pwm not supported by the backend");
+  } else {
+    log_msg(LOG_MOD_GPIO, LOG_DEBUG, "EXECUTING %s PIN %d FROM %d TO %d IN %lu ms", CLIENT_FADE, pin_num, from, to, duration_ms);
+    write_msg_to_client(client_socket_fd, "operation performed");
+  }
+}
+
+/**
+ * \brief Write the fade statistics.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ */
+void do_write_pwm_stats(int client_socket_fd) {
+  char msg[BUFFER_SIZE];
+  int t, active = 0;
+  unsigned long steps, done;
+
+  pthread_mutex_lock(&pwm_lock);
+  for (t = 0; t <= PWM_TARGET_LCD; t++) {
+    active += fades[t].active;
+  }
+  steps = fade_steps;
+  done  = fades_done;
+  pthread_mutex_unlock(&pwm_lock);
+
+  snprintf(msg, BUFFER_SIZE, "pwm: %d fading, %lu fades done, %lu steps", active, done, steps);
+  write_msg_to_client(client_socket_fd, msg);
+}
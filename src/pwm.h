@@ -0,0 +1,60 @@
+/*
+ * pwm.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef PWM_H_
+#define PWM_H_
+
+/**
+ * \brief Full duty of a pwm pin, like the wiringPi hardware pwm range.
+ */
+#define PWM_RANGE 1024
+
+/**
+ * \brief Full level of the lcd backlight in percent.
+ */
+#define PWM_LCD_RANGE 100
+
+/**
+ * \brief Fade target of the lcd backlight, pins are targets 0 to NUM_PINS - 1.
+ */
+#define PWM_TARGET_LCD NUM_PINS
+
+/**
+ * \brief Interval of the fade steps in milliseconds.
+ */
+#define PWM_FADE_STEP_MS 10
+
+/**
+ * \brief Longest fade in milliseconds.
+ */
+#define PWM_FADE_MAX_MS 3600000UL
+
+/**
+ * \brief Exponent of the gamma curve.
+ *
+ * A gamma fade changes the perceived brightness of a led linearly.
+ */
+#define PWM_GAMMA 2.2
+
+#define CLIENT_PWM  "PWM"
+#define CLIENT_FADE "FADE"
+
+/**
+ * \brief Curve of a fade.
+ */
+typedef enum FadeCurve {
+  FADE_LINEAR = 0,
+  FADE_GAMMA
+} FadeCurve;
+
+int pwm_set_level(int target, int level);
+int pwm_start_fade(int target, int from, int to, unsigned long duration_ms, FadeCurve curve);
+int parse_fade_curve(const char *name, FadeCurve *curve);
+void do_pwm(int client_socket_fd, char *buf);
+void do_fade(int client_socket_fd, char *buf);
+void do_write_pwm_stats(int client_socket_fd);
+
+#endif /* PWM_H_ */
@@ -0,0 +1,112 @@
+/*
+ * record.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "gpiod.h"
+#include "record.h"
+
+static char *record_file_name = NULL; /**< trace file or NULL if not recording */
+static FILE *record_file      = NULL;
+static unsigned long long record_start_ns = 0;
+static pthread_mutex_t record_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * \brief Set the trace file.
+ *
+ * @param file_name The file name or NULL to not record.
+ */
+void set_record_file(char *file_name) {
+  record_file_name = file_name;
+}
+
+/**
+ * \brief Open the trace file and write the header.
+ *
+ * @return 0 or -1 on error.
+ */
+int init_record() {
+  RecordHeader header;
+
+  if (record_file_name == NULL) {
+    return 0;
+  }
+  if ((record_file = fopen(record_file_name, "w")) == NULL) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "%s: %m", record_file_name);
+    return -1;
+  }
+  setvbuf(record_file, NULL, _IOFBF, RECORD_BUFFER_SIZE);
+  record_start_ns  = get_monotonic_ns();
+  header.magic     = RECORD_MAGIC;
+  header.version   = RECORD_VERSION;
+  header.start_ns  = record_start_ns;
+  fwrite(&header, sizeof(header), 1, record_file);
+
+  return 0;
+}
+
+/**
+ * \brief Flush and close the trace file.
+ */
+void cleanup_record() {
+  pthread_mutex_lock(&record_lock);
+  if (record_file != NULL) {
+    fclose(record_file);
+    record_file = NULL;
+  }
+  pthread_mutex_unlock(&record_lock);
+}
+
+/**
+ * Append a record to the trace.
+ *
+ * The records are buffered, a trace is complete after cleanup_record.
+ */
+static void record_write(unsigned long long time_ns, RecordType type, int client, const void *data, size_t len) {
+  RecordEntry entry;
+
+  if (record_file == NULL) {
+    return;
+  }
+  entry.time_ns = time_ns > record_start_ns ? time_ns - record_start_ns : 0;
+  entry.type    = type;
+  entry.client  = client;
+  entry.len     = len;
+
+  pthread_mutex_lock(&record_lock);
+  if (record_file != NULL) {
+    fwrite(&entry, sizeof(entry), 1, record_file);
+    fwrite(data, 1, len, record_file);
+  }
+  pthread_mutex_unlock(&record_lock);
+}
+
+void record_connect(int fd) {
+  record_write(get_monotonic_ns(), RECORD_CONNECT, fd, NULL, 0);
+}
+
+void record_close(int fd) {
+  record_write(get_monotonic_ns(), RECORD_CLOSE, fd, NULL, 0);
+}
+
+void record_command(int fd, const char *command) {
+  record_write(get_monotonic_ns(), RECORD_COMMAND, fd, command, strlen(command));
+}
+
+/**
+ * \brief Record an edge.
+ *
+ * @param pin          The pin.
+ * @param level        The level after the edge.
+ * @param timestamp_ns Monotonic time of the edge.
+ */
+void record_edge(int pin, int level, unsigned long long timestamp_ns) {
+  uint8_t data[2] = { pin, level };
+
+  record_write(timestamp_ns, RECORD_EDGE, 0, data, sizeof(data));
+}
+
+void record_event(const char *name) {
+  record_write(get_monotonic_ns(), RECORD_EVENT, 0, name, strlen(name));
+}
@@ -0,0 +1,55 @@
+/*
+ * record.h
+ *
+ *  Created on: 19.10.2026
+ *
+ * Binary trace of the client commands and the interrupt timing.
+ *
+ * The trace starts with a RecordHeader, every record is a RecordEntry
+ * followed by len bytes of data. All numbers are in host byte order.
+ */
+
+#ifndef RECORD_H_
+#define RECORD_H_
+
+#include <stdint.h>
+
+#define RECORD_MAGIC   0x72647067
+#define RECORD_VERSION 2
+
+/**
+ * \brief Size of the write buffer of the trace file.
+ */
+#define RECORD_BUFFER_SIZE 65536
+
+typedef enum RecordType {
+  RECORD_CONNECT = 1, //> A client connected, no data.
+  RECORD_CLOSE,       //> A client closed the connection, no data.
+  RECORD_COMMAND,     //> A command line of a client without newline.
+  RECORD_EDGE,        //> An edge, data is the pin and the level.
+  RECORD_EVENT        //> An interrupt event, data is the event name.
+} RecordType;
+
+typedef struct RecordHeader {
+  uint32_t magic;     //> RECORD_MAGIC
+  uint32_t version;   //> RECORD_VERSION
+  uint64_t start_ns;  //> Monotonic time of the start of the trace.
+} RecordHeader;
+
+typedef struct __attribute__((packed)) RecordEntry {
+  uint64_t time_ns;   //> Nanoseconds since the start of the trace.
+  uint8_t type;       //> RecordType
+  uint32_t client;    //> Client id, the socket of the client.
+  uint16_t len;       //> Length of the data.
+} RecordEntry;
+
+void set_record_file(char *file_name);
+int init_record();
+void cleanup_record();
+void record_connect(int fd);
+void record_close(int fd);
+void record_command(int fd, const char *command);
+void record_edge(int pin, int level, unsigned long long timestamp_ns);
+void record_event(const char *name);
+
+#endif /* RECORD_H_ */
@@ -0,0 +1,234 @@
+/*
+ * rules.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "gpiod.h"
+#include "rules.h"
+
+static char *rule_action_names[] = { "set", "pulse", "mirror", "toggle" };
+
+/**
+ * \brief The compiled rule table.
+ *
+ * The rules are sorted by source pin, the rules of pin n are
+ * rule_table[rule_first[n]] up to rule_table[rule_first[n + 1] - 1].
+ * The table is static, so a pulse timer never points to freed memory.
+ */
+static Rule rule_table[MAX_RULES];
+static int rule_first[NUM_PINS + 1];
+static int rule_count = 0;
+static pthread_mutex_t rules_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * \brief Get the action of a rule name.
+ *
+ * @param action The action name of the config file.
+ *
+ * @return The action or -1 if unknown.
+ */
+int parse_rule_action(const char *action) {
+  int i;
+
+  for (i = 0; i <= RULE_TOGGLE; i++) {
+    if (strcmp(action, rule_action_names[i]) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Write the target of a rule. rules_lock must be held.
+ */
+static inline void rule_write(Rule *rule, int level) {
+  gpio_digital_write(rule->target, level);
+  state_set_level(rule->target, level);
+  rule->level = level;
+}
+
+/**
+ * \brief Timer callback at the end of a pulse.
+ *
+ * @param arg The rule.
+ */
+void rule_pulse_end(void *arg) {
+  Rule *rule = (Rule *) arg;
+
+  pthread_mutex_lock(&rules_lock);
+  // A retriggered pulse was extended, a reloaded rule has no pulse.
+  if (rule->pulse_end_ns != 0 && rule->pulse_end_ns / TIMER_TICK_NS <= get_monotonic_ns() / TIMER_TICK_NS) {
+    rule_write(rule, !rule->value);
+    rule->pulse_end_ns = 0;
+  }
+  pthread_mutex_unlock(&rules_lock);
+}
+
+/**
+ * Sort the rules by source pin into the table. rules_lock must be held.
+ *
+ * @param rules The rules.
+ * @param count Count of rules.
+ */
+static void compile_rules(Rule *rules, int count) {
+  int pin, r, n = 0;
+
+  for (pin = 0; pin < NUM_PINS; pin++) {
+    rule_first[pin] = n;
+    for (r = 0; r < count; r++) {
+      if (rules[r].pin == pin) {
+        rule_table[n] = rules[r];
+        rule_table[n].level        = 0;
+        rule_table[n].pulse_end_ns = 0;
+        rule_table[n].fired        = 0;
+        timer_init(&rule_table[n].timer, rule_pulse_end, &rule_table[n]);
+        n++;
+      }
+    }
+  }
+  rule_first[NUM_PINS] = n;
+  rule_count = n;
+}
+
+/**
+ * \brief Set the rules of the config file on startup.
+ *
+ * @param rules The rules, pins are already checked.
+ * @param count Count of rules.
+ */
+void set_rules(Rule *rules, int count) {
+  pthread_mutex_lock(&rules_lock);
+  compile_rules(rules, count);
+  pthread_mutex_unlock(&rules_lock);
+}
+
+/**
+ * \brief Set the targets of the rules as output.
+ *
+ * Pulse targets start inactive, mirror targets start with the source level.
+ */
+void apply_rules() {
+  Rule *rule;
+  int r;
+
+  pthread_mutex_lock(&rules_lock);
+  for (r = 0; r < rule_count; r++) {
+    rule = &rule_table[r];
+    gpio_pin_mode(rule->target, OUTPUT);
+    state_set_mode(rule->target, 1);
+    switch (rule->action) {
+      case RULE_PULSE:
+        rule_write(rule, !rule->value);
+        break;
+      case RULE_MIRROR:
+        rule_write(rule, gpio_digital_read(rule->pin) == rule->value);
+        break;
+      default:
+        rule->level = gpio_digital_read(rule->target);
+        break;
+    }
+  }
+  pthread_mutex_unlock(&rules_lock);
+}
+
+/**
+ * \brief Apply reloaded rules.
+ *
+ * Running pulses are finished at once, then the new rules are compiled.
+ *
+ * @param rules       The new rules.
+ * @param count       Count of rules.
+ * @param report      Buffer for the human readable result.
+ * @param report_len  Size of the report buffer.
+ *
+ * @return 0
+ */
+int reload_rules(Rule *rules, int count, char *report, size_t report_len) {
+  Rule *rule;
+  int r;
+
+  pthread_mutex_lock(&rules_lock);
+  for (r = 0; r < rule_count; r++) {
+    rule = &rule_table[r];
+    timer_cancel(&rule->timer);
+    if (rule->pulse_end_ns != 0) {
+      rule_write(rule, !rule->value);
+    }
+  }
+  compile_rules(rules, count);
+  pthread_mutex_unlock(&rules_lock);
+  apply_rules();
+
+  snprintf(report, report_len, "rules reloaded: %d rules", count);
+
+  return 0;
+}
+
+/**
+ * \brief Run the rules of a pin.
+ *
+ * Called for every edge of the pin in the edge callback, before the event
+ * is queued for the clients.
+ *
+ * @param pin          The source pin.
+ * @param level        The level after the edge.
+ * @param timestamp_ns Monotonic time of the edge.
+ */
+void run_rules(int pin, int level, unsigned long long timestamp_ns) {
+  Rule *rule;
+  int r;
+
+  if (pin < 0 || pin >= NUM_PINS) {
+    return;
+  }
+  pthread_mutex_lock(&rules_lock);
+  for (r = rule_first[pin]; r < rule_first[pin + 1]; r++) {
+    rule = &rule_table[r];
+    if ((rule->edge == INT_EDGE_RISING && !level) || (rule->edge == INT_EDGE_FALLING && level)) {
+      continue;
+    }
+    rule->fired++;
+    switch (rule->action) {
+      case RULE_SET:
+        rule_write(rule, rule->value);
+        break;
+      case RULE_PULSE:
+        // A retrigger extends the running pulse.
+        if (rule->pulse_end_ns == 0) {
+          rule_write(rule, rule->value);
+        }
+        rule->pulse_end_ns = timestamp_ns + (unsigned long long) rule->duration * 1000000ULL;
+        timer_add(&rule->timer, rule->pulse_end_ns);
+        break;
+      case RULE_MIRROR:
+        rule_write(rule, level == rule->value);
+        break;
+      case RULE_TOGGLE:
+        rule_write(rule, !rule->level);
+        break;
+    }
+  }
+  pthread_mutex_unlock(&rules_lock);
+}
+
+/**
+ * \brief Write the rule statistics.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ */
+void do_write_rules_stats(int client_socket_fd) {
+  char msg[BUFFER_SIZE];
+  unsigned long fired = 0;
+  int r, count;
+
+  pthread_mutex_lock(&rules_lock);
+  count = rule_count;
+  for (r = 0; r < rule_count; r++) {
+    fired += rule_table[r].fired;
+  }
+  pthread_mutex_unlock(&rules_lock);
+
+  snprintf(msg, BUFFER_SIZE, "rules: %d, fired %lu", count, fired);
+  write_msg_to_client(client_socket_fd, msg);
+}
@@ -0,0 +1,48 @@
+/*
+ * rules.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef RULES_H_
+#define RULES_H_
+
+#include <stddef.h>
+#include "timer.h"
+
+/**
+ * \brief Maximal count of rules.
+ */
+#define MAX_RULES 32
+
+typedef enum RuleAction {
+  RULE_SET = 0, //> Write value to the target.
+  RULE_PULSE,   //> Write value to the target and the inverted value after duration.
+  RULE_MIRROR,  //> Write the source level to the target, inverted if value is 0.
+  RULE_TOGGLE   //> Invert the target.
+} RuleAction;
+
+/**
+ * \brief A reflex rule, executed in the edge callback without a client.
+ */
+typedef struct Rule {
+  int pin;          //> Source pin.
+  int edge;         //> INT_EDGE_FALLING, INT_EDGE_RISING or INT_EDGE_BOTH.
+  RuleAction action;
+  int target;       //> Target pin, set as output.
+  int value;        //> Value of set and pulse, 0 inverts a mirror.
+  int duration;     //> Pulse duration in milliseconds.
+  int level;        //> Last written target level.
+  unsigned long long pulse_end_ns; //> End of the running pulse or 0.
+  unsigned long fired; //> Count of executions.
+  Timer timer;      //> Pulse end timer.
+} Rule;
+
+int parse_rule_action(const char *action);
+void set_rules(Rule *rules, int count);
+void apply_rules();
+int reload_rules(Rule *rules, int count, char *report, size_t report_len);
+void run_rules(int pin, int level, unsigned long long timestamp_ns);
+void do_write_rules_stats(int client_socket_fd);
+
+#endif /* RULES_H_ */
@@ -0,0 +1,590 @@
+/*
+ * scheduler.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "gpiod.h"
+#include "scheduler.h"
+
+/**
+ * \brief A queued command or event.
+ */
+typedef struct Job {
+  int client_socket_fd;          //> Socket to answer or CLIENT_BROADCAST for events.
+  CommandClass class;            //> Class of the command.
+  char *command;                 //> The command line or the event name.
+  char tag[REPLY_TAG_SIZE];      //> Tag of the command, empty if not tagged.
+  LcdCall call;                  //> Internal lcd job or NULL.
+  unsigned long long queued_ns;  //> Monotonic time the job was queued.
+  struct Job *next;
+} Job;
+
+typedef struct JobQueue {
+  Job *head;
+  Job *tail;
+  int length;                    //> Count of queued jobs.
+  unsigned long executed;        //> Count of executed jobs.
+  unsigned long long max_wait_ns; //> Longest time a job waited in the queue.
+} JobQueue;
+
+/**
+ * \brief Commands of a client in flight, to keep the order of the client.
+ *
+ * A command waits in held while earlier commands of the client run in
+ * another class. Commands of one class keep their order in the class queue.
+ */
+typedef struct ClientOrder {
+  int fd;                        //> Socket of the client or -1 if the entry is free.
+  CommandClass class;            //> Class of the commands in flight.
+  int running;                   //> Count of commands of the client queued or running.
+  Job *held;                     //> Commands waiting for the commands in flight.
+  Job *held_tail;
+} ClientOrder;
+
+static char *class_names[CLASS_COUNT] = { "gpio", "event", "lcd", "info", "serial" };
+static ClientOrder client_orders[MAX_CLIENTS];
+static unsigned long held_commands = 0; /**< count of commands held behind another class */
+
+JobQueue job_queues[CLASS_COUNT];
+pthread_mutex_t scheduler_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t dispatch_cond   = PTHREAD_COND_INITIALIZER; /**< signal new event or info job */
+pthread_cond_t lcd_cond        = PTHREAD_COND_INITIALIZER; /**< signal new lcd job */
+pthread_cond_t serial_cond     = PTHREAD_COND_INITIALIZER; /**< signal new serial job */
+
+/**
+ * \brief Get the priority class of a command.
+ *
+ * @param command The command line.
+ *
+ * @return The command class.
+ */
+CommandClass classify_command(char *command) {
+  char *lcd_command;
+
+  if (strncmp(command, CLIENT_READALL, strlen(CLIENT_READALL)) == 0
+      || strncmp(command, CLIENT_TRACE, strlen(CLIENT_TRACE)) == 0) {
+    return CLASS_INFO;
+  } else if (strncmp(command, CLIENT_LCD, strlen(CLIENT_LCD)) == 0) {
+    lcd_command = command + strlen(CLIENT_LCD);
+    while (*lcd_command == ' ') {
+      lcd_command++;
+    }
+    if (strncmp(lcd_command, LCD_INFO, strlen(LCD_INFO)) == 0
+        || strncmp(lcd_command, LCD_FONT_INFO, strlen(LCD_FONT_INFO)) == 0
+        || strncmp(lcd_command, LCD_DUMP, strlen(LCD_DUMP)) == 0) {
+      return CLASS_INFO;
+    }
+    return CLASS_LCD;
+  } else if (strncmp(command, CLIENT_STATS, strlen(CLIENT_STATS)) == 0
+      || strncmp(command, CLIENT_INFO, strlen(CLIENT_INFO)) == 0) {
+    return CLASS_INFO;
+  } else if (strncmp(command, CLIENT_SHIFTOUT, strlen(CLIENT_SHIFTOUT)) == 0
+      || strncmp(command, CLIENT_SHIFTIN, strlen(CLIENT_SHIFTIN)) == 0
+      || strncmp(command, CLIENT_SERIALOUT, strlen(CLIENT_SERIALOUT)) == 0
+      || strncmp(command, CLIENT_SERIALIN, strlen(CLIENT_SERIALIN)) == 0) {
+    return CLASS_SERIAL;
+  }
+  return CLASS_GPIO;
+}
+
+/**
+ * Append a job to the class queue. scheduler_lock must be held.
+ *
+ * @param class The class queue.
+ * @param job   The job.
+ */
+void enqueue_job(CommandClass class, Job *job) {
+  JobQueue *queue = &job_queues[class];
+
+  job->next = NULL;
+  if (queue->tail != NULL) {
+    queue->tail->next = job;
+  } else {
+    queue->head = job;
+  }
+  queue->tail = job;
+  queue->length++;
+}
+
+/**
+ * Take the first job of the class queue. scheduler_lock must be held.
+ *
+ * @param class The class queue.
+ *
+ * @return The job or NULL.
+ */
+Job *dequeue_job(CommandClass class) {
+  JobQueue *queue = &job_queues[class];
+  Job *job = queue->head;
+  unsigned long long wait;
+
+  if (job == NULL) {
+    return NULL;
+  }
+  queue->head = job->next;
+  if (queue->head == NULL) {
+    queue->tail = NULL;
+  }
+  queue->length--;
+  queue->executed++;
+  wait = get_monotonic_ns() - job->queued_ns;
+  if (wait > queue->max_wait_ns) {
+    queue->max_wait_ns = wait;
+  }
+  return job;
+}
+
+/**
+ * Execute the job and release it.
+ *
+ * @param class The class of the job.
+ * @param job   The job.
+ */
+static void run_job(CommandClass class, Job *job) {
+  unsigned long long trace_ns = trace_begin();
+
+  // The wait in the queue is traced from the time the job was queued.
+  trace_end(class == CLASS_EVENT ? TRACE_EVENT_DEQUEUE : TRACE_DISPATCH, trace_ns ? job->queued_ns : 0, class);
+  if (job->call != NULL) {
+    job->call();
+  } else if (class == CLASS_EVENT) {
+    queue_client_events(job->command, job->queued_ns);
+    state_count_event();
+    trace_end(TRACE_EVENT_DELIVERY, trace_ns, 0);
+  } else {
+    begin_reply(job->client_socket_fd, job->tag, class == CLASS_INFO);
+    read_command(job->command, job->client_socket_fd);
+    end_reply(job->client_socket_fd, class == CLASS_INFO);
+    release_client(job->client_socket_fd);
+    trace_end(TRACE_COMMAND, trace_ns, job->client_socket_fd);
+  }
+  free(job->command);
+  free(job);
+}
+
+/**
+ * Find the order entry of a client with commands in flight. scheduler_lock
+ * must be held.
+ *
+ * @param fd     The socket of the client.
+ * @param create 1 to take a free entry if the client has none.
+ *
+ * @return The entry or NULL.
+ */
+static ClientOrder *find_client_order(int fd, int create) {
+  ClientOrder *free_order = NULL;
+  int i;
+
+  for (i = 0; i < MAX_CLIENTS; i++) {
+    if (client_orders[i].fd == fd) {
+      return &client_orders[i];
+    }
+    if (client_orders[i].fd == -1 && free_order == NULL) {
+      free_order = &client_orders[i];
+    }
+  }
+  if (create && free_order != NULL) {
+    free_order->fd        = fd;
+    free_order->running   = 0;
+    free_order->held      = NULL;
+    free_order->held_tail = NULL;
+  }
+  return create ? free_order : NULL;
+}
+
+/**
+ * Signal the worker of a class. scheduler_lock must be held.
+ */
+static void signal_worker(CommandClass class) {
+  if (class == CLASS_LCD) {
+    pthread_cond_signal(&lcd_cond);
+  } else if (class == CLASS_SERIAL) {
+    pthread_cond_signal(&serial_cond);
+  } else {
+    pthread_cond_signal(&dispatch_cond);
+  }
+}
+
+/**
+ * Start the held commands of a client that can run now. scheduler_lock must
+ * be held, it is released while a held GPIO command is executed.
+ *
+ * A held command of a queued class joins its queue if no command of the
+ * client runs in another class. A held GPIO command is executed here after
+ * all commands in flight, the held commands behind it wait for it.
+ *
+ * @param order The entry of the client.
+ */
+static void start_held_commands(ClientOrder *order) {
+  Job *job;
+
+  while ((job = order->held) != NULL) {
+    if (order->running > 0 && (job->class == CLASS_GPIO || job->class != order->class)) {
+      break;
+    }
+    order->held = job->next;
+    if (order->held == NULL) {
+      order->held_tail = NULL;
+    }
+    order->class = job->class;
+    order->running++;
+    if (job->class == CLASS_GPIO) {
+      job_queues[CLASS_GPIO].executed++;
+      pthread_mutex_unlock(&scheduler_lock);
+      run_job(CLASS_GPIO, job);
+      pthread_mutex_lock(&scheduler_lock);
+      order->running--;
+    } else {
+      enqueue_job(job->class, job);
+      signal_worker(job->class);
+    }
+  }
+  if (order->running == 0 && order->held == NULL) {
+    order->fd = -1;
+  }
+}
+
+/**
+ * Execute the job and release it, then start the commands of the client
+ * held behind it.
+ *
+ * @param class The class of the job.
+ * @param job   The job.
+ */
+void execute_job(CommandClass class, Job *job) {
+  int fd = job->client_socket_fd, command = job->call == NULL && class != CLASS_EVENT;
+  ClientOrder *order;
+
+  run_job(class, job);
+  if (!command) {
+    return;
+  }
+  pthread_mutex_lock(&scheduler_lock);
+  if ((order = find_client_order(fd, 0)) != NULL) {
+    order->running--;
+    start_held_commands(order);
+  }
+  pthread_mutex_unlock(&scheduler_lock);
+}
+
+/**
+ * \brief Worker for events and info commands.
+ *
+ * All queued events are added to the batches of the clients at once, then
+ * the due batches are written with one write per client. The worker wakes
+ * up for the next due batch. Events are always added before the next info
+ * command is executed.
+ *
+ * @param arg unused
+ */
+void *dispatch_worker(void *arg) {
+  Job *job, *events, **tail;
+  struct timespec ts;
+  unsigned long long flush_ns = 0;
+  int n;
+
+  trace_name_thread("dispatch");
+  while (1) {
+    pthread_mutex_lock(&scheduler_lock);
+    while (job_queues[CLASS_EVENT].head == NULL && job_queues[CLASS_INFO].head == NULL) {
+      if (flush_ns == 0) {
+        pthread_cond_wait(&dispatch_cond, &scheduler_lock);
+      } else {
+        ts.tv_sec  = flush_ns / 1000000000ULL;
+        ts.tv_nsec = flush_ns % 1000000000ULL;
+        if (pthread_cond_timedwait(&dispatch_cond, &scheduler_lock, &ts) == ETIMEDOUT) {
+          break;
+        }
+      }
+    }
+    if (job_queues[CLASS_EVENT].head != NULL) {
+      events = NULL;
+      tail   = &events;
+      for (n = 0; n < EVENT_BATCH_MAX && job_queues[CLASS_EVENT].head != NULL; n++) {
+        *tail = dequeue_job(CLASS_EVENT);
+        tail  = &(*tail)->next;
+      }
+      *tail = NULL;
+      pthread_mutex_unlock(&scheduler_lock);
+
+      while (events != NULL) {
+        job    = events;
+        events = job->next;
+        execute_job(CLASS_EVENT, job);
+      }
+    } else if (job_queues[CLASS_INFO].head != NULL) {
+      job = dequeue_job(CLASS_INFO);
+      pthread_mutex_unlock(&scheduler_lock);
+
+      execute_job(CLASS_INFO, job);
+    } else {
+      pthread_mutex_unlock(&scheduler_lock);
+    }
+    flush_ns = flush_client_events(get_monotonic_ns());
+  }
+  return NULL;
+}
+
+/**
+ * \brief Worker for lcd commands.
+ *
+ * A long lcd command only delays other lcd commands.
+ *
+ * @param arg unused
+ */
+void *lcd_worker(void *arg) {
+  Job *job;
+
+  trace_name_thread("lcd");
+  while (1) {
+    pthread_mutex_lock(&scheduler_lock);
+    while (job_queues[CLASS_LCD].head == NULL) {
+      pthread_cond_wait(&lcd_cond, &scheduler_lock);
+    }
+    job = dequeue_job(CLASS_LCD);
+    pthread_mutex_unlock(&scheduler_lock);
+
+    execute_job(CLASS_LCD, job);
+  }
+  return NULL;
+}
+
+/**
+ * \brief Worker for the serial transfers.
+ *
+ * A transfer waits the half clock period of its engine for every bit, so it
+ * runs here and never delays the socket thread.
+ *
+ * @param arg unused
+ */
+void *serial_worker(void *arg) {
+  Job *job;
+
+  trace_name_thread("serial");
+  while (1) {
+    pthread_mutex_lock(&scheduler_lock);
+    while (job_queues[CLASS_SERIAL].head == NULL) {
+      pthread_cond_wait(&serial_cond, &scheduler_lock);
+    }
+    job = dequeue_job(CLASS_SERIAL);
+    pthread_mutex_unlock(&scheduler_lock);
+
+    execute_job(CLASS_SERIAL, job);
+  }
+  return NULL;
+}
+
+/**
+ * \brief Start the worker threads.
+ */
+void start_scheduler() {
+  pthread_t thread;
+  pthread_condattr_t attr;
+  int i;
+
+  for (i = 0; i < MAX_CLIENTS; i++) {
+    client_orders[i].fd = -1;
+  }
+
+  // The batch deadlines are monotonic times.
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&dispatch_cond, &attr);
+  pthread_condattr_destroy(&attr);
+
+  if ((errno = pthread_create(&thread, NULL, dispatch_worker, NULL)) != 0) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "pthread_create: %m");
+    flush_log();
+    exit (EXIT_FAILURE);
+  }
+  pthread_detach(thread);
+  if ((errno = pthread_create(&thread, NULL, lcd_worker, NULL)) != 0) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "pthread_create: %m");
+    flush_log();
+    exit (EXIT_FAILURE);
+  }
+  pthread_detach(thread);
+  if ((errno = pthread_create(&thread, NULL, serial_worker, NULL)) != 0) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "pthread_create: %m");
+    flush_log();
+    exit (EXIT_FAILURE);
+  }
+  pthread_detach(thread);
+}
+
+/**
+ * Create a job.
+ *
+ * @param class            The class of the job.
+ * @param client_socket_fd The socket to answer.
+ * @param tag              The tag of the command, copied into the job.
+ * @param command          The command, copied into the job.
+ *
+ * @return The job.
+ */
+static Job *create_job(CommandClass class, int client_socket_fd, const char *tag, char *command) {
+  Job *job = malloc(sizeof(Job));
+
+  job->client_socket_fd = client_socket_fd;
+  job->class            = class;
+  job->command          = strdup(command);
+  job->call             = NULL;
+  snprintf(job->tag, REPLY_TAG_SIZE, "%s", tag);
+  job->queued_ns        = get_monotonic_ns();
+  return job;
+}
+
+/**
+ * Create and queue a job.
+ *
+ * @param class            The class of the job.
+ * @param client_socket_fd The socket to answer.
+ * @param tag              The tag of the command, copied into the job.
+ * @param command          The command, copied into the job.
+ */
+void queue_job(CommandClass class, int client_socket_fd, const char *tag, char *command) {
+  Job *job = create_job(class, client_socket_fd, tag, command);
+
+  pthread_mutex_lock(&scheduler_lock);
+  enqueue_job(class, job);
+  signal_worker(class);
+  pthread_mutex_unlock(&scheduler_lock);
+}
+
+/**
+ * \brief Schedule a client command.
+ *
+ * GPIO commands are executed at once, all other commands are queued for
+ * the worker of their class. The commands of a client keep their order: a
+ * command waits while earlier commands of the client run in another class,
+ * a GPIO command while any earlier command of the client runs. Commands of
+ * other clients are not delayed. A command with a #id tag gets the tag
+ * before every answer line, so tagged commands can be pipelined and matched
+ * even if they complete out of order, like WAIT.
+ *
+ * @param client_socket_fd The socket of the client.
+ * @param command          The command line.
+ */
+void schedule_command(int client_socket_fd, char *command) {
+  char tag[REPLY_TAG_SIZE];
+  unsigned long long trace_ns = trace_begin();
+  ClientOrder *order;
+  CommandClass class;
+  Job *job;
+
+  record_command(client_socket_fd, command);
+  if ((command = split_request_tag(command, tag)) == NULL) {
+    write_error_msg_to_client(client_socket_fd, "invalid tag");
+    return;
+  }
+  class = classify_command(command);
+  trace_end(TRACE_PARSE, trace_ns, client_socket_fd);
+
+  pthread_mutex_lock(&scheduler_lock);
+  order = find_client_order(client_socket_fd, 0);
+  if (order != NULL && (order->held != NULL || class == CLASS_GPIO || class != order->class)) {
+    job = create_job(class, client_socket_fd, tag, command);
+    job->next = NULL;
+    if (order->held_tail != NULL) {
+      order->held_tail->next = job;
+    } else {
+      order->held = job;
+    }
+    order->held_tail = job;
+    held_commands++;
+    hold_client(client_socket_fd);
+    pthread_mutex_unlock(&scheduler_lock);
+    return;
+  }
+  if (class == CLASS_GPIO) {
+    job_queues[CLASS_GPIO].executed++;
+    pthread_mutex_unlock(&scheduler_lock);
+    trace_ns = trace_begin();
+    begin_reply(client_socket_fd, tag, 0);
+    read_command(command, client_socket_fd);
+    end_reply(client_socket_fd, 0);
+    trace_end(TRACE_COMMAND, trace_ns, client_socket_fd);
+    return;
+  }
+  // Without a free entry the order across classes can't be kept.
+  if (order == NULL && (order = find_client_order(client_socket_fd, 1)) != NULL) {
+    order->class = class;
+  }
+  if (order != NULL) {
+    order->running++;
+  }
+  hold_client(client_socket_fd);
+  enqueue_job(class, create_job(class, client_socket_fd, tag, command));
+  signal_worker(class);
+  pthread_mutex_unlock(&scheduler_lock);
+}
+
+/**
+ * \brief Schedule an interrupt event for all clients.
+ *
+ * Called by the isr threads, so the socket write is done by the dispatch
+ * worker.
+ *
+ * @param name The interrupt name.
+ */
+void schedule_event(char *name) {
+  unsigned long long trace_ns = trace_begin();
+
+  queue_job(CLASS_EVENT, CLIENT_BROADCAST, "", name);
+  trace_end(TRACE_EVENT_ENQUEUE, trace_ns, 0);
+}
+
+/**
+ * \brief Schedule an internal job for the lcd worker.
+ *
+ * The job is executed in order with the lcd commands of the clients, so it
+ * never draws into a half finished client drawing command.
+ *
+ * @param call The function to execute.
+ */
+void schedule_lcd_call(LcdCall call) {
+  Job *job = malloc(sizeof(Job));
+
+  job->client_socket_fd = CLIENT_BROADCAST;
+  job->class            = CLASS_LCD;
+  job->command          = NULL;
+  job->tag[0]           = '\0';
+  job->call             = call;
+  job->queued_ns        = get_monotonic_ns();
+
+  pthread_mutex_lock(&scheduler_lock);
+  enqueue_job(CLASS_LCD, job);
+  pthread_cond_signal(&lcd_cond);
+  pthread_mutex_unlock(&scheduler_lock);
+}
+
+/**
+ * \brief Write the queue statistics.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ */
+void do_write_scheduler_stats(int client_socket_fd) {
+  char msg[BUFFER_SIZE];
+  unsigned long executed[CLASS_COUNT];
+  unsigned long long max_wait_ns[CLASS_COUNT];
+  unsigned long held;
+  int length[CLASS_COUNT], class;
+
+  pthread_mutex_lock(&scheduler_lock);
+  held = held_commands;
+  for (class = 0; class < CLASS_COUNT; class++) {
+    executed[class]    = job_queues[class].executed;
+    length[class]      = job_queues[class].length;
+    max_wait_ns[class] = job_queues[class].max_wait_ns;
+  }
+  pthread_mutex_unlock(&scheduler_lock);
+
+  for (class = 0; class < CLASS_COUNT; class++) {
+    snprintf(msg, BUFFER_SIZE, "queue %s: executed %lu, queued %d, max wait %llu us",
+        class_names[class], executed[class], length[class], max_wait_ns[class] / 1000);
+    write_msg_to_client(client_socket_fd, msg);
+  }
+  snprintf(msg, BUFFER_SIZE, "queue order: %lu commands held behind earlier commands of their client", held);
+  write_msg_to_client(client_socket_fd, msg);
+}
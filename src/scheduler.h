@@ -0,0 +1,40 @@
+/*
+ * scheduler.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+/**
+ * \brief Priority class of a command.
+ *
+ * GPIO commands are executed at once by the socket thread. Events and info
+ * commands are executed by the dispatch worker, events first. lcd commands
+ * are executed by the lcd worker, the bit banged serial transfers by the
+ * serial worker. The commands of a client keep their order across the
+ * classes, commands of different clients don't wait for each other.
+ */
+typedef enum CommandClass {
+  CLASS_GPIO = 0, //> READ, WRITE, MODE and unknown commands.
+  CLASS_EVENT,    //> Interrupt events to write to the clients.
+  CLASS_LCD,      //> lcd drawing commands.
+  CLASS_INFO,     //> READALL, INFO, STATS, TRACE, LCD INFO, LCD FONTINFO and LCD DUMP.
+  CLASS_SERIAL,   //> SHIFTOUT, SHIFTIN, SERIALOUT and SERIALIN.
+  CLASS_COUNT
+} CommandClass;
+
+/**
+ * \brief An internal lcd job, executed by the lcd worker without a client.
+ */
+typedef void (*LcdCall)(void);
+
+CommandClass classify_command(char *command);
+void start_scheduler();
+void schedule_command(int client_socket_fd, char *command);
+void schedule_event(char *name);
+void schedule_lcd_call(LcdCall call);
+void do_write_scheduler_stats(int client_socket_fd);
+
+#endif /* SCHEDULER_H_ */
@@ -0,0 +1,356 @@
+/*
+ * shift.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "gpiod.h"
+#include "shift.h"
+
+static SerialEngine serial_engines[MAX_SERIAL_ENGINES];
+static int serial_engines_count = 0;
+static pthread_mutex_t serial_lock = PTHREAD_MUTEX_INITIALIZER; /**< guard the engines against a reload */
+
+/**
+ * \brief Set the configured serial engines.
+ *
+ * The engines of a reload replace the running engines, the names are
+ * owned by the table afterwards.
+ *
+ * @param engines The engines.
+ * @param count   Count of engines.
+ */
+void set_serial_engines(SerialEngine *engines, int count) {
+  char *old_names[MAX_SERIAL_ENGINES];
+  int i, old_count;
+
+  pthread_mutex_lock(&serial_lock);
+  old_count = serial_engines_count;
+  for (i = 0; i < old_count; i++) {
+    old_names[i] = serial_engines[i].name;
+  }
+  for (i = 0; i < count; i++) {
+    serial_engines[i] = engines[i];
+    serial_engines[i].data_output = -1;
+  }
+  serial_engines_count = count;
+  pthread_mutex_unlock(&serial_lock);
+
+  for (i = 0; i < old_count; i++) {
+    free(old_names[i]);
+  }
+}
+
+/**
+ * Wait the half clock period of the engine.
+ */
+static inline void serial_delay(SerialEngine *engine) {
+  if (engine->delay_us > 0) {
+    timer_spin_until(get_monotonic_ns() + engine->delay_us * 1000ULL);
+  }
+}
+
+/**
+ * Set the pin modes of the engine for the direction.
+ */
+static void serial_setup(SerialEngine *engine, int output) {
+  if (engine->data_output != output) {
+    gpio_pin_mode(engine->data, output ? OUTPUT : INPUT);
+    state_set_mode(engine->data, output);
+    gpio_pin_mode(engine->clock, OUTPUT);
+    state_set_mode(engine->clock, 1);
+    if (engine->latch != -1) {
+      gpio_pin_mode(engine->latch, OUTPUT);
+      state_set_mode(engine->latch, 1);
+    }
+    engine->data_output = output;
+  }
+}
+
+/**
+ * \brief Shift bytes out.
+ *
+ * Runs the whole transfer against the backend without socket I/O.
+ *
+ * @param engine The engine.
+ * @param bytes  The bytes.
+ * @param count  Count of bytes.
+ */
+void serial_shift_out(SerialEngine *engine, unsigned char *bytes, int count) {
+  int i, bit;
+
+  serial_setup(engine, 1);
+  gpio_digital_write(engine->clock, engine->clock_idle);
+  if (engine->latch != -1) {
+    gpio_digital_write(engine->latch, 0);
+  }
+  for (i = 0; i < count; i++) {
+    for (bit = 0; bit < 8; bit++) {
+      gpio_digital_write(engine->data, engine->msb_first ? (bytes[i] >> (7 - bit)) & 1 : (bytes[i] >> bit) & 1);
+      serial_delay(engine);
+      gpio_digital_write(engine->clock, !engine->clock_idle);
+      serial_delay(engine);
+      gpio_digital_write(engine->clock, engine->clock_idle);
+    }
+  }
+  if (engine->latch != -1) {
+    gpio_digital_write(engine->latch, 1);
+  }
+}
+
+/**
+ * \brief Shift bytes in.
+ *
+ * @param engine The engine.
+ * @param bytes  Buffer for the bytes.
+ * @param count  Count of bytes.
+ */
+void serial_shift_in(SerialEngine *engine, unsigned char *bytes, int count) {
+  int i, bit, value;
+
+  serial_setup(engine, 0);
+  gpio_digital_write(engine->clock, engine->clock_idle);
+  if (engine->latch != -1) {
+    gpio_digital_write(engine->latch, 0);
+    serial_delay(engine);
+    gpio_digital_write(engine->latch, 1);
+  }
+  for (i = 0; i < count; i++) {
+    bytes[i] = 0;
+    for (bit = 0; bit < 8; bit++) {
+      gpio_digital_write(engine->clock, !engine->clock_idle);
+      serial_delay(engine);
+      value = gpio_digital_read(engine->data);
+      if (engine->msb_first) {
+        bytes[i] |= value << (7 - bit);
+      } else {
+        bytes[i] |= value << bit;
+      }
+      gpio_digital_write(engine->clock, engine->clock_idle);
+      serial_delay(engine);
+    }
+  }
+}
+
+/**
+ * Parse the bytes of an out command.
+ *
+ * @param buf   The byte list, decimal or hex with 0x.
+ * @param bytes Buffer for MAX_SHIFT_BYTES bytes.
+ *
+ * @return Count of bytes or -1 on error.
+ */
+static int parse_shift_bytes(char *buf, unsigned char *bytes) {
+  char *end;
+  long value;
+  int count = 0;
+
+  while (*buf != '\0') {
+    value = strtol(buf, &end, 0);
+    if (end == buf || value < 0 || value > 255 || (*end != ' ' && *end != '\0')) {
+      return -1;
+    }
+    if (count == MAX_SHIFT_BYTES) {
+      return -1;
+    }
+    bytes[count++] = value;
+    buf = end;
+    while (*buf == ' ') {
+      buf++;
+    }
+  }
+  return count;
+}
+
+/**
+ * Parse the bit order MSB or LSB.
+ *
+ * @return 1 for MSB, 0 for LSB or -1.
+ */
+static int parse_bit_order(char *order) {
+  if (strcmp(order, "MSB") == 0) {
+    return 1;
+  } else if (strcmp(order, "LSB") == 0) {
+    return 0;
+  }
+  return -1;
+}
+
+/**
+ * Write the shifted in bytes as hex.
+ */
+static void write_shift_bytes(int client_socket_fd, unsigned char *bytes, int count) {
+  char msg[BUFFER_SIZE];
+  int i, len = 0;
+
+  msg[0] = '\0';
+  for (i = 0; i < count; i++) {
+    len += snprintf(msg + len, BUFFER_SIZE - len, i ? " %02x" : "%02x", bytes[i]);
+  }
+  write_msg_to_client(client_socket_fd, msg);
+}
+
+/**
+ * Parse and check the pins of an ad hoc engine.
+ *
+ * @return 1 if valid, otherwise the error is written to the client.
+ */
+static int parse_shift_engine(int client_socket_fd, SerialEngine *engine, char *buf, char *usage, int *offset) {
+  char order[4];
+  int n = sscanf(buf, "%d %d %d %3s %n", &engine->data, &engine->clock, &engine->latch, order, offset);
+
+  if (n != 4) {
+    write_error_msg_to_client(client_socket_fd, usage);
+  } else if (!is_valid_pin_num(engine->data) || !is_valid_pin_num(engine->clock)
+      || (engine->latch != -1 && !is_valid_pin_num(engine->latch))) {
+    write_error_msg_to_client(client_socket_fd, "unknown port number");
+  } else if ((engine->msb_first = parse_bit_order(order)) == -1) {
+    write_error_msg_to_client(client_socket_fd, "order must be MSB or LSB");
+  } else {
+    engine->name        = NULL;
+    engine->clock_idle  = 0;
+    engine->delay_us    = 0;
+    engine->data_output = -1;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * \brief Shift bytes out with the given pins.
+ *
+ * SHIFTOUT data clock latch MSB|LSB byte... with latch -1 for none.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ * @param buf              The command arguments.
+ */
+void do_shift_out(int client_socket_fd, char *buf) {
+  SerialEngine engine;
+  unsigned char bytes[MAX_SHIFT_BYTES];
+  char msg[BUFFER_SIZE];
+  int offset = 0, count;
+
+  if (!parse_shift_engine(client_socket_fd, &engine, buf,
+      "expected SHIFTOUT <#data> <#clock> <#latch|-1> <MSB|LSB> <byte>...", &offset)) {
+    return;
+  }
+  if ((count = parse_shift_bytes(buf + offset, bytes)) <= 0) {
+    write_error_msg_to_client(client_socket_fd, "expected 1 to 32 bytes of 0 to 255");
+    return;
+  }
+  log_msg(LOG_MOD_GPIO, LOG_DEBUG, "EXECUTING %s DATA %d CLOCK %d LATCH %d %d BYTES", CLIENT_SHIFTOUT, engine.data, engine.clock, engine.latch, count);
+  serial_shift_out(&engine, bytes, count);
+  snprintf(msg, BUFFER_SIZE, "shifted %d bytes", count);
+  write_msg_to_client(client_socket_fd, msg);
+}
+
+/**
+ * \brief Shift bytes in with the given pins.
+ *
+ * SHIFTIN data clock load MSB|LSB count with load -1 for none.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ * @param buf              The command arguments.
+ */
+void do_shift_in(int client_socket_fd, char *buf) {
+  SerialEngine engine;
+  unsigned char bytes[MAX_SHIFT_BYTES];
+  int offset = 0, count;
+
+  if (!parse_shift_engine(client_socket_fd, &engine, buf,
+      "expected SHIFTIN <#data> <#clock> <#load|-1> <MSB|LSB> <count>", &offset)) {
+    return;
+  }
+  if (sscanf(buf + offset, "%d", &count) != 1 || count < 1 || count > MAX_SHIFT_BYTES) {
+    write_error_msg_to_client(client_socket_fd, "count must be 1 to 32");
+    return;
+  }
+  log_msg(LOG_MOD_GPIO, LOG_DEBUG, "EXECUTING %s DATA %d CLOCK %d LOAD %d %d BYTES", CLIENT_SHIFTIN, engine.data, engine.clock, engine.latch, count);
+  serial_shift_in(&engine, bytes, count);
+  write_shift_bytes(client_socket_fd, bytes, count);
+}
+
+/**
+ * Find a configured engine. serial_lock must be held.
+ *
+ * @param name     Buffer with the engine name at the start.
+ * @param name_len Length of the name.
+ */
+static SerialEngine *find_serial_engine(char *name, int name_len) {
+  int i;
+
+  for (i = 0; i < serial_engines_count; i++) {
+    if ((int) strlen(serial_engines[i].name) == name_len && strncmp(serial_engines[i].name, name, name_len) == 0) {
+      return &serial_engines[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * \brief Shift bytes out with a configured engine.
+ *
+ * SERIALOUT name byte...
+ *
+ * @param client_socket_fd The socket file descriptor.
+ * @param buf              The command arguments.
+ */
+void do_serial_out(int client_socket_fd, char *buf) {
+  SerialEngine *engine;
+  unsigned char bytes[MAX_SHIFT_BYTES];
+  char msg[BUFFER_SIZE];
+  int name_len = strcspn(buf, " "), count;
+
+  if (name_len == 0 || buf[name_len] == '\0') {
+    write_error_msg_to_client(client_socket_fd, "expected SERIALOUT <name> <byte>...");
+    return;
+  }
+  if ((count = parse_shift_bytes(buf + name_len + 1, bytes)) <= 0) {
+    write_error_msg_to_client(client_socket_fd, "expected 1 to 32 bytes of 0 to 255");
+    return;
+  }
+  pthread_mutex_lock(&serial_lock);
+  if ((engine = find_serial_engine(buf, name_len)) != NULL) {
+    serial_shift_out(engine, bytes, count);
+  }
+  pthread_mutex_unlock(&serial_lock);
+  if (engine == NULL) {
+    write_error_msg_to_client(client_socket_fd, "unknown serial engine");
+    return;
+  }
+  snprintf(msg, BUFFER_SIZE, "shifted %d bytes", count);
+  write_msg_to_client(client_socket_fd, msg);
+}
+
+/**
+ * \brief Shift bytes in with a configured engine.
+ *
+ * SERIALIN name count
+ *
+ * @param client_socket_fd The socket file descriptor.
+ * @param buf              The command arguments.
+ */
+void do_serial_in(int client_socket_fd, char *buf) {
+  SerialEngine *engine;
+  unsigned char bytes[MAX_SHIFT_BYTES];
+  int name_len = strcspn(buf, " "), count;
+
+  if (name_len == 0 || sscanf(buf + name_len, "%d", &count) != 1) {
+    write_error_msg_to_client(client_socket_fd, "expected SERIALIN <name> <count>");
+    return;
+  }
+  if (count < 1 || count > MAX_SHIFT_BYTES) {
+    write_error_msg_to_client(client_socket_fd, "count must be 1 to 32");
+    return;
+  }
+  pthread_mutex_lock(&serial_lock);
+  if ((engine = find_serial_engine(buf, name_len)) != NULL) {
+    serial_shift_in(engine, bytes, count);
+  }
+  pthread_mutex_unlock(&serial_lock);
+  if (engine == NULL) {
+    write_error_msg_to_client(client_socket_fd, "unknown serial engine");
+    return;
+  }
+  write_shift_bytes(client_socket_fd, bytes, count);
+}
@@ -0,0 +1,58 @@
+/*
+ * shift.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef SHIFT_H_
+#define SHIFT_H_
+
+/**
+ * \brief Maximal count of bytes of one shift command.
+ */
+#define MAX_SHIFT_BYTES 32
+
+/**
+ * \brief Maximal count of configured serial engines.
+ */
+#define MAX_SERIAL_ENGINES 8
+
+/**
+ * \brief Longest half clock period of a serial engine in microseconds.
+ *
+ * A transfer of MAX_SHIFT_BYTES takes at most about half a second, in the
+ * serial worker.
+ */
+#define MAX_SERIAL_DELAY_US 1000
+
+/**
+ * \brief A clocked serial engine.
+ *
+ * Data is written before the clock leaves its idle level and read while
+ * the clock is active. The latch is low while shifting out and goes high
+ * afterwards (74HC595 storage clock), before shifting in it is pulsed low
+ * (74HC165 parallel load).
+ */
+typedef struct SerialEngine {
+  char *name;       //> Name of a configured engine.
+  int data;         //> Data pin.
+  int clock;        //> Clock pin.
+  int latch;        //> Latch or load pin, -1 for none.
+  int msb_first;    //> 1 to shift the most significant bit first.
+  int clock_idle;   //> Idle level of the clock.
+  int delay_us;     //> Half clock period in microseconds, 0 for full speed.
+  int data_output;  //> Current direction of the data pin, -1 if unknown.
+} SerialEngine;
+
+#define CLIENT_SHIFTOUT  "SHIFTOUT"
+#define CLIENT_SHIFTIN   "SHIFTIN"
+#define CLIENT_SERIALOUT "SERIALOUT"
+#define CLIENT_SERIALIN  "SERIALIN"
+
+void set_serial_engines(SerialEngine *engines, int count);
+void do_shift_out(int client_socket_fd, char *buf);
+void do_shift_in(int client_socket_fd, char *buf);
+void do_serial_out(int client_socket_fd, char *buf);
+void do_serial_in(int client_socket_fd, char *buf);
+
+#endif /* SHIFT_H_ */
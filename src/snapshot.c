@@ -0,0 +1,440 @@
+/*
+ * snapshot.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <limits.h>
+#include <sys/mman.h>
+#include "gpiod.h"
+#include "snapshot.h"
+
+static char *snapshot_file = NULL;     /**< snapshot file or NULL if disabled */
+static Snapshot snapshot = { .contrast = -1 }; /**< the state written to the file */
+static int snapshot_dirty   = 0;       /**< 1 if the state changed since the last write */
+static int snapshot_started = 0;       /**< 1 after the snapshot thread is running */
+static int snapshot_applied = 0;       /**< 1 if a snapshot was applied on startup */
+static unsigned long snapshot_saves  = 0;
+static unsigned long snapshot_errors = 0;
+static unsigned long long snapshot_save_us = 0; /**< duration of the last write */
+static pthread_mutex_t snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t snapshot_save_lock = PTHREAD_MUTEX_INITIALIZER; /**< serialize the file writes */
+static pthread_cond_t snapshot_cond = PTHREAD_COND_INITIALIZER;
+
+/**
+ * \brief Set the snapshot file.
+ *
+ * @param file_name The file name or NULL to disable the snapshot.
+ */
+void set_snapshot_file(char *file_name) {
+  snapshot_file = file_name;
+}
+
+char *get_snapshot_file() {
+  return snapshot_file;
+}
+
+/**
+ * Mark the snapshot as changed and wake the snapshot thread.
+ * snapshot_lock must be held.
+ */
+static inline void snapshot_changed() {
+  if (!snapshot_dirty) {
+    snapshot_dirty = 1;
+    if (snapshot_started) {
+      pthread_cond_signal(&snapshot_cond);
+    }
+  }
+}
+
+/**
+ * Write the snapshot to a temporary file and rename it over the snapshot file.
+ *
+ * The rename replaces the file at once, so the snapshot file is always
+ * complete.
+ *
+ * @return 0 or -1 on error.
+ */
+static int write_snapshot() {
+  char tmp_name[PATH_MAX];
+  unsigned long long start = get_monotonic_ns();
+  struct timespec now;
+  Snapshot *map;
+  int fd, r = -1;
+
+  pthread_mutex_lock(&snapshot_save_lock);
+  snprintf(tmp_name, PATH_MAX, "%s.tmp", snapshot_file);
+  if ((fd = open(tmp_name, O_CREAT | O_TRUNC | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)) == -1) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "%s: %m", tmp_name);
+    goto out;
+  }
+  if (ftruncate(fd, sizeof(Snapshot)) == -1) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "%s: %m", tmp_name);
+    close(fd);
+    goto out;
+  }
+  map = mmap(NULL, sizeof(Snapshot), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "mmap: %m");
+    goto out;
+  }
+
+  pthread_mutex_lock(&snapshot_lock);
+  clock_gettime(CLOCK_REALTIME, &now);
+  snapshot.saved_ns = (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+  // The edges are counted without marking the snapshot, they are taken as they are.
+  get_widget_edges(snapshot.edges);
+  memcpy(map, &snapshot, sizeof(Snapshot));
+  snapshot_dirty = 0;
+  pthread_mutex_unlock(&snapshot_lock);
+
+  if (msync(map, sizeof(Snapshot), MS_SYNC) == -1) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "msync: %m");
+  } else if (rename(tmp_name, snapshot_file) == -1) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "%s: %m", snapshot_file);
+  } else {
+    r = 0;
+  }
+  munmap(map, sizeof(Snapshot));
+
+out:
+  if (r == 0) {
+    snapshot_saves++;
+    snapshot_save_us = (get_monotonic_ns() - start) / 1000;
+  } else {
+    snapshot_errors++;
+  }
+  pthread_mutex_unlock(&snapshot_save_lock);
+  return r;
+}
+
+/**
+ * \brief Thread writing the changed snapshot.
+ *
+ * The thread waits SNAPSHOT_DELAY_MS after the first change, so the changes
+ * of a burst of commands or of a fade are written together.
+ *
+ * @param arg unused
+ */
+void *snapshot_thread(void *arg) {
+  struct timespec ts = { SNAPSHOT_DELAY_MS / 1000, (SNAPSHOT_DELAY_MS % 1000) * 1000000L };
+
+  trace_name_thread("snapshot");
+  while (1) {
+    pthread_mutex_lock(&snapshot_lock);
+    while (!snapshot_dirty) {
+      pthread_cond_wait(&snapshot_cond, &snapshot_lock);
+    }
+    pthread_mutex_unlock(&snapshot_lock);
+    nanosleep(&ts, NULL);
+    write_snapshot();
+  }
+  return NULL;
+}
+
+/**
+ * Read and check the snapshot file.
+ *
+ * @return 0 or -1 if there is no valid snapshot.
+ */
+static int read_snapshot(Snapshot *read_snapshot) {
+  int fd;
+  ssize_t n;
+
+  if ((fd = open(snapshot_file, O_RDONLY)) == -1) {
+    if (errno != ENOENT) {
+      log_msg(LOG_MOD_DAEMON, LOG_WARNING, "%s: %m", snapshot_file);
+    }
+    return -1;
+  }
+  n = read(fd, read_snapshot, sizeof(Snapshot));
+  close(fd);
+  if (n != sizeof(Snapshot) || read_snapshot->magic != SNAPSHOT_MAGIC
+      || read_snapshot->version != SNAPSHOT_VERSION || read_snapshot->size != sizeof(Snapshot)
+      || read_snapshot->pin_count != NUM_PINS) {
+    log_msg(LOG_MOD_DAEMON, LOG_WARNING, "%s: no valid snapshot, starting without", snapshot_file);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * \brief Apply the snapshot file.
+ *
+ * Must be called after the backend and state setup and before the sockets
+ * are opened. An output gets its level before it is switched to output, so
+ * it doesn't drive the reset level for a moment, the chardev backend requests
+ * the line with the level as initial output value. The display is shown again
+ * by start_snapshot.
+ */
+void apply_snapshot() {
+  Snapshot saved;
+  int pin;
+
+  if (snapshot_file == NULL || read_snapshot(&saved) == -1) {
+    return;
+  }
+  for (pin = 0; pin < NUM_PINS; pin++) {
+    if (!(saved.modes_valid & (1U << pin))) {
+      continue;
+    }
+    if (saved.outputs & (1U << pin)) {
+      gpio_digital_write(pin, (saved.levels >> pin) & 1);
+      gpio_pin_mode(pin, OUTPUT);
+      state_set_level(pin, (saved.levels >> pin) & 1);
+      state_set_mode(pin, 1);
+    } else {
+      gpio_pin_mode(pin, INPUT);
+      state_set_mode(pin, 0);
+    }
+  }
+  for (pin = 0; pin < NUM_PINS; pin++) {
+    if (saved.pwm_valid & (1U << pin)) {
+      pwm_set_level(pin, saved.pwm[pin]);
+    }
+  }
+  state_restore_counters(saved.commands, saved.events, saved.clients);
+  set_widget_edges(saved.edges);
+  if (saved.lcd_shown) {
+    fb_restore(saved.fb);
+  }
+
+  pthread_mutex_lock(&snapshot_lock);
+  memcpy(&snapshot, &saved, sizeof(Snapshot));
+  snapshot_dirty = 0;
+  pthread_mutex_unlock(&snapshot_lock);
+  snapshot_applied = 1;
+  log_msg(LOG_MOD_DAEMON, LOG_INFO, "Applied the snapshot %s", snapshot_file);
+}
+
+/**
+ * Show the restored display, job of the lcd worker.
+ */
+static void restore_lcd() {
+  int contrast_value, backlight_level = -1;
+
+  pthread_mutex_lock(&snapshot_lock);
+  contrast_value = snapshot.contrast;
+  if (snapshot.pwm_valid & SNAPSHOT_PWM_LCD) {
+    backlight_level = snapshot.pwm[PWM_TARGET_LCD];
+  }
+  pthread_mutex_unlock(&snapshot_lock);
+
+  lcd_restore(contrast_value, backlight_level);
+}
+
+/**
+ * \brief Start writing the snapshot on changes.
+ *
+ * Must be called after start_scheduler, a restored display is shown by the
+ * lcd worker.
+ */
+void start_snapshot() {
+  pthread_t thread;
+  int show_lcd;
+
+  if (snapshot_file == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&snapshot_lock);
+  snapshot.magic     = SNAPSHOT_MAGIC;
+  snapshot.version   = SNAPSHOT_VERSION;
+  snapshot.size      = sizeof(Snapshot);
+  snapshot.pin_count = NUM_PINS;
+  snapshot_started   = 1;
+  show_lcd = snapshot_applied && (snapshot.lcd_shown || snapshot.contrast != -1 || (snapshot.pwm_valid & SNAPSHOT_PWM_LCD));
+  pthread_mutex_unlock(&snapshot_lock);
+
+  if (pthread_create(&thread, NULL, snapshot_thread, NULL) != 0) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "pthread_create: %m");
+    return;
+  }
+  pthread_detach(thread);
+  if (show_lcd) {
+    schedule_lcd_call(restore_lcd);
+  }
+}
+
+/**
+ * \brief Write a changed snapshot on exit.
+ *
+ * Called by the signal thread on SIGTERM and SIGINT, never from a signal
+ * handler, so it waits for the locks.
+ */
+void save_snapshot() {
+  int dirty;
+
+  if (snapshot_file == NULL || !snapshot_started) {
+    return;
+  }
+  pthread_mutex_lock(&snapshot_lock);
+  dirty = snapshot_dirty;
+  pthread_mutex_unlock(&snapshot_lock);
+  if (dirty) {
+    write_snapshot();
+  }
+}
+
+void snapshot_set_level(int pin, int level) {
+  if (snapshot_file == NULL || pin < 0 || pin >= NUM_PINS) {
+    return;
+  }
+  pthread_mutex_lock(&snapshot_lock);
+  if (((snapshot.levels >> pin) & 1) != (level ? 1U : 0U)) {
+    snapshot.levels ^= 1U << pin;
+    if (snapshot.outputs & (1U << pin)) {
+      snapshot_changed();
+    }
+  }
+  pthread_mutex_unlock(&snapshot_lock);
+}
+
+/**
+ * \brief Set the sampled levels of all pins.
+ *
+ * Only a changed output level marks the snapshot, the input levels are not
+ * restored.
+ *
+ * @param levels Bit n is the level of pin n.
+ */
+void snapshot_set_levels(unsigned int levels) {
+  if (snapshot_file == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&snapshot_lock);
+  if ((snapshot.levels ^ levels) & snapshot.outputs) {
+    snapshot_changed();
+  }
+  snapshot.levels = levels;
+  pthread_mutex_unlock(&snapshot_lock);
+}
+
+void snapshot_set_bank(unsigned int set_mask, unsigned int clear_mask) {
+  unsigned int levels;
+
+  if (snapshot_file == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&snapshot_lock);
+  levels = (snapshot.levels | set_mask) & ~clear_mask;
+  if ((levels ^ snapshot.levels) & snapshot.outputs) {
+    snapshot_changed();
+  }
+  snapshot.levels = levels;
+  pthread_mutex_unlock(&snapshot_lock);
+}
+
+void snapshot_set_mode(int pin, int output) {
+  unsigned int outputs;
+
+  if (snapshot_file == NULL || pin < 0 || pin >= NUM_PINS) {
+    return;
+  }
+  pthread_mutex_lock(&snapshot_lock);
+  outputs = output ? snapshot.outputs | (1U << pin) : snapshot.outputs & ~(1U << pin);
+  if (outputs != snapshot.outputs || !(snapshot.modes_valid & (1U << pin))) {
+    snapshot.outputs      = outputs;
+    snapshot.modes_valid |= 1U << pin;
+    snapshot_changed();
+  }
+  pthread_mutex_unlock(&snapshot_lock);
+}
+
+/**
+ * \brief Set the level of a pwm pin or the backlight.
+ *
+ * @param target The pin or PWM_TARGET_LCD.
+ * @param level  The written level.
+ */
+void snapshot_set_pwm(int target, int level) {
+  if (snapshot_file == NULL || target < 0 || target > NUM_PINS) {
+    return;
+  }
+  pthread_mutex_lock(&snapshot_lock);
+  if (snapshot.pwm[target] != level || !(snapshot.pwm_valid & (1U << target))) {
+    snapshot.pwm[target]  = level;
+    snapshot.pwm_valid   |= 1U << target;
+    snapshot_changed();
+  }
+  pthread_mutex_unlock(&snapshot_lock);
+}
+
+void snapshot_set_contrast(int value) {
+  if (snapshot_file == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&snapshot_lock);
+  if (snapshot.contrast != value) {
+    snapshot.contrast = value;
+    snapshot_changed();
+  }
+  pthread_mutex_unlock(&snapshot_lock);
+}
+
+/**
+ * \brief Take the shown framebuffer.
+ *
+ * Called by mirror_show with the mirror lock held, only if a page changed.
+ *
+ * @param pages The shown pages.
+ */
+void snapshot_lcd_shown(const uint8_t pages[FB_PAGES][FB_WIDTH]) {
+  if (snapshot_file == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&snapshot_lock);
+  memcpy(snapshot.fb, pages, sizeof(snapshot.fb));
+  snapshot.lcd_shown = 1;
+  snapshot_changed();
+  pthread_mutex_unlock(&snapshot_lock);
+}
+
+/**
+ * Increment a counter, a counter alone doesn't mark the snapshot.
+ */
+static inline void snapshot_count(uint64_t *counter) {
+  if (snapshot_file == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&snapshot_lock);
+  (*counter)++;
+  pthread_mutex_unlock(&snapshot_lock);
+}
+
+void snapshot_count_command() {
+  snapshot_count(&snapshot.commands);
+}
+
+void snapshot_count_event() {
+  snapshot_count(&snapshot.events);
+}
+
+void snapshot_count_client() {
+  snapshot_count(&snapshot.clients);
+}
+
+/**
+ * \brief Write the snapshot statistics.
+ *
+ * @param client_socket_fd The unix socket file descriptor.
+ */
+void do_write_snapshot_stats(int client_socket_fd) {
+  char msg[BUFFER_SIZE];
+  unsigned long saves, errors;
+  unsigned long long save_us;
+
+  if (snapshot_file == NULL) {
+    write_msg_to_client(client_socket_fd, "snapshot: disabled");
+    return;
+  }
+  pthread_mutex_lock(&snapshot_save_lock);
+  saves   = snapshot_saves;
+  errors  = snapshot_errors;
+  save_us = snapshot_save_us;
+  pthread_mutex_unlock(&snapshot_save_lock);
+
+  snprintf(msg, BUFFER_SIZE, "snapshot: %s, %s, %lu saves, %lu errors, last save %llu us",
+           snapshot_file, snapshot_applied ? "applied" : "not applied", saves, errors, save_us);
+  write_msg_to_client(client_socket_fd, msg);
+}
@@ -0,0 +1,78 @@
+/*
+ * snapshot.h
+ *
+ *  Created on: 19.10.2026
+ *
+ * Binary snapshot of the state set by the clients, kept across restarts.
+ *
+ * The snapshot holds the pin modes and output levels, the pwm and backlight
+ * levels, the lcd contrast and framebuffer and the counters. A change arms a
+ * short timer, the timer copies the snapshot into a mapped temporary file,
+ * syncs it and renames it over the snapshot file. So the file is always
+ * complete, also after a power loss. On startup the snapshot is applied
+ * before the sockets are opened.
+ */
+
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <stdint.h>
+#include "fb.h"
+
+#define SNAPSHOT_MAGIC   0x50414e53 /* "SNAP" little endian */
+#define SNAPSHOT_VERSION 1
+
+/**
+ * \brief Delay between a change and the write of the snapshot in milliseconds.
+ *
+ * All changes within the delay are written together, a fade doesn't write a
+ * file per step.
+ */
+#define SNAPSHOT_DELAY_MS 250
+
+/**
+ * \brief Bit of the backlight in pwm_valid.
+ */
+#define SNAPSHOT_PWM_LCD (1U << NUM_PINS)
+
+/**
+ * \brief The snapshot file, the integers are in host byte order.
+ */
+typedef struct Snapshot {
+  uint32_t magic;               //> SNAPSHOT_MAGIC
+  uint32_t version;             //> SNAPSHOT_VERSION
+  uint32_t size;                //> sizeof(Snapshot)
+  uint32_t pin_count;           //> NUM_PINS
+  uint64_t saved_ns;            //> Realtime of the write.
+  uint32_t modes_valid;         //> Bit n is set if the mode of pin n was set.
+  uint32_t outputs;             //> Bit n is set if pin n is an output.
+  uint32_t levels;              //> Bit n is the last written level of pin n.
+  uint32_t pwm_valid;           //> Bit n is set if pin n has a pwm level, SNAPSHOT_PWM_LCD for the backlight.
+  int32_t pwm[NUM_PINS + 1];    //> The pwm levels, the backlight is the last.
+  int32_t contrast;             //> The lcd contrast or -1 if not set.
+  uint32_t lcd_shown;           //> 1 if the framebuffer was shown.
+  uint64_t commands;            //> Executed commands.
+  uint64_t events;              //> Sent events.
+  uint64_t clients;             //> Accepted clients.
+  uint64_t edges[NUM_PINS];     //> Edges of every pin counted for the widgets.
+  uint8_t fb[FB_PAGES][FB_WIDTH]; //> The shown framebuffer.
+} Snapshot;
+
+void set_snapshot_file(char *file_name);
+char *get_snapshot_file();
+void apply_snapshot();
+void start_snapshot();
+void save_snapshot();
+void snapshot_set_level(int pin, int level);
+void snapshot_set_levels(unsigned int levels);
+void snapshot_set_bank(unsigned int set_mask, unsigned int clear_mask);
+void snapshot_set_mode(int pin, int output);
+void snapshot_set_pwm(int target, int level);
+void snapshot_set_contrast(int value);
+void snapshot_lcd_shown(const uint8_t pages[FB_PAGES][FB_WIDTH]);
+void snapshot_count_command();
+void snapshot_count_event();
+void snapshot_count_client();
+void do_write_snapshot_stats(int client_socket_fd);
+
+#endif /* SNAPSHOT_H_ */
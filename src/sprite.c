@@ -0,0 +1,320 @@
+/*
+ * sprite.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <ctype.h>
+#include <dirent.h>
+#include <limits.h>
+#include "gpiod.h"
+#include "fb.h"
+#include "sprite.h"
+
+/**
+ * \brief A sprite bitmap in the slab.
+ *
+ * The bitmap is page packed like the framebuffer: width bytes per page of
+ * 8 rows, bit n of a byte is row 8 * page + n.
+ */
+typedef struct Sprite {
+  int defined;
+  int width;
+  int height;
+  size_t offset;   //> Start of the bitmap in the slab.
+  size_t size;     //> Size of the bitmap in bytes.
+} Sprite;
+
+static Sprite sprites[MAX_SPRITES];
+static uint8_t sprite_slab[SPRITE_SLAB_SIZE];
+static size_t sprite_slab_used    = 0;
+static unsigned long sprite_draws = 0;
+static char *sprite_dir           = NULL; /**< directory of preloaded sprites or NULL */
+static pthread_mutex_t sprite_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * \brief Set the directory of the sprites loaded on startup and reload.
+ *
+ * @param dir The directory or NULL, owned by the sprites afterwards.
+ */
+void set_sprite_dir(char *dir) {
+  if (sprite_dir != dir) {
+    free(sprite_dir);
+  }
+  sprite_dir = dir;
+}
+
+/**
+ * Free the bitmap of a sprite, the slab stays compact. sprite_lock must be
+ * held.
+ */
+static void free_sprite(int id) {
+  Sprite *sprite = &sprites[id];
+  int i;
+
+  if (!sprite->defined) {
+    return;
+  }
+  memmove(sprite_slab + sprite->offset, sprite_slab + sprite->offset + sprite->size,
+      sprite_slab_used - sprite->offset - sprite->size);
+  for (i = 0; i < MAX_SPRITES; i++) {
+    if (sprites[i].defined && sprites[i].offset > sprite->offset) {
+      sprites[i].offset -= sprite->size;
+    }
+  }
+  sprite_slab_used -= sprite->size;
+  sprite->defined = 0;
+}
+
+/**
+ * \brief Define or replace a sprite.
+ *
+ * @param id     The sprite id.
+ * @param width  Width in pixels.
+ * @param height Height in pixels.
+ * @param data   The page packed bitmap, width * ((height + 7) / 8) bytes.
+ *
+ * @return 0 or -1 if the slab is full.
+ */
+int define_sprite(int id, int width, int height, const uint8_t *data) {
+  size_t size = (size_t) width * ((height + 7) / 8);
+  Sprite *sprite = &sprites[id];
+
+  pthread_mutex_lock(&sprite_lock);
+  free_sprite(id);
+  if (sprite_slab_used + size > SPRITE_SLAB_SIZE) {
+    pthread_mutex_unlock(&sprite_lock);
+    return -1;
+  }
+  memcpy(sprite_slab + sprite_slab_used, data, size);
+  sprite->defined = 1;
+  sprite->width   = width;
+  sprite->height  = height;
+  sprite->offset  = sprite_slab_used;
+  sprite->size    = size;
+  sprite_slab_used += size;
+  pthread_mutex_unlock(&sprite_lock);
+
+  return 0;
+}
+
+/**
+ * \brief Draw a sprite into the framebuffer.
+ *
+ * @param id   The sprite id.
+ * @param x    Left column.
+ * @param y    Top row.
+ * @param mode How the pixels are combined.
+ *
+ * @return 0 or -1 if the sprite is not defined.
+ */
+int draw_sprite(int id, int x, int y, FbMode mode) {
+  Sprite *sprite = &sprites[id];
+
+  pthread_mutex_lock(&sprite_lock);
+  if (!sprite->defined) {
+    pthread_mutex_unlock(&sprite_lock);
+    return -1;
+  }
+  fb_blit(x, y, sprite->width, sprite->height, sprite_slab + sprite->offset, mode);
+  sprite_draws++;
+  pthread_mutex_unlock(&sprite_lock);
+
+  return 0;
+}
+
+/**
+ * Read a number of a pbm header, comments are skipped.
+ */
+static int read_pbm_int(FILE *file, int *value) {
+  int ch;
+
+  while ((ch = fgetc(file)) != EOF) {
+    if (ch == '#') {
+      while ((ch = fgetc(file)) != EOF && ch != '\n');
+    } else if (ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n') {
+      ungetc(ch, file);
+      return fscanf(file, "%d", value) == 1 ? 0 : -1;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Load a binary pbm (P4) file as sprite.
+ *
+ * @return 0 or -1 if the file is not valid.
+ */
+static int load_pbm_sprite(int id, const char *file_name) {
+  uint8_t data[FB_PAGES * FB_WIDTH], row[FB_WIDTH / 8];
+  int width, height, y, x, r = -1;
+  FILE *file;
+
+  if ((file = fopen(file_name, "r")) == NULL) {
+    return -1;
+  }
+  if (fgetc(file) == 'P' && fgetc(file) == '4' && read_pbm_int(file, &width) == 0 && read_pbm_int(file, &height) == 0
+      && width >= 1 && width <= FB_WIDTH && height >= 1 && height <= FB_HEIGHT && fgetc(file) != EOF) {
+    memset(data, 0, sizeof(data));
+    for (y = 0; y < height; y++) {
+      if (fread(row, 1, (width + 7) / 8, file) != (size_t) (width + 7) / 8) {
+        break;
+      }
+      // pbm rows are packed msb first, sprites are page packed.
+      for (x = 0; x < width; x++) {
+        if (row[x / 8] & (0x80 >> (x % 8))) {
+          data[(y / 8) * width + x] |= 1 << (y % 8);
+        }
+      }
+    }
+    if (y == height) {
+      r = define_sprite(id, width, height, data);
+    }
+  }
+  fclose(file);
+  return r;
+}
+
+/**
+ * \brief Load the sprites of the sprite directory.
+ *
+ * Every file id.pbm is loaded as sprite id.
+ *
+ * @return Count of loaded sprites or -1 if the directory is not readable.
+ */
+int load_sprites() {
+  char file_name[PATH_MAX];
+  struct dirent *entry;
+  int id, count = 0;
+  char end;
+  DIR *dir;
+
+  if (sprite_dir == NULL) {
+    return 0;
+  }
+  if ((dir = opendir(sprite_dir)) == NULL) {
+    log_msg(LOG_MOD_LCD, LOG_ERR, "%s: %m", sprite_dir);
+    return -1;
+  }
+  while ((entry = readdir(dir)) != NULL) {
+    if (sscanf(entry->d_name, "%d.pb%c", &id, &end) != 2 || end != 'm' || id < 0 || id >= MAX_SPRITES) {
+      continue;
+    }
+    snprintf(file_name, sizeof(file_name), "%s/%s", sprite_dir, entry->d_name);
+    if (load_pbm_sprite(id, file_name) == 0) {
+      count++;
+    } else {
+      log_msg(LOG_MOD_LCD, LOG_WARNING, "%s: not a valid sprite", file_name);
+    }
+  }
+  closedir(dir);
+  return count;
+}
+
+/**
+ * Parse the hex bitmap of LCD SPRITE DEFINE.
+ *
+ * @return 0 or -1 if the payload has not size bytes.
+ */
+static int parse_sprite_payload(const char *hex, uint8_t *data, size_t size) {
+  unsigned int byte;
+  size_t i;
+
+  if (strlen(hex) != size * 2) {
+    return -1;
+  }
+  for (i = 0; i < size; i++) {
+    if (!isxdigit((unsigned char) hex[2 * i]) || !isxdigit((unsigned char) hex[2 * i + 1])
+        || sscanf(hex + 2 * i, "%2x", &byte) != 1) {
+      return -1;
+    }
+    data[i] = byte;
+  }
+  return 0;
+}
+
+/**
+ * \brief Sprite lcd commands.
+ *
+ * LCD SPRITE DEFINE id width height hex, the hex bitmap is page packed:
+ * width bytes per 8 rows, bit 0 is the top row of the page.
+ * LCD SPRITE DRAW id x y [set|clear|xor] draws into the framebuffer.
+ * LCD SPRITE FREE id.
+ *
+ * @param client_socket_fd The unix socket file descriptor.
+ * @param buf              The lcd command.
+ */
+void do_lcd_sprite(int client_socket_fd, char *buf) {
+  char command[16], mode_name[8] = "set";
+  uint8_t data[FB_PAGES * FB_WIDTH];
+  int id, width, height, x, y, offset = 0, n;
+  FbMode mode;
+  char *hex;
+
+  if (sscanf(buf, "%*s %15s", command) != 1) {
+    write_error_msg_to_client(client_socket_fd, "expected LCD SPRITE <DEFINE|DRAW|FREE>");
+  } else if (strcmp(command, LCD_SPRITE_DEFINE) == 0) {
+    n = sscanf(buf, "%*s %*s %d %d %d %n", &id, &width, &height, &offset);
+    hex = buf + offset;
+    hex[strcspn(hex, " \t")] = '\0';
+    if (n != 3 || offset == 0) {
+      write_error_msg_to_client(client_socket_fd, "expected LCD SPRITE DEFINE <id> <width> <height> <hex>");
+    } else if (id < 0 || id >= MAX_SPRITES) {
+      write_error_msg_to_client(client_socket_fd, "unknown sprite id");
+    } else if (width < 1 || width > FB_WIDTH || height < 1 || height > FB_HEIGHT) {
+      write_error_msg_to_client(client_socket_fd, "sprite must fit into 128x64");
+    } else if (parse_sprite_payload(hex, data, (size_t) width * ((height + 7) / 8)) == -1) {
+      write_error_msg_to_client(client_socket_fd, "expected width * (height + 7) / 8 hex bytes");
+    } else if (define_sprite(id, width, height, data) == -1) {
+      write_error_msg_to_client(client_socket_fd, "sprite memory full");
+    } else {
+      log_msg(LOG_MOD_LCD, LOG_DEBUG, "EXECUTING LCD %s %s %d %dx%d", LCD_SPRITE, LCD_SPRITE_DEFINE, id, width, height);
+    }
+  } else if (strcmp(command, LCD_SPRITE_DRAW) == 0) {
+    n = sscanf(buf, "%*s %*s %d %d %d %7s", &id, &x, &y, mode_name);
+    mode = strcmp(mode_name, "clear") == 0 ? FB_CLEAR : strcmp(mode_name, "xor") == 0 ? FB_XOR : FB_SET;
+    if (n < 3) {
+      write_error_msg_to_client(client_socket_fd, "expected LCD SPRITE DRAW <id> <x> <y> [set|clear|xor]");
+    } else if (mode == FB_SET && strcmp(mode_name, "set") != 0) {
+      write_error_msg_to_client(client_socket_fd, "mode must be set, clear or xor");
+    } else if (id < 0 || id >= MAX_SPRITES) {
+      write_error_msg_to_client(client_socket_fd, "unknown sprite id");
+    } else if (x < 0 || x >= FB_WIDTH || y < 0 || y >= FB_HEIGHT) {
+      write_error_msg_to_client(client_socket_fd, "position outside of the display");
+    } else if (draw_sprite(id, x, y, mode) == -1) {
+      write_error_msg_to_client(client_socket_fd, "sprite not defined");
+    }
+  } else if (strcmp(command, LCD_SPRITE_FREE) == 0) {
+    if (sscanf(buf, "%*s %*s %d", &id) != 1 || id < 0 || id >= MAX_SPRITES) {
+      write_error_msg_to_client(client_socket_fd, "expected LCD SPRITE FREE <id>");
+    } else {
+      pthread_mutex_lock(&sprite_lock);
+      free_sprite(id);
+      pthread_mutex_unlock(&sprite_lock);
+    }
+  } else {
+    write_error_msg_to_client(client_socket_fd, "expected LCD SPRITE <DEFINE|DRAW|FREE>");
+  }
+}
+
+/**
+ * \brief Write the sprite statistics.
+ *
+ * @param client_socket_fd The unix socket file descriptor.
+ */
+void do_write_sprite_stats(int client_socket_fd) {
+  char msg[BUFFER_SIZE];
+  unsigned long used, draws;
+  int i, count = 0;
+
+  pthread_mutex_lock(&sprite_lock);
+  for (i = 0; i < MAX_SPRITES; i++) {
+    count += sprites[i].defined;
+  }
+  used  = sprite_slab_used;
+  draws = sprite_draws;
+  pthread_mutex_unlock(&sprite_lock);
+
+  snprintf(msg, BUFFER_SIZE, "sprites: %d defined, %lu of %d bytes, %lu draws", count, used, SPRITE_SLAB_SIZE, draws);
+  write_msg_to_client(client_socket_fd, msg);
+}
@@ -0,0 +1,35 @@
+/*
+ * sprite.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef SPRITE_H_
+#define SPRITE_H_
+
+#include <stdint.h>
+#include "fb.h"
+
+/**
+ * \brief Maximal count of sprites, the ids are 0 to MAX_SPRITES - 1.
+ */
+#define MAX_SPRITES 64
+
+/**
+ * \brief Size of the slab of all sprite bitmaps in bytes.
+ */
+#define SPRITE_SLAB_SIZE 16384
+
+#define LCD_SPRITE        "SPRITE"
+#define LCD_SPRITE_DEFINE "DEFINE"
+#define LCD_SPRITE_DRAW   "DRAW"
+#define LCD_SPRITE_FREE   "FREE"
+
+void set_sprite_dir(char *dir);
+int load_sprites();
+int define_sprite(int id, int width, int height, const uint8_t *data);
+int draw_sprite(int id, int x, int y, FbMode mode);
+void do_lcd_sprite(int client_socket_fd, char *buf);
+void do_write_sprite_stats(int client_socket_fd);
+
+#endif /* SPRITE_H_ */
@@ -0,0 +1,274 @@
+/*
+ * state.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <sys/mman.h>
+#include "gpiod.h"
+#include "state.h"
+#include "gpiod_state.h"
+
+static char *state_name      = GPIOD_STATE_NAME; /**< shared memory name or NULL if disabled */
+static int state_refresh_ms  = STATE_REFRESH_MS;
+static GpiodState *state     = NULL;
+static pthread_mutex_t state_lock = PTHREAD_MUTEX_INITIALIZER; /**< serialize the writers */
+
+/**
+ * \brief Set the name of the shared memory state.
+ *
+ * @param name The name or "none" to disable the state.
+ */
+void set_state_name(char *name) {
+  state_name = strcmp(name, "none") == 0 ? NULL : name;
+}
+
+char *get_state_name() {
+  return state_name;
+}
+
+void set_state_refresh(int refresh_ms) {
+  state_refresh_ms = refresh_ms;
+}
+
+/**
+ * Start a write, readers retry until state_write_end.
+ * state_lock must be held.
+ */
+static inline void state_write_begin() {
+  __atomic_store_n(&state->seq, state->seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ * End a write. state_lock must be held.
+ */
+static inline void state_write_end() {
+  state->updated_ns = get_monotonic_ns();
+  __atomic_store_n(&state->seq, state->seq + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * \brief Sample thread of the pin levels.
+ *
+ * @param arg unused
+ */
+void *state_refresh_thread(void *arg) {
+  struct timespec ts = { state_refresh_ms / 1000, (state_refresh_ms % 1000) * 1000000L };
+
+  trace_name_thread("state refresh");
+  while (1) {
+    nanosleep(&ts, NULL);
+    state_set_levels(gpio_read_bank());
+  }
+  return NULL;
+}
+
+/**
+ * \brief Create the shared memory state.
+ *
+ * The segment is readable for everybody and writable only by the daemon.
+ * Must be called after the backend setup.
+ *
+ * @return 0 or -1 on error.
+ */
+int init_state() {
+  pthread_t thread;
+  void *map;
+  int fd;
+
+  if (state_name == NULL) {
+    return 0;
+  }
+  if ((fd = shm_open(state_name, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)) == -1) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "%s: %m", state_name);
+    return -1;
+  }
+  // shm_open is subject to the umask.
+  fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if (ftruncate(fd, sizeof(GpiodState)) == -1) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "%s: %m", state_name);
+    close(fd);
+    return -1;
+  }
+  map = mmap(NULL, sizeof(GpiodState), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "mmap: %m");
+    return -1;
+  }
+  state = (GpiodState *) map;
+
+  pthread_mutex_lock(&state_lock);
+  state_write_begin();
+  memset((char *) state + sizeof(uint32_t) * 3, 0, sizeof(GpiodState) - sizeof(uint32_t) * 3);
+  state->pin_count = NUM_PINS;
+  state->levels    = gpio_read_bank();
+  state->magic     = GPIOD_STATE_MAGIC;
+  state->version   = GPIOD_STATE_VERSION;
+  state_write_end();
+  pthread_mutex_unlock(&state_lock);
+
+  if (state_refresh_ms > 0) {
+    if ((errno = pthread_create(&thread, NULL, state_refresh_thread, NULL)) != 0) {
+      log_msg(LOG_MOD_DAEMON, LOG_ERR, "pthread_create: %m");
+      return -1;
+    }
+    pthread_detach(thread);
+  }
+  return 0;
+}
+
+/**
+ * \brief Remove the shared memory state.
+ */
+void cleanup_state() {
+  if (state != NULL) {
+    shm_unlink(state_name);
+  }
+}
+
+void state_set_level(int pin, int level) {
+  snapshot_set_level(pin, level);
+  if (state == NULL || pin < 0 || pin >= GPIOD_STATE_PINS) {
+    return;
+  }
+  pthread_mutex_lock(&state_lock);
+  state_write_begin();
+  if (level) {
+    state->levels |= 1U << pin;
+  } else {
+    state->levels &= ~(1U << pin);
+  }
+  state_write_end();
+  pthread_mutex_unlock(&state_lock);
+}
+
+/**
+ * \brief Set the levels of all pins.
+ *
+ * A write is skipped if nothing changed, so a reader isn't delayed by the
+ * sampling.
+ *
+ * @param levels Bit n is the level of pin n.
+ */
+void state_set_levels(unsigned int levels) {
+  snapshot_set_levels(levels);
+  if (state == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&state_lock);
+  if (state->levels != levels) {
+    state_write_begin();
+    state->levels = levels;
+    state_write_end();
+  }
+  pthread_mutex_unlock(&state_lock);
+}
+
+/**
+ * \brief Set the levels of a bank write.
+ *
+ * @param set_mask   Pins set high.
+ * @param clear_mask Pins set low.
+ */
+void state_set_bank(unsigned int set_mask, unsigned int clear_mask) {
+  snapshot_set_bank(set_mask, clear_mask);
+  if (state == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&state_lock);
+  state_write_begin();
+  state->levels = (state->levels | set_mask) & ~clear_mask;
+  state_write_end();
+  pthread_mutex_unlock(&state_lock);
+}
+
+void state_set_mode(int pin, int output) {
+  snapshot_set_mode(pin, output);
+  if (state == NULL || pin < 0 || pin >= GPIOD_STATE_PINS) {
+    return;
+  }
+  pthread_mutex_lock(&state_lock);
+  state_write_begin();
+  if (output) {
+    state->outputs |= 1U << pin;
+  } else {
+    state->outputs &= ~(1U << pin);
+  }
+  state_write_end();
+  pthread_mutex_unlock(&state_lock);
+}
+
+/**
+ * \brief Record an edge of a pin.
+ *
+ * @param pin          The pin.
+ * @param level        The level after the edge.
+ * @param timestamp_ns Monotonic time of the edge.
+ */
+void state_edge(int pin, int level, unsigned long long timestamp_ns) {
+  if (state == NULL || pin < 0 || pin >= GPIOD_STATE_PINS) {
+    return;
+  }
+  pthread_mutex_lock(&state_lock);
+  state_write_begin();
+  if (level) {
+    state->levels |= 1U << pin;
+  } else {
+    state->levels &= ~(1U << pin);
+  }
+  state->event_seq++;
+  state->pins[pin].event_seq++;
+  state->pins[pin].last_event_ns = timestamp_ns;
+  state_write_end();
+  pthread_mutex_unlock(&state_lock);
+}
+
+/**
+ * Increment a counter of the state.
+ */
+static inline void state_count(uint64_t *counter) {
+  pthread_mutex_lock(&state_lock);
+  state_write_begin();
+  (*counter)++;
+  state_write_end();
+  pthread_mutex_unlock(&state_lock);
+}
+
+void state_count_command() {
+  snapshot_count_command();
+  if (state != NULL) {
+    state_count(&state->commands);
+  }
+}
+
+void state_count_event() {
+  snapshot_count_event();
+  if (state != NULL) {
+    state_count(&state->events);
+  }
+}
+
+void state_count_client() {
+  snapshot_count_client();
+  if (state != NULL) {
+    state_count(&state->clients);
+  }
+}
+
+/**
+ * \brief Set the counters saved by the snapshot of the last run.
+ */
+void state_restore_counters(unsigned long long commands, unsigned long long events, unsigned long long clients) {
+  if (state == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&state_lock);
+  state_write_begin();
+  state->commands = commands;
+  state->events   = events;
+  state->clients  = clients;
+  state_write_end();
+  pthread_mutex_unlock(&state_lock);
+}
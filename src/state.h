@@ -0,0 +1,33 @@
+/*
+ * state.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef STATE_H_
+#define STATE_H_
+
+/**
+ * \brief Default sample interval of the pin levels in milliseconds.
+ *
+ * Input levels change without a command, so they are sampled. 0 disables
+ * the sampling, then only commands and edges update the levels.
+ */
+#define STATE_REFRESH_MS 10
+
+void set_state_name(char *name);
+char *get_state_name();
+void set_state_refresh(int refresh_ms);
+int init_state();
+void cleanup_state();
+void state_set_level(int pin, int level);
+void state_set_levels(unsigned int levels);
+void state_set_bank(unsigned int set_mask, unsigned int clear_mask);
+void state_set_mode(int pin, int output);
+void state_edge(int pin, int level, unsigned long long timestamp_ns);
+void state_count_command();
+void state_count_event();
+void state_count_client();
+void state_restore_counters(unsigned long long commands, unsigned long long events, unsigned long long clients);
+
+#endif /* STATE_H_ */
@@ -2,11 +2,33 @@
 
 GPIOD=gpiod
 SOCKET=/tmp/gpiod-test.sock
+PACKET=/tmp/gpiod-test-packet.sock
+STATE=/gpiod-test-state
+SNAPSHOT=/tmp/gpiod-test.snapshot
+CONFIG=/tmp/gpiod-test.cfg
 REPORT=gpiod.testreport
 NC="nc -U $SOCKET"
+CLIENT_BUFFER_SIZE=256 # of client.h
 PRELOAD_LIB=
+GPIOD_ARGS=
 
-rm -f $SOCKET
+rm -f $SOCKET $PACKET $SNAPSHOT
+
+# Send $1 as one packet to the packet socket, print every answer packet in brackets.
+send_packet() {
+    python3 -c '
+import socket, sys
+s = socket.socket(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+s.connect(sys.argv[1])
+s.send(sys.argv[2].encode())
+s.settimeout(0.5)
+try:
+    while True:
+        print("[%s]" % s.recv(4096).decode().rstrip("\n"))
+except socket.timeout:
+    pass
+' "$PACKET" "$1"
+}
 
 if [ $# -ge 1 ]
 then
@@ -18,11 +40,15 @@ then
     then
 	PRELOAD_LIB=$PWD/libwiringPi_mock.so
     fi
+    if [ "$1" == "--with-mock-backend" ]
+    then
+	GPIOD_ARGS="-b mock"
+    fi
 fi
 
-echo "executing LD_PRELOAD=$PRELOAD_LIB ./$GPIOD -d -v -s $SOCKET > $REPORT &"
+echo "executing LD_PRELOAD=$PRELOAD_LIB ./$GPIOD -d -v -s $SOCKET -p $PACKET -m $STATE -k $SNAPSHOT $GPIOD_ARGS > $REPORT &"
 
-LD_PRELOAD=$PRELOAD_LIB ./$GPIOD -d -s $SOCKET > $REPORT &
+LD_PRELOAD=$PRELOAD_LIB ./$GPIOD -d -s $SOCKET -p $PACKET -m $STATE -k $SNAPSHOT $GPIOD_ARGS > $REPORT &
 GPIOD_PID=$!
 
 sleep 1
@@ -88,9 +114,85 @@ TESTCASE[18]="MODE 10 IN"
 EXPECTED[18]="OK - operation performed"
 TESTCASE[19]="MODE 11 OUT"
 EXPECTED[19]="OK - operation performed"
+TESTCASE[20]="PULSE 1"
+EXPECTED[20]="ERROR - expected PULSE <#pin> <0|1> <width_us>"
+TESTCASE[21]="WRITEAFTER 999 0 10"
+EXPECTED[21]="ERROR - unknown port number"
+TESTCASE[22]="WRITEAT 10 2 0"
+EXPECTED[22]="ERROR - value must be 0 or 1"
+TESTCASE[23]="SHIFTOUT 12 14 10 MSB 0xa5 255"
+EXPECTED[23]="OK - shifted 2 bytes"
+TESTCASE[24]="SHIFTOUT 12 14 -1 MID 1"
+EXPECTED[24]="ERROR - order must be MSB or LSB"
+TESTCASE[25]="SHIFTOUT 12 14 -1 LSB 256"
+EXPECTED[25]="ERROR - expected 1 to 32 bytes of 0 to 255"
+TESTCASE[26]="SHIFTIN 13 14 -1 MSB 2"
+EXPECTED[26]="OK - ff ff"
+TESTCASE[27]="SERIALOUT nothing 1"
+EXPECTED[27]="ERROR - unknown serial engine"
+TESTCASE[28]="BUSWRITE nothing 1"
+EXPECTED[28]="ERROR - unknown group"
+TESTCASE[29]="BUSREAD"
+EXPECTED[29]="ERROR - expected BUSREAD <group>"
+TESTCASE[30]="READ 16"
+EXPECTED[30]="OK - 0"
+TESTCASE[31]="PWM 1 512"
+EXPECTED[31]="OK - operation performed"
+TESTCASE[32]="PWM 1"
+EXPECTED[32]="OK - 512"
+TESTCASE[33]="FADE 1 0 1024 0 gamma"
+EXPECTED[33]="OK - operation performed"
+TESTCASE[34]="PWM 1"
+EXPECTED[34]="OK - 1024"
+TESTCASE[35]="FADE 1 0 1024 10 cubic"
+EXPECTED[35]="ERROR - curve must be linear or gamma"
+TESTCASE[36]="EVENTS"
+EXPECTED[36]="OK - events batch 64, latency 0 ms, aggregate off, prefix OK"
+TESTCASE[37]="EVENTS AGGREGATE ON"
+EXPECTED[37]="OK - events batch 64, latency 0 ms, aggregate on, prefix OK"
+TESTCASE[38]="EVENTS BATCH 0 5"
+EXPECTED[38]="ERROR - batch must be between 1 and 64"
+TESTCASE[39]="MOCK"
+EXPECTED[39]="ERROR - expected MOCK EDGE <#pin> <0|1>"
+TESTCASE[40]="WAIT 3 EDGE 20"
+EXPECTED[40]="ERROR - wait timeout"
+TESTCASE[41]="WAITANY 0x20000"
+EXPECTED[41]="ERROR - mask of unknown port numbers"
+TESTCASE[42]="WAIT 1 2 10"
+EXPECTED[42]="ERROR - wait for 0, 1 or EDGE"
+TESTCASE[43]="#7 UNKNOWNCOMMAND"
+EXPECTED[43]="#7 ERROR - unkown command"
+TESTCASE[44]="#x! READ 1"
+EXPECTED[44]="ERROR - invalid tag"
+TESTCASE[45]="#w-1 WAIT 3 EDGE 20"
+EXPECTED[45]="#w-1 ERROR - wait timeout"
+TESTCASE[46]="EVENTS PREFIX EVENT"
+EXPECTED[46]="OK - events batch 64, latency 0 ms, aggregate off, prefix EVENT"
+TESTCASE[47]="LCD SPRITE DEFINE 1 8 8 ff"
+EXPECTED[47]="ERROR - expected width * (height + 7) / 8 hex bytes"
+TESTCASE[48]="LCD SPRITE DRAW 2 0 0 xor"
+EXPECTED[48]="ERROR - sprite not defined"
+TESTCASE[49]="LCD WIDGET BAR 1 4 100 0 40 8 10"
+EXPECTED[49]="ERROR - widget must fit into 128x64"
+TESTCASE[50]="LCD WIDGET FREE 3"
+EXPECTED[50]="ERROR - widget not defined"
+TESTCASE[51]="LCD WATCH MAYBE"
+EXPECTED[51]="ERROR - expected LCD WATCH [ON|OFF]"
+TESTCASE[52]="TRACE"
+EXPECTED[52]="OK - trace off, 0 spans, ring 16384"
+TESTCASE[53]="TRACE START"
+EXPECTED[53]="ERROR - expected TRACE [ON|OFF|DUMP]"
+TESTCASE[54]="LOG GPIO DEBUG"
+EXPECTED[54]="OK - log stdout, daemon info, client info, gpio debug, isr info, lcd info, timer info"
+TESTCASE[55]="LOG ALL verbose"
+EXPECTED[55]="ERROR - level must be error, warning, notice, info or debug"
+TESTCASE[56]="TAGS"
+EXPECTED[56]="OK - tags begin off"
+TESTCASE[57]="TAGS BEGIN MAYBE"
+EXPECTED[57]="ERROR - expected TAGS [BEGIN ON|OFF]"
 
 failcount=0
-for((i=0; $i <= 19; i=$i + 1))
+for((i=0; $i <= 57; i=$i + 1))
 do
     TESTCASE="${TESTCASE[$i]}"
     EXPECTED="${EXPECTED[$i]}"
@@ -116,6 +218,76 @@ do
     fi
 done
 
+TESTCASE="Tagged multi line begin"
+printf "Test Case %4d :  %-30s " "$i" "$TESTCASE"
+# Only the multi line answer starts with BEGIN.
+ACTUAL=$(printf 'TAGS BEGIN ON\n#1 STATS\n#2 READ 1\n' | $NC | grep -E '^(#[12] (BEGIN|END|OK - [0-9]+)|OK - tags.*)$' | tr '\n' ' ')
+EXPECTED='OK - tags begin on #1 BEGIN #1 END #2 OK - 1 '
+if [ "$ACTUAL" == "$EXPECTED" ]
+then
+    printf " PASS\n"
+else
+    printf " FAIL\n\n"
+    printf "Actual:   $ACTUAL\n"
+    printf "Expected: $EXPECTED\n\n"
+    failcount=$(($failcount + 1))
+fi
+
+i=$(($i + 1))
+TESTCASE="LCD sprite xor over rect"
+printf "Test Case %4d :  %-30s " "$i" "$TESTCASE"
+# A sprite xor over a filled rectangle, the first 8 columns of the shown rows.
+printf 'LCD CLEAR\nLCD RECT 0 0 7 3 1\nLCD SPRITE DEFINE 1 4 8 0f0f0f0f\nLCD SPRITE DRAW 1 2 0 xor\nLCD SHOW\n' | $NC
+ACTUAL=$(echo "LCD DUMP" | $NC | sed -n '3,7p' | cut -c6-13 | tr '\n' ' ')
+EXPECTED='11000011 11000011 11000011 11000011 00000000 '
+if [ "$ACTUAL" == "$EXPECTED" ]
+then
+    printf " PASS\n"
+else
+    printf " FAIL\n\n"
+    printf "Actual:   $ACTUAL\n"
+    printf "Expected: $EXPECTED\n\n"
+    failcount=$(($failcount + 1))
+fi
+
+i=$(($i + 1))
+TESTCASE="LCD widget before SHOW"
+printf "Test Case %4d :  %-30s " "$i" "$TESTCASE"
+# A widget update shows the widget, not the unshown rectangle of the client.
+printf 'LCD CLEAR\nLCD SHOW\nLCD RECT 0 0 7 7 1\nLCD WIDGET PIN 5 1 100 0 8 8\n' | $NC
+sleep 0.5
+ACTUAL=$(echo "LCD DUMP" | $NC | sed -n '3,4p' | cut -c6-13,106-113 | tr '\n' ' ')
+echo "LCD SHOW" | $NC
+ACTUAL="$ACTUAL$(echo "LCD DUMP" | $NC | sed -n '3,4p' | cut -c6-13,106-113 | tr '\n' ' ')"
+echo "LCD WIDGET FREE 5" | $NC
+EXPECTED='0000000011111111 0000000010000001 1111111111111111 1111111110000001 '
+if [ "$ACTUAL" == "$EXPECTED" ]
+then
+    printf " PASS\n"
+else
+    printf " FAIL\n\n"
+    printf "Actual:   $ACTUAL\n"
+    printf "Expected: $EXPECTED\n\n"
+    failcount=$(($failcount + 1))
+fi
+
+i=$(($i + 1))
+TESTCASE="Client order across classes"
+printf "Test Case %4d :  %-30s " "$i" "$TESTCASE"
+# The READ of the latch waits for the SHIFTOUT in the serial worker.
+ACTUAL=$(printf 'WRITE 10 0\nSHIFTOUT 12 14 10 MSB %s\nREAD 10\n' "$(seq -s ' ' 1 32)" | $NC | tr '\n' ' ')
+EXPECTED='OK - operation performed OK - shifted 32 bytes OK - 1 '
+if [ "$ACTUAL" == "$EXPECTED" ]
+then
+    printf " PASS\n"
+else
+    printf " FAIL\n\n"
+    printf "Actual:   $ACTUAL\n"
+    printf "Expected: $EXPECTED\n\n"
+    failcount=$(($failcount + 1))
+fi
+
+i=$(($i + 1))
 TESTCASE="Socket permissions"
 printf "Test Case %4d :  %-30s " "$i" "$TESTCASE"
 ACTUAL=$(ls -l $SOCKET | awk '{ print $1 }')
@@ -130,8 +302,197 @@ else
     failcount=$(($failcount + 1))
 fi
 
+i=$(($i + 1))
+TESTCASE="Packet socket permissions"
+printf "Test Case %4d :  %-30s " "$i" "$TESTCASE"
+ACTUAL=$(ls -l $PACKET | awk '{ print $1 }')
+EXPECTED='srwxrwxrwx'
+if [ "$ACTUAL" == "$EXPECTED" ]
+then
+    printf " PASS\n"
+else
+    printf " FAIL\n\n"
+    printf "Actual:   $ACTUAL\n"
+    printf "Expected: $EXPECTED\n\n"
+    failcount=$(($failcount + 1))
+fi
+
+i=$(($i + 1))
+TESTCASE="Packet batch"
+printf "Test Case %4d :  %-30s " "$i" "$TESTCASE"
+# One packet of command lines gets one answer packet per command.
+ACTUAL=$(send_packet $'#6 WRITE 2 0\nREAD 2\n#7 WRITE 2 1\n#8 READ 2' | tr '\n' ' ')
+EXPECTED='[#6 OK - operation performed] [OK - 0] [#7 OK - operation performed] [#8 OK - 1] '
+if [ "$ACTUAL" == "$EXPECTED" ]
+then
+    printf " PASS\n"
+else
+    printf " FAIL\n\n"
+    printf "Actual:   $ACTUAL\n"
+    printf "Expected: $EXPECTED\n\n"
+    failcount=$(($failcount + 1))
+fi
+
+i=$(($i + 1))
+TESTCASE="Packet too long"
+printf "Test Case %4d :  %-30s " "$i" "$TESTCASE"
+ACTUAL=$(send_packet "$(head -c $((CLIENT_BUFFER_SIZE + 44)) /dev/zero | tr '\0' X)")
+EXPECTED='[ERROR - command too long]'
+if [ "$ACTUAL" == "$EXPECTED" ]
+then
+    printf " PASS\n"
+else
+    printf " FAIL\n\n"
+    printf "Actual:   $ACTUAL\n"
+    printf "Expected: $EXPECTED\n\n"
+    failcount=$(($failcount + 1))
+fi
+
+i=$(($i + 1))
+TESTCASE="Shared memory state"
+printf "Test Case %4d :  %-30s " "$i" "$TESTCASE"
+# magic, version and pin count of the state header
+ACTUAL=$(od -A n -t x4 -N 16 /dev/shm$STATE | awk '{ print $1, $2, $4 }')
+EXPECTED='67706964 00000001 00000011'
+if [ "$ACTUAL" == "$EXPECTED" ]
+then
+    printf " PASS\n"
+else
+    printf " FAIL\n\n"
+    printf "Actual:   $ACTUAL\n"
+    printf "Expected: $EXPECTED\n\n"
+    failcount=$(($failcount + 1))
+fi
+
+i=$(($i + 1))
+TESTCASE="Slow client output dropped"
+printf "Test Case %4d :  %-30s " "$i" "$TESTCASE"
+# A client that doesn't read the answers of 400 INFO, the output above the
+# high water mark is dropped.
+(yes INFO | head -400; sleep 2) | $NC | (sleep 3; cat > /dev/null) &
+SLOW_PID=$!
+sleep 1.5
+ACTUAL=$(echo "STATS" | $NC | grep -c "output: [1-9][0-9]* queued, [1-9][0-9]* dropped")
+EXPECTED='1'
+wait $SLOW_PID
+if [ "$ACTUAL" == "$EXPECTED" ]
+then
+    printf " PASS\n"
+else
+    printf " FAIL\n\n"
+    printf "Actual:   $ACTUAL\n"
+    printf "Expected: $EXPECTED\n\n"
+    failcount=$(($failcount + 1))
+fi
+
+# Written on exit at the latest, restored by the restart below.
+printf 'MODE 12 OUT\nWRITE 12 1\nPWM 1 300\n' | $NC > /dev/null
+kill $GPIOD_PID
+wait $GPIOD_PID 2> /dev/null
+
+i=$(($i + 1))
+TESTCASE="Snapshot file"
+printf "Test Case %4d :  %-30s " "$i" "$TESTCASE"
+# magic, version and pin count of the snapshot written on exit
+ACTUAL=$(od -A n -t x4 -N 16 $SNAPSHOT | awk '{ print $1, $2, $4 }')
+EXPECTED='50414e53 00000001 00000011'
+if [ "$ACTUAL" == "$EXPECTED" ]
+then
+    printf " PASS\n"
+else
+    printf " FAIL\n\n"
+    printf "Actual:   $ACTUAL\n"
+    printf "Expected: $EXPECTED\n\n"
+    failcount=$(($failcount + 1))
+fi
+
+rm -f $SOCKET
+LD_PRELOAD=$PRELOAD_LIB ./$GPIOD -d -s $SOCKET -m none -k $SNAPSHOT $GPIOD_ARGS > $REPORT &
+GPIOD_PID=$!
+
+sleep 1
+
+i=$(($i + 1))
+TESTCASE="Snapshot restored"
+printf "Test Case %4d :  %-30s " "$i" "$TESTCASE"
+ACTUAL=$(printf 'READ 12\nPWM 1\n' | $NC | tr '\n' ' ')
+EXPECTED='OK - 1 OK - 300 '
+if [ "$ACTUAL" == "$EXPECTED" ]
+then
+    printf " PASS\n"
+else
+    printf " FAIL\n\n"
+    printf "Actual:   $ACTUAL\n"
+    printf "Expected: $EXPECTED\n\n"
+    failcount=$(($failcount + 1))
+fi
+
+i=$(($i + 1))
+TESTCASE="Short pulse width"
+printf "Test Case %4d :  %-30s " "$i" "$TESTCASE"
+# A 50 us pulse ends on the timer thread well before the next 1 ms tick.
+WIDTH=$(echo "PULSE 4 1 50" | $NC | sed -n 's/^OK - pulse pin 4 .* width \([0-9]*\) ns$/\1/p')
+if [ -n "$WIDTH" ] && [ "$WIDTH" -ge 50000 ] && [ "$WIDTH" -lt 500000 ]
+then
+    printf " PASS\n"
+else
+    printf " FAIL\n\n"
+    printf "Actual:   $WIDTH\n"
+    printf "Expected: 50000 to 499999\n\n"
+    failcount=$(($failcount + 1))
+fi
+
+kill $GPIOD_PID
+wait $GPIOD_PID 2> /dev/null
+
+# A daemon that disconnects clients above 1 MB of queued output.
+cat > $CONFIG <<CFG
+output = { high_water = 1048576; policy = "disconnect"; };
+CFG
+rm -f $SOCKET
+LD_PRELOAD=$PRELOAD_LIB ./$GPIOD -d -i $CONFIG -s $SOCKET -m none $GPIOD_ARGS > $REPORT &
+GPIOD_PID=$!
+
+sleep 1
+
+i=$(($i + 1))
+TESTCASE="Slow client output flushed"
+printf "Test Case %4d :  %-30s " "$i" "$TESTCASE"
+# The answers of 100 INFO are queued and written when the client reads.
+ACTUAL=$( (yes INFO | head -100; sleep 2) | $NC | (sleep 1; grep -c "^OK - ") )
+EXPECTED=$(( $(echo "INFO" | $NC | grep -c "^OK - ") * 100 ))
+if [ "$ACTUAL" == "$EXPECTED" ]
+then
+    printf " PASS\n"
+else
+    printf " FAIL\n\n"
+    printf "Actual:   $ACTUAL\n"
+    printf "Expected: $EXPECTED\n\n"
+    failcount=$(($failcount + 1))
+fi
+
+i=$(($i + 1))
+TESTCASE="Slow client disconnected"
+printf "Test Case %4d :  %-30s " "$i" "$TESTCASE"
+# 1000 INFO don't fit into the queue, the client is disconnected.
+(yes INFO | head -1000; sleep 2) | $NC | (sleep 3; cat > /dev/null) &
+SLOW_PID=$!
+sleep 1.5
+ACTUAL=$(echo "STATS" | $NC | grep "output:" | sed 's/.*dropped ([0-9]* bytes), //; s/, max.*//')
+EXPECTED='1 disconnects'
+wait $SLOW_PID
+if [ "$ACTUAL" == "$EXPECTED" ]
+then
+    printf " PASS\n"
+else
+    printf " FAIL\n\n"
+    printf "Actual:   $ACTUAL\n"
+    printf "Expected: $EXPECTED\n\n"
+    failcount=$(($failcount + 1))
+fi
 
 kill $GPIOD_PID
+wait $GPIOD_PID 2> /dev/null
 
 if [ $failcount -gt 0 ]
 then
@@ -0,0 +1,56 @@
+#!/bin/bash
+#
+# Pipeline commands with gpiodctl and libgpiodclient against the mock backend.
+#
+
+GPIOD=gpiod
+CTL=gpiodctl
+SOCKET=/tmp/gpiod-test-client.sock
+REPORT=gpiod.testreport
+
+rm -f $SOCKET
+
+./$GPIOD -d -s $SOCKET -m none -b mock > $REPORT &
+GPIOD_PID=$!
+
+sleep 1
+
+failcount=0
+check() {
+    printf "Test Case %-40s " "$1"
+    if [ "$2" == "$3" ]
+    then
+	printf " PASS\n"
+    else
+	printf " FAIL\n\n"
+	printf "Actual:   $2\n"
+	printf "Expected: $3\n\n"
+	failcount=$(($failcount + 1))
+    fi
+}
+
+check "Pipelined commands" "$(./$CTL -s $SOCKET "WRITE 2 1" "READ 2" "WRITE 2 0" "READ 2")" \
+    "OK - operation performed
+OK - 1
+OK - operation performed
+OK - 0"
+# The WAIT answer comes after the answers of the later commands.
+check "Out of order answer" "$(./$CTL -s $SOCKET "WAIT 3 EDGE 100" "READ 2" "LCD CLEAR")" \
+    "OK - 0
+OK - operation performed
+ERROR - wait timeout"
+check "Multi line answer" "$(./$CTL -s $SOCKET "READALL" "READ 2" | wc -l)" "19"
+check "Multi line LCD DUMP" "$(./$CTL -s $SOCKET "LCD DUMP" "READ 2" | wc -l)" "67"
+check "Commands from stdin" "$(printf 'READ 2\nNOPE\n' | ./$CTL -s $SOCKET; echo "exit $?")" \
+    "OK - 0
+ERROR - unkown command
+exit 1"
+
+kill $GPIOD_PID
+
+if [ $failcount -gt 0 ]
+then
+    printf "\nMore than one test failed\n"
+else
+    printf "\nAll tests passed\n"
+fi
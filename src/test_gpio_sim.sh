@@ -0,0 +1,84 @@
+#!/bin/bash
+#
+# Test the chardev backend with the gpio-sim kernel module (needs root).
+#
+
+GPIOD=gpiod
+SOCKET=/tmp/gpiod-test-sim.sock
+CONFIG=/tmp/gpiod-test-sim.cfg
+EVENTS=/tmp/gpiod-test-sim.events
+REPORT=gpiod.testreport
+NC="nc -U $SOCKET"
+CONFIGFS=/sys/kernel/config/gpio-sim/gpiod-test
+
+if ! modprobe gpio-sim
+then
+    printf "gpio-sim module not available\n"
+    exit 1
+fi
+
+# One simulated bank, wiringPi pin 0 is line 17, pin 1 is line 18 and pin 2 is line 27.
+mkdir -p $CONFIGFS/bank0
+echo 32 > $CONFIGFS/bank0/num_lines
+echo 1 > $CONFIGFS/live
+CHIP=$(cat $CONFIGFS/bank0/chip_name)
+SIM=/sys/devices/platform/$(cat $CONFIGFS/dev_name)/$CHIP
+
+cat > $CONFIG <<CFG
+socket = "$SOCKET";
+backend = "chardev";
+backend_device = "/dev/$CHIP";
+interrupt = ( { pin = 0; type = "both"; name = "Edge"; wait = 0; pud = "none"; debounce = 0; } );
+CFG
+
+rm -f $SOCKET
+./$GPIOD -d -i $CONFIG > $REPORT &
+GPIOD_PID=$!
+
+sleep 1
+
+failcount=0
+check() {
+    printf "Test Case %-40s " "$1"
+    if [ "$2" == "$3" ]
+    then
+	printf " PASS\n"
+    else
+	printf " FAIL\n\n"
+	printf "Actual:   $2\n"
+	printf "Expected: $3\n\n"
+	failcount=$(($failcount + 1))
+    fi
+}
+
+# Keep a client connected to receive the events.
+(sleep 2) | $NC > $EVENTS &
+sleep 0.5
+echo pull-up > $SIM/sim_gpio17/pull
+sleep 0.2
+echo pull-down > $SIM/sim_gpio17/pull
+sleep 0.2
+echo pull-up > $SIM/sim_gpio17/pull
+wait %2 2> /dev/null
+
+check "3 edges of pin 0" "$(grep -c Edge $EVENTS)" "3"
+check "READ 0" "$(echo "READ 0" | $NC)" "OK - 1"
+# Pin 2 is line 27, never requested by gpiod, a READ doesn't request it.
+echo pull-up > $SIM/sim_gpio27/pull
+check "READ 2 not requested" "$(echo "READ 2" | $NC)" "OK - 1"
+check "WRITE 1 1" "$(echo "WRITE 1 1" | $NC)" "OK - operation performed"
+check "line 18 high" "$(cat $SIM/sim_gpio18/value)" "1"
+check "STATS lost edges" "$(echo "STATS" | $NC | grep -c 'lost: 0')" "1"
+
+kill $GPIOD_PID
+sleep 0.5
+echo 0 > $CONFIGFS/live
+rmdir $CONFIGFS/bank0 $CONFIGFS
+rm -f $CONFIG $EVENTS
+
+if [ $failcount -gt 0 ]
+then
+    printf "\nMore than one test failed\n"
+else
+    printf "\nAll tests passed\n"
+fi
@@ -0,0 +1,66 @@
+#!/bin/bash
+#
+# Test the mmap register backend against a plain file as fake registers.
+#
+
+GPIOD=gpiod
+SOCKET=/tmp/gpiod-test-mmap.sock
+REGISTERS=/tmp/gpiod-test-mmap.regs
+STATE=/gpiod-test-mmap-state
+REPORT=gpiod.testreport
+NC="nc -U $SOCKET"
+
+rm -f $SOCKET $REGISTERS
+: > $REGISTERS
+
+./$GPIOD -d -s $SOCKET -m $STATE -b mmap:$REGISTERS > $REPORT &
+GPIOD_PID=$!
+
+sleep 1
+
+# Read the 32 bit register with the given word offset from the fake registers.
+register() {
+    od -A n -t u4 -j $(($1 * 4)) -N 4 $REGISTERS | tr -d ' '
+}
+
+# Read the pin levels of the shared memory state.
+state_levels() {
+    od -A n -t u4 -j 16 -N 4 /dev/shm$STATE | tr -d ' '
+}
+
+failcount=0
+check() {
+    printf "Test Case %-40s " "$1"
+    if [ "$2" == "$3" ]
+    then
+	printf " PASS\n"
+    else
+	printf " FAIL\n\n"
+	printf "Actual:   $2\n"
+	printf "Expected: $3\n\n"
+	failcount=$(($failcount + 1))
+    fi
+}
+
+# wiringPi pin 0 is BCM 17: GPFSEL1 bits 21-23, GPSET0/GPCLR0/GPLEV0 bit 17.
+check "MODE 0 OUT" "$(echo "MODE 0 OUT" | $NC)" "OK - operation performed"
+check "GPFSEL1 output" "$(( $(register 1) >> 21 & 7 ))" "1"
+check "WRITE 0 1" "$(echo "WRITE 0 1" | $NC)" "OK - operation performed"
+check "GPSET0 bit 17" "$(( $(register 7) >> 17 & 1 ))" "1"
+check "READ 0" "$(echo "READ 0" | $NC)" "OK - 1"
+check "state level pin 0" "$(( $(state_levels) & 1 ))" "1"
+check "WRITE 0 0" "$(echo "WRITE 0 0" | $NC)" "OK - operation performed"
+check "GPCLR0 bit 17" "$(( $(register 10) >> 17 & 1 ))" "1"
+check "GPLEV0 bit 17" "$(( $(register 13) >> 17 & 1 ))" "0"
+check "READ 0 after clear" "$(echo "READ 0" | $NC)" "OK - 0"
+check "state level pin 0 after clear" "$(( $(state_levels) & 1 ))" "0"
+
+kill $GPIOD_PID
+rm -f $REGISTERS
+
+if [ $failcount -gt 0 ]
+then
+    printf "\nMore than one test failed\n"
+else
+    printf "\nAll tests passed\n"
+fi
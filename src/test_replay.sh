@@ -0,0 +1,72 @@
+#!/bin/bash
+#
+# Record a session with the mock backend and replay it against a new daemon.
+#
+
+GPIOD=gpiod
+REPLAY=gpiod_replay
+SOCKET=/tmp/gpiod-test-replay.sock
+TRACE=/tmp/gpiod-test-replay.trace
+CONFIG=/tmp/gpiod-test-replay.cfg
+REPORT=gpiod.testreport
+NC="nc -U $SOCKET"
+
+rm -f $SOCKET $TRACE
+
+# Only edges of interrupt pins are recorded.
+cat > $CONFIG <<CFG
+socket = "$SOCKET";
+backend = "mock";
+interrupt = ( { pin = 6; type = "both"; name = "Edge6"; wait = 0; pud = "none"; debounce = 0; } );
+CFG
+
+./$GPIOD -d -i $CONFIG -m none -r $TRACE > $REPORT &
+GPIOD_PID=$!
+
+sleep 1
+
+failcount=0
+check() {
+    printf "Test Case %-40s " "$1"
+    if [ "$2" == "$3" ]
+    then
+	printf " PASS\n"
+    else
+	printf " FAIL\n\n"
+	printf "Actual:   $2\n"
+	printf "Expected: $3\n\n"
+	failcount=$(($failcount + 1))
+    fi
+}
+
+check "READ 1" "$(echo "READ 1" | $NC)" "OK - 1"
+# The replay sends the command with a tag of its own.
+check "Tagged READ 1" "$(echo "#t1 READ 1" | $NC)" "#t1 OK - 1"
+check "MOCK EDGE 4 1" "$(echo "MOCK EDGE 4 1" | $NC)" "OK - operation performed"
+check "READ 4" "$(echo "READ 4" | $NC)" "OK - 1"
+# The edge of the interrupt pin is recorded, its MOCK EDGE command too.
+check "MOCK EDGE 6 1" "$(echo "MOCK EDGE 6 1" | $NC | grep -c 'operation performed')" "1"
+
+# The trace is flushed on exit.
+kill $GPIOD_PID
+wait $GPIOD_PID 2> /dev/null
+check "Trace magic" "$(od -A n -t x4 -N 8 $TRACE | awk '{ print $1, $2 }')" "72647067 00000002"
+
+./$GPIOD -d -s $SOCKET -m none -b mock > $REPORT &
+GPIOD_PID=$!
+
+sleep 1
+
+check "Replay" "$(./$REPLAY -s $SOCKET -x 10 $TRACE | head -1 | sed 's/.*ms: //')" \
+    "commands 5, answered 5, lost 0, edges 1 (0 failed), events 1 recorded, 0 received"
+check "Replayed edge" "$(echo "READ 4" | $NC)" "OK - 1"
+check "Replayed interrupt edge" "$(echo "READ 6" | $NC)" "OK - 1"
+
+kill $GPIOD_PID
+
+if [ $failcount -gt 0 ]
+then
+    printf "\nMore than one test failed\n"
+else
+    printf "\nAll tests passed\n"
+fi
@@ -0,0 +1,224 @@
+/*
+ * timed.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "gpiod.h"
+#include "timed.h"
+
+/**
+ * \brief A pending write at a deadline.
+ */
+typedef struct TimedWrite {
+  Timer timer;
+  int client_socket_fd;          //> Socket for the completion report.
+  char tag[REPLY_TAG_SIZE];      //> Tag of the command.
+  int pin;
+  int value;                     //> Value to write at the deadline.
+  int pulse;                     //> 1 if the write ends a pulse.
+  unsigned long long deadline_ns; //> Requested monotonic time of the write.
+  unsigned long long start_ns;   //> Achieved start of the pulse.
+} TimedWrite;
+
+static int timed_writes = 0; /**< count of pending timed writes */
+static pthread_mutex_t timed_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Write the pin and get the time of the write.
+ */
+static unsigned long long timed_pin_write(int pin, int value) {
+  unsigned long long now;
+
+  gpio_digital_write(pin, value);
+  now = get_monotonic_ns();
+  state_set_level(pin, value);
+  return now;
+}
+
+/**
+ * Write the completion report of a timed write.
+ *
+ * @param write  The timed write.
+ * @param now_ns Achieved time of the write.
+ */
+static void timed_report(TimedWrite *write, unsigned long long now_ns) {
+  char msg[BUFFER_SIZE];
+
+  if (write->pulse) {
+    snprintf(msg, BUFFER_SIZE, "pulse pin %d start %llu end %llu width %llu ns",
+        write->pin, write->start_ns, now_ns, now_ns - write->start_ns);
+  } else {
+    snprintf(msg, BUFFER_SIZE, "write pin %d value %d at %llu late %llu ns",
+        write->pin, write->value, now_ns, now_ns > write->deadline_ns ? now_ns - write->deadline_ns : 0);
+  }
+  write_msg_to_client(write->client_socket_fd, msg);
+}
+
+/**
+ * \brief Timer callback of a timed write.
+ *
+ * @param arg The timed write.
+ */
+void timed_write_expired(void *arg) {
+  TimedWrite *write = (TimedWrite *) arg;
+
+  set_reply_tag(write->tag);
+  timed_report(write, timed_pin_write(write->pin, write->value));
+  set_reply_tag(NULL);
+  release_client(write->client_socket_fd);
+
+  pthread_mutex_lock(&timed_lock);
+  timed_writes--;
+  pthread_mutex_unlock(&timed_lock);
+  free(write);
+}
+
+/**
+ * Execute the write at the deadline.
+ *
+ * Every deadline gets a precise timer and is written and reported by the
+ * timer thread, the command never waits on the client thread. A deadline
+ * closer than one timer tick wakes the timer thread at once.
+ *
+ * @param write The timed write, freed afterwards.
+ */
+static void timed_write_schedule(TimedWrite *write) {
+  pthread_mutex_lock(&timed_lock);
+  if (timed_writes == MAX_TIMED_WRITES) {
+    pthread_mutex_unlock(&timed_lock);
+    if (write->pulse) {
+      // Never leave a started pulse active.
+      timed_pin_write(write->pin, write->value);
+    }
+    write_error_msg_to_client(write->client_socket_fd, "too many timed writes");
+    free(write);
+    return;
+  }
+  timed_writes++;
+  pthread_mutex_unlock(&timed_lock);
+
+  hold_client(write->client_socket_fd);
+  defer_reply(write->tag);
+  timer_init(&write->timer, timed_write_expired, write);
+  timer_add_precise(&write->timer, write->deadline_ns);
+}
+
+/**
+ * Check pin and value of a timed command.
+ *
+ * @return 1 if valid, otherwise the error is written to the client.
+ */
+static int timed_check(int client_socket_fd, int pin_num, int value, unsigned long long time_us) {
+  if (!is_valid_pin_num(pin_num)) {
+    write_error_msg_to_client(client_socket_fd, "unknown port number");
+  } else if (!is_valid_pin_value(value)) {
+    write_error_msg_to_client(client_socket_fd, "value must be 0 or 1");
+  } else if (time_us > TIMED_MAX_US) {
+    write_error_msg_to_client(client_socket_fd, "time too long");
+  } else {
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * Create a timed write.
+ */
+static TimedWrite *timed_write_new(int client_socket_fd, int pin_num, int value) {
+  TimedWrite *write = malloc(sizeof(TimedWrite));
+
+  write->client_socket_fd = client_socket_fd;
+  write->pin              = pin_num;
+  write->value            = value;
+  write->pulse            = 0;
+  write->start_ns         = 0;
+  write->deadline_ns      = 0;
+  return write;
+}
+
+/**
+ * \brief Write a pulse.
+ *
+ * Write the level to the pin and the inverted level after the width. The
+ * report has the achieved start and end of the pulse.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ * @param buf              The command arguments.
+ */
+void do_pulse(int client_socket_fd, char *buf) {
+  TimedWrite *write;
+  unsigned long long width_us;
+  int pin_num, level;
+  char args[BUFFER_SIZE];
+  int n = sscanf(expand_pin_alias(buf, args, BUFFER_SIZE), "%d %d %llu", &pin_num, &level, &width_us);
+
+  if (n != 3) {
+    write_error_msg_to_client(client_socket_fd, "expected PULSE <#pin> <0|1> <width_us>");
+    return;
+  }
+  if (!timed_check(client_socket_fd, pin_num, level, width_us)) {
+    return;
+  }
+  log_msg(LOG_MOD_TIMER, LOG_DEBUG, "EXECUTING %s PIN %d LEVEL %d WIDTH %llu us", CLIENT_PULSE, pin_num, level, width_us);
+  write = timed_write_new(client_socket_fd, pin_num, !level);
+  write->pulse       = 1;
+  write->start_ns    = timed_pin_write(pin_num, level);
+  write->deadline_ns = write->start_ns + width_us * 1000ULL;
+  timed_write_schedule(write);
+}
+
+/**
+ * \brief Write a pin at a monotonic time.
+ *
+ * A time in the past is written at once and reported as late.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ * @param buf              The command arguments.
+ */
+void do_write_at(int client_socket_fd, char *buf) {
+  TimedWrite *write;
+  unsigned long long time_ns, now;
+  int pin_num, value;
+  char args[BUFFER_SIZE];
+  int n = sscanf(expand_pin_alias(buf, args, BUFFER_SIZE), "%d %d %llu", &pin_num, &value, &time_ns);
+
+  if (n != 3) {
+    write_error_msg_to_client(client_socket_fd, "expected WRITEAT <#pin> <0|1> <monotonic_ns>");
+    return;
+  }
+  now = get_monotonic_ns();
+  if (!timed_check(client_socket_fd, pin_num, value, time_ns > now ? (time_ns - now) / 1000ULL : 0)) {
+    return;
+  }
+  log_msg(LOG_MOD_TIMER, LOG_DEBUG, "EXECUTING %s PIN %d VALUE = %d AT %llu", CLIENT_WRITEAT, pin_num, value, time_ns);
+  write = timed_write_new(client_socket_fd, pin_num, value);
+  write->deadline_ns = time_ns;
+  timed_write_schedule(write);
+}
+
+/**
+ * \brief Write a pin after a delay.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ * @param buf              The command arguments.
+ */
+void do_write_after(int client_socket_fd, char *buf) {
+  TimedWrite *write;
+  unsigned long long delay_us;
+  int pin_num, value;
+  char args[BUFFER_SIZE];
+  int n = sscanf(expand_pin_alias(buf, args, BUFFER_SIZE), "%d %d %llu", &pin_num, &value, &delay_us);
+
+  if (n != 3) {
+    write_error_msg_to_client(client_socket_fd, "expected WRITEAFTER <#pin> <0|1> <delay_us>");
+    return;
+  }
+  if (!timed_check(client_socket_fd, pin_num, value, delay_us)) {
+    return;
+  }
+  log_msg(LOG_MOD_TIMER, LOG_DEBUG, "EXECUTING %s PIN %d VALUE = %d AFTER %llu us", CLIENT_WRITEAFTER, pin_num, value, delay_us);
+  write = timed_write_new(client_socket_fd, pin_num, value);
+  write->deadline_ns = get_monotonic_ns() + delay_us * 1000ULL;
+  timed_write_schedule(write);
+}
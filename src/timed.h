@@ -0,0 +1,24 @@
+/*
+ * timed.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef TIMED_H_
+#define TIMED_H_
+
+/**
+ * \brief Maximal count of pending timed writes.
+ */
+#define MAX_TIMED_WRITES 64
+
+/**
+ * \brief Longest delay or pulse width in microseconds.
+ */
+#define TIMED_MAX_US 3600000000ULL
+
+void do_pulse(int client_socket_fd, char *buf);
+void do_write_at(int client_socket_fd, char *buf);
+void do_write_after(int client_socket_fd, char *buf);
+
+#endif /* TIMED_H_ */
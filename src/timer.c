@@ -0,0 +1,349 @@
+/*
+ * timer.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <stdint.h>
+#include "gpiod.h"
+#include "timer.h"
+
+static Timer *timer_wheel[TIMER_WHEEL_SLOTS];
+static Timer *timer_levels[TIMER_LEVELS][TIMER_LEVEL_SLOTS];
+static unsigned long long timer_tick = 0; /**< last processed tick */
+static int timer_count = 0;               /**< count of armed timers */
+static Timer *timer_soon = NULL;          /**< precise timers due before the next tick */
+static int timer_fd = -1;
+static int timer_wake_fd = -1;            /**< eventfd to wake the timer thread */
+static pthread_mutex_t timer_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Start or stop the periodic tick of the timerfd. timer_lock must be held.
+ *
+ * @param run 1 to start the tick.
+ */
+static void timer_set_tick(int run) {
+  struct itimerspec spec;
+
+  memset(&spec, 0, sizeof(spec));
+  if (run) {
+    spec.it_value.tv_nsec    = TIMER_TICK_NS;
+    spec.it_interval.tv_nsec = TIMER_TICK_NS;
+  }
+  if (timerfd_settime(timer_fd, 0, &spec, NULL) == -1) {
+    log_msg(LOG_MOD_TIMER, LOG_ERR, "timerfd_settime: %m");
+  }
+}
+
+/**
+ * Put the timer into the slot of its expiry tick. timer_lock must be held.
+ *
+ * A timer due in the next TIMER_WHEEL_SLOTS ticks is put into the first
+ * level, a later timer into the level which covers its distance. A timer
+ * beyond the last level waits in the farthest slot and is put back on the
+ * cascade.
+ */
+static void timer_link(Timer *timer) {
+  unsigned long long expires = timer->expires_ns / TIMER_TICK_NS;
+  unsigned long long distance;
+  int level, shift = TIMER_WHEEL_BITS;
+
+  if (expires <= timer_tick) {
+    expires = timer_tick + 1;
+  }
+  distance = expires - timer_tick;
+  if (distance < TIMER_WHEEL_SLOTS) {
+    timer->slot = &timer_wheel[expires & (TIMER_WHEEL_SLOTS - 1)];
+  } else {
+    for (level = 0; level < TIMER_LEVELS - 1; level++) {
+      if (distance < 1ULL << (shift + TIMER_LEVEL_BITS)) {
+        break;
+      }
+      shift += TIMER_LEVEL_BITS;
+    }
+    if (distance >= 1ULL << (shift + TIMER_LEVEL_BITS)) {
+      expires = timer_tick + (1ULL << (shift + TIMER_LEVEL_BITS)) - 1;
+    }
+    timer->slot = &timer_levels[level][(expires >> shift) & (TIMER_LEVEL_SLOTS - 1)];
+  }
+  timer->prev = NULL;
+  timer->next = *timer->slot;
+  if (timer->next != NULL) {
+    timer->next->prev = timer;
+  }
+  *timer->slot = timer;
+}
+
+/**
+ * Remove the timer from its slot. timer_lock must be held.
+ */
+static void timer_unlink(Timer *timer) {
+  if (timer->prev != NULL) {
+    timer->prev->next = timer->next;
+  } else {
+    *timer->slot = timer->next;
+  }
+  if (timer->next != NULL) {
+    timer->next->prev = timer->prev;
+  }
+  timer->next = NULL;
+  timer->prev = NULL;
+  timer->slot = NULL;
+}
+
+/**
+ * Move the timers of a higher level slot down. timer_lock must be held.
+ */
+static void timer_cascade(Timer **slot) {
+  Timer *timer = *slot, *next;
+
+  *slot = NULL;
+  while (timer != NULL) {
+    next = timer->next;
+    timer_link(timer);
+    timer = next;
+  }
+}
+
+/**
+ * Move the timers of the slot to the expired list sorted by deadline.
+ * timer_lock must be held.
+ */
+static void timer_expire(Timer **slot, Timer **expired) {
+  Timer *timer, **pos;
+
+  while ((timer = *slot) != NULL) {
+    timer_unlink(timer);
+    timer->armed = 0;
+    timer_count--;
+    for (pos = expired; *pos != NULL; pos = &(*pos)->due) {
+      if ((*pos)->precise_ns > timer->precise_ns) {
+        break;
+      }
+    }
+    timer->due = *pos;
+    *pos = timer;
+  }
+}
+
+/**
+ * Advance the wheel by one tick and move the due timers to the expired
+ * list sorted by deadline. timer_lock must be held.
+ */
+static void timer_advance(Timer **expired) {
+  unsigned long long index;
+  int level, shift = TIMER_WHEEL_BITS;
+
+  timer_tick++;
+  // Every wrap of a level moves the next slot of the level above down.
+  for (level = 0; level < TIMER_LEVELS; level++) {
+    if ((timer_tick & ((1ULL << shift) - 1)) != 0) {
+      break;
+    }
+    index = (timer_tick >> shift) & (TIMER_LEVEL_SLOTS - 1);
+    timer_cascade(&timer_levels[level][index]);
+    shift += TIMER_LEVEL_BITS;
+  }
+
+  timer_expire(&timer_wheel[timer_tick & (TIMER_WHEEL_SLOTS - 1)], expired);
+}
+
+/**
+ * \brief Busy wait until the deadline.
+ *
+ * @param deadline_ns Monotonic deadline.
+ *
+ * @return The monotonic time after the wait.
+ */
+unsigned long long timer_spin_until(unsigned long long deadline_ns) {
+  unsigned long long now;
+
+  while ((now = get_monotonic_ns()) < deadline_ns) {
+    // spin
+  }
+  return now;
+}
+
+/**
+ * \brief Timer thread.
+ *
+ * The timerfd ticks every TIMER_TICK_NS while timers are armed. Every tick
+ * the wheel is advanced up to the current time, the callbacks of the
+ * expired timers are called without a lock held. A precise timer expires
+ * one tick early and the thread spins until its deadline. A precise timer
+ * due before the next tick wakes the thread through the eventfd at once.
+ *
+ * @param arg unused
+ */
+void *timer_thread(void *arg) {
+  Timer *expired, *timer;
+  unsigned long long now_tick;
+  uint64_t ticks;
+  struct pollfd fds[2];
+
+  trace_name_thread("timer");
+  fds[0].fd     = timer_fd;
+  fds[0].events = POLLIN;
+  fds[1].fd     = timer_wake_fd;
+  fds[1].events = POLLIN;
+  while (1) {
+    if (poll(fds, 2, -1) <= 0) {
+      continue;
+    }
+    if (fds[0].revents & POLLIN) {
+      read(timer_fd, &ticks, sizeof(ticks));
+    }
+    if (fds[1].revents & POLLIN) {
+      read(timer_wake_fd, &ticks, sizeof(ticks));
+    }
+    expired  = NULL;
+    now_tick = get_monotonic_ns() / TIMER_TICK_NS;
+
+    pthread_mutex_lock(&timer_lock);
+    while (timer_tick < now_tick) {
+      timer_advance(&expired);
+    }
+    timer_expire(&timer_soon, &expired);
+    if (timer_count == 0) {
+      timer_set_tick(0);
+    }
+    pthread_mutex_unlock(&timer_lock);
+
+    while (expired != NULL) {
+      timer   = expired;
+      expired = timer->due;
+      if (timer->precise_ns != 0) {
+        timer_spin_until(timer->precise_ns);
+      }
+      timer->callback(timer->arg);
+    }
+  }
+  return NULL;
+}
+
+/**
+ * \brief Start the timer thread.
+ */
+void start_timers() {
+  pthread_t thread;
+
+  if ((timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC)) == -1) {
+    log_msg(LOG_MOD_TIMER, LOG_ERR, "timerfd_create: %m");
+    flush_log();
+    exit (EXIT_FAILURE);
+  }
+  if ((timer_wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) == -1) {
+    log_msg(LOG_MOD_TIMER, LOG_ERR, "eventfd: %m");
+    flush_log();
+    exit (EXIT_FAILURE);
+  }
+  timer_tick = get_monotonic_ns() / TIMER_TICK_NS;
+  if ((errno = pthread_create(&thread, NULL, timer_thread, NULL)) != 0) {
+    log_msg(LOG_MOD_TIMER, LOG_ERR, "pthread_create: %m");
+    flush_log();
+    exit (EXIT_FAILURE);
+  }
+  pthread_detach(thread);
+}
+
+void timer_init(Timer *timer, TimerCallback callback, void *arg) {
+  timer->expires_ns = 0;
+  timer->precise_ns = 0;
+  timer->callback   = callback;
+  timer->arg        = arg;
+  timer->armed      = 0;
+  timer->slot       = NULL;
+  timer->next       = NULL;
+  timer->prev       = NULL;
+  timer->due        = NULL;
+}
+
+/**
+ * Arm the timer. timer_lock must be held.
+ *
+ * @param soon 1 to put the timer on the list of the next wakeup instead of
+ *             the wheel.
+ */
+static void timer_arm(Timer *timer, unsigned long long expires_ns, int soon) {
+  if (timer->armed) {
+    timer_unlink(timer);
+    timer_count--;
+  }
+  // An idle wheel has no timers, it starts again at the current tick.
+  if (timer_count == 0) {
+    timer_tick = get_monotonic_ns() / TIMER_TICK_NS;
+  }
+  timer->expires_ns = expires_ns;
+  timer->armed      = 1;
+  if (soon) {
+    timer->slot = &timer_soon;
+    timer->prev = NULL;
+    timer->next = timer_soon;
+    if (timer->next != NULL) {
+      timer->next->prev = timer;
+    }
+    timer_soon = timer;
+  } else {
+    timer_link(timer);
+  }
+  if (timer_count++ == 0) {
+    timer_set_tick(1);
+  }
+}
+
+/**
+ * \brief Arm the timer, an armed timer is moved.
+ *
+ * The timer expires with the tick of the expiry time.
+ *
+ * @param timer      The timer.
+ * @param expires_ns Monotonic expiry time.
+ */
+void timer_add(Timer *timer, unsigned long long expires_ns) {
+  pthread_mutex_lock(&timer_lock);
+  timer->precise_ns = 0;
+  timer_arm(timer, expires_ns, 0);
+  pthread_mutex_unlock(&timer_lock);
+}
+
+/**
+ * \brief Arm the timer for an exact deadline.
+ *
+ * The timer expires one tick before the deadline and the timer thread
+ * spins until the deadline. A deadline closer than one tick wakes the
+ * timer thread at once, it spins there and not on the caller thread.
+ *
+ * @param timer       The timer.
+ * @param deadline_ns Monotonic deadline.
+ */
+void timer_add_precise(Timer *timer, unsigned long long deadline_ns) {
+  uint64_t wake = 1;
+  int soon = deadline_ns < get_monotonic_ns() + TIMER_TICK_NS;
+
+  pthread_mutex_lock(&timer_lock);
+  timer->precise_ns = deadline_ns;
+  timer_arm(timer, deadline_ns - TIMER_TICK_NS, soon);
+  pthread_mutex_unlock(&timer_lock);
+  if (soon && write(timer_wake_fd, &wake, sizeof(wake)) != sizeof(wake)) {
+    log_msg(LOG_MOD_TIMER, LOG_ERR, "eventfd write: %m");
+  }
+}
+
+/**
+ * \brief Disarm the timer.
+ *
+ * The callback may still run if the timer expired just before.
+ *
+ * @param timer The timer.
+ */
+void timer_cancel(Timer *timer) {
+  pthread_mutex_lock(&timer_lock);
+  if (timer->armed) {
+    timer_unlink(timer);
+    timer->armed = 0;
+    timer_count--;
+  }
+  pthread_mutex_unlock(&timer_lock);
+}
@@ -0,0 +1,58 @@
+/*
+ * timer.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef TIMER_H_
+#define TIMER_H_
+
+/**
+ * \brief Count of slots of the first level of the timer wheel.
+ *
+ * The first level holds the timers due in the next 256 ticks, every
+ * higher level holds 64 slots of the level below.
+ */
+#define TIMER_WHEEL_BITS  8
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_LEVEL_BITS  6
+#define TIMER_LEVEL_SLOTS (1 << TIMER_LEVEL_BITS)
+#define TIMER_LEVELS      3
+
+/**
+ * \brief Tick of the timer wheel in nanoseconds.
+ */
+#define TIMER_TICK_NS 1000000ULL
+
+/**
+ * \brief Callback of an expired timer.
+ *
+ * Called by the timer thread without a lock held.
+ *
+ * @param arg The argument given to timer_init.
+ */
+typedef void (*TimerCallback)(void *arg);
+
+/**
+ * \brief A timer, owned and allocated by the caller.
+ */
+typedef struct Timer {
+  unsigned long long expires_ns; //> Monotonic expiry time in the wheel.
+  unsigned long long precise_ns; //> Deadline of a precise timer or 0.
+  TimerCallback callback;
+  void *arg;
+  int armed;                     //> 1 while the timer is in the wheel.
+  struct Timer **slot;           //> Slot list of the armed timer.
+  struct Timer *next;
+  struct Timer *prev;
+  struct Timer *due;             //> Next timer in the expired list of the timer thread.
+} Timer;
+
+void start_timers();
+void timer_init(Timer *timer, TimerCallback callback, void *arg);
+void timer_add(Timer *timer, unsigned long long expires_ns);
+void timer_add_precise(Timer *timer, unsigned long long deadline_ns);
+void timer_cancel(Timer *timer);
+unsigned long long timer_spin_until(unsigned long long deadline_ns);
+
+#endif /* TIMER_H_ */
@@ -0,0 +1,291 @@
+/*
+ * trace.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <sys/syscall.h>
+#include "gpiod.h"
+#include "trace.h"
+
+/**
+ * \brief Name, category and argument name of a span type in the trace.
+ */
+typedef struct TraceTypeInfo {
+  const char *name;
+  const char *category;
+  const char *arg_name;  //> NULL if the span has no argument.
+  int async;             //> 1 for waits, they overlap the spans of their thread.
+} TraceTypeInfo;
+
+static const TraceTypeInfo trace_types[TRACE_TYPE_COUNT] = {
+  { "accept",         "client", "fd",      0 },
+  { "read",           "client", "fd",      0 },
+  { "parse",          "client", "fd",      0 },
+  { "dispatch",       "queue",  "class",   1 },
+  { "command",        "client", "fd",      0 },
+  { "backend",        "gpio",   "pin",     0 },
+  { "lcd render",     "lcd",    "widgets", 0 },
+  { "spi flush",      "lcd",    NULL,      0 },
+  { "event enqueue",  "event",  NULL,      0 },
+  { "event dequeue",  "event",  NULL,      1 },
+  { "event delivery", "event",  NULL,      0 },
+  { "event flush",    "event",  "events",  0 }
+};
+
+int trace_enabled = 0;
+static TraceSpan trace_ring[TRACE_RING_SIZE];
+static unsigned long trace_head  = 0;  /**< count of spans since the daemon start */
+static unsigned long trace_first = 0;  /**< trace_head at the last TRACE ON */
+static char *trace_file_name = TRACE_FILE;
+static __thread int trace_tid = 0;
+
+static struct {
+  int tid;
+  const char *name;
+} trace_threads[TRACE_MAX_THREADS];
+static int trace_threads_count = 0;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * \brief Set the file of TRACE DUMP and of the dump after SIGUSR1.
+ *
+ * @param file_name The file name.
+ */
+void set_trace_file(char *file_name) {
+  trace_file_name = file_name;
+}
+
+/**
+ * Thread id of the current thread, cached per thread.
+ */
+static int get_trace_tid() {
+  if (trace_tid == 0) {
+    trace_tid = (int) syscall(SYS_gettid);
+  }
+  return trace_tid;
+}
+
+/**
+ * \brief Record a finished span.
+ *
+ * Lock free, so isr threads never wait for a dump. A writer claims a slot
+ * with an atomic increment and publishes it with the sequence number, a
+ * slot read while it is written is skipped by the dump.
+ *
+ * @param type     The kind of the span.
+ * @param start_ns Monotonic start time.
+ * @param arg      The argument of the span.
+ */
+void trace_record(TraceType type, unsigned long long start_ns, int arg) {
+  unsigned long long end_ns = get_monotonic_ns();
+  unsigned long seq = __atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED);
+  TraceSpan *span = &trace_ring[seq & (TRACE_RING_SIZE - 1)];
+
+  __atomic_store_n(&span->seq, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  span->start_ns = start_ns;
+  span->dur_ns   = end_ns - start_ns;
+  span->tid      = get_trace_tid();
+  span->type     = type;
+  span->arg      = arg;
+  __atomic_store_n(&span->seq, seq + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * \brief Name the current thread in the trace.
+ *
+ * @param name The thread name, a string constant.
+ */
+void trace_name_thread(const char *name) {
+  pthread_mutex_lock(&trace_lock);
+  if (trace_threads_count < TRACE_MAX_THREADS) {
+    trace_threads[trace_threads_count].tid  = get_trace_tid();
+    trace_threads[trace_threads_count].name = name;
+    trace_threads_count++;
+  }
+  pthread_mutex_unlock(&trace_lock);
+}
+
+/**
+ * \brief Start a new trace, the spans of an earlier trace are dropped.
+ */
+void trace_start() {
+  trace_first = __atomic_load_n(&trace_head, __ATOMIC_RELAXED);
+  __atomic_store_n(&trace_enabled, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * \brief Stop the trace, the spans stay in the ring for a dump.
+ */
+void trace_stop() {
+  __atomic_store_n(&trace_enabled, 0, __ATOMIC_RELAXED);
+}
+
+/**
+ * Count of spans of the trace in the ring.
+ */
+static unsigned long trace_span_count(unsigned long head) {
+  return head - trace_first < TRACE_RING_SIZE ? head - trace_first : TRACE_RING_SIZE;
+}
+
+/**
+ * Write a time in nanoseconds as microseconds of the trace format.
+ */
+static void write_trace_us(FILE *file, const char *key, unsigned long long ns) {
+  fprintf(file, ",\"%s\":%llu.%03llu", key, ns / 1000, ns % 1000);
+}
+
+/**
+ * Write a span as one or two trace events.
+ */
+static void write_trace_span(FILE *file, int pid, unsigned long seq, TraceSpan *span) {
+  const TraceTypeInfo *info = &trace_types[span->type];
+
+  fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%s\",\"pid\":%d,\"tid\":%d",
+      info->name, info->category, info->async ? "b" : "X", pid, span->tid);
+  if (info->async) {
+    fprintf(file, ",\"id\":%lu", seq);
+  }
+  write_trace_us(file, "ts", span->start_ns);
+  if (!info->async) {
+    write_trace_us(file, "dur", span->dur_ns);
+  }
+  if (info->arg_name != NULL) {
+    fprintf(file, ",\"args\":{\"%s\":%d}", info->arg_name, span->arg);
+  }
+  fprintf(file, "}");
+  if (info->async) {
+    fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"e\",\"pid\":%d,\"tid\":%d,\"id\":%lu",
+        info->name, info->category, pid, span->tid, seq);
+    write_trace_us(file, "ts", span->start_ns + span->dur_ns);
+    fprintf(file, "}");
+  }
+}
+
+/**
+ * \brief Write the spans of the trace as Chrome trace event JSON.
+ *
+ * The trace keeps running, spans written during the dump are skipped.
+ *
+ * @param file_name The file to write.
+ *
+ * @return Count of written spans or -1 on error.
+ */
+int trace_dump(const char *file_name) {
+  unsigned long head = __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE), seq;
+  int pid = getpid(), written = 0, i;
+  TraceSpan span;
+  FILE *file;
+
+  if ((file = fopen(file_name, "w")) == NULL) {
+    return -1;
+  }
+  fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"gpiod\"}}", pid);
+  pthread_mutex_lock(&trace_lock);
+  for (i = 0; i < trace_threads_count; i++) {
+    fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+        pid, trace_threads[i].tid, trace_threads[i].name);
+  }
+  pthread_mutex_unlock(&trace_lock);
+  for (seq = head - trace_span_count(head); seq < head; seq++) {
+    TraceSpan *slot = &trace_ring[seq & (TRACE_RING_SIZE - 1)];
+
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != seq + 1) {
+      continue;
+    }
+    span = *slot;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq + 1 || span.type >= TRACE_TYPE_COUNT) {
+      continue;
+    }
+    write_trace_span(file, pid, seq, &span);
+    written++;
+  }
+  fprintf(file, "\n]}\n");
+  if (fclose(file) != 0) {
+    return -1;
+  }
+  return written;
+}
+
+/**
+ * \brief Start or stop the trace on SIGUSR1.
+ *
+ * A stopped trace is written to the trace file.
+ */
+void trace_toggle() {
+  int written;
+
+  if (!__atomic_load_n(&trace_enabled, __ATOMIC_RELAXED)) {
+    trace_start();
+    return;
+  }
+  trace_stop();
+  if ((written = trace_dump(trace_file_name)) == -1) {
+    log_msg(LOG_MOD_DAEMON, LOG_ERR, "%s: %m", trace_file_name);
+  } else {
+    log_msg(LOG_MOD_DAEMON, LOG_INFO, "trace: %d spans written to %s", written, trace_file_name);
+  }
+}
+
+/**
+ * Write the state of the trace.
+ */
+static void write_trace_status(int client_socket_fd) {
+  char msg[BUFFER_SIZE];
+
+  snprintf(msg, BUFFER_SIZE, "trace %s, %lu spans, ring %d",
+      __atomic_load_n(&trace_enabled, __ATOMIC_RELAXED) ? "on" : "off",
+      trace_span_count(__atomic_load_n(&trace_head, __ATOMIC_RELAXED)), TRACE_RING_SIZE);
+  write_msg_to_client(client_socket_fd, msg);
+}
+
+/**
+ * \brief Control the trace.
+ *
+ * TRACE shows the state, TRACE ON starts a new trace, TRACE OFF stops it
+ * and TRACE DUMP writes the ring as Chrome trace JSON to the trace file.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ * @param buf              The command arguments.
+ */
+void do_trace(int client_socket_fd, char *buf) {
+  char mode[16], msg[BUFFER_SIZE];
+  int written;
+
+  if (sscanf(buf, "%15s", mode) != 1) {
+    write_trace_status(client_socket_fd);
+  } else if (strcmp(mode, "ON") == 0) {
+    trace_start();
+    write_trace_status(client_socket_fd);
+  } else if (strcmp(mode, "OFF") == 0) {
+    trace_stop();
+    write_trace_status(client_socket_fd);
+  } else if (strcmp(mode, "DUMP") == 0) {
+    if ((written = trace_dump(trace_file_name)) == -1) {
+      write_error_msg_to_client(client_socket_fd, "unable to write trace file");
+    } else {
+      snprintf(msg, BUFFER_SIZE, "%d spans written to %s", written, trace_file_name);
+      write_msg_to_client(client_socket_fd, msg);
+    }
+  } else {
+    write_error_msg_to_client(client_socket_fd, "expected TRACE [ON|OFF|DUMP]");
+  }
+}
+
+/**
+ * \brief Write the trace statistics.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ */
+void do_write_trace_stats(int client_socket_fd) {
+  char msg[BUFFER_SIZE];
+  unsigned long head = __atomic_load_n(&trace_head, __ATOMIC_RELAXED);
+
+  snprintf(msg, BUFFER_SIZE, "trace: %s, %lu spans recorded, %lu overwritten",
+      __atomic_load_n(&trace_enabled, __ATOMIC_RELAXED) ? "on" : "off",
+      head - trace_first, head - trace_first - trace_span_count(head));
+  write_msg_to_client(client_socket_fd, msg);
+}
@@ -0,0 +1,102 @@
+/*
+ * trace.h
+ *
+ *  Created on: 19.10.2026
+ *
+ * Ring of timed spans of the command and event lifecycles.
+ *
+ * Tracing is off by default and switched with TRACE ON|OFF or SIGUSR1. A
+ * disabled span costs one load of the enabled flag. The ring is written as
+ * Chrome trace event JSON, readable by chrome://tracing and Perfetto.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+/**
+ * \brief Count of spans in the ring, a power of two.
+ *
+ * The ring keeps the newest spans, older spans are overwritten.
+ */
+#define TRACE_RING_SIZE 16384
+
+/**
+ * \brief Count of named threads in the trace.
+ */
+#define TRACE_MAX_THREADS 16
+
+/**
+ * \brief Default file of TRACE DUMP and of the dump after SIGUSR1.
+ *
+ * Clients can't choose the file, the daemon may run as root.
+ */
+#define TRACE_FILE "/tmp/gpiod-trace.json"
+
+#define CLIENT_TRACE "TRACE"
+
+typedef enum TraceType {
+  TRACE_ACCEPT = 0,      //> Accept of a client, arg is the socket.
+  TRACE_READ,            //> Read of client input, arg is the socket.
+  TRACE_PARSE,           //> Tag and class of a command line, arg is the socket.
+  TRACE_DISPATCH,        //> Wait of a command in its queue, arg is the class.
+  TRACE_COMMAND,         //> Execution of a command, arg is the socket.
+  TRACE_BACKEND,         //> Call of the gpio backend, arg is the pin or -1 for a bank.
+  TRACE_LCD_RENDER,      //> Widgets and framebuffer pushed into the library, arg is the count of drawn widgets.
+  TRACE_SPI_FLUSH,       //> Write of the screen to the display, no arg.
+  TRACE_EVENT_ENQUEUE,   //> Event queued by an isr thread, no arg.
+  TRACE_EVENT_DEQUEUE,   //> Wait of an event in the event queue, no arg.
+  TRACE_EVENT_DELIVERY,  //> Event added to the batches of the clients, no arg.
+  TRACE_EVENT_FLUSH,     //> Batch written to a client, arg is the count of events.
+  TRACE_TYPE_COUNT
+} TraceType;
+
+/**
+ * \brief A finished span.
+ */
+typedef struct TraceSpan {
+  unsigned long seq;            //> Position + 1 in the trace, 0 while the span is written.
+  unsigned long long start_ns;  //> Monotonic start time.
+  unsigned long long dur_ns;
+  int tid;                      //> Thread id of the thread of the span.
+  int type;                     //> TraceType
+  int arg;
+} TraceSpan;
+
+extern int trace_enabled;
+
+unsigned long long get_monotonic_ns();
+
+/**
+ * \brief Start time of a span.
+ *
+ * @return Monotonic time or 0 if tracing is off.
+ */
+static inline unsigned long long trace_begin(void) {
+  return __atomic_load_n(&trace_enabled, __ATOMIC_RELAXED) ? get_monotonic_ns() : 0;
+}
+
+void trace_record(TraceType type, unsigned long long start_ns, int arg);
+
+/**
+ * \brief End a span started with trace_begin.
+ *
+ * @param type     The kind of the span.
+ * @param start_ns The result of trace_begin, nothing is recorded for 0.
+ * @param arg      The argument of the span, see TraceType.
+ */
+static inline void trace_end(TraceType type, unsigned long long start_ns, int arg) {
+  if (start_ns != 0) {
+    trace_record(type, start_ns, arg);
+  }
+}
+
+void set_trace_file(char *file_name);
+void trace_name_thread(const char *name);
+void trace_start();
+void trace_stop();
+int trace_dump(const char *file_name);
+void trace_toggle();
+void do_trace(int client_socket_fd, char *buf);
+void do_write_trace_stats(int client_socket_fd);
+
+#endif /* TRACE_H_ */
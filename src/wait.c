@@ -0,0 +1,349 @@
+/*
+ * wait.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "gpiod.h"
+#include "wait.h"
+
+typedef enum WaitMode {
+  WAIT_LEVEL = 0, //> Wait until the pin has the level.
+  WAIT_EDGE       //> Wait for a change of any pin of the mask.
+} WaitMode;
+
+/**
+ * \brief A parked WAIT or WAITANY command.
+ */
+typedef struct Wait {
+  Timer timer;                   //> Timeout timer.
+  int active;                    //> 1 while the wait is parked.
+  int client_socket_fd;          //> Socket for the answer.
+  char tag[REPLY_TAG_SIZE];      //> Tag of the command.
+  WaitMode mode;
+  unsigned int mask;             //> Pins of the wait.
+  int level;                     //> Level of a WAIT_LEVEL.
+  unsigned int levels;           //> Levels of the pins when the wait was parked.
+  unsigned long long deadline_ns; //> Timeout or 0.
+} Wait;
+
+/**
+ * \brief Answer of a completed wait, written without a lock held.
+ */
+typedef struct WaitDone {
+  int client_socket_fd;
+  char tag[REPLY_TAG_SIZE];
+  int pin;                       //> Pin of the completion or -1 on timeout.
+  int level;
+  unsigned long long timestamp_ns;
+} WaitDone;
+
+static Wait waits[MAX_WAITS];
+static int waits_count = 0;               /**< count of parked waits */
+static unsigned long waits_completed = 0;
+static unsigned long waits_timed_out = 0;
+static Timer sample_timer;
+static int sample_timer_init = 0;
+static pthread_mutex_t wait_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Write the answers of completed waits.
+ */
+static void write_wait_done(WaitDone *done, int count) {
+  char msg[BUFFER_SIZE];
+  int i;
+
+  for (i = 0; i < count; i++) {
+    set_reply_tag(done[i].tag);
+    if (done[i].pin == -1) {
+      write_error_msg_to_client(done[i].client_socket_fd, "wait timeout");
+    } else {
+      snprintf(msg, BUFFER_SIZE, "pin %d level %d at %llu", done[i].pin, done[i].level, done[i].timestamp_ns);
+      write_msg_to_client(done[i].client_socket_fd, msg);
+    }
+    set_reply_tag(NULL);
+    release_client(done[i].client_socket_fd);
+  }
+}
+
+/**
+ * Unpark a wait. wait_lock must be held.
+ */
+static void wait_complete(Wait *wait, WaitDone *done, int pin, int level, unsigned long long timestamp_ns) {
+  wait->active = 0;
+  waits_count--;
+  if (wait->deadline_ns != 0) {
+    timer_cancel(&wait->timer);
+  }
+  done->client_socket_fd = wait->client_socket_fd;
+  memcpy(done->tag, wait->tag, REPLY_TAG_SIZE);
+  done->pin              = pin;
+  done->level            = level;
+  done->timestamp_ns     = timestamp_ns;
+}
+
+/**
+ * Check a wait against a change of a pin. wait_lock must be held.
+ *
+ * @return 1 if the wait is completed.
+ */
+static int wait_matches(Wait *wait, int pin, int level) {
+  if (!wait->active || !(wait->mask & (1U << pin))) {
+    return 0;
+  }
+  return wait->mode == WAIT_EDGE || wait->level == level;
+}
+
+/**
+ * \brief Complete the waits of an edge.
+ *
+ * Called in the edge callback of the interrupts.
+ *
+ * @param pin          The pin.
+ * @param level        The level after the edge.
+ * @param timestamp_ns Monotonic time of the edge.
+ */
+void wait_notify_edge(int pin, int level, unsigned long long timestamp_ns) {
+  WaitDone done[MAX_WAITS];
+  int i, count = 0;
+
+  pthread_mutex_lock(&wait_lock);
+  if (waits_count > 0) {
+    for (i = 0; i < MAX_WAITS; i++) {
+      if (wait_matches(&waits[i], pin, level)) {
+        wait_complete(&waits[i], &done[count++], pin, level, timestamp_ns);
+      }
+    }
+    waits_completed += count;
+  }
+  pthread_mutex_unlock(&wait_lock);
+
+  write_wait_done(done, count);
+}
+
+/**
+ * \brief Timer callback of the pin sampling.
+ *
+ * Completes the waits of pins without interrupt. The timer runs only while
+ * a wait is parked.
+ *
+ * @param arg unused
+ */
+void wait_sample(void *arg) {
+  WaitDone done[MAX_WAITS];
+  unsigned int levels = gpio_read_bank(), changed;
+  unsigned long long now = get_monotonic_ns();
+  int i, pin, count = 0;
+
+  pthread_mutex_lock(&wait_lock);
+  for (i = 0; i < MAX_WAITS; i++) {
+    if (!waits[i].active) {
+      continue;
+    }
+    changed = (levels ^ waits[i].levels) & waits[i].mask;
+    for (pin = 0; changed != 0 && pin < NUM_PINS; pin++) {
+      if ((changed & (1U << pin)) && wait_matches(&waits[i], pin, (levels >> pin) & 1)) {
+        wait_complete(&waits[i], &done[count++], pin, (levels >> pin) & 1, now);
+        break;
+      }
+    }
+    if (waits[i].active) {
+      waits[i].levels = levels;
+    }
+  }
+  waits_completed += count;
+  if (waits_count > 0) {
+    timer_add(&sample_timer, now + WAIT_SAMPLE_MS * 1000000ULL);
+  }
+  pthread_mutex_unlock(&wait_lock);
+
+  write_wait_done(done, count);
+}
+
+/**
+ * \brief Timer callback of a wait timeout.
+ *
+ * @param arg The wait.
+ */
+void wait_timeout(void *arg) {
+  Wait *wait = (Wait *) arg;
+  WaitDone done;
+  int count = 0;
+
+  pthread_mutex_lock(&wait_lock);
+  // The slot may be used by a later wait after the timer expired.
+  if (wait->active && wait->deadline_ns != 0) {
+    if (wait->deadline_ns <= get_monotonic_ns()) {
+      wait_complete(wait, &done, -1, 0, 0);
+      waits_timed_out++;
+      count = 1;
+    } else {
+      // The tick of the deadline starts before the deadline.
+      timer_add(&wait->timer, wait->deadline_ns);
+    }
+  }
+  pthread_mutex_unlock(&wait_lock);
+
+  write_wait_done(&done, count);
+}
+
+/**
+ * Park a wait. A wait already completed by the current levels is answered
+ * at once.
+ */
+static void park_wait(int client_socket_fd, WaitMode mode, unsigned int mask, int level, unsigned long timeout_ms) {
+  unsigned int levels = gpio_read_bank();
+  unsigned long long now = get_monotonic_ns();
+  char msg[BUFFER_SIZE];
+  Wait *wait = NULL;
+  int i, pin;
+
+  if (mode == WAIT_LEVEL) {
+    for (pin = 0; !(mask & (1U << pin)); pin++);
+    if (((levels >> pin) & 1) == level) {
+      snprintf(msg, BUFFER_SIZE, "pin %d level %d at %llu", pin, level, now);
+      write_msg_to_client(client_socket_fd, msg);
+      return;
+    }
+  }
+
+  pthread_mutex_lock(&wait_lock);
+  for (i = 0; i < MAX_WAITS; i++) {
+    if (!waits[i].active) {
+      wait = &waits[i];
+      break;
+    }
+  }
+  if (wait == NULL) {
+    pthread_mutex_unlock(&wait_lock);
+    write_error_msg_to_client(client_socket_fd, "too many waits");
+    return;
+  }
+  if (wait->timer.callback == NULL) {
+    timer_init(&wait->timer, wait_timeout, wait);
+  }
+  if (!sample_timer_init) {
+    timer_init(&sample_timer, wait_sample, NULL);
+    sample_timer_init = 1;
+  }
+  hold_client(client_socket_fd);
+  defer_reply(wait->tag);
+  wait->active           = 1;
+  wait->client_socket_fd = client_socket_fd;
+  wait->mode             = mode;
+  wait->mask             = mask;
+  wait->level            = level;
+  wait->levels           = levels;
+  wait->deadline_ns      = timeout_ms > 0 ? now + timeout_ms * 1000000ULL : 0;
+  if (wait->deadline_ns != 0) {
+    timer_add(&wait->timer, wait->deadline_ns);
+  }
+  if (waits_count++ == 0) {
+    timer_add(&sample_timer, now + WAIT_SAMPLE_MS * 1000000ULL);
+  }
+  pthread_mutex_unlock(&wait_lock);
+}
+
+/**
+ * \brief Drop the waits of a closed client.
+ *
+ * @param client_socket_fd The socket of the client.
+ */
+void cancel_client_waits(int client_socket_fd) {
+  int i, released = 0;
+
+  pthread_mutex_lock(&wait_lock);
+  for (i = 0; i < MAX_WAITS; i++) {
+    if (waits[i].active && waits[i].client_socket_fd == client_socket_fd) {
+      waits[i].active = 0;
+      waits_count--;
+      if (waits[i].deadline_ns != 0) {
+        timer_cancel(&waits[i].timer);
+      }
+      released++;
+    }
+  }
+  pthread_mutex_unlock(&wait_lock);
+
+  while (released-- > 0) {
+    release_client(client_socket_fd);
+  }
+}
+
+/**
+ * \brief Wait for a level or an edge of a pin.
+ *
+ * WAIT pin 0|1|EDGE timeout_ms, the answer is the pin, the new level and
+ * the monotonic time of the change. A timeout of 0 waits without timeout.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ * @param buf              The command arguments.
+ */
+void do_wait(int client_socket_fd, char *buf) {
+  unsigned long timeout_ms;
+  int pin_num, level;
+  char args[BUFFER_SIZE], condition[8];
+  int n = sscanf(expand_pin_alias(buf, args, BUFFER_SIZE), "%d %7s %lu", &pin_num, condition, &timeout_ms);
+
+  if (n != 3) {
+    write_error_msg_to_client(client_socket_fd, "expected WAIT <#pin> <0|1|EDGE> <timeout_ms>");
+    return;
+  }
+  if (!is_valid_pin_num(pin_num)) {
+    write_error_msg_to_client(client_socket_fd, "unknown port number");
+  } else if (strcmp(condition, "0") != 0 && strcmp(condition, "1") != 0 && strcmp(condition, "EDGE") != 0) {
+    write_error_msg_to_client(client_socket_fd, "wait for 0, 1 or EDGE");
+  } else if (timeout_ms > WAIT_MAX_MS) {
+    write_error_msg_to_client(client_socket_fd, "time too long");
+  } else {
+    log_msg(LOG_MOD_GPIO, LOG_DEBUG, "EXECUTING %s PIN %d FOR %s TIMEOUT %lu ms", CLIENT_WAIT, pin_num, condition, timeout_ms);
+    level = atoi(condition);
+    park_wait(client_socket_fd, strcmp(condition, "EDGE") == 0 ? WAIT_EDGE : WAIT_LEVEL, 1U << pin_num, level, timeout_ms);
+  }
+}
+
+/**
+ * \brief Wait for an edge of any pin of a mask.
+ *
+ * WAITANY mask [timeout_ms], the mask is decimal or 0x hex with bit n for
+ * pin n.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ * @param buf              The command arguments.
+ */
+void do_wait_any(int client_socket_fd, char *buf) {
+  unsigned long mask, timeout_ms = 0;
+  char *end;
+
+  mask = strtoul(buf, &end, 0);
+  if (end == buf || (*end != '\0' && sscanf(end, " %lu", &timeout_ms) != 1)) {
+    write_error_msg_to_client(client_socket_fd, "expected WAITANY <mask> [timeout_ms]");
+  } else if (mask == 0 || mask >> NUM_PINS) {
+    write_error_msg_to_client(client_socket_fd, "mask of unknown port numbers");
+  } else if (timeout_ms > WAIT_MAX_MS) {
+    write_error_msg_to_client(client_socket_fd, "time too long");
+  } else {
+    log_msg(LOG_MOD_GPIO, LOG_DEBUG, "EXECUTING %s MASK 0x%lx TIMEOUT %lu ms", CLIENT_WAITANY, mask, timeout_ms);
+    park_wait(client_socket_fd, WAIT_EDGE, mask, 0, timeout_ms);
+  }
+}
+
+/**
+ * \brief Write the wait statistics.
+ *
+ * @param client_socket_fd The socket file descriptor.
+ */
+void do_write_wait_stats(int client_socket_fd) {
+  char msg[BUFFER_SIZE];
+  unsigned long completed, timed_out;
+  int count;
+
+  pthread_mutex_lock(&wait_lock);
+  count     = waits_count;
+  completed = waits_completed;
+  timed_out = waits_timed_out;
+  pthread_mutex_unlock(&wait_lock);
+
+  snprintf(msg, BUFFER_SIZE, "waits: %d parked, %lu completed, %lu timed out", count, completed, timed_out);
+  write_msg_to_client(client_socket_fd, msg);
+}
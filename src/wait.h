@@ -0,0 +1,37 @@
+/*
+ * wait.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef WAIT_H_
+#define WAIT_H_
+
+/**
+ * \brief Maximal count of parked WAIT and WAITANY commands.
+ */
+#define MAX_WAITS 64
+
+/**
+ * \brief Sample interval of the pins of parked waits in milliseconds.
+ *
+ * Pins with an interrupt complete a wait at once from the edge, other pins
+ * are sampled while a wait is parked.
+ */
+#define WAIT_SAMPLE_MS 1
+
+/**
+ * \brief Longest timeout of a wait in milliseconds.
+ */
+#define WAIT_MAX_MS 3600000UL
+
+#define CLIENT_WAIT    "WAIT"
+#define CLIENT_WAITANY "WAITANY"
+
+void wait_notify_edge(int pin, int level, unsigned long long timestamp_ns);
+void cancel_client_waits(int client_socket_fd);
+void do_wait(int client_socket_fd, char *buf);
+void do_wait_any(int client_socket_fd, char *buf);
+void do_write_wait_stats(int client_socket_fd);
+
+#endif /* WAIT_H_ */
@@ -0,0 +1,554 @@
+/*
+ * widget.c
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "gpiod.h"
+#include "fb.h"
+#include "widget.h"
+
+/**
+ * \brief Rectangle of a freed or moved widget, cleared with the next update.
+ */
+typedef struct WidgetArea {
+  int x1;
+  int y1;
+  int x2;
+  int y2;
+} WidgetArea;
+
+static Widget widgets[MAX_WIDGETS];
+static int widgets_count = 0;             /**< count of defined widgets */
+static unsigned int widget_pins = 0;      /**< pins of the defined widgets */
+static unsigned int widget_levels = 0;    /**< last known levels of all pins */
+static int widget_levels_valid = 0;
+static unsigned long widget_edges[NUM_PINS];
+static WidgetArea widget_erase[MAX_WIDGETS];
+static int widget_erase_count = 0;
+static int widget_interval_ms = WIDGET_INTERVAL_MS;
+static int widgets_started = 0;           /**< 1 after the timers are running */
+static int widget_flush_pending = 0;      /**< 1 while the update timer is armed */
+static int widget_sample_armed = 0;
+static unsigned long long widget_last_flush_ns = 0;
+static unsigned long widget_draws = 0;
+static unsigned long widget_updates = 0;
+static unsigned long widget_coalesced = 0;
+static Timer widget_flush_timer;
+static Timer widget_sample_timer;
+static pthread_mutex_t widget_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static char *widget_type_names[] = { "pin", "counter", "bar", "text" };
+static char *widget_commands[]   = { LCD_WIDGET_PIN, LCD_WIDGET_COUNTER, LCD_WIDGET_BAR, LCD_WIDGET_TEXT };
+
+/**
+ * \brief Parse the type of a config widget.
+ *
+ * @param type pin, counter, bar or text.
+ *
+ * @return The WidgetType or -1.
+ */
+int parse_widget_type(const char *type) {
+  int i;
+
+  for (i = 0; i <= WIDGET_TEXT; i++) {
+    if (strcmp(type, widget_type_names[i]) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * \brief Set the shortest time between two widget updates.
+ *
+ * @param interval_ms The interval, -1 keeps the interval.
+ */
+void set_widget_interval(int interval_ms) {
+  if (interval_ms >= 1 && interval_ms <= WIDGET_INTERVAL_MAX_MS) {
+    widget_interval_ms = interval_ms;
+  }
+}
+
+/**
+ * \brief Check the geometry of a widget.
+ *
+ * @param widget The widget, height of counter and text is set.
+ *
+ * @return NULL or the error message.
+ */
+char *check_widget(Widget *widget) {
+  if (!is_valid_pin_num(widget->pin)) {
+    return "unknown port number";
+  }
+  if (widget->type == WIDGET_COUNTER || widget->type == WIDGET_TEXT) {
+    widget->height = FB_CHAR_HEIGHT;
+  }
+  if (widget->x < 0 || widget->y < 0 || widget->width < 1 || widget->height < 1
+      || widget->x + widget->width > FB_WIDTH || widget->y + widget->height > FB_HEIGHT) {
+    return "widget must fit into 128x64";
+  }
+  if ((widget->type == WIDGET_PIN && (widget->width < 3 || widget->height < 3))
+      || (widget->type == WIDGET_BAR && (widget->width < 5 || widget->height < 5))) {
+    return "widget too small";
+  }
+  if (widget->type == WIDGET_BAR && widget->max < 1) {
+    return "bar max must be at least 1";
+  }
+  return NULL;
+}
+
+/**
+ * Arm the update timer. widget_lock must be held.
+ *
+ * The update is due one interval after the last update, changes until then
+ * are drawn with the same update.
+ */
+static void request_widget_flush(unsigned long long now) {
+  unsigned long long due = widget_last_flush_ns + widget_interval_ms * 1000000ULL;
+
+  if (!widgets_started) {
+    return;
+  }
+  if (widget_flush_pending) {
+    widget_coalesced++;
+    return;
+  }
+  widget_flush_pending = 1;
+  timer_add(&widget_flush_timer, due > now ? due : now);
+}
+
+/**
+ * Arm the sampling of the widget pins. widget_lock must be held.
+ */
+static void arm_widget_sample(unsigned long long now) {
+  if (widgets_started && !widget_sample_armed && widgets_count > 0) {
+    widget_sample_armed = 1;
+    timer_add(&widget_sample_timer, now + widget_interval_ms * 1000000ULL);
+  }
+}
+
+/**
+ * Mark the widgets of a pin for drawing. widget_lock must be held.
+ *
+ * @return Count of marked widgets.
+ */
+static int mark_pin_widgets(int pin) {
+  int i, count = 0;
+
+  for (i = 0; i < MAX_WIDGETS; i++) {
+    if (widgets[i].defined && widgets[i].pin == pin) {
+      widgets[i].dirty = 1;
+      count++;
+    }
+  }
+  return count;
+}
+
+/**
+ * Remember the area of a widget to clear it. widget_lock must be held.
+ */
+static void erase_widget(Widget *widget) {
+  WidgetArea *area;
+
+  if (!widget->defined || widget_erase_count == MAX_WIDGETS) {
+    return;
+  }
+  area = &widget_erase[widget_erase_count++];
+  area->x1 = widget->x;
+  area->y1 = widget->y;
+  area->x2 = widget->x + widget->width - 1;
+  area->y2 = widget->y + widget->height - 1;
+}
+
+/**
+ * Count the widgets and collect their pins. widget_lock must be held.
+ */
+static void update_widget_pins() {
+  int i;
+
+  widgets_count = 0;
+  widget_pins   = 0;
+  for (i = 0; i < MAX_WIDGETS; i++) {
+    if (widgets[i].defined) {
+      widgets_count++;
+      widget_pins |= 1U << widgets[i].pin;
+    }
+  }
+}
+
+/**
+ * Define or replace a widget. widget_lock must be held.
+ */
+static void put_widget(int id, Widget *widget) {
+  erase_widget(&widgets[id]);
+  widgets[id]         = *widget;
+  widgets[id].defined = 1;
+  widgets[id].dirty   = 1;
+  widgets[id].base    = widget_edges[widget->pin];
+}
+
+/**
+ * \brief Replace all widgets with the widgets of the config file.
+ *
+ * The widget ids are the positions in the list.
+ *
+ * @param list  The widgets.
+ * @param count Count of widgets.
+ */
+void set_widgets(Widget *list, int count) {
+  unsigned long long now = get_monotonic_ns();
+  int i;
+
+  pthread_mutex_lock(&widget_lock);
+  for (i = 0; i < MAX_WIDGETS; i++) {
+    erase_widget(&widgets[i]);
+    widgets[i].defined = 0;
+  }
+  for (i = 0; i < count && i < MAX_WIDGETS; i++) {
+    put_widget(i, &list[i]);
+  }
+  update_widget_pins();
+  arm_widget_sample(now);
+  request_widget_flush(now);
+  pthread_mutex_unlock(&widget_lock);
+}
+
+/**
+ * \brief Timer callback of the widget update.
+ *
+ * The drawing is done by the lcd worker, so it is never mixed with an lcd
+ * command.
+ *
+ * @param arg unused
+ */
+void widget_flush_due(void *arg) {
+  pthread_mutex_lock(&widget_lock);
+  widget_flush_pending = 0;
+  widget_last_flush_ns = get_monotonic_ns();
+  pthread_mutex_unlock(&widget_lock);
+
+  schedule_lcd_call(lcd_flush_widgets);
+}
+
+/**
+ * \brief Timer callback of the pin sampling.
+ *
+ * Pins without interrupt change without an edge callback, so the widget
+ * pins are sampled while widgets are defined. A changed level counts as
+ * edge, an edge already reported by the interrupt is not counted twice.
+ *
+ * @param arg unused
+ */
+void widget_sample(void *arg) {
+  unsigned int levels = gpio_read_bank(), changed;
+  unsigned long long now = get_monotonic_ns();
+  int pin, marked = 0;
+
+  pthread_mutex_lock(&widget_lock);
+  changed = (levels ^ widget_levels) & widget_pins;
+  for (pin = 0; changed != 0 && pin < NUM_PINS; pin++) {
+    if (changed & (1U << pin)) {
+      // The first sample only sets the levels.
+      widget_edges[pin] += widget_levels_valid;
+      marked += mark_pin_widgets(pin);
+    }
+  }
+  widget_levels       = levels;
+  widget_levels_valid = 1;
+  if (marked > 0) {
+    request_widget_flush(now);
+  }
+  widget_sample_armed = 0;
+  arm_widget_sample(now);
+  pthread_mutex_unlock(&widget_lock);
+}
+
+/**
+ * \brief Start the timers of the widgets.
+ *
+ * Called after the timer thread is running.
+ */
+void start_widgets() {
+  unsigned long long now = get_monotonic_ns();
+
+  pthread_mutex_lock(&widget_lock);
+  timer_init(&widget_flush_timer, widget_flush_due, NULL);
+  timer_init(&widget_sample_timer, widget_sample, NULL);
+  widgets_started = 1;
+  if (widgets_count > 0) {
+    arm_widget_sample(now);
+    request_widget_flush(now);
+  }
+  pthread_mutex_unlock(&widget_lock);
+}
+
+/**
+ * \brief Count an edge for the widgets.
+ *
+ * Called in the edge callback of the interrupts. Only the widgets of the
+ * pin are drawn again.
+ *
+ * @param pin          The pin.
+ * @param level        The level after the edge.
+ * @param timestamp_ns Monotonic time of the edge.
+ */
+void widget_notify_edge(int pin, int level, unsigned long long timestamp_ns) {
+  if (pin < 0 || pin >= NUM_PINS) {
+    return;
+  }
+  pthread_mutex_lock(&widget_lock);
+  if (level) {
+    widget_levels |= 1U << pin;
+  } else {
+    widget_levels &= ~(1U << pin);
+  }
+  widget_edges[pin]++;
+  if ((widget_pins & (1U << pin)) && mark_pin_widgets(pin) > 0) {
+    request_widget_flush(timestamp_ns);
+  }
+  pthread_mutex_unlock(&widget_lock);
+}
+
+/**
+ * \brief Copy the edge counts of all pins.
+ *
+ * Read without the widget lock, so it can be called on exit.
+ *
+ * @param edges NUM_PINS counts.
+ */
+void get_widget_edges(uint64_t *edges) {
+  int pin;
+
+  for (pin = 0; pin < NUM_PINS; pin++) {
+    edges[pin] = __atomic_load_n(&widget_edges[pin], __ATOMIC_RELAXED);
+  }
+}
+
+/**
+ * \brief Set the edge counts of all pins, before the widgets are started.
+ *
+ * @param edges NUM_PINS counts.
+ */
+void set_widget_edges(const uint64_t *edges) {
+  int pin;
+
+  pthread_mutex_lock(&widget_lock);
+  for (pin = 0; pin < NUM_PINS; pin++) {
+    widget_edges[pin] = edges[pin];
+  }
+  pthread_mutex_unlock(&widget_lock);
+}
+
+/**
+ * \brief Draw all widgets again with the next update.
+ *
+ * Called by the lcd worker after the framebuffer was cleared or inverted.
+ */
+void invalidate_widgets() {
+  int i;
+
+  pthread_mutex_lock(&widget_lock);
+  for (i = 0; i < MAX_WIDGETS; i++) {
+    widgets[i].dirty = widgets[i].defined;
+  }
+  pthread_mutex_unlock(&widget_lock);
+}
+
+/**
+ * Draw a widget into the framebuffer, only its own rectangle is changed.
+ */
+static void draw_widget(Widget *widget, int level, unsigned long count) {
+  int x2 = widget->x + widget->width - 1, y2 = widget->y + widget->height - 1, inset, fill;
+  char text[24];
+
+  fb_fill(widget->x, widget->y, x2, y2, 0);
+  switch (widget->type) {
+    case WIDGET_PIN:
+      fb_frame(widget->x, widget->y, x2, y2, 1);
+      inset = widget->width >= 6 && widget->height >= 6 ? 2 : 1;
+      if (level) {
+        fb_fill(widget->x + inset, widget->y + inset, x2 - inset, y2 - inset, 1);
+      }
+      break;
+    case WIDGET_COUNTER:
+      snprintf(text, sizeof(text), "%lu", count);
+      fb_text(widget->x, widget->y, x2, text);
+      break;
+    case WIDGET_BAR:
+      fb_frame(widget->x, widget->y, x2, y2, 1);
+      fill = (int) ((widget->width - 4) * (count < widget->max ? count : widget->max) / widget->max);
+      fb_fill(widget->x + 2, widget->y + 2, widget->x + 1 + fill, y2 - 2, 1);
+      break;
+    case WIDGET_TEXT:
+      fb_text(widget->x, widget->y, x2, level ? widget->high : widget->low);
+      break;
+  }
+}
+
+/**
+ * \brief Draw the changed widgets into the framebuffer.
+ *
+ * Called by the lcd worker before the framebuffer is pushed. The widgets
+ * are copied under the lock, so the edge callbacks are not delayed by the
+ * drawing.
+ *
+ * @param show 1 to show the rectangles of the widgets at once, a widget
+ *             update between two SHOWs of a client.
+ *
+ * @return Count of drawn widgets and cleared areas.
+ */
+int render_widgets(int show) {
+  Widget draw[MAX_WIDGETS];
+  WidgetArea erase[MAX_WIDGETS];
+  int levels[MAX_WIDGETS], erase_count, count = 0, i;
+  unsigned long counts[MAX_WIDGETS];
+
+  pthread_mutex_lock(&widget_lock);
+  erase_count = widget_erase_count;
+  memcpy(erase, widget_erase, sizeof(WidgetArea) * erase_count);
+  widget_erase_count = 0;
+  for (i = 0; i < MAX_WIDGETS; i++) {
+    if (widgets[i].defined && widgets[i].dirty) {
+      widgets[i].dirty = 0;
+      draw[count]   = widgets[i];
+      levels[count] = (widget_levels >> widgets[i].pin) & 1;
+      counts[count] = widget_edges[widgets[i].pin] - widgets[i].base;
+      count++;
+    }
+  }
+  widget_draws += count;
+  if (count + erase_count > 0) {
+    widget_updates++;
+  }
+  pthread_mutex_unlock(&widget_lock);
+
+  for (i = 0; i < erase_count; i++) {
+    fb_fill(erase[i].x1, erase[i].y1, erase[i].x2, erase[i].y2, 0);
+    if (show) {
+      fb_show_area(erase[i].x1, erase[i].y1, erase[i].x2, erase[i].y2);
+    }
+  }
+  for (i = 0; i < count; i++) {
+    draw_widget(&draw[i], levels[i], counts[i]);
+    if (show) {
+      fb_show_area(draw[i].x, draw[i].y, draw[i].x + draw[i].width - 1, draw[i].y + draw[i].height - 1);
+    }
+  }
+  return count + erase_count;
+}
+
+/**
+ * Read the arguments of a widget definition after the pin.
+ *
+ * @return 0 or -1 if the arguments don't match the type.
+ */
+static int parse_widget_args(Widget *widget, char *args) {
+  switch (widget->type) {
+    case WIDGET_PIN:
+      return sscanf(args, "%d %d %d %d %d", &widget->pin, &widget->x, &widget->y, &widget->width, &widget->height) == 5 ? 0 : -1;
+    case WIDGET_COUNTER:
+      return sscanf(args, "%d %d %d %d", &widget->pin, &widget->x, &widget->y, &widget->width) == 4 ? 0 : -1;
+    case WIDGET_BAR:
+      return sscanf(args, "%d %d %d %d %d %lu", &widget->pin, &widget->x, &widget->y, &widget->width, &widget->height, &widget->max) == 6 ? 0 : -1;
+    case WIDGET_TEXT:
+      return sscanf(args, "%d %d %d %d %21s %21s", &widget->pin, &widget->x, &widget->y, &widget->width, widget->high, widget->low) == 6 ? 0 : -1;
+  }
+  return -1;
+}
+
+/**
+ * \brief Widget lcd commands.
+ *
+ * LCD WIDGET PIN id pin x y w h
+ * LCD WIDGET COUNTER id pin x y w
+ * LCD WIDGET BAR id pin x y w h max
+ * LCD WIDGET TEXT id pin x y w high low
+ * LCD WIDGET RESET id restarts the count of edges.
+ * LCD WIDGET FREE id
+ *
+ * @param client_socket_fd The unix socket file descriptor.
+ * @param buf              The lcd command.
+ */
+void do_lcd_widget(int client_socket_fd, char *buf) {
+  char command[16], args[BUFFER_SIZE], *error;
+  unsigned long long now = get_monotonic_ns();
+  int id, offset = 0, type;
+  Widget widget;
+
+  if (sscanf(buf, "%*s %15s", command) != 1) {
+    write_error_msg_to_client(client_socket_fd, "expected LCD WIDGET <PIN|COUNTER|BAR|TEXT|RESET|FREE>");
+    return;
+  }
+  if (strcmp(command, LCD_WIDGET_RESET) == 0 || strcmp(command, LCD_WIDGET_FREE) == 0) {
+    if (sscanf(buf, "%*s %*s %d", &id) != 1 || id < 0 || id >= MAX_WIDGETS) {
+      write_error_msg_to_client(client_socket_fd, "expected LCD WIDGET <RESET|FREE> <id>");
+      return;
+    }
+    pthread_mutex_lock(&widget_lock);
+    if (!widgets[id].defined) {
+      pthread_mutex_unlock(&widget_lock);
+      write_error_msg_to_client(client_socket_fd, "widget not defined");
+      return;
+    }
+    if (strcmp(command, LCD_WIDGET_RESET) == 0) {
+      widgets[id].base  = widget_edges[widgets[id].pin];
+      widgets[id].dirty = 1;
+    } else {
+      erase_widget(&widgets[id]);
+      widgets[id].defined = 0;
+      update_widget_pins();
+    }
+    request_widget_flush(now);
+    pthread_mutex_unlock(&widget_lock);
+    return;
+  }
+
+  for (type = 0; type <= WIDGET_TEXT; type++) {
+    if (strcmp(command, widget_commands[type]) == 0) {
+      break;
+    }
+  }
+  memset(&widget, 0, sizeof(widget));
+  widget.type = type;
+  if (type > WIDGET_TEXT) {
+    write_error_msg_to_client(client_socket_fd, "expected LCD WIDGET <PIN|COUNTER|BAR|TEXT|RESET|FREE>");
+  } else if (sscanf(buf, "%*s %*s %d %n", &id, &offset) != 1 || offset == 0
+      || parse_widget_args(&widget, expand_pin_alias(buf + offset, args, BUFFER_SIZE)) == -1) {
+    write_error_msg_to_client(client_socket_fd, "unexpected parameters for widget");
+  } else if (id < 0 || id >= MAX_WIDGETS) {
+    write_error_msg_to_client(client_socket_fd, "unknown widget id");
+  } else if ((error = check_widget(&widget)) != NULL) {
+    write_error_msg_to_client(client_socket_fd, error);
+  } else {
+    log_msg(LOG_MOD_LCD, LOG_DEBUG, "EXECUTING LCD %s %s %d PIN %d", LCD_WIDGET, command, id, widget.pin);
+    pthread_mutex_lock(&widget_lock);
+    put_widget(id, &widget);
+    update_widget_pins();
+    arm_widget_sample(now);
+    request_widget_flush(now);
+    pthread_mutex_unlock(&widget_lock);
+  }
+}
+
+/**
+ * \brief Write the widget statistics.
+ *
+ * @param client_socket_fd The unix socket file descriptor.
+ */
+void do_write_widget_stats(int client_socket_fd) {
+  char msg[BUFFER_SIZE];
+  unsigned long draws, updates, coalesced;
+  int count;
+
+  pthread_mutex_lock(&widget_lock);
+  count     = widgets_count;
+  draws     = widget_draws;
+  updates   = widget_updates;
+  coalesced = widget_coalesced;
+  pthread_mutex_unlock(&widget_lock);
+
+  snprintf(msg, BUFFER_SIZE, "widgets: %d defined, %lu draws in %lu updates, %lu changes coalesced, interval %d ms",
+      count, draws, updates, coalesced, widget_interval_ms);
+  write_msg_to_client(client_socket_fd, msg);
+}
@@ -0,0 +1,77 @@
+/*
+ * widget.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef WIDGET_H_
+#define WIDGET_H_
+
+#include <stdint.h>
+
+/**
+ * \brief Maximal count of widgets, the ids are 0 to MAX_WIDGETS - 1.
+ */
+#define MAX_WIDGETS 32
+
+/**
+ * \brief Size of the texts of a text widget.
+ */
+#define WIDGET_TEXT_SIZE 22
+
+/**
+ * \brief Default shortest time between two widget updates of the display in milliseconds.
+ *
+ * Changes inside the interval are drawn together with the next update.
+ * Pins without interrupt are sampled with the same interval.
+ */
+#define WIDGET_INTERVAL_MS 50
+#define WIDGET_INTERVAL_MAX_MS 10000
+
+#define LCD_WIDGET         "WIDGET"
+#define LCD_WIDGET_PIN     "PIN"
+#define LCD_WIDGET_COUNTER "COUNTER"
+#define LCD_WIDGET_BAR     "BAR"
+#define LCD_WIDGET_TEXT    "TEXT"
+#define LCD_WIDGET_RESET   "RESET"
+#define LCD_WIDGET_FREE    "FREE"
+
+typedef enum WidgetType {
+  WIDGET_PIN = 0, //> Frame, filled while the pin is high.
+  WIDGET_COUNTER, //> Count of edges of the pin.
+  WIDGET_BAR,     //> Frame, filled by the count of edges of the pin up to max.
+  WIDGET_TEXT     //> Text of the pin level.
+} WidgetType;
+
+/**
+ * \brief A widget bound to a pin, drawn by the daemon into the framebuffer.
+ */
+typedef struct Widget {
+  int defined;
+  WidgetType type;
+  int pin;                           //> Source pin.
+  int x;                             //> Left column.
+  int y;                             //> Top row.
+  int width;
+  int height;                        //> Height of pin and bar, counter and text are 8 rows.
+  unsigned long max;                 //> Count of a full bar.
+  unsigned long base;                //> Edge count of the pin at the last reset.
+  char high[WIDGET_TEXT_SIZE];       //> Text of a high pin.
+  char low[WIDGET_TEXT_SIZE];        //> Text of a low pin.
+  int dirty;                         //> 1 if the widget must be drawn again.
+} Widget;
+
+int parse_widget_type(const char *type);
+char *check_widget(Widget *widget);
+void set_widget_interval(int interval_ms);
+void set_widgets(Widget *widgets, int count);
+void start_widgets();
+void widget_notify_edge(int pin, int level, unsigned long long timestamp_ns);
+void get_widget_edges(uint64_t *edges);
+void set_widget_edges(const uint64_t *edges);
+void invalidate_widgets();
+int render_widgets(int show);
+void do_lcd_widget(int client_socket_fd, char *buf);
+void do_write_widget_stats(int client_socket_fd);
+
+#endif /* WIDGET_H_ */
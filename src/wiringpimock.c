@@ -14,6 +14,19 @@ void digitalWriteWMock(int pin, int value) {
 void pinModeWMock(int pin, int mode) {
 }
 
+void pwmWrite(int pin, int value) {
+}
+
+int softPwmCreate(int pin, int value, int range) {
+    return 0;
+}
+
+void softPwmWrite(int pin, int value) {
+}
+
+void softPwmStop(int pin) {
+}
+
 int wiringPiSetupGpio () {
     pinMode      = pinModeWMock;
     digitalRead  = digitalReadWMock;